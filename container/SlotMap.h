@@ -0,0 +1,368 @@
+#ifndef container_SlotMap_h
+#define container_SlotMap_h
+
+//
+// Slot map, a dense array of item pointers with generational handles.
+//
+// Items are kept in insertion order in one contiguous array, iterating is
+// a linear walk over it. Erasing an item leaves a hole (NULL) in the array,
+// which iterators skip. Holes are compacted away, keeping the order, once
+// there are enough of them and no iterator is active, so both insert and
+// erase are (amortized) constant time, also while iterating.
+//
+// A handle stays valid until its item is erased. After that the handle
+// no longer resolves, as the slot generation is bumped on erase.
+// Items are erased by handle only, there is no item to slot lookup. The
+// owner of the map keeps the handle returned on insert, usually in the
+// item itself (as GameObject keeps its list node).
+//
+// LinkedSlotMap additionally mirrors the items in a LinkedList. This is a
+// bridge for the getAll*() callers of the game object lists (scripting,
+// ui, ai and such, over a hundred of them) that still walk a LinkedList,
+// it costs a list node allocation per item. Only the per-tick loops walk
+// the slot map so far. To remove it: convert the callers of one list's
+// getAll*() to its get*Slots() iterator, then make that list a plain
+// SlotMap and drop its getAll*(). Once no list uses LinkedSlotMap, it goes.
+//
+
+#include <assert.h>
+#include <vector>
+
+#include "LinkedList.h"
+
+// holes are not compacted before there are this many of them
+#define SLOTMAP_MIN_COMPACT_HOLES 32
+
+struct SlotMapHandle
+{
+  SlotMapHandle()
+    : index(-1), generation(0)
+  {
+  }
+
+  SlotMapHandle(int index, int generation)
+    : index(index), generation(generation)
+  {
+  }
+
+  bool isValid() const
+  {
+    return index >= 0;
+  }
+
+  bool operator== (const SlotMapHandle &other) const
+  {
+    return index == other.index && generation == other.generation;
+  }
+
+  bool operator!= (const SlotMapHandle &other) const
+  {
+    return !(*this == other);
+  }
+
+  int index;
+  int generation;
+};
+
+
+template<class T> class SlotMap
+{
+  private:
+    struct Slot
+    {
+      // position in dense array, -1 if the slot is free
+      int dense;
+      int generation;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<int> freeSlots;
+
+    // items in insertion order, NULL for erased ones (holes)
+    std::vector<T *> dense;
+    // slot of each dense array item
+    std::vector<int> denseSlots;
+    int holeAmount;
+    // items in the map (dense size without holes)
+    int amount;
+
+    // active iterators, compacting is not allowed while there are any
+    mutable int iteratorDepth;
+
+    SlotMap(const SlotMap &);
+    SlotMap &operator= (const SlotMap &);
+
+    void compactIfNeeded()
+    {
+      if (iteratorDepth > 0
+        || holeAmount < SLOTMAP_MIN_COMPACT_HOLES
+        || holeAmount * 2 < (int)dense.size())
+      {
+        return;
+      }
+      compact();
+    }
+
+    void compact()
+    {
+      assert(iteratorDepth == 0);
+
+      int to = 0;
+      for (int from = 0; from < (int)dense.size(); from++)
+      {
+        if (dense[from] == NULL)
+          continue;
+        dense[to] = dense[from];
+        denseSlots[to] = denseSlots[from];
+        slots[denseSlots[to]].dense = to;
+        to++;
+      }
+      dense.resize(to);
+      denseSlots.resize(to);
+      holeAmount = 0;
+    }
+
+  public:
+    SlotMap()
+      : holeAmount(0), amount(0), iteratorDepth(0)
+    {
+    }
+
+    ~SlotMap()
+    {
+      assert(iteratorDepth == 0);
+    }
+
+    SlotMapHandle insert(T *item)
+    {
+      assert(item != NULL);
+
+      int slot;
+      if (!freeSlots.empty())
+      {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+      } else {
+        slot = (int)slots.size();
+        Slot s;
+        s.dense = -1;
+        s.generation = 0;
+        slots.push_back(s);
+      }
+
+      slots[slot].dense = (int)dense.size();
+      dense.push_back(item);
+      denseSlots.push_back(slot);
+      amount++;
+
+      return SlotMapHandle(slot, slots[slot].generation);
+    }
+
+    // returns false if the handle does not resolve (already erased)
+    bool erase(const SlotMapHandle &handle)
+    {
+      if (get(handle) == NULL)
+        return false;
+
+      Slot &s = slots[handle.index];
+      dense[s.dense] = NULL;
+      holeAmount++;
+      amount--;
+      s.dense = -1;
+      s.generation++;
+      freeSlots.push_back(handle.index);
+
+      compactIfNeeded();
+      return true;
+    }
+
+    void clear()
+    {
+      assert(iteratorDepth == 0);
+
+      for (int i = 0; i < (int)dense.size(); i++)
+      {
+        if (dense[i] == NULL)
+          continue;
+        Slot &s = slots[denseSlots[i]];
+        s.dense = -1;
+        s.generation++;
+        freeSlots.push_back(denseSlots[i]);
+      }
+      dense.clear();
+      denseSlots.clear();
+      holeAmount = 0;
+      amount = 0;
+    }
+
+    T *get(const SlotMapHandle &handle) const
+    {
+      if (handle.index < 0 || handle.index >= (int)slots.size())
+        return NULL;
+      const Slot &s = slots[handle.index];
+      if (s.dense < 0 || s.generation != handle.generation)
+        return NULL;
+      return dense[s.dense];
+    }
+
+    int getAmount() const
+    {
+      return amount;
+    }
+
+    bool isEmpty() const
+    {
+      return amount == 0;
+    }
+
+    // dense array access, for splitting the items in ranges
+    // (items may be NULL, positions change when compacted)
+    int getDenseAmount() const
+    {
+      return (int)dense.size();
+    }
+
+    T *getDenseItem(int position) const
+    {
+      assert(position >= 0 && position < (int)dense.size());
+      return dense[position];
+    }
+
+    // iterates the items in insertion order. items may be inserted and
+    // erased while iterating, erased items are not returned anymore and
+    // items inserted after the iterator was created are not returned
+    // (unless includeInserted is set).
+    class Iterator
+    {
+      private:
+        const SlotMap<T> *map;
+        int position;
+        int end;
+
+        Iterator(const Iterator &);
+        Iterator &operator= (const Iterator &);
+
+        int getEnd() const
+        {
+          return (end < 0) ? (int)map->dense.size() : end;
+        }
+
+      public:
+        Iterator(const SlotMap<T> *map, bool includeInserted = false)
+          : map(map), position(0)
+        {
+          end = includeInserted ? -1 : (int)map->dense.size();
+          map->iteratorDepth++;
+        }
+
+        ~Iterator()
+        {
+          map->iteratorDepth--;
+          if (map->iteratorDepth == 0)
+            const_cast<SlotMap<T> *>(map)->compactIfNeeded();
+        }
+
+        inline bool iterateAvailable()
+        {
+          int e = getEnd();
+          while (position < e && map->dense[position] == NULL)
+            position++;
+          return position < e;
+        }
+
+        inline T *iterateNext()
+        {
+          if (!iterateAvailable())
+          {
+            assert(!"SlotMap::Iterator::iterateNext - No more items.");
+            return NULL;
+          }
+          return map->dense[position++];
+        }
+    };
+
+    friend class Iterator;
+};
+
+
+template<class T> class LinkedSlotMap
+{
+  private:
+    SlotMap<T> map;
+    LinkedList *list;
+    // list node of each slot (indexed by slot map handle index)
+    std::vector<const ListNode *> nodes;
+
+    LinkedSlotMap(const LinkedSlotMap &);
+    LinkedSlotMap &operator= (const LinkedSlotMap &);
+
+  public:
+    LinkedSlotMap()
+    {
+      list = new LinkedList();
+    }
+
+    ~LinkedSlotMap()
+    {
+      while (!list->isEmpty())
+      {
+        list->popLast();
+      }
+      delete list;
+    }
+
+    SlotMapHandle insert(T *item)
+    {
+      SlotMapHandle handle = map.insert(item);
+      list->append(item);
+      if (handle.index >= (int)nodes.size())
+        nodes.resize(handle.index + 1, NULL);
+      nodes[handle.index] = list->getLastNode();
+      return handle;
+    }
+
+    // returns false if the handle does not resolve (already erased)
+    bool erase(const SlotMapHandle &handle)
+    {
+      if (map.get(handle) == NULL)
+        return false;
+
+      list->removeNode(nodes[handle.index]);
+      nodes[handle.index] = NULL;
+      return map.erase(handle);
+    }
+
+    void clear()
+    {
+      while (!list->isEmpty())
+      {
+        list->popLast();
+      }
+      nodes.clear();
+      map.clear();
+    }
+
+    T *get(const SlotMapHandle &handle) const
+    {
+      return map.get(handle);
+    }
+
+    const SlotMap<T> *getSlotMap() const
+    {
+      return &map;
+    }
+
+    // the mirror list, must not be modified directly
+    // (bridge for unconverted callers, see the top of this file)
+    LinkedList *getLinkedList() const
+    {
+      return list;
+    }
+
+    int getAmount() const
+    {
+      return map.getAmount();
+    }
+};
+
+#endif
@@ -0,0 +1,85 @@
+
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#endif
+
+#include "crc32.h"
+#include <string.h>
+
+#include "../util/Debug_MemoryManager.h"
+
+namespace frozenbyte {
+namespace filesystem {
+namespace {
+
+	struct Crc32Tables
+	{
+		// table[0] is the classic byte table, table[n] advances n more zero bytes
+		unsigned int table[8][256];
+
+		Crc32Tables()
+		{
+			for(unsigned int i = 0; i < 256; ++i)
+			{
+				unsigned int value = i;
+				for(int j = 0; j < 8; ++j)
+					value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+
+				table[0][i] = value;
+			}
+
+			for(unsigned int i = 0; i < 256; ++i)
+			{
+				for(int slice = 1; slice < 8; ++slice)
+				{
+					unsigned int previous = table[slice - 1][i];
+					table[slice][i] = (previous >> 8) ^ table[0][previous & 0xFF];
+				}
+			}
+		}
+	};
+
+	const Crc32Tables tables;
+
+	inline bool isLittleEndian()
+	{
+		const unsigned int value = 1;
+		return *reinterpret_cast<const unsigned char *> (&value) == 1;
+	}
+
+} // unnamed
+
+unsigned int calculateCrc32(const void *buffer, int size, unsigned int crc)
+{
+	const unsigned char *data = reinterpret_cast<const unsigned char *> (buffer);
+	const unsigned int (*t)[256] = tables.table;
+
+	crc = ~crc;
+
+	if(isLittleEndian())
+	{
+		for(; size >= 8; size -= 8, data += 8)
+		{
+			unsigned int low = 0;
+			unsigned int high = 0;
+			memcpy(&low, data, 4);
+			memcpy(&high, data + 4, 4);
+			low ^= crc;
+
+			crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+				^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+		}
+	}
+
+	for(; size > 0; --size, ++data)
+		crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+
+	return ~crc;
+}
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
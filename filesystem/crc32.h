@@ -0,0 +1,16 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_FILESYSTEM_CRC32_H
+#define INCLUDED_FILESYSTEM_CRC32_H
+
+namespace frozenbyte {
+namespace filesystem {
+
+// Standard (zip) crc32, processes 8 bytes per step (slicing-by-8).
+// Pass previous result as crc to continue a running checksum.
+unsigned int calculateCrc32(const void *buffer, int size, unsigned int crc = 0);
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
+
+#endif
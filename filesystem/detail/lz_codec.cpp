@@ -0,0 +1,252 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#include "lz_codec.h"
+#include <string.h>
+#include <vector>
+
+namespace frozenbyte {
+namespace filesystem {
+namespace lz {
+namespace {
+
+	static const int MIN_MATCH = 4;
+	static const int MAX_OFFSET = 65535;
+	static const int HASH_LOG = 16;
+
+	// Last bytes of a block are always literals and matches may not start
+	// too close to the end. This keeps decoder inner loop simple.
+	static const int LAST_LITERALS = 5;
+	static const int MATCH_FIND_LIMIT = 12;
+
+	// Skip faster over incompressible data
+	static const int SKIP_TRIGGER = 6;
+
+	inline unsigned int read32(const unsigned char *p)
+	{
+		unsigned int value = 0;
+		memcpy(&value, p, 4);
+		return value;
+	}
+
+	inline unsigned int hash(unsigned int sequence)
+	{
+		return (sequence * 2654435761U) >> (32 - HASH_LOG);
+	}
+
+	inline bool writeLength(unsigned char *&op, const unsigned char *oend, int length)
+	{
+		for(; length >= 255; length -= 255)
+		{
+			if(op >= oend)
+				return false;
+			*op++ = 255;
+		}
+
+		if(op >= oend)
+			return false;
+
+		*op++ = (unsigned char) length;
+		return true;
+	}
+
+	bool writeSequence(unsigned char *&op, const unsigned char *oend, const unsigned char *literals, int literalLength, int offset, int matchLength)
+	{
+		if(op >= oend)
+			return false;
+
+		unsigned char *token = op++;
+		*token = (unsigned char) ((literalLength >= 15 ? 15 : literalLength) << 4);
+		if(literalLength >= 15 && !writeLength(op, oend, literalLength - 15))
+			return false;
+
+		if(oend - op < literalLength)
+			return false;
+		if(literalLength > 0)
+			memcpy(op, literals, literalLength);
+		op += literalLength;
+
+		// Final literal-only sequence
+		if(offset == 0)
+			return true;
+
+		if(oend - op < 2)
+			return false;
+		*op++ = (unsigned char) (offset & 0xFF);
+		*op++ = (unsigned char) (offset >> 8);
+
+		*token |= (unsigned char) (matchLength >= 15 ? 15 : matchLength);
+		if(matchLength >= 15 && !writeLength(op, oend, matchLength - 15))
+			return false;
+
+		return true;
+	}
+
+	inline bool readLength(const unsigned char *&ip, const unsigned char *iend, size_t &length)
+	{
+		unsigned int s = 0;
+		do
+		{
+			if(ip >= iend)
+				return false;
+
+			s = *ip++;
+			length += s;
+		} while(s == 255);
+
+		return true;
+	}
+
+} // unnamed
+
+int compressBound(int sourceSize)
+{
+	return sourceSize + (sourceSize / 255) + 16;
+}
+
+int compress(const unsigned char *source, int sourceSize, unsigned char *destination, int destinationCapacity)
+{
+	if(sourceSize < 0 || destinationCapacity <= 0)
+		return 0;
+
+	unsigned char *op = destination;
+	const unsigned char *oend = destination + destinationCapacity;
+
+	int anchor = 0;
+	if(sourceSize > MATCH_FIND_LIMIT)
+	{
+		std::vector<int> table(1 << HASH_LOG, -1);
+
+		const int findLimit = sourceSize - MATCH_FIND_LIMIT;
+		const int matchLimit = sourceSize - LAST_LITERALS;
+
+		int ip = 0;
+		int searchCount = 1 << SKIP_TRIGGER;
+
+		while(ip < findLimit)
+		{
+			unsigned int sequence = read32(source + ip);
+			unsigned int h = hash(sequence);
+			int ref = table[h];
+			table[h] = ip;
+
+			if(ref < 0 || ip - ref > MAX_OFFSET || read32(source + ref) != sequence)
+			{
+				ip += searchCount++ >> SKIP_TRIGGER;
+				continue;
+			}
+
+			searchCount = 1 << SKIP_TRIGGER;
+
+			// Catch up backwards
+			while(ip > anchor && ref > 0 && source[ip - 1] == source[ref - 1])
+			{
+				--ip;
+				--ref;
+			}
+
+			int matchEnd = ip + MIN_MATCH;
+			int refEnd = ref + MIN_MATCH;
+			while(matchEnd < matchLimit && source[matchEnd] == source[refEnd])
+			{
+				++matchEnd;
+				++refEnd;
+			}
+
+			if(!writeSequence(op, oend, source + anchor, ip - anchor, ip - ref, matchEnd - ip - MIN_MATCH))
+				return 0;
+
+			ip = matchEnd;
+			anchor = ip;
+
+			if(ip - 2 < findLimit)
+				table[hash(read32(source + ip - 2))] = ip - 2;
+		}
+	}
+
+	if(!writeSequence(op, oend, source + anchor, sourceSize - anchor, 0, 0))
+		return 0;
+
+	return int(op - destination);
+}
+
+bool decompress(const unsigned char *source, int sourceSize, unsigned char *destination, int destinationSize)
+{
+	const unsigned char *ip = source;
+	const unsigned char *iend = source + sourceSize;
+	unsigned char *op = destination;
+	unsigned char *oend = destination + destinationSize;
+
+	if(sourceSize <= 0)
+		return destinationSize == 0;
+
+	for(;;)
+	{
+		if(ip >= iend)
+			return false;
+
+		unsigned int token = *ip++;
+
+		// Literals
+		size_t length = token >> 4;
+		if(length == 15 && !readLength(ip, iend, length))
+			return false;
+
+		if(length > size_t(iend - ip) || length > size_t(oend - op))
+			return false;
+
+		if(length <= 16 && iend - ip >= 16 && oend - op >= 16)
+			memcpy(op, ip, 16);
+		else
+			memcpy(op, ip, length);
+
+		op += length;
+		ip += length;
+
+		if(ip == iend)
+			return op == oend;
+
+		// Match
+		if(iend - ip < 2)
+			return false;
+
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		if(offset == 0 || offset > size_t(op - destination))
+			return false;
+
+		length = token & 15;
+		if(length == 15 && !readLength(ip, iend, length))
+			return false;
+
+		length += MIN_MATCH;
+		if(length > size_t(oend - op))
+			return false;
+
+		const unsigned char *match = op - offset;
+		if(offset >= 8 && size_t(oend - op) >= length + 8)
+		{
+			// Source never overlaps the 8 bytes being written, copy wide
+			unsigned char *copyEnd = op + length;
+			do
+			{
+				memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			} while(op < copyEnd);
+
+			op = copyEnd;
+		}
+		else
+		{
+			for(size_t i = 0; i < length; ++i)
+				op[i] = match[i];
+
+			op += length;
+		}
+	}
+}
+
+} // end of namespace lz
+} // end of namespace filesystem
+} // end of namespace frozenbyte
@@ -0,0 +1,34 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_FILESYSTEM_DETAIL_LZ_CODEC_H
+#define INCLUDED_FILESYSTEM_DETAIL_LZ_CODEC_H
+
+namespace frozenbyte {
+namespace filesystem {
+namespace lz {
+
+	// Byte oriented LZ77 block codec (LZ4 style token layout).
+	// Compression is greedy and fairly quick, decompression is a plain
+	// copy loop without any entropy decoding which makes it several times
+	// faster than inflate.
+	//
+	// Block layout is a sequence of
+	//   token (literal length << 4 | match length - 4)
+	//   [extra literal length bytes] literals
+	//   offset (16 bit little endian) [extra match length bytes]
+	// The last sequence of a block contains only literals.
+
+	// Worst case output size for given input size
+	int compressBound(int sourceSize);
+
+	// Returns compressed size, or 0 if output did not fit into destination
+	int compress(const unsigned char *source, int sourceSize, unsigned char *destination, int destinationCapacity);
+
+	// Decompresses exactly destinationSize bytes. Returns false on malformed input.
+	bool decompress(const unsigned char *source, int sourceSize, unsigned char *destination, int destinationSize);
+
+} // end of namespace lz
+} // end of namespace filesystem
+} // end of namespace frozenbyte
+
+#endif
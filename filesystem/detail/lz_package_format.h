@@ -0,0 +1,68 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_FILESYSTEM_DETAIL_LZ_PACKAGE_FORMAT_H
+#define INCLUDED_FILESYSTEM_DETAIL_LZ_PACKAGE_FORMAT_H
+
+#include <string>
+#include <vector>
+
+namespace frozenbyte {
+namespace filesystem {
+namespace lz {
+
+	// Package layout (all values little endian):
+	//
+	//   header      magic "FBLZ", version, file count, directory offset, directory size
+	//   file data   each entry stored as one independently compressed block
+	//   directory   for each entry: name length (16 bit), name,
+	//               offset, packed size, size, crc32, method (8 bit)
+	//
+	// Directory is at the end so that packer can stream file data out first.
+
+	static const char PACKAGE_MAGIC[4] = { 'F', 'B', 'L', 'Z' };
+	static const unsigned int PACKAGE_VERSION = 1;
+	static const int PACKAGE_HEADER_SIZE = 20;
+
+	enum PackageMethod
+	{
+		MethodStored = 0,
+		MethodLz = 1
+	};
+
+	struct PackageEntry
+	{
+		std::string filename;
+		unsigned int offset;
+		unsigned int packedSize;
+		unsigned int size;
+		unsigned int crc;
+		unsigned char method;
+
+		PackageEntry()
+		:	offset(0),
+			packedSize(0),
+			size(0),
+			crc(0),
+			method(MethodStored)
+		{
+		}
+	};
+
+	inline void putUInt(std::vector<unsigned char> &buffer, unsigned int value)
+	{
+		buffer.push_back((unsigned char) (value & 0xFF));
+		buffer.push_back((unsigned char) ((value >> 8) & 0xFF));
+		buffer.push_back((unsigned char) ((value >> 16) & 0xFF));
+		buffer.push_back((unsigned char) ((value >> 24) & 0xFF));
+	}
+
+	inline unsigned int getUInt(const unsigned char *buffer)
+	{
+		return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | (unsigned int) (buffer[3] << 24);
+	}
+
+} // end of namespace lz
+} // end of namespace filesystem
+} // end of namespace frozenbyte
+
+#endif
@@ -23,8 +23,15 @@ namespace filesystem {
 			return 0;
 		}
 
-		void popBytes(char *, int)
+		void popBytes(char *buffer, int bytes)
 		{
+			for(int i = 0; i < bytes; ++i)
+				buffer[i] = 0;
+		}
+
+		int popAvailableBytes(char *, int)
+		{
+			return 0;
 		}
 	};
 
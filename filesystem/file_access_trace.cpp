@@ -0,0 +1,314 @@
+
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#pragma warning(disable:4786)
+#endif
+
+#include "file_access_trace.h"
+#include "detail/lz_package_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "../util/Debug_MemoryManager.h"
+
+namespace frozenbyte {
+namespace filesystem {
+namespace {
+
+	// Trace layout (little endian):
+	//
+	//   header   magic "FBTR", version
+	//   records  sequence, time (64 bit), size, latency, source (8 bit),
+	//            path length (16 bit), path, package length (16 bit), package
+	//
+	// Records are written when streams are released so they are not in
+	// open order in the file, reader sorts them by sequence.
+
+	const char TRACE_MAGIC[4] = { 'F', 'B', 'T', 'R' };
+	const unsigned int TRACE_VERSION = 1;
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct TraceState
+	{
+		std::mutex mutex;
+		std::atomic<bool> enabled;
+		FILE *fp;
+		unsigned int sequence;
+		Clock::time_point startTime;
+
+		TraceState()
+		:	enabled(false),
+			fp(0),
+			sequence(0)
+		{
+		}
+
+		~TraceState()
+		{
+			enabled = false;
+			if(fp)
+				fclose(fp);
+			fp = 0;
+		}
+	};
+
+	TraceState traceState;
+
+	void putString(std::vector<unsigned char> &buffer, const std::string &string)
+	{
+		unsigned int length = std::min<unsigned int>(string.size(), 0xFFFF);
+		buffer.push_back((unsigned char) (length & 0xFF));
+		buffer.push_back((unsigned char) (length >> 8));
+		buffer.insert(buffer.end(), string.begin(), string.begin() + length);
+	}
+
+	void writeRecord(const FileAccessRecord &record)
+	{
+		std::vector<unsigned char> buffer;
+		lz::putUInt(buffer, record.sequence);
+		lz::putUInt(buffer, (unsigned int) (record.time & 0xFFFFFFFF));
+		lz::putUInt(buffer, (unsigned int) (record.time >> 32));
+		lz::putUInt(buffer, record.size);
+		lz::putUInt(buffer, record.latency);
+		buffer.push_back(record.source);
+		putString(buffer, record.path);
+		putString(buffer, record.package);
+
+		std::lock_guard<std::mutex> lock(traceState.mutex);
+		if(traceState.fp)
+			fwrite(&buffer[0], 1, buffer.size(), traceState.fp);
+	}
+
+	unsigned int nextSequence()
+	{
+		std::lock_guard<std::mutex> lock(traceState.mutex);
+		return traceState.sequence++;
+	}
+
+	// Times everything done through the buffer, record goes out with the last stream copy
+	class TracingInputBuffer: public IInputStreamBuffer
+	{
+		std::shared_ptr<IInputStreamBuffer> buffer;
+		FileAccessRecord record;
+		unsigned long long readTime;
+
+		class Timer
+		{
+			unsigned long long &total;
+			unsigned long long start;
+
+		public:
+			explicit Timer(unsigned long long &total_)
+			:	total(total_),
+				start(getFileAccessTraceTime())
+			{
+			}
+
+			~Timer()
+			{
+				total += getFileAccessTraceTime() - start;
+			}
+		};
+
+	public:
+		TracingInputBuffer(const std::shared_ptr<IInputStreamBuffer> &buffer_, const FileAccessRecord &record_, unsigned long long openTime)
+		:	buffer(buffer_),
+			record(record_),
+			readTime(openTime)
+		{
+		}
+
+		~TracingInputBuffer()
+		{
+			record.latency = (unsigned int) std::min<unsigned long long>(readTime, 0xFFFFFFFF);
+			writeRecord(record);
+		}
+
+		unsigned char popByte()
+		{
+			Timer timer(readTime);
+			return buffer->popByte();
+		}
+
+		bool isEof() const
+		{
+			return buffer->isEof();
+		}
+
+		int getSize() const
+		{
+			return buffer->getSize();
+		}
+
+		void popBytes(char *target, int bytes)
+		{
+			Timer timer(readTime);
+			buffer->popBytes(target, bytes);
+		}
+
+		int popAvailableBytes(char *target, int maxBytes)
+		{
+			Timer timer(readTime);
+			return buffer->popAvailableBytes(target, maxBytes);
+		}
+	};
+
+	bool readUInt(FILE *fp, unsigned int &value)
+	{
+		unsigned char buffer[4] = { 0 };
+		if(fread(buffer, 1, 4, fp) != 4)
+			return false;
+
+		value = lz::getUInt(buffer);
+		return true;
+	}
+
+	bool readString(FILE *fp, std::string &string)
+	{
+		unsigned char buffer[2] = { 0 };
+		if(fread(buffer, 1, 2, fp) != 2)
+			return false;
+
+		unsigned int length = buffer[0] | (buffer[1] << 8);
+		string.resize(length);
+		if(length > 0 && fread(&string[0], 1, length, fp) != length)
+			return false;
+
+		return true;
+	}
+
+	bool sequenceOrder(const FileAccessRecord &a, const FileAccessRecord &b)
+	{
+		return a.sequence < b.sequence;
+	}
+
+} // end of unnamed namespace
+
+bool startFileAccessTrace(const std::string &traceFile)
+{
+	stopFileAccessTrace();
+
+	FILE *fp = fopen(traceFile.c_str(), "wb");
+	if(!fp)
+		return false;
+
+	std::vector<unsigned char> header(TRACE_MAGIC, TRACE_MAGIC + 4);
+	lz::putUInt(header, TRACE_VERSION);
+	if(fwrite(&header[0], 1, header.size(), fp) != header.size())
+	{
+		fclose(fp);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(traceState.mutex);
+	traceState.fp = fp;
+	traceState.sequence = 0;
+	traceState.startTime = Clock::now();
+	traceState.enabled = true;
+	return true;
+}
+
+void stopFileAccessTrace()
+{
+	std::lock_guard<std::mutex> lock(traceState.mutex);
+	traceState.enabled = false;
+	if(traceState.fp)
+	{
+		fclose(traceState.fp);
+		traceState.fp = 0;
+	}
+}
+
+bool isFileAccessTraceEnabled()
+{
+	return traceState.enabled;
+}
+
+unsigned long long getFileAccessTraceTime()
+{
+	Clock::duration time = Clock::now() - traceState.startTime;
+	return std::chrono::duration_cast<std::chrono::microseconds> (time).count();
+}
+
+InputStream traceFileAccess(InputStream &stream, const std::string &path, const std::string &package, FileAccessSource source, unsigned long long openStartTime)
+{
+	FileAccessRecord record;
+	record.sequence = nextSequence();
+	record.time = openStartTime;
+	record.size = stream.getSize();
+	record.source = (unsigned char) source;
+	record.path = path;
+	record.package = package;
+
+	unsigned long long openTime = getFileAccessTraceTime() - openStartTime;
+	std::shared_ptr<IInputStreamBuffer> buffer(new TracingInputBuffer(stream.getBuffer(), record, openTime));
+
+	InputStream result;
+	result.setBuffer(buffer);
+	return result;
+}
+
+void traceMissingFile(const std::string &path, FileAccessSource source, unsigned long long openStartTime)
+{
+	FileAccessRecord record;
+	record.sequence = nextSequence();
+	record.time = openStartTime;
+	record.size = FileAccessRecord::NOT_FOUND;
+	record.latency = (unsigned int) (getFileAccessTraceTime() - openStartTime);
+	record.source = (unsigned char) source;
+	record.path = path;
+
+	writeRecord(record);
+}
+
+bool readFileAccessTrace(const std::string &traceFile, std::vector<FileAccessRecord> &result)
+{
+	FILE *fp = fopen(traceFile.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	char magic[4] = { 0 };
+	unsigned int version = 0;
+	if(fread(magic, 1, 4, fp) != 4 || memcmp(magic, TRACE_MAGIC, 4) != 0 || !readUInt(fp, version) || version != TRACE_VERSION)
+	{
+		fclose(fp);
+		return false;
+	}
+
+	for(;;)
+	{
+		FileAccessRecord record;
+		unsigned int timeLow = 0;
+		unsigned int timeHigh = 0;
+
+		if(!readUInt(fp, record.sequence))
+			break;
+		if(!readUInt(fp, timeLow) || !readUInt(fp, timeHigh) || !readUInt(fp, record.size) || !readUInt(fp, record.latency))
+			break;
+		if(fread(&record.source, 1, 1, fp) != 1)
+			break;
+		if(!readString(fp, record.path) || !readString(fp, record.package))
+			break;
+
+		record.time = timeLow | ((unsigned long long) timeHigh << 32);
+		result.push_back(record);
+	}
+
+	fclose(fp);
+
+	// Streams released in any order, open order is what matters
+	std::stable_sort(result.begin(), result.end(), sequenceOrder);
+	return true;
+}
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
@@ -0,0 +1,61 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_FILESYSTEM_FILE_ACCESS_TRACE_H
+#define INCLUDED_FILESYSTEM_FILE_ACCESS_TRACE_H
+
+#include <string>
+#include <vector>
+#include "input_stream.h"
+
+namespace frozenbyte {
+namespace filesystem {
+
+// Optional binary log of which files are opened, in what order, from which
+// package and how long reading them took. Used to build access ordered
+// packages (see lzpacker -order).
+
+enum FileAccessSource
+{
+	FileAccessStream = 0,
+	FileAccessFbFile = 1
+};
+
+struct FileAccessRecord
+{
+	unsigned int sequence;     // open order
+	unsigned long long time;   // open time, microseconds from trace start
+	unsigned int size;         // NOT_FOUND if no package had the file
+	unsigned int latency;      // microseconds spent opening and reading
+	unsigned char source;      // FileAccessSource
+	std::string path;
+	std::string package;
+
+	enum { NOT_FOUND = 0xFFFFFFFF };
+
+	FileAccessRecord()
+	:	sequence(0),
+		time(0),
+		size(0),
+		latency(0),
+		source(FileAccessStream)
+	{
+	}
+};
+
+bool startFileAccessTrace(const std::string &traceFile);
+void stopFileAccessTrace();
+bool isFileAccessTraceEnabled();
+
+// Manager calls these. Found files are wrapped so that read time is included,
+// record is written once the stream is released.
+InputStream traceFileAccess(InputStream &stream, const std::string &path, const std::string &package, FileAccessSource source, unsigned long long openStartTime);
+void traceMissingFile(const std::string &path, FileAccessSource source, unsigned long long openStartTime);
+unsigned long long getFileAccessTraceTime();
+
+// Records sorted by open order
+bool readFileAccessTrace(const std::string &traceFile, std::vector<FileAccessRecord> &result);
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
+
+#endif
@@ -0,0 +1,318 @@
+
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#pragma warning(disable:4786)
+#endif
+
+#include "file_body_cache.h"
+
+#include <string.h>
+#include <ctype.h>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "../util/Debug_MemoryManager.h"
+
+namespace frozenbyte {
+namespace filesystem {
+namespace {
+
+	typedef std::shared_ptr<const std::vector<unsigned char> > Body;
+	typedef std::pair<const IFilePackage *, std::string> BodyKey;
+
+	struct BodyEntry
+	{
+		BodyKey key;
+		Body body;
+	};
+
+	typedef std::list<BodyEntry> BodyList;
+	typedef std::map<BodyKey, BodyList::iterator> BodyMap;
+
+	// Shared with caching buffers, which may outlive the cache
+	struct BodyStorage
+	{
+		mutable std::mutex mutex;
+
+		BodyList bodies; // most recently used first
+		BodyMap bodyMap;
+		FileBodyCacheStats stats;
+
+		void evict(unsigned int bytes)
+		{
+			while(!bodies.empty() && stats.cachedBytes + bytes > stats.budget)
+			{
+				BodyEntry &entry = bodies.back();
+				stats.cachedBytes -= entry.body->size();
+				--stats.entries;
+				++stats.evictions;
+
+				bodyMap.erase(entry.key);
+				bodies.pop_back();
+			}
+		}
+
+		bool find(const BodyKey &key, Body &result)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			BodyMap::iterator it = bodyMap.find(key);
+			if(it == bodyMap.end())
+				return false;
+
+			bodies.splice(bodies.begin(), bodies, it->second);
+			result = it->second->body;
+			++stats.hits;
+			return true;
+		}
+
+		void insert(const BodyKey &key, const Body &body)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			unsigned int size = body->size();
+			if(size > stats.budget / 4)
+				return;
+
+			// Same file opened twice before either was read
+			if(bodyMap.find(key) != bodyMap.end())
+				return;
+
+			evict(size);
+
+			BodyEntry entry;
+			entry.key = key;
+			entry.body = body;
+			bodies.push_front(entry);
+			bodyMap[key] = bodies.begin();
+
+			stats.cachedBytes += size;
+			++stats.entries;
+		}
+	};
+
+	class BodyInputBuffer: public IInputStreamBuffer
+	{
+		Body body;
+		int position;
+
+	public:
+		BodyInputBuffer(const Body &body_)
+		:	body(body_),
+			position(0)
+		{
+		}
+
+		unsigned char popByte()
+		{
+			if(position >= getSize())
+				return 0;
+
+			return (*body)[position++];
+		}
+
+		bool isEof() const
+		{
+			return position >= getSize();
+		}
+
+		int getSize() const
+		{
+			return int(body->size());
+		}
+
+		void popBytes(char *target, int bytes)
+		{
+			int readBytes = popAvailableBytes(target, bytes);
+			for(int i = readBytes; i < bytes; ++i)
+				target[i] = 0;
+		}
+
+		int popAvailableBytes(char *target, int maxBytes)
+		{
+			int readSize = maxBytes;
+			if(position + readSize > getSize())
+				readSize = getSize() - position;
+			if(readSize <= 0)
+				return 0;
+
+			memcpy(target, &(*body)[position], readSize);
+			position += readSize;
+			return readSize;
+		}
+	};
+
+	// Pulls whole file from package buffer on first read and hands it to cache.
+	// Opening a file without reading it (existence checks) stays cheap.
+	class CachingInputBuffer: public IInputStreamBuffer
+	{
+		std::shared_ptr<IInputStreamBuffer> source;
+		std::shared_ptr<BodyStorage> storage;
+		BodyKey key;
+
+		Body body;
+		int size;
+		int position;
+
+		void load()
+		{
+			std::vector<unsigned char> *fileData = new std::vector<unsigned char>(size);
+			body.reset(fileData);
+			source->popBytes(reinterpret_cast<char *> (&(*fileData)[0]), size);
+			source.reset();
+
+			storage->insert(key, body);
+		}
+
+	public:
+		CachingInputBuffer(const std::shared_ptr<IInputStreamBuffer> &source_, const std::shared_ptr<BodyStorage> &storage_, const BodyKey &key_)
+		:	source(source_),
+			storage(storage_),
+			key(key_),
+			size(source_->getSize()),
+			position(0)
+		{
+		}
+
+		unsigned char popByte()
+		{
+			if(position >= size)
+				return 0;
+
+			if(!body)
+				load();
+
+			return (*body)[position++];
+		}
+
+		bool isEof() const
+		{
+			return position >= size;
+		}
+
+		int getSize() const
+		{
+			return size;
+		}
+
+		void popBytes(char *target, int bytes)
+		{
+			int readBytes = popAvailableBytes(target, bytes);
+			for(int i = readBytes; i < bytes; ++i)
+				target[i] = 0;
+		}
+
+		int popAvailableBytes(char *target, int maxBytes)
+		{
+			int readSize = maxBytes;
+			if(position + readSize > size)
+				readSize = size - position;
+			if(readSize <= 0)
+				return 0;
+
+			if(!body)
+				load();
+
+			memcpy(target, &(*body)[position], readSize);
+			position += readSize;
+			return readSize;
+		}
+	};
+
+	BodyKey createKey(const IFilePackage *package, const std::string &fileName)
+	{
+		// Packages with compressed entries find files case insensitively
+		BodyKey key(package, fileName);
+		for(unsigned int i = 0; i < key.second.size(); ++i)
+			key.second[i] = tolower(key.second[i]);
+
+		return key;
+	}
+
+} // end of unnamed namespace
+
+struct FileBodyCacheData
+{
+	std::shared_ptr<BodyStorage> storage;
+
+	FileBodyCacheData()
+	:	storage(new BodyStorage())
+	{
+	}
+};
+
+FileBodyCache::FileBodyCache()
+{
+	data = new FileBodyCacheData();
+}
+
+FileBodyCache::~FileBodyCache()
+{
+	assert(data);
+	delete data;
+}
+
+void FileBodyCache::setBudget(unsigned int bytes)
+{
+	BodyStorage &storage = *data->storage;
+	std::lock_guard<std::mutex> lock(storage.mutex);
+
+	storage.stats.budget = bytes;
+	storage.evict(0);
+}
+
+void FileBodyCache::clear()
+{
+	BodyStorage &storage = *data->storage;
+	std::lock_guard<std::mutex> lock(storage.mutex);
+
+	storage.bodies.clear();
+	storage.bodyMap.clear();
+	storage.stats.entries = 0;
+	storage.stats.cachedBytes = 0;
+}
+
+bool FileBodyCache::getFile(const IFilePackage *package, const std::string &fileName, InputStream &result)
+{
+	Body body;
+	if(!data->storage->find(createKey(package, fileName), body))
+		return false;
+
+	std::shared_ptr<IInputStreamBuffer> buffer(new BodyInputBuffer(body));
+	result.setBuffer(buffer);
+	return true;
+}
+
+InputStream FileBodyCache::cacheFile(const IFilePackage *package, const std::string &fileName, InputStream &stream)
+{
+	BodyStorage &storage = *data->storage;
+	{
+		std::lock_guard<std::mutex> lock(storage.mutex);
+		++storage.stats.misses;
+
+		if(stream.getSize() > int(storage.stats.budget / 4))
+			return stream;
+	}
+
+	std::shared_ptr<IInputStreamBuffer> buffer(new CachingInputBuffer(stream.getBuffer(), data->storage, createKey(package, fileName)));
+
+	InputStream result;
+	result.setBuffer(buffer);
+	return result;
+}
+
+FileBodyCacheStats FileBodyCache::getStats() const
+{
+	BodyStorage &storage = *data->storage;
+	std::lock_guard<std::mutex> lock(storage.mutex);
+
+	return storage.stats;
+}
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
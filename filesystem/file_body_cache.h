@@ -0,0 +1,62 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_FILESYSTEM_FILE_BODY_CACHE_H
+#define INCLUDED_FILESYSTEM_FILE_BODY_CACHE_H
+
+#include <string>
+#include "input_stream.h"
+
+namespace frozenbyte {
+namespace filesystem {
+
+class IFilePackage;
+struct FileBodyCacheData;
+
+struct FileBodyCacheStats
+{
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int evictions;
+
+	unsigned int entries;
+	unsigned int cachedBytes;
+	unsigned int budget;
+
+	FileBodyCacheStats()
+	:	hits(0),
+		misses(0),
+		evictions(0),
+		entries(0),
+		cachedBytes(0),
+		budget(0)
+	{
+	}
+};
+
+// Least recently used set of decompressed file bodies, keyed by package and entry.
+// Bodies are shared with open streams, evicting only drops the cache reference.
+
+class FileBodyCache
+{
+	FileBodyCacheData* data;
+
+public:
+	FileBodyCache();
+	~FileBodyCache();
+
+	// 0 disables caching. Files bigger than a quarter of budget are never cached.
+	void setBudget(unsigned int bytes);
+	void clear();
+
+	// Stream over cached body, if any
+	bool getFile(const IFilePackage *package, const std::string &fileName, InputStream &result);
+	// Wraps stream just opened from package. Body is added to cache when stream is first read.
+	InputStream cacheFile(const IFilePackage *package, const std::string &fileName, InputStream &stream);
+
+	FileBodyCacheStats getStats() const;
+};
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
+
+#endif
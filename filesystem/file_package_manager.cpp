@@ -10,10 +10,12 @@
 #include "file_package_manager.h"
 #include "empty_buffer.h"
 #include "file_list.h"
+#include "file_body_cache.h"
 #include <map>
 #include <assert.h>
 
 #include "../system/Logger.h"
+#include "../system/LoadTrace.h"
 
 #include "../util/Debug_MemoryManager.h"
 
@@ -37,12 +39,48 @@ struct FilePackageManagerData
 	PackageMap packages;
 	bool logNonExisting;
 
+	FileBodyCache bodyCache;
+	unsigned int bodyCacheBudget;
+
 	FilePackageManagerData()
-		: logNonExisting(true)
+		: logNonExisting(true),
+		bodyCacheBudget(0)
+	{
+	}
+
+	InputStream getFile(std::string fileName, FileAccessSource source)
 	{
+		if(!isFileAccessTraceEnabled())
+			return findFile(fileName, 0);
+
+		unsigned long long startTime = getFileAccessTraceTime();
+		const IFilePackage *package = 0;
+
+		InputStream result = findFile(fileName, &package);
+		if(package)
+			return traceFileAccess(result, fileName, package->getPackageName(), source, startTime);
+
+		traceMissingFile(fileName, source, startTime);
+		return result;
+	}
+
+	bool findFile(IFilePackage &package, const std::string &fileName, InputStream &result)
+	{
+		bool cached = bodyCacheBudget > 0 && package.hasCompressedFiles();
+		if(cached && bodyCache.getFile(&package, fileName, result))
+			return true;
+
+		result = package.getFile(fileName);
+		if(result.isEof())
+			return false;
+
+		if(cached)
+			result = bodyCache.cacheFile(&package, fileName, result);
+
+		return true;
 	}
 
-	InputStream getFile(std::string fileName)
+	InputStream findFile(std::string fileName, const IFilePackage **package)
 	{
 		for(unsigned int i = 0; i < fileName.size(); ++i)
 		{
@@ -52,9 +90,13 @@ struct FilePackageManagerData
 
 		for(PackageMap::reverse_iterator it = packages.rbegin(); it != packages.rend(); ++it)
 		{
-			InputStream result = it->second->getFile(fileName);
-			if(!result.isEof())
+			InputStream result;
+			if(findFile(*it->second, fileName, result))
+			{
+				if(package)
+					*package = it->second.get();
 				return result;
+			}
 		}
 
 		// Not found, try again all lowercase
@@ -66,9 +108,13 @@ struct FilePackageManagerData
 
 		for(PackageMap::reverse_iterator it = packages.rbegin(); it != packages.rend(); ++it)
 		{
-			InputStream result = it->second->getFile(fileName);
-			if(!result.isEof())
+			InputStream result;
+			if(findFile(*it->second, fileName, result))
+			{
+				if(package)
+					*package = it->second.get();
 				return result;
+			}
 		}
 
 		if (logNonExisting)
@@ -134,9 +180,10 @@ std::shared_ptr<IFileList> FilePackageManager::findFiles(const std::string &dir,
 	return result;
 }
 
-InputStream FilePackageManager::getFile(const std::string &fileName)
+InputStream FilePackageManager::getFile(const std::string &fileName, FileAccessSource source)
 {
-	return data->getFile(fileName);
+	LoadTraceScope trace("filesystem", fileName.c_str());
+	return data->getFile(fileName, source);
 }
 
 unsigned int FilePackageManager::getCrc(const std::string &fileName)
@@ -144,6 +191,22 @@ unsigned int FilePackageManager::getCrc(const std::string &fileName)
 	return data->getCrc(fileName);
 }
 
+void FilePackageManager::setFileCacheBudget(unsigned int bytes)
+{
+	data->bodyCacheBudget = bytes;
+	data->bodyCache.setBudget(bytes);
+}
+
+void FilePackageManager::clearFileCache()
+{
+	data->bodyCache.clear();
+}
+
+FileBodyCacheStats FilePackageManager::getFileCacheStats() const
+{
+	return data->bodyCache.getStats();
+}
+
 void FilePackageManager::setInputStreamErrorReporting(bool logNonExisting)
 {
 	// HACK: this goes directly to input file stream..
@@ -6,6 +6,8 @@
 #include <memory>
 
 #include "ifile_package.h"
+#include "file_access_trace.h"
+#include "file_body_cache.h"
 
 namespace frozenbyte {
 namespace filesystem {
@@ -23,9 +25,16 @@ public:
 
 	void addPackage(std::shared_ptr<IFilePackage> filePackage, int priority);	
 	std::shared_ptr<IFileList> findFiles(const std::string &dir, const std::string &extension, bool caseSensitive = false);
-	InputStream getFile(const std::string &fileName);
+	InputStream getFile(const std::string &fileName, FileAccessSource source = FileAccessStream);
 	unsigned int getCrc(const std::string &fileName);
 
+	// Decompressed bodies of files from compressed packages are kept
+	// in memory up to given budget (bytes). 0 disables. The manager starts
+	// with the cache disabled, the game sets its own budget at startup.
+	void setFileCacheBudget(unsigned int bytes);
+	void clearFileCache();
+	FileBodyCacheStats getFileCacheStats() const;
+
 	void setInputStreamErrorReporting(bool logNonExisting);
 
 	static FilePackageManager &getInstance();
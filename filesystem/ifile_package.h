@@ -18,6 +18,10 @@ public:
 	virtual void findFiles(const std::string &dir, const std::string &extension, IFileList &result) = 0;
 	virtual InputStream getFile(const std::string &fileName) = 0;
 	virtual unsigned int getCrc(const std::string &fileName) { return 0; }
+	// Shown in file access traces
+	virtual std::string getPackageName() const { return std::string(); }
+	// Decompressing is expensive enough for manager to cache file bodies
+	virtual bool hasCompressedFiles() const { return false; }
 };
 
 } // end of namespace filesystem
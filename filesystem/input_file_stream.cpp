@@ -30,13 +30,31 @@ struct InputFileStreamBufferData
 	:	stream(fileName.c_str(), std::ios::binary),
 		size(0)
 	{
+		// Size is taken once here, reading past end leaves the stream
+		// unable to seek and tell
 		if(stream)
 		{
-			std::filebuf *buffer = stream.rdbuf();
-			if(buffer)
-				size = buffer->in_avail();
+			stream.seekg(0, std::ios::end);
+			size = stream.tellg();
+			stream.seekg(0, std::ios::beg);
+			if(!stream || size < 0)
+			{
+				stream.clear();
+				size = 0;
+			}
 		}
 	}
+
+	// Short read hit end of file, keep only eof set so that
+	// the stream is not considered failed
+	void readPast(char *buffer, int bytes)
+	{
+		int readBytes = int(stream.gcount());
+		for(int i = readBytes; i < bytes; ++i)
+			buffer[i] = 0;
+
+		stream.clear(std::ios::eofbit);
+	}
 };
 
 InputFileStreamBuffer::InputFileStreamBuffer(const std::string &fileName)
@@ -69,16 +87,12 @@ bool InputFileStreamBuffer::isEof() const
 
 int InputFileStreamBuffer::getSize() const
 {
-	if(!data->stream)
+	if(!data->stream.is_open())
 		return 0;
 
 	// FIXME: causing a possible 2Gb limitation to file size here when casting to int!
 	// --jpk
-	std::ifstream::pos_type currPos = data->stream.tellg();
-	data->stream.seekg(0, std::ios::end);
-	std::ifstream::pos_type res = data->stream.tellg();
-	data->stream.seekg(currPos, std::ios::beg);
-	return int(res);
+	return int(data->size);
 }
 
 void InputFileStreamBuffer::popBytes(char *buffer, int bytes)
@@ -87,9 +101,26 @@ void InputFileStreamBuffer::popBytes(char *buffer, int bytes)
 	{
 		for(int i = 0; i < bytes; ++i)
 			buffer[i] = 0;
+
+		return;
 	}
 
 	data->stream.read(buffer, bytes);
+	if(!data->stream)
+		data->readPast(buffer, bytes);
+}
+
+int InputFileStreamBuffer::popAvailableBytes(char *buffer, int maxBytes)
+{
+	if(isEof())
+		return 0;
+
+	data->stream.read(buffer, maxBytes);
+	int readBytes = int(data->stream.gcount());
+	if(!data->stream)
+		data->readPast(buffer, readBytes);
+
+	return readBytes;
 }
 
 // HACK: ffs. this is needed to actually get some sense into the input stream error reportings...
@@ -23,6 +23,7 @@ public:
 	int getSize() const;
 
 	void popBytes(char *buffer, int bytes);
+	int popAvailableBytes(char *buffer, int maxBytes);
 };
 
 InputStream createInputFileStream(const std::string &fileName);
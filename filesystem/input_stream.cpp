@@ -12,7 +12,6 @@
 #endif
 
 #include "input_stream.h"
-#include "convert_type.h"
 
 #include <limits.h>
 
@@ -34,14 +33,35 @@ static_assert(CHAR_BIT == 8, "");
 namespace frozenbyte {
 namespace filesystem {
 namespace {
-	template<class Type>
-	void readFromStream(IInputStreamBuffer &buffer, Type &value)
+	inline bool isLittleEndian()
 	{
-		ConvertTo<Type> converter;
-		for(int i = 0; i < converter.getSize(); ++i)
-			converter.setByte(i, buffer.popByte());
+		const uint16_t value = 1;
+		return *reinterpret_cast<const unsigned char *> (&value) == 1;
+	}
 
-		value = converter.getValue();
+	// Data is stored little endian, swap in place on big endian hosts
+	template<int Size>
+	void fixByteOrder(void *buffer, int elements)
+	{
+		if(isLittleEndian())
+			return;
+
+		unsigned char *data = reinterpret_cast<unsigned char *> (buffer);
+		for(int i = 0; i < elements; ++i, data += Size)
+		{
+			for(int j = 0; j < Size / 2; ++j)
+			{
+				unsigned char temp = data[j];
+				data[j] = data[Size - 1 - j];
+				data[Size - 1 - j] = temp;
+			}
+		}
+	}
+
+	template<class Type>
+	void fixByteOrder(Type *buffer, int elements)
+	{
+		fixByteOrder<sizeof(Type)>(buffer, elements);
 	}
 } // end of unnamed namespace
 
@@ -56,136 +76,224 @@ InputStream::~InputStream()
 void InputStream::setBuffer(std::shared_ptr<IInputStreamBuffer> streamBuffer_)
 {
 	assert(streamBuffer_);
-	streamBuffer = streamBuffer_;
+	cache.reset(new Cache());
+	cache->streamBuffer = streamBuffer_;
+}
+
+std::shared_ptr<IInputStreamBuffer> InputStream::getBuffer() const
+{
+	assert(cache);
+	return cache->streamBuffer;
 }
 
 bool InputStream::isEof() const
 {
-	assert(streamBuffer);
-	return streamBuffer->isEof();
+	assert(cache);
+	return cache->position >= cache->end && cache->streamBuffer->isEof();
 }
 
 int InputStream::getSize() const
 {
-	assert(streamBuffer);
-	return streamBuffer->getSize();
+	assert(cache);
+	return cache->streamBuffer->getSize();
+}
+
+void InputStream::readBytesSlow(void *buffer, int bytes)
+{
+	Cache &c = *cache;
+	unsigned char *target = reinterpret_cast<unsigned char *> (buffer);
+
+	int available = c.end - c.position;
+	if(available > 0)
+	{
+		memcpy(target, c.data.data() + c.position, available);
+		c.position += available;
+		target += available;
+		bytes -= available;
+	}
+
+	// Large reads skip the cache
+	if(bytes >= Cache::CACHE_SIZE)
+	{
+		c.streamBuffer->popBytes(reinterpret_cast<char *> (target), bytes);
+		return;
+	}
+
+	if(c.data.empty())
+		c.data.resize(Cache::CACHE_SIZE);
+
+	c.position = 0;
+	c.end = c.streamBuffer->popAvailableBytes(reinterpret_cast<char *> (c.data.data()), Cache::CACHE_SIZE);
+
+	available = bytes < c.end ? bytes : c.end;
+	memcpy(target, c.data.data(), available);
+	c.position = available;
+
+	// Past end of data reads as zeros
+	if(available < bytes)
+		memset(target + available, 0, bytes - available);
 }
 
 InputStream &InputStream::read(std::string &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
 	uint16_t stringSize = 0;
 	this->read(stringSize);
 
 	value.resize(stringSize);
-	for(int i = 0; i < stringSize; ++i)
-		value[i] = streamBuffer->popByte();
+	if(stringSize > 0)
+		readBytes(&value[0], stringSize);
 
 	return *this;
 }
 
 InputStream &InputStream::read(bool &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	value = streamBuffer->popByte() != 0;
+	unsigned char byte = 0;
+	readBytes(&byte, 1);
+	value = byte != 0;
 	return *this;
 }
 
 InputStream &InputStream::read(unsigned char &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	value = streamBuffer->popByte();
+	readBytes(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(char &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	value = streamBuffer->popByte();
+	readBytes(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(signed char &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	value = streamBuffer->popByte();
+	readBytes(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(unsigned short &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	readFromStream(*streamBuffer, value);
+	readBytes(&value, sizeof(value));
+	fixByteOrder(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(signed short &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	readFromStream(*streamBuffer, value);
+	readBytes(&value, sizeof(value));
+	fixByteOrder(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(unsigned int &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	readFromStream(*streamBuffer, value);
+	readBytes(&value, sizeof(value));
+	fixByteOrder(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(signed int &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	readFromStream(*streamBuffer, value);
+	readBytes(&value, sizeof(value));
+	fixByteOrder(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(float &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	readFromStream(*streamBuffer, value);
+	readBytes(&value, sizeof(value));
+	fixByteOrder(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(double &value)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	readFromStream(*streamBuffer, value);
+	readBytes(&value, sizeof(value));
+	fixByteOrder(&value, 1);
 	return *this;
 }
 
 InputStream &InputStream::read(unsigned char *buffer, int elements)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	streamBuffer->popBytes(reinterpret_cast<char *> (buffer), elements);
+	readBytes(buffer, elements);
 	return *this;
 }
 
 InputStream &InputStream::read(char *buffer, int elements)
 {
-	assert(streamBuffer);
+	assert(cache);
 
-	streamBuffer->popBytes(buffer, elements);
+	readBytes(buffer, elements);
 	return *this;
 }
 
 InputStream &InputStream::read(unsigned short *buffer, int elements)
 {
-	assert(streamBuffer);
+	assert(cache);
+
+	readBytes(buffer, elements * sizeof(short));
+	fixByteOrder(buffer, elements);
+	return *this;
+}
+
+InputStream &InputStream::read(signed short *buffer, int elements)
+{
+	assert(cache);
+
+	readBytes(buffer, elements * sizeof(short));
+	fixByteOrder(buffer, elements);
+	return *this;
+}
+
+InputStream &InputStream::read(unsigned int *buffer, int elements)
+{
+	assert(cache);
+
+	readBytes(buffer, elements * sizeof(int));
+	fixByteOrder(buffer, elements);
+	return *this;
+}
+
+InputStream &InputStream::read(signed int *buffer, int elements)
+{
+	assert(cache);
+
+	readBytes(buffer, elements * sizeof(int));
+	fixByteOrder(buffer, elements);
+	return *this;
+}
+
+InputStream &InputStream::read(float *buffer, int elements)
+{
+	assert(cache);
 
-	streamBuffer->popBytes(reinterpret_cast<char *> (buffer), elements * sizeof(short));
+	readBytes(buffer, elements * sizeof(float));
+	fixByteOrder(buffer, elements);
 	return *this;
 }
 
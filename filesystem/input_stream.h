@@ -5,6 +5,8 @@
 
 #include <memory>
 #include <string>
+#include <vector>
+#include <string.h>
 
 namespace frozenbyte {
 namespace filesystem {
@@ -19,17 +21,62 @@ public:
 	virtual int getSize() const = 0;
 
 	virtual void popBytes(char *buffer, int bytes) = 0;
+
+	// Reads up to maxBytes, returns amount actually read (less only at end of data).
+	// Used to fill InputStream read ahead, buffers should override this with a block copy.
+	virtual int popAvailableBytes(char *buffer, int maxBytes)
+	{
+		int bytes = 0;
+		for(; bytes < maxBytes && !isEof(); ++bytes)
+			buffer[bytes] = popByte();
+
+		return bytes;
+	}
 };
 
 class InputStream
 {
-	std::shared_ptr<IInputStreamBuffer> streamBuffer;
+	// Read ahead shared by all copies of the stream, so that small reads
+	// are plain copies and the buffer interface is only used to refill it.
+	struct Cache
+	{
+		enum { CACHE_SIZE = 8 * 1024 };
+
+		std::shared_ptr<IInputStreamBuffer> streamBuffer;
+		std::vector<unsigned char> data;
+		int position;
+		int end;
+
+		Cache()
+		:	position(0),
+			end(0)
+		{
+		}
+	};
+
+	std::shared_ptr<Cache> cache;
+
+	void readBytesSlow(void *buffer, int bytes);
+
+	inline void readBytes(void *buffer, int bytes)
+	{
+		Cache &c = *cache;
+		if(c.end - c.position >= bytes)
+		{
+			memcpy(buffer, c.data.data() + c.position, bytes);
+			c.position += bytes;
+		}
+		else
+			readBytesSlow(buffer, bytes);
+	}
 
 public:
 	InputStream();
 	~InputStream();
 
 	void setBuffer(std::shared_ptr<IInputStreamBuffer> streamBuffer);
+	// Underlying buffer, for wrapping a stream that has not been read yet
+	std::shared_ptr<IInputStreamBuffer> getBuffer() const;
 	bool isEof() const;
 	int getSize() const;
 
@@ -56,6 +103,20 @@ public:
 	InputStream &read(char *buffer, int elements);
 	InputStream &read(unsigned short *buffer, int elements);
 
+	// Bulk readers for little endian data, byte order fixed in one pass if needed
+	InputStream &read(signed short *buffer, int elements);
+	InputStream &read(unsigned int *buffer, int elements);
+	InputStream &read(signed int *buffer, int elements);
+	InputStream &read(float *buffer, int elements);
+
+	// Arrays of float based types (VC2, VC3, QUAT, COL, ...)
+	template<class Vector>
+	InputStream &readFloatArray(Vector *buffer, int elements)
+	{
+		static_assert(sizeof(Vector) % sizeof(float) == 0, "Vector must consist of floats");
+		return read(reinterpret_cast<float *> (buffer), elements * int(sizeof(Vector) / sizeof(float)));
+	}
+
 	friend InputStream &operator >> (InputStream &, std::string &);
 	friend InputStream &operator >> (InputStream &, bool &);
 	friend InputStream &operator >> (InputStream &, unsigned char &);
@@ -60,7 +60,7 @@ FB_FILE *fb_fopen(const char *filename, const char *)
 
 	manager.setInputStreamErrorReporting(false);
 
-	InputStream stream = manager.getFile(filename);
+	InputStream stream = manager.getFile(filename, FileAccessFbFile);
 
 	manager.setInputStreamErrorReporting(true);
 
@@ -72,6 +72,10 @@ FB_FILE *fb_fopen(const char *filename, const char *)
 
 size_t fb_fread(void *buffer, size_t size, size_t count, FB_FILE *stream)
 {
+	// (buffer may be NULL, such as an empty vector's data)
+	if(size * count == 0)
+		return 0;
+
 	// always zero out the buffer
 	memset(buffer, 0, size * count);
 
@@ -92,6 +96,38 @@ size_t fb_fread(void *buffer, size_t size, size_t count, FB_FILE *stream)
 	return count;
 }
 
+size_t fb_fread_floats(float *buffer, size_t count, FB_FILE *stream)
+{
+	if(count == 0)
+		return 0;
+
+	if(!stream)
+	{
+		memset(buffer, 0, count * sizeof(float));
+		Logger::getInstance()->warning("fb_fread_floats - Attempt to read when no stream available.");
+		return 0;
+	}
+
+	stream->stream.read(buffer, int(count));
+	return count;
+}
+
+size_t fb_fread_ints(int *buffer, size_t count, FB_FILE *stream)
+{
+	if(count == 0)
+		return 0;
+
+	if(!stream)
+	{
+		memset(buffer, 0, count * sizeof(int));
+		Logger::getInstance()->warning("fb_fread_ints - Attempt to read when no stream available.");
+		return 0;
+	}
+
+	stream->stream.read(buffer, int(count));
+	return count;
+}
+
 size_t fb_fsize(FB_FILE *stream)
 {
 	if(!stream)
@@ -0,0 +1,323 @@
+
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#pragma warning(disable:4786)
+#endif
+
+#include "lz_package.h"
+#include "empty_buffer.h"
+#include "ifile_list.h"
+#include "detail/lz_codec.h"
+#include "detail/lz_package_format.h"
+#include "crc32.h"
+
+#include <stdio.h>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "../util/Debug_MemoryManager.h"
+
+namespace frozenbyte {
+namespace filesystem {
+
+	typedef std::map<std::string, lz::PackageEntry> LzFileList;
+
+	struct LzData
+	{
+		FILE *fileId;
+		LzFileList fileList;
+
+		// Buffers of different files share fileId, loaders may read from several threads
+		std::mutex readMutex;
+
+		LzData(const std::string &archive)
+		:	fileId(0)
+		{
+			fileId = fopen(archive.c_str(), "rb");
+			if(fileId && !findFiles())
+			{
+				fclose(fileId);
+				fileId = 0;
+				fileList.clear();
+			}
+		}
+
+		~LzData()
+		{
+			if(fileId)
+				fclose(fileId);
+		}
+
+		bool findFiles()
+		{
+			unsigned char header[lz::PACKAGE_HEADER_SIZE] = { 0 };
+			if(fread(header, 1, sizeof(header), fileId) != sizeof(header))
+				return false;
+			if(memcmp(header, lz::PACKAGE_MAGIC, 4) != 0)
+				return false;
+			if(lz::getUInt(header + 4) != lz::PACKAGE_VERSION)
+				return false;
+
+			unsigned int fileCount = lz::getUInt(header + 8);
+			unsigned int directoryOffset = lz::getUInt(header + 12);
+			unsigned int directorySize = lz::getUInt(header + 16);
+
+			// Whole directory in one read
+			std::vector<unsigned char> directory(directorySize);
+			if(directorySize == 0 || fseek(fileId, directoryOffset, SEEK_SET) != 0)
+				return false;
+			if(fread(&directory[0], 1, directorySize, fileId) != directorySize)
+				return false;
+
+			unsigned int position = 0;
+			for(unsigned int i = 0; i < fileCount; ++i)
+			{
+				if(position + 2 > directorySize)
+					return false;
+
+				unsigned int nameLength = directory[position] | (directory[position + 1] << 8);
+				position += 2;
+				if(position + nameLength + 17 > directorySize)
+					return false;
+
+				lz::PackageEntry entry;
+				entry.filename.assign(reinterpret_cast<const char *> (&directory[position]), nameLength);
+				position += nameLength;
+
+				entry.offset = lz::getUInt(&directory[position]);
+				entry.packedSize = lz::getUInt(&directory[position + 4]);
+				entry.size = lz::getUInt(&directory[position + 8]);
+				entry.crc = lz::getUInt(&directory[position + 12]);
+				entry.method = directory[position + 16];
+				position += 17;
+
+				if(entry.size == 0)
+					continue;
+
+				std::string filename = entry.filename;
+				convertLower(filename);
+				fileList[filename] = entry;
+			}
+
+			return true;
+		}
+
+		void findFiles(std::string dir, std::string extension, IFileList &result)
+		{
+			convertLower(dir);
+			convertLower(extension);
+
+			// Same rules as zip packages: only "*suffix" style patterns
+			if(extension.empty())
+				return;
+			if(extension[0] == '*')
+				extension.erase(0, 1);
+			if(extension.find('*') != extension.npos)
+				return;
+
+			LzFileList::iterator it = fileList.lower_bound(dir);
+			for(; it != fileList.end(); ++it)
+			{
+				const std::string &file = it->first;
+				if(file.compare(0, dir.size(), dir) != 0)
+					break;
+				if(file.size() <= extension.size())
+					continue;
+
+				std::string::size_type fileStart = file.find_last_of("/");
+				std::string::size_type index = file.size() - extension.size();
+				if(fileStart != file.npos && index <= fileStart)
+					continue;
+
+				if(file.compare(index, extension.size(), extension) == 0)
+					result.addFile(it->second.filename);
+			}
+		}
+
+		bool findFile(std::string file, LzFileList::iterator &it)
+		{
+			convertLower(file);
+
+			it = fileList.find(file);
+			if(it == fileList.end())
+				return false;
+
+			return true;
+		}
+
+		bool readFile(const lz::PackageEntry &entry, std::vector<unsigned char> &result)
+		{
+			result.resize(entry.size);
+
+			std::vector<unsigned char> packed;
+			{
+				std::lock_guard<std::mutex> lock(readMutex);
+				if(!fileId || fseek(fileId, entry.offset, SEEK_SET) != 0)
+					return false;
+
+				if(entry.method == lz::MethodStored)
+					return fread(&result[0], 1, entry.size, fileId) == entry.size;
+
+				packed.resize(entry.packedSize);
+				if(entry.packedSize == 0 || fread(&packed[0], 1, entry.packedSize, fileId) != entry.packedSize)
+					return false;
+			}
+
+			// Decompress outside the lock
+
+			if(!lz::decompress(&packed[0], entry.packedSize, &result[0], entry.size))
+				return false;
+
+#ifndef NDEBUG
+			assert(calculateCrc32(&result[0], entry.size) == entry.crc);
+#endif
+			return true;
+		}
+	};
+
+	class LzInputBuffer: public IInputStreamBuffer
+	{
+		std::shared_ptr<LzData> lzData;
+		std::vector<unsigned char> buffer;
+		int position;
+		bool loaded;
+
+		lz::PackageEntry fileData;
+
+		void fillBuffer()
+		{
+			loaded = true;
+
+			if(!lzData->readFile(fileData, buffer))
+			{
+				Logger::getInstance()->error("LzInputBuffer - Failed to read file from package.");
+				Logger::getInstance()->debug(fileData.filename.c_str());
+				std::fill(buffer.begin(), buffer.end(), 0);
+			}
+		}
+
+	public:
+		LzInputBuffer(std::shared_ptr<LzData> &lzData_, const lz::PackageEntry &fileData_)
+		:	lzData(lzData_),
+			position(0),
+			loaded(false),
+			fileData(fileData_)
+		{
+		}
+
+		unsigned char popByte()
+		{
+			if(position >= getSize())
+				return 0;
+
+			if(!loaded)
+				fillBuffer();
+
+			return buffer[position++];
+		}
+
+		bool isEof() const
+		{
+			if(position >= getSize())
+				return true;
+
+			return false;
+		}
+
+		int getSize() const
+		{
+			return int(fileData.size);
+		}
+
+		void popBytes(char *target, int bytes)
+		{
+			int readBytes = popAvailableBytes(target, bytes);
+			for(int i = readBytes; i < bytes; ++i)
+				target[i] = 0;
+		}
+
+		int popAvailableBytes(char *target, int maxBytes)
+		{
+			int readSize = maxBytes;
+			if(position + readSize > getSize())
+				readSize = getSize() - position;
+			if(readSize <= 0)
+				return 0;
+
+			if(!loaded)
+				fillBuffer();
+
+			memcpy(target, &buffer[position], readSize);
+			position += readSize;
+			return readSize;
+		}
+	};
+
+struct LzPackageData
+{
+	std::string archiveName;
+	std::shared_ptr<LzData> lzData;
+};
+
+LzPackage::LzPackage(const std::string &archiveName)
+{
+	data = new LzPackageData();
+	data->archiveName = archiveName;
+	data->lzData.reset(new LzData(archiveName));
+}
+
+LzPackage::~LzPackage()
+{
+	assert(data);
+	delete data;
+}
+
+void LzPackage::findFiles(const std::string &dir, const std::string &extension, IFileList &result)
+{
+	data->lzData->findFiles(dir, extension, result);
+}
+
+InputStream LzPackage::getFile(const std::string &fileName)
+{
+	InputStream inputStream;
+
+	LzFileList::iterator it;
+	if(data->lzData->findFile(fileName, it))
+	{
+		std::shared_ptr<LzInputBuffer> inputBuffer(new LzInputBuffer(data->lzData, it->second));
+		inputStream.setBuffer(inputBuffer);
+	}
+	else
+	{
+		std::shared_ptr<EmptyBuffer> inputBuffer(new EmptyBuffer());
+		inputStream.setBuffer(inputBuffer);
+	}
+
+	return inputStream;
+}
+
+unsigned int LzPackage::getCrc(const std::string &fileName)
+{
+	LzFileList::iterator it;
+	if(data->lzData->findFile(fileName, it))
+		return it->second.crc;
+
+	return 0;
+}
+
+std::string LzPackage::getPackageName() const
+{
+	return data->archiveName;
+}
+
+bool LzPackage::hasCompressedFiles() const
+{
+	return true;
+}
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
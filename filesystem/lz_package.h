@@ -0,0 +1,35 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_FILESYSTEM_LZ_PACKAGE
+#define INCLUDED_FILESYSTEM_LZ_PACKAGE
+
+#include "ifile_package.h"
+
+namespace frozenbyte {
+namespace filesystem {
+
+class IFileList;
+struct LzPackageData;
+
+// Package with per-file LZ compressed entries (see detail/lz_package_format.h).
+// Bigger than zip but decompresses several times faster.
+
+class LzPackage: public IFilePackage
+{
+	LzPackageData* data;
+
+public:
+	LzPackage(const std::string &archiveName);
+	~LzPackage();
+
+	void findFiles(const std::string &dir, const std::string &extension, IFileList &result);
+	InputStream getFile(const std::string &fileName);
+	unsigned int getCrc(const std::string &fileName);
+	std::string getPackageName() const;
+	bool hasCompressedFiles() const;
+};
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
+
+#endif
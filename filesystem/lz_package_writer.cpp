@@ -0,0 +1,214 @@
+
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#pragma warning(disable:4786)
+#endif
+
+#include "lz_package_writer.h"
+#include "detail/lz_codec.h"
+#include "detail/lz_package_format.h"
+#include "crc32.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <vector>
+#include "../util/Debug_MemoryManager.h"
+
+namespace frozenbyte {
+namespace filesystem {
+
+struct LzPackageWriterData
+{
+	std::vector<lz::PackageEntry> entries;
+
+	FILE *fp;
+	bool failed;
+	unsigned int offset;
+
+	unsigned int packedSize;
+	unsigned int unpackedSize;
+
+	LzPackageWriterData()
+	:	fp(0),
+		failed(false),
+		offset(0),
+		packedSize(0),
+		unpackedSize(0)
+	{
+	}
+
+	~LzPackageWriterData()
+	{
+		if(fp)
+			fclose(fp);
+	}
+
+	void writeHeader(unsigned int directoryOffset, unsigned int directorySize)
+	{
+		std::vector<unsigned char> header(lz::PACKAGE_MAGIC, lz::PACKAGE_MAGIC + 4);
+		lz::putUInt(header, lz::PACKAGE_VERSION);
+		lz::putUInt(header, entries.size());
+		lz::putUInt(header, directoryOffset);
+		lz::putUInt(header, directorySize);
+		assert(header.size() == lz::PACKAGE_HEADER_SIZE);
+
+		if(fwrite(&header[0], 1, header.size(), fp) != header.size())
+			failed = true;
+	}
+};
+
+LzPackageWriter::LzPackageWriter()
+{
+	data = new LzPackageWriterData();
+}
+
+LzPackageWriter::~LzPackageWriter()
+{
+	assert(data);
+	delete data;
+}
+
+bool LzPackageWriter::open(const std::string &archiveName)
+{
+	assert(!data->fp);
+
+	data->fp = fopen(archiveName.c_str(), "wb");
+	if(!data->fp)
+		return false;
+
+	// Placeholder, patched in finish()
+	data->writeHeader(0, 0);
+	data->offset = lz::PACKAGE_HEADER_SIZE;
+	return !data->failed;
+}
+
+bool LzPackageWriter::addFile(const std::string &packageName, const std::vector<unsigned char> &fileData)
+{
+	if(!data->fp || data->failed)
+		return false;
+	if(fileData.empty() || packageName.empty() || packageName.size() > 0xFFFF)
+		return false;
+
+	lz::PackageEntry entry;
+	entry.filename = packageName;
+	for(unsigned int i = 0; i < entry.filename.size(); ++i)
+	{
+		if(entry.filename[i] == '\\')
+			entry.filename[i] = '/';
+	}
+
+	entry.size = fileData.size();
+	entry.crc = calculateCrc32(&fileData[0], fileData.size());
+
+	std::vector<unsigned char> block(lz::compressBound(fileData.size()));
+	int packed = lz::compress(&fileData[0], fileData.size(), &block[0], block.size());
+	if(packed > 0 && packed < int(fileData.size()))
+	{
+		entry.method = lz::MethodLz;
+		block.resize(packed);
+	}
+	else
+	{
+		entry.method = lz::MethodStored;
+		block = fileData;
+	}
+
+	entry.packedSize = block.size();
+	entry.offset = data->offset;
+
+	if(fwrite(&block[0], 1, block.size(), data->fp) != block.size())
+	{
+		data->failed = true;
+		return false;
+	}
+
+	data->offset += entry.packedSize;
+	data->packedSize += entry.packedSize;
+	data->unpackedSize += entry.size;
+	data->entries.push_back(entry);
+	return true;
+}
+
+bool LzPackageWriter::addFile(const std::string &packageName, const std::string &sourceFile)
+{
+	std::ifstream stream(sourceFile.c_str(), std::ios::binary);
+	if(!stream)
+		return false;
+
+	stream.seekg(0, std::ios::end);
+	std::streamoff size = stream.tellg();
+	stream.seekg(0, std::ios::beg);
+	if(size <= 0)
+		return false;
+
+	std::vector<unsigned char> fileData((unsigned int) size);
+	stream.read(reinterpret_cast<char *> (&fileData[0]), size);
+	if(!stream)
+		return false;
+
+	return addFile(packageName, fileData);
+}
+
+int LzPackageWriter::getFileAmount() const
+{
+	return int(data->entries.size());
+}
+
+unsigned int LzPackageWriter::getPackedSize() const
+{
+	return data->packedSize;
+}
+
+unsigned int LzPackageWriter::getUnpackedSize() const
+{
+	return data->unpackedSize;
+}
+
+bool LzPackageWriter::finish()
+{
+	if(!data->fp)
+		return false;
+
+	std::vector<unsigned char> directory;
+	for(unsigned int i = 0; i < data->entries.size(); ++i)
+	{
+		const lz::PackageEntry &entry = data->entries[i];
+		directory.push_back((unsigned char) (entry.filename.size() & 0xFF));
+		directory.push_back((unsigned char) (entry.filename.size() >> 8));
+		directory.insert(directory.end(), entry.filename.begin(), entry.filename.end());
+
+		lz::putUInt(directory, entry.offset);
+		lz::putUInt(directory, entry.packedSize);
+		lz::putUInt(directory, entry.size);
+		lz::putUInt(directory, entry.crc);
+		directory.push_back(entry.method);
+	}
+
+	if(!data->failed && !directory.empty())
+	{
+		if(fwrite(&directory[0], 1, directory.size(), data->fp) != directory.size())
+			data->failed = true;
+	}
+
+	// Patch file count and directory location into header
+	if(!data->failed)
+	{
+		if(fseek(data->fp, 0, SEEK_SET) == 0)
+			data->writeHeader(data->offset, directory.size());
+		else
+			data->failed = true;
+	}
+
+	if(fclose(data->fp) != 0)
+		data->failed = true;
+	data->fp = 0;
+
+	return !data->failed;
+}
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
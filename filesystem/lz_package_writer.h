@@ -0,0 +1,44 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_FILESYSTEM_LZ_PACKAGE_WRITER
+#define INCLUDED_FILESYSTEM_LZ_PACKAGE_WRITER
+
+#include <string>
+#include <vector>
+
+namespace frozenbyte {
+namespace filesystem {
+
+struct LzPackageWriterData;
+
+// Builds packages readable with LzPackage.
+// Entries are written to the archive in the order they were added, as they
+// are added. Only the directory is kept in memory until finish().
+
+class LzPackageWriter
+{
+	LzPackageWriterData* data;
+
+public:
+	LzPackageWriter();
+	~LzPackageWriter();
+
+	bool open(const std::string &archiveName);
+
+	// Entries that do not compress are stored as is
+	bool addFile(const std::string &packageName, const std::vector<unsigned char> &fileData);
+	bool addFile(const std::string &packageName, const std::string &sourceFile);
+
+	int getFileAmount() const;
+	unsigned int getPackedSize() const;
+	unsigned int getUnpackedSize() const;
+
+	// Writes directory and closes the archive.
+	// Returns false if any write failed.
+	bool finish();
+};
+
+} // end of namespace filesystem
+} // end of namespace frozenbyte
+
+#endif
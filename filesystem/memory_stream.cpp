@@ -67,5 +67,17 @@ void MemoryStreamBuffer::popBytes(char *buffer, int bytes)
 		buffer[i] = popByte();
 }
 
+int MemoryStreamBuffer::popAvailableBytes(char *buffer, int maxBytes)
+{
+	int bytes = 0;
+	for(; bytes < maxBytes && !data->buffer.empty(); ++bytes)
+	{
+		buffer[bytes] = data->buffer.front();
+		data->buffer.pop();
+	}
+
+	return bytes;
+}
+
 } // end of namespace filesystem
 } // end of namespace frozenbyte
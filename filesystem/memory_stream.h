@@ -25,6 +25,7 @@ public:
 
 	void putByte(unsigned char byte);
 	void popBytes(char *buffer, int bytes);
+	int popAvailableBytes(char *buffer, int maxBytes);
 };
 
 } // end of namespace filesystem
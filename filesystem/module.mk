@@ -6,7 +6,9 @@ d              := $(dir)
 FILES:=file_list.cpp file_package_manager.cpp input_file_stream.cpp \
        input_stream.cpp input_stream_wrapper.cpp memory_stream.cpp \
        output_file_stream.cpp output_stream.cpp standard_package.cpp \
-       zip_package.cpp rle_packed_file_wrapper.cpp
+       zip_package.cpp rle_packed_file_wrapper.cpp \
+       lz_package.cpp lz_package_writer.cpp detail/lz_codec.cpp \
+       crc32.cpp file_access_trace.cpp file_body_cache.cpp
 
 SRC_$(d):=$(addprefix $(d)/,$(FILES))
 
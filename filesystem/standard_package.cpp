@@ -10,8 +10,14 @@
 #include "standard_package.h"
 #include "input_file_stream.h"
 #include "ifile_list.h"
+#include "crc32.h"
 #include "../editor/FindFileWrapper.h"
 #include <string>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "../util/Debug_MemoryManager.h"
 
@@ -55,14 +61,64 @@ void iterateDir(const std::string &dir, const std::string &extension, IFileList
 	}
 }
 
+struct CrcInfo
+{
+	time_t modifyTime;
+	long size;
+	unsigned int crc;
+
+	CrcInfo()
+	:	modifyTime(0),
+		size(0),
+		crc(0)
+	{
+	}
+};
+
+typedef std::map<std::string, CrcInfo> CrcCache;
+
+bool calculateFileCrc(const std::string &fileName, unsigned int &crc)
+{
+	FILE *fp = fopen(fileName.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	static const int BUFFER_SIZE = 64 * 1024;
+	std::vector<unsigned char> buffer(BUFFER_SIZE);
+
+	crc = 0;
+	for(;;)
+	{
+		size_t bytes = fread(&buffer[0], 1, BUFFER_SIZE, fp);
+		if(bytes == 0)
+			break;
+
+		crc = calculateCrc32(&buffer[0], int(bytes), crc);
+	}
+
+	bool ok = ferror(fp) == 0;
+	fclose(fp);
+	return ok;
+}
+
 } // unnamed
 
+struct StandardPackageData
+{
+	// (files may be read from loader threads too)
+	std::mutex crcMutex;
+	CrcCache crcCache;
+};
+
 StandardPackage::StandardPackage()
 {
+	data = new StandardPackageData();
 }
 
 StandardPackage::~StandardPackage()
 {
+	assert(data);
+	delete data;
 }
 
 void StandardPackage::findFiles(const std::string &dir, const std::string &extension, IFileList &result)
@@ -77,12 +133,47 @@ InputStream StandardPackage::getFile(const std::string &fileName)
 
 unsigned int StandardPackage::getCrc(const std::string &fileName)
 {
-	InputStream strm = createInputFileStream(fileName);
-	if(strm.getSize() != 0)
+	struct stat fileInfo;
+	if(stat(fileName.c_str(), &fileInfo) != 0 || fileInfo.st_size == 0)
+		return 0;
+
+#ifdef PROJECT_SURVIVOR_DEMO
+	// Demo builds use this marker to refuse loose (modified) data files
+	return 0xFFFFFFFF;
+#else
+	{
+		std::lock_guard<std::mutex> lock(data->crcMutex);
+		CrcCache::iterator it = data->crcCache.find(fileName);
+		if(it != data->crcCache.end())
+		{
+			const CrcInfo &info = it->second;
+			if(info.modifyTime == fileInfo.st_mtime && info.size == long(fileInfo.st_size))
+				return info.crc;
+		}
+	}
+
+	// Not locked while reading, another thread may count the same file
+	unsigned int crc = 0;
+	bool ok = calculateFileCrc(fileName, crc);
+
+	std::lock_guard<std::mutex> lock(data->crcMutex);
+	if(!ok)
 	{
-		return 0xFFFFFFFF;
+		data->crcCache.erase(fileName);
+		return 0;
 	}
-	return 0;
+
+	CrcInfo &info = data->crcCache[fileName];
+	info.modifyTime = fileInfo.st_mtime;
+	info.size = long(fileInfo.st_size);
+	info.crc = crc;
+	return crc;
+#endif
+}
+
+std::string StandardPackage::getPackageName() const
+{
+	return ".";
 }
 
 } // end of namespace filesystem
@@ -9,16 +9,21 @@ namespace frozenbyte {
 namespace filesystem {
 
 class IFileList;
+struct StandardPackageData;
 
 class StandardPackage: public IFilePackage
 {
+	StandardPackageData* data;
+
 public:
 	StandardPackage();
 	~StandardPackage();
 
 	void findFiles(const std::string &dir, const std::string &extension, IFileList &result);
 	InputStream getFile(const std::string &fileName);
+	// Computed on first request and cached by file path, size and modification time
 	unsigned int getCrc(const std::string &fileName);
+	std::string getPackageName() const;
 };
 
 } // end of namespace filesystem
@@ -20,6 +20,7 @@
 #endif
 
 #include <map>
+#include <mutex>
 #include <stack>
 #include <vector>
 #include "../util/Debug_MemoryManager.h"
@@ -148,6 +149,9 @@ namespace filesystem {
 		unzFile fileId;
 		ZipFileList fileList;
 
+		// Current file state lives in fileId, reads from several threads take turns
+		std::mutex readMutex;
+
 		ZipData(const std::string &archive)
 		:	fileId(0)
 		{
@@ -440,6 +444,7 @@ namespace filesystem {
 			if (buffer.size() < readSize)
 				buffer.resize(readSize);
 
+			std::lock_guard<std::mutex> lock(zipData->readMutex);
 			if(unzGoToFilePos(zipData->fileId, &fileData.filePosition) != UNZ_OK)
 				return;
 			if(unzOpenCurrentFile(zipData->fileId) != UNZ_OK)
@@ -502,10 +507,30 @@ namespace filesystem {
 			return fileData.size;
 		}
 
-		void popBytes(char *buffer, int bytes)
+		void popBytes(char *target, int bytes)
 		{
-			for(int i = 0; i < bytes; ++i)
-				buffer[i] = popByte();
+			int readBytes = popAvailableBytes(target, bytes);
+			for(int i = readBytes; i < bytes; ++i)
+				target[i] = 0;
+		}
+
+		int popAvailableBytes(char *target, int maxBytes)
+		{
+			int readSize = maxBytes;
+			if(position + readSize > fileData.size)
+				readSize = fileData.size - position;
+			if(readSize <= 0)
+				return 0;
+
+			if(position == 0)
+			{
+				buffer.reserve(fileData.size);
+				fillBuffer();
+			}
+
+			memcpy(target, &buffer[position], readSize);
+			position += readSize;
+			return readSize;
 		}
 	};
 
@@ -575,5 +600,15 @@ unsigned int ZipPackage::getCrc(const std::string &fileName)
 	return 0;
 }
 
+std::string ZipPackage::getPackageName() const
+{
+	return data->archiveName;
+}
+
+bool ZipPackage::hasCompressedFiles() const
+{
+	return true;
+}
+
 } // end of namespace filesystem
 } // end of namespace frozenbyte
@@ -22,6 +22,8 @@ public:
 	void findFiles(const std::string &dir, const std::string &extension, IFileList &result);
 	InputStream getFile(const std::string &fileName);
 	unsigned int getCrc(const std::string &fileName);
+	std::string getPackageName() const;
+	bool hasCompressedFiles() const;
 };
 
 } // end of namespace filesystem
@@ -6,6 +6,7 @@
 
 #include "GameObject.h"
 #include "../ui/VisualObject.h"
+#include "../container/SlotMap.h"
 
 
 namespace ui
@@ -72,6 +73,11 @@ namespace game
     ui::VisualObject *visualObject;
 
 		StaticPhysicsObject *physicsObject;
+
+    // handle in BuildingList
+    SlotMapHandle listHandle;
+
+    friend class BuildingList;
   };
 
 }
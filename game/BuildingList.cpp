@@ -11,16 +11,12 @@ namespace game
 
   BuildingList::BuildingList()
   {
-    allBuildings = new LinkedList();
+    allBuildings = new LinkedSlotMap<Building>();
   }
 
   // NOTE, does not delete the buildings inside this but just the list of them
   BuildingList::~BuildingList()
   {
-    while (!allBuildings->isEmpty())
-    {
-      allBuildings->popLast();
-    }
     delete allBuildings;
   }
 
@@ -37,31 +33,35 @@ namespace game
 
   int BuildingList::getAllBuildingAmount()
   {
-    // TODO, optimize, not thread safe! (caller may not be using iterator)
-    int count = 0;
-    allBuildings->resetIterate();
-    while (allBuildings->iterateAvailable())
-    {
-      allBuildings->iterateNext();
-      count++;
-    }
-    return count;
+    return allBuildings->getAmount();
   }
 
   LinkedList *BuildingList::getAllBuildings()
   {
-    return allBuildings;
+    return allBuildings->getLinkedList();
   }
 
-  void BuildingList::addBuilding(Building *building)
+  const SlotMap<Building> *BuildingList::getAllBuildingSlots()
   {
-    allBuildings->append(building);
+    return allBuildings->getSlotMap();
+  }
+
+  SlotMapHandle BuildingList::addBuilding(Building *building)
+  {
+    building->listHandle = allBuildings->insert(building);
+    return building->listHandle;
   }
 
   // does not delete the building, just removes it from the list
   void BuildingList::removeBuilding(Building *building)
   {
-    allBuildings->remove(building);
+    allBuildings->erase(building->listHandle);
+    building->listHandle = SlotMapHandle();
+  }
+
+  Building *BuildingList::getBuildingBySlotHandle(const SlotMapHandle &handle)
+  {
+    return allBuildings->get(handle);
   }
 
 }
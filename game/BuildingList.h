@@ -3,6 +3,7 @@
 #define BUILDINGLIST_H
 
 #include "../container/LinkedList.h"
+#include "../container/SlotMap.h"
 #include "GameObject.h"
 #include "Building.h"
 
@@ -32,11 +33,18 @@ namespace game
 
     LinkedList *getAllBuildings();
 
-    void addBuilding(Building *building);
+    // same buildings in the same order, without the list nodes
+    const SlotMap<Building> *getAllBuildingSlots();
+
+    // returns the handle in getAllBuildingSlots
+    SlotMapHandle addBuilding(Building *building);
     void removeBuilding(Building *building);
 
+    // NULL if the building has been removed
+    Building *getBuildingBySlotHandle(const SlotMapHandle &handle);
+
   private:
-    LinkedList *allBuildings;
+    LinkedSlotMap<Building> *allBuildings;
   };
 
 }
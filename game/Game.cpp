@@ -4,6 +4,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4786)
@@ -81,8 +84,12 @@
 #include "UnitSelections.h"
 #include "UnitSpawner.h"
 #include "UnitVisibilityChecker.h"
+#include "LineOfSightCache.h"
+#include "UnitCollisionBroadphase.h"
+#include "JobSystem.h"
 #include "Checkpoints.h"
 #include "PartTypeAvailabilityList.h"
+#include "../container/SlotMap.h"
 #include "../util/AI_PathFind.h"
 #include "UnitLevelAI.h"
 #include "scripting/GameScripting.h"
@@ -115,10 +122,15 @@
 #include "GameProfiles.h"
 #include "GameProfilesEnumeration.h"
 #include "../filesystem/input_stream_wrapper.h"
+#include "../filesystem/file_package_manager.h"
+#include "../filesystem/ifile_list.h"
 #include "../util/fb_assert.h"
 #include "../util/Debug_MemoryManager.h"
 #include "AlienSpawner.h"
 #include "GameStats.h"
+#include "LoadTaskGraph.h"
+#include "../util/TextureCache.h"
+#include "../system/LoadTrace.h"
 #include "../util/FBCopyFile.h"
 #include "../system/FileTimestampChecker.h"
 #include "physics/GamePhysics.h"
@@ -315,6 +327,64 @@ namespace {
 
 		return result;
 	}
+
+	// Reads mission directory files through the package manager on load
+	// workers, so compressed files are already unpacked in the file cache
+	// when the loading stages get to them.
+	class MissionPreload
+	{
+	public:
+		MissionPreload()
+			: preloadedBytes(0),
+			cancelled(false)
+		{
+		}
+
+		void findFiles(const char *missionDir)
+		{
+			if (missionDir == NULL)
+				return;
+
+			std::shared_ptr<filesystem::IFileList> list = filesystem::FilePackageManager::getInstance().findFiles(missionDir, "*");
+			filesystem::getAllFiles(*list, missionDir, files, true);
+		}
+
+		void readFiles(int first, int step)
+		{
+			filesystem::FilePackageManager &manager = filesystem::FilePackageManager::getInstance();
+
+			// leave room for everything else loaded meanwhile
+			unsigned int budget = manager.getFileCacheStats().budget;
+			unsigned int maxBytes = budget / 2;
+
+			std::vector<unsigned char> buffer(64 * 1024);
+			for (int i = first; i < (int)files.size(); i += step)
+			{
+				if (cancelled)
+					break;
+
+				filesystem::InputStream stream = manager.getFile(files[i]);
+				unsigned int size = (unsigned int)stream.getSize();
+				if (size == 0 || size > budget / 4)
+					continue;
+				if (preloadedBytes.fetch_add(size) + size > maxBytes)
+					break;
+
+				while (!stream.isEof() && !cancelled)
+					stream.read(&buffer[0], (int)buffer.size());
+			}
+		}
+
+		void cancel()
+		{
+			cancelled = true;
+		}
+
+	private:
+		std::vector<std::string> files;
+		std::atomic<unsigned int> preloadedBytes;
+		std::atomic<bool> cancelled;
+	};
 }
 
 	class SaveParentEntry
@@ -380,6 +450,10 @@ namespace {
 		}
 
 		visibilityChecker = new UnitVisibilityChecker(this);
+		losCache = new LineOfSightCache();
+		unitBroadphase = new UnitCollisionBroadphase(this);
+
+		jobSystem = NULL;
 
 		currentMap = NULL;
 
@@ -529,7 +603,10 @@ namespace {
 		clawController->setGame(this);
 		gamephysics_clawController = clawController;
 #endif
-		this->physics = new GamePhysics();
+		{
+			LoadTraceScope trace("physics", "physics init");
+			this->physics = new GamePhysics();
+		}
 
 #ifdef PHYSICS_ODE
 		odeModelCooker.setStorage(this->visualObjectModelStorage);
@@ -537,6 +614,7 @@ namespace {
 
 		tracking::TrackableUnifiedHandleObject::setGame(this);
 		objectTracker = new tracking::ObjectTracker();
+		objectTracker->setGameRandom(gameRandom);
 		unifiedHandleManager = new UnifiedHandleManager(this);
 
 		std::vector<tracking::ITrackableUnifiedHandleObjectImplementationManager *> burnableImplementations;
@@ -605,6 +683,9 @@ namespace {
 		delete orderQueue;
 
 		delete visibilityChecker;
+		delete losCache;
+		delete unitBroadphase;
+		delete jobSystem;
 
 		if (decorationManager != NULL)
 		{
@@ -1017,6 +1098,7 @@ static VC3 last_attemptedPos = VC3(0,0,0);
 					// NEW: visibility check run only every 2nd tick!
 					if ((gameTimer & 1) == 0)
 					{
+						losCache->setLifetime(SimpleOptions::getInt(DH_OPT_I_LOS_CACHE_LIFETIME));
 #ifdef _DEBUG
 #ifdef FROZENBYTE_DEBUG_MEMORY
 						frozenbyte::debug::debugSetAllocationInfo("visibility check");
@@ -1063,15 +1145,25 @@ static VC3 last_attemptedPos = VC3(0,0,0);
 
 					UnitPhysicsUpdater::startStats();
 
-					LinkedList *ulist = units->getAllUnits();
-					LinkedListIterator unititer = LinkedListIterator(ulist);
+					// find pushes for overlapping units, actCollisions applies
+					// them instead of doing its own pushing
+					if (SimpleOptions::getBool(DH_OPT_B_UNIT_COLLISION_BROADPHASE))
+					{
+						unitBroadphase->run();
+					}
+
+					const SlotMap<Unit> *uslots = units->getAllUnitSlots();
+
+					// (units spawned while acting get their turn too, as they did
+					// with the list iterator)
+					SlotMap<Unit>::Iterator unititer(uslots, true);
 					while (unititer.iterateAvailable())
 					{
 						bool lessActing = false;
 
 						unitActNum++;
 
-						Unit *unit = (Unit *)unititer.iterateNext();
+						Unit *unit = unititer.iterateNext();
 						if (unit->isActive())
 						{
 							// has been in acting range? (no act check counter value set)
@@ -1232,6 +1324,12 @@ static VC3 last_attemptedPos = VC3(0,0,0);
 						}
 					}
 
+					// pushes of units that did not act (or did not reach actCollisions)
+					if (SimpleOptions::getBool(DH_OPT_B_UNIT_COLLISION_BROADPHASE))
+					{
+						unitBroadphase->applyRemainingPushes();
+					}
+
 					UnitPhysicsUpdater::endStats();
 /*
 Logger::getInstance()->error("Units acted:");
@@ -1244,13 +1342,12 @@ Logger::getInstance()->error(int2str(slowNoActAmount));
 //					int projAmount = 0;
 
 					// move projectiles
-					LinkedList *projlist = projectiles->getAllProjectiles();
-					// projectiles may be deleted during combat, thus need to
-					// use safe iterator!
-					SafeLinkedListIterator projiter = SafeLinkedListIterator(projlist);
+					// projectiles may be deleted during combat (the slot map
+					// iterator skips them, no list copy needed)
+					SlotMap<Projectile>::Iterator projiter(projectiles->getAllProjectileSlots());
 					while (projiter.iterateAvailable())
 					{
-						Projectile *proj = (Projectile *)projiter.iterateNext();
+						Projectile *proj = projiter.iterateNext();
 						ProjectileActor pa = ProjectileActor(this);
 						pa.act(proj);
 //						projAmount++;
@@ -1913,193 +2010,300 @@ bool game_in_start_combat = false;
 			gameUI->closeCommandWindow(p);
 		}
 
-		gameUI->setRenderMap(gameMap, currentMap);
+		// Mission load stages, each declaring the stages whose results it
+		// needs. Anything touching the renderer, scripts or physics runs on
+		// this thread. Workers load the obstacle/area map and the cover map
+		// and preload mission files meanwhile. Worker tasks touch only their
+		// own map data, the main thread applies the results afterwards.
+		// (preloading only helps compressed packages, which keep the
+		// unpacked files in the file body cache. zip reads are serialized
+		// per package, loose files just end up in the OS file cache.)
+		unsigned char *clipMap = NULL;
+		bool loadedCache = false;
 
-		SHOW_LOADING_BAR(45);
+		LoadTaskGraph loadGraph(LoadTaskGraph::getDefaultWorkerAmount());
 
-		gameScene = new GameScene(gameUI->storm3d, gameUI->scene, 
-			gameUI->renderTerrain, gameMap);
-		gameUI->getVisualEffectManager()->setGameScene(gameScene);
+		MissionPreload preload;
+		if (filesystem::FilePackageManager::getInstance().getFileCacheStats().budget > 0)
+		{
+			int preloadListTask = loadGraph.addTask("preload file list", LoadTaskGraph::TASK_THREAD_WORKER,
+				[&]() { preload.findFiles(currentMap); });
 
-		// TODO: this size should be halved!
-		units->recreateLists(VC2(gameMap->getScaledSizeX(), gameMap->getScaledSizeY()));
+			int preloadAmount = LoadTaskGraph::getDefaultWorkerAmount();
+			for (int i = 0; i < preloadAmount; i++)
+			{
+				int task = loadGraph.addTask("preload files", LoadTaskGraph::TASK_THREAD_WORKER,
+					[&preload, i, preloadAmount]() { preload.readFiles(i, preloadAmount); });
+				loadGraph.addDependency(task, preloadListTask);
+			}
+		}
 
-		SHOW_LOADING_BAR(50);
+		int terrainTask = loadGraph.addTask("terrain", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			gameUI->setRenderMap(gameMap, currentMap);
 
-		assert(particleSpawnerManager == NULL);
-		particleSpawnerManager = new ParticleSpawnerManager(this);
+			SHOW_LOADING_BAR(45);
+		});
 
-		formations.setGameScene(gameScene);
+		int sceneTask = loadGraph.addTask("game scene", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			gameScene = new GameScene(gameUI->storm3d, gameUI->scene, 
+				gameUI->renderTerrain, gameMap);
+			gameUI->getVisualEffectManager()->setGameScene(gameScene);
 
-		// try to load obstaclemap and areamap
-		gameMap->loadObstacleAndAreaMap(gameScene->getPathFinder());
+			// TODO: this size should be halved!
+			units->recreateLists(VC2(gameMap->getScaledSizeX(), gameMap->getScaledSizeY()));
 
-		decorationManager = new DecorationManager();
-		waterManager = new WaterManager();
-		lightBlinker = new LightBlinker(this, false);
-		outdoorLightBlinker = new LightBlinker(this, true);
-		gameUI->setCamerasWaterManager();
+			SHOW_LOADING_BAR(50);
 
-		map.reset(new Map(*this));
-		map->setMission(currentMap);
+			assert(particleSpawnerManager == NULL);
+			particleSpawnerManager = new ParticleSpawnerManager(this);
 
-		SHOW_LOADING_BAR(55);
+			formations.setGameScene(gameScene);
+		});
+		loadGraph.addDependency(sceneTask, terrainTask);
 
-		if (script == NULL)
+		// pure map data, overlaps with the managers below
+		int obstacleTask = loadGraph.addTask("obstacle/area map", LoadTaskGraph::TASK_THREAD_WORKER, [&]()
 		{
-			Logger::getInstance()->warning("Game::startCombat - No mission script set.");
-		}
-		gameScripting->runMissionScript(script, "begin");
+			// try to load obstaclemap and areamap
+			gameMap->loadObstacleAndAreaMap(gameScene->getPathFinder());
+		});
+		loadGraph.addDependency(obstacleTask, sceneTask);
 
-		SHOW_LOADING_BAR(56);
+		// cover map file (recreated later by "cover map" if out of date)
+		int coverLoadTask = loadGraph.addTask("cover map file", LoadTaskGraph::TASK_THREAD_WORKER, [&]()
+		{
+			gameMap->loadCoverMap();
+		});
+		loadGraph.addDependency(coverLoadTask, terrainTask);
 
-		// set visual objects for buildings
-		// make obstacle maps for them
+		int managersTask = loadGraph.addTask("managers", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			decorationManager = new DecorationManager();
+			waterManager = new WaterManager();
+			lightBlinker = new LightBlinker(this, false);
+			outdoorLightBlinker = new LightBlinker(this, true);
+			gameUI->setCamerasWaterManager();
 
-		// fill area map with terrain material
-		gameScene->initTerrainMaterial();
+			map.reset(new Map(*this));
+			map->setMission(currentMap);
 
-		SHOW_LOADING_BAR(57);
+			SHOW_LOADING_BAR(55);
+		});
+		loadGraph.addDependency(managersTask, terrainTask);
 
-#ifdef LEGACY_FILES
-		// nop
-#else
-		gameScripting->runMissionScript("spotlight_init", "main");
+		int beginScriptTask = loadGraph.addTask("mission begin script", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			// obstacle/area map was loaded on a worker, pass it to terrain raytrace
+			gameMap->applyObstacleHeightChanges();
+
+#ifndef PROJECT_SURVIVOR
+			if (!gameMap->isObstacleAndAreaMapLoaded())
+			{
+				LoadingMessage::showLoadingMessage(getLocaleGuiString("gui_loading_regen_bin_obstaclemap"));
+			}
 #endif
 
-		gameScripting->runMissionScript(buildingsScript, "create");
+			if (script == NULL)
+			{
+				Logger::getInstance()->warning("Game::startCombat - No mission script set.");
+			}
+			gameScripting->runMissionScript(script, "begin");
+
+			SHOW_LOADING_BAR(56);
+		});
+		loadGraph.addDependency(beginScriptTask, obstacleTask);
+		loadGraph.addDependency(beginScriptTask, coverLoadTask);
+		loadGraph.addDependency(beginScriptTask, managersTask);
 
-		SHOW_LOADING_BAR(58);
+		int terrainMaterialTask = loadGraph.addTask("terrain material", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			// set visual objects for buildings
+			// make obstacle maps for them
+
+			// fill area map with terrain material
+			gameScene->initTerrainMaterial();
 
-		unsigned char *clipMap = gameScene->generateTerrainTexturing();
+			SHOW_LOADING_BAR(57);
+		});
+		loadGraph.addDependency(terrainMaterialTask, beginScriptTask);
 
-		SHOW_LOADING_BAR(60);
+		int buildingsTask = loadGraph.addTask("buildings", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+#ifdef LEGACY_FILES
+			// nop
+#else
+			gameScripting->runMissionScript("spotlight_init", "main");
+#endif
 
-		// require physics cache recreate?
-		std::string obstFilename = std::string(currentMap) + std::string("/scene.bin");
-		std::string cacheFilename = std::string(currentMap) + std::string("/pcache.bin");
-		bool needPhysCacheRecreate = !FileTimestampChecker::isFileUpToDateComparedTo(cacheFilename.c_str(), obstFilename.c_str());
+			gameScripting->runMissionScript(buildingsScript, "create");
 
-		bool loadedCache = false;
+			SHOW_LOADING_BAR(58);
+		});
+		loadGraph.addDependency(buildingsTask, terrainMaterialTask);
 
-		if (SimpleOptions::getBool(DH_OPT_B_FORCE_PHYSICS_CACHE_RECREATE)
-			|| (SimpleOptions::getBool(DH_OPT_B_AUTO_PHYSICS_CACHE_RECREATE) && needPhysCacheRecreate))
+		int texturingTask = loadGraph.addTask("terrain texturing", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
 		{
-			Logger::getInstance()->debug("About to simulate physics to stable state for cache file.");
-			Timer::update();
-			int startTimeForPhysSim = Timer::getUnfactoredTime();
+			clipMap = gameScene->generateTerrainTexturing();
 
-			// no hardware accel when recreating physics cache (as it cannot handle the initial 4000+ contacts)
-			bool wasHardware = SimpleOptions::getBool(DH_OPT_B_PHYSICS_USE_HARDWARE);
-			if (wasHardware)
-			{
-				Logger::getInstance()->debug("Temporarily disabled hardware physics for cached physics state stabilization.");
-				SimpleOptions::setBool(DH_OPT_B_PHYSICS_USE_HARDWARE, false);
-			}
+			SHOW_LOADING_BAR(60);
+		});
+		loadGraph.addDependency(texturingTask, buildingsTask);
 
-			physics->createPhysics(gameScripting);
-			bool usedDynamicObst = gameUI->getTerrain()->doesUseDynamicObstacles();
-			gameUI->getTerrain()->setUseDynamicObstacles(false);
-			gameUI->getTerrain()->createPhysics(physics, clipMap, false, currentMap);
+		int physicsCacheTask = loadGraph.addTask("physics cache", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			// require physics cache recreate?
+			std::string obstFilename = std::string(currentMap) + std::string("/scene.bin");
+			std::string cacheFilename = std::string(currentMap) + std::string("/pcache.bin");
+			bool needPhysCacheRecreate = !FileTimestampChecker::isFileUpToDateComparedTo(cacheFilename.c_str(), obstFilename.c_str());
 
-			physics->setIgnoreContacts(true);
-			// simulate for a while... (about 180 secs or so ok?)
-			for (int psim = 0; psim < 180 * GAME_TICKS_PER_SECOND; psim++)
+			if (SimpleOptions::getBool(DH_OPT_B_FORCE_PHYSICS_CACHE_RECREATE)
+				|| (SimpleOptions::getBool(DH_OPT_B_AUTO_PHYSICS_CACHE_RECREATE) && needPhysCacheRecreate))
 			{
-				physics->runPhysics(gameUI->getStormScene(), gameUI->getVisualEffectManager()->getParticleEffectManager());
-				std::vector<TerrainObstacle> tmplist;
-				gameUI->getTerrain()->updatePhysics(physics, tmplist, NULL);
-			}
-			physics->setIgnoreContacts(false);
-			gameUI->getTerrain()->setUseDynamicObstacles(usedDynamicObst);
+				Logger::getInstance()->debug("About to simulate physics to stable state for cache file.");
+				Timer::update();
+				int startTimeForPhysSim = Timer::getUnfactoredTime();
 
-			LinkedListIterator biter(buildings->getAllBuildings());
-			while (biter.iterateAvailable())
-			{
-				Building *b = (Building *)biter.iterateNext();
-				b->deletePhysics(physics);
-			}
+				// no hardware accel when recreating physics cache (as it cannot handle the initial 4000+ contacts)
+				bool wasHardware = SimpleOptions::getBool(DH_OPT_B_PHYSICS_USE_HARDWARE);
+				if (wasHardware)
+				{
+					Logger::getInstance()->debug("Temporarily disabled hardware physics for cached physics state stabilization.");
+					SimpleOptions::setBool(DH_OPT_B_PHYSICS_USE_HARDWARE, false);
+				}
 
-			gameUI->getTerrain()->savePhysicsCache(physics, currentMap);
+				physics->createPhysics(gameScripting);
+				bool usedDynamicObst = gameUI->getTerrain()->doesUseDynamicObstacles();
+				gameUI->getTerrain()->setUseDynamicObstacles(false);
+				gameUI->getTerrain()->createPhysics(physics, clipMap, false, currentMap);
 
-			gameUI->getTerrain()->deletePhysics(physics);
-			physics->deletePhysics();
+				physics->setIgnoreContacts(true);
+				// simulate for a while... (about 180 secs or so ok?)
+				for (int psim = 0; psim < 180 * GAME_TICKS_PER_SECOND; psim++)
+				{
+					physics->runPhysics(gameUI->getStormScene(), gameUI->getVisualEffectManager()->getParticleEffectManager());
+					std::vector<TerrainObstacle> tmplist;
+					gameUI->getTerrain()->updatePhysics(physics, tmplist, NULL);
+				}
+				physics->setIgnoreContacts(false);
+				gameUI->getTerrain()->setUseDynamicObstacles(usedDynamicObst);
 
-			if (wasHardware)
-			{
-				SimpleOptions::setBool(DH_OPT_B_PHYSICS_USE_HARDWARE, wasHardware);
-			}
+				LinkedListIterator biter(buildings->getAllBuildings());
+				while (biter.iterateAvailable())
+				{
+					Building *b = (Building *)biter.iterateNext();
+					b->deletePhysics(physics);
+				}
 
-			LinkedListIterator biter2(buildings->getAllBuildings());
-			while (biter2.iterateAvailable())
-			{
-				Building *b = (Building *)biter2.iterateNext();
-				b->addPhysics(physics);
-			}
+				gameUI->getTerrain()->savePhysicsCache(physics, currentMap);
 
-			Timer::update();
-			int endTimeForPhysSim = Timer::getUnfactoredTime();
-			Logger::getInstance()->debug("Stabilizing simulation done, time used follows:");
-			Logger::getInstance()->debug(int2str(endTimeForPhysSim - startTimeForPhysSim));
-		} else {
-			Logger::getInstance()->debug("About to load physics state cache file.");
-			gameUI->getTerrain()->loadPhysicsCache(physics, currentMap);
-			Logger::getInstance()->debug("Physics state cache file loaded.");
-			loadedCache = true;
-		}
+				gameUI->getTerrain()->deletePhysics(physics);
+				physics->deletePhysics();
+
+				if (wasHardware)
+				{
+					SimpleOptions::setBool(DH_OPT_B_PHYSICS_USE_HARDWARE, wasHardware);
+				}
+
+				LinkedListIterator biter2(buildings->getAllBuildings());
+				while (biter2.iterateAvailable())
+				{
+					Building *b = (Building *)biter2.iterateNext();
+					b->addPhysics(physics);
+				}
 
-		SHOW_LOADING_BAR(65);
+				Timer::update();
+				int endTimeForPhysSim = Timer::getUnfactoredTime();
+				Logger::getInstance()->debug("Stabilizing simulation done, time used follows:");
+				Logger::getInstance()->debug(int2str(endTimeForPhysSim - startTimeForPhysSim));
+			} else {
+				Logger::getInstance()->debug("About to load physics state cache file.");
+				gameUI->getTerrain()->loadPhysicsCache(physics, currentMap);
+				Logger::getInstance()->debug("Physics state cache file loaded.");
+				loadedCache = true;
+			}
 
-		// terrain obstacles...
+			SHOW_LOADING_BAR(65);
+		});
+		loadGraph.addDependency(physicsCacheTask, texturingTask);
 
-		//std::vector<TerrainObstacle> &obstacleList = gameUI->renderTerrain->getObstacles();
-		std::vector<TerrainObstacle> obstacleList;
-		gameUI->renderTerrain->getObstacles(obstacleList);
-		gameScene->addTerrainObstacles(obstacleList);
+		int terrainObstaclesTask = loadGraph.addTask("terrain obstacles", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			// terrain obstacles...
 
-		gameMap->createCoverMap();
+			//std::vector<TerrainObstacle> &obstacleList = gameUI->renderTerrain->getObstacles();
+			std::vector<TerrainObstacle> obstacleList;
+			gameUI->renderTerrain->getObstacles(obstacleList);
+			gameScene->addTerrainObstacles(obstacleList);
+		});
+		loadGraph.addDependency(terrainObstaclesTask, physicsCacheTask);
 
-		// now, we should have either loaded the hidemap or created it
-		// try saving it. (done only if it was created, not loaded)
-//		gameMap->saveHideMap();
+		int coverMapTask = loadGraph.addTask("cover map", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
+			gameMap->createCoverMap();
 
-		gameMap->saveObstacleAndAreaMap(gameScene->getPathFinder());
+			// now, we should have either loaded the hidemap or created it
+			// try saving it. (done only if it was created, not loaded)
+//			gameMap->saveHideMap();
 
-		// set visual objects for all parts in units,
-		// create ai for units,
-		// move units to spawn...
+			gameMap->saveObstacleAndAreaMap(gameScene->getPathFinder());
 
-		SHOW_LOADING_BAR(70);
+			// set visual objects for all parts in units,
+			// create ai for units,
+			// move units to spawn...
 
+			SHOW_LOADING_BAR(70);
+		});
+		loadGraph.addDependency(coverMapTask, terrainObstaclesTask);
+
+		int combatScriptTask = loadGraph.addTask("combat scripts", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
+		{
 #ifdef LEGACY_FILES
-		gameScripting->loadScripts("Config/user_autoexec.dhs", NULL);
+			gameScripting->loadScripts("Config/user_autoexec.dhs", NULL);
 #else
-		gameScripting->loadScripts("config/user_autoexec.dhs", NULL);
+			gameScripting->loadScripts("config/user_autoexec.dhs", NULL);
 #endif
-		gameScripting->runMissionScript("user_autoexec", "runcombat");
+			gameScripting->runMissionScript("user_autoexec", "runcombat");
 
-		// now, we can run the mission script, not before, cos the unit
-		// spawning would not be able to solve proper coordinates before
-		// loading the map first.
-		if (sectionScript != NULL)
-		{
-			gameScripting->runMissionScript(sectionScript, "runcombat");
-			setSectionScript(NULL);
-		}
+			// now, we can run the mission script, not before, cos the unit
+			// spawning would not be able to solve proper coordinates before
+			// loading the map first.
+			if (sectionScript != NULL)
+			{
+				gameScripting->runMissionScript(sectionScript, "runcombat");
+				setSectionScript(NULL);
+			}
+
+			// everything after this is already in memory
+			preload.cancel();
+		});
+		loadGraph.addDependency(combatScriptTask, coverMapTask);
 
-		if (loadedCache)
+		int relightTask = loadGraph.addTask("physics relight", LoadTaskGraph::TASK_THREAD_MAIN, [&]()
 		{
-			Timer::update();
-			int startTimeForRelight = Timer::getUnfactoredTime();
-			Logger::getInstance()->debug("About to relight all physics objects loaded from cache...");
+			if (loadedCache)
+			{
+				Timer::update();
+				int startTimeForRelight = Timer::getUnfactoredTime();
+				Logger::getInstance()->debug("About to relight all physics objects loaded from cache...");
 
-			gameUI->getTerrain()->updateAllPhysicsObjectsLighting();
+				gameUI->getTerrain()->updateAllPhysicsObjectsLighting();
 
-			Timer::update();
-			int endTimeForRelight = Timer::getUnfactoredTime();
-			Logger::getInstance()->debug("Physics object relighting done, time used follows:");
-			Logger::getInstance()->debug(int2str(endTimeForRelight - startTimeForRelight));
-		}
+				Timer::update();
+				int endTimeForRelight = Timer::getUnfactoredTime();
+				Logger::getInstance()->debug("Physics object relighting done, time used follows:");
+				Logger::getInstance()->debug(int2str(endTimeForRelight - startTimeForRelight));
+			}
+		});
+		loadGraph.addDependency(relightTask, combatScriptTask);
+
+		loadGraph.run();
+		loadGraph.logTimings();
+
+		// textures preloaded by mission scripts were read while loading went on,
+		// create the rest of them now rather than during first frames
+		gameUI->getTextureCache()->finishRequests();
 
 		SHOW_LOADING_BAR(75);
 
@@ -2206,6 +2410,9 @@ gameUI->getTerrain()->calculateLighting();
 			unitSelections[seli]->reset();
 		}
 
+		losCache->clear();
+		losCache->resetStats();
+		losCache->setLifetime(SimpleOptions::getInt(DH_OPT_I_LOS_CACHE_LIFETIME));
 		visibilityChecker->restart();
 
 		SHOW_LOADING_BAR(95);
@@ -4292,6 +4499,20 @@ gameUI->getTerrain()->calculateLighting();
 		return this->environmentalEffectManager;
 	}
 
+	JobSystem *Game::getJobSystem()
+	{
+		// no idle threads for games that never run any jobs
+		if (jobSystem == NULL)
+		{
+			// (negative worker amount for machine default)
+			int jobWorkers = SimpleOptions::getInt(DH_OPT_I_JOB_WORKER_AMOUNT);
+			if (jobWorkers < 0)
+				jobWorkers = JobSystem::getDefaultWorkerAmount();
+			jobSystem = new JobSystem(jobWorkers);
+		}
+		return jobSystem;
+	}
+
 	bool Game::isMissionAboutToEnd()
 	{
 		if ( ( this->missionFailureCounter < 0 
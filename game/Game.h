@@ -54,6 +54,9 @@ namespace game
 
   class GameCollisionInfo;
   class UnitVisibilityChecker;
+  class LineOfSightCache;
+  class UnitCollisionBroadphase;
+  class JobSystem;
 	class GameProfiles;
 
   class ItemList;
@@ -259,6 +262,10 @@ namespace game
 		void setEnvironmentalEffectManager(EnvironmentalEffectManager *effman);
 		EnvironmentalEffectManager *getEnvironmentalEffectManager();
 
+		// worker threads for the game tick, started on the first call
+		// (job_worker_amount option)
+		JobSystem *getJobSystem();
+
     //void addMapObstacle(int x, int y);
 
     //void removeMapObstacle(int x, int y);
@@ -330,6 +337,15 @@ namespace game
 
     UnitVisibilityChecker *visibilityChecker;
 
+    // line of sight results shared by visibility checks and AI
+    LineOfSightCache *losCache;
+
+    // unit to unit pushing, run before units act
+    UnitCollisionBroadphase *unitBroadphase;
+
+    // worker threads for the game tick (NULL until getJobSystem is called)
+    JobSystem *jobSystem;
+
     UnitFormation formations;
 
 		Checkpoints *checkpoints;
@@ -25,6 +25,8 @@
 #include "../util/Floodfill.h"
 #include "../filesystem/input_stream_wrapper.h"
 #include "../filesystem/rle_packed_file_wrapper.h"
+#include "ObstacleMapFile.h"
+#include "LoadTaskGraph.h"
 
 #include "../util/Debug_MemoryManager.h"
 
@@ -124,12 +126,14 @@ namespace game
     scaleHeight = 1;
     heightMap = NULL;
     terrain = NULL;
+		collisionEpoch = 0;
     obstacleHeightMap = NULL;
 		coverMap = NULL;
 		coverFilename = NULL;
 //		hideMap = NULL;
 //		hideMapLoaded = false;
 		obstacleAndAreaMapLoaded = false;
+		coverMapLoaded = false;
 		areaMap = NULL;
 		colorMap = 0;
 		lightMap = 0;
@@ -174,7 +178,20 @@ namespace game
 
   void GameMap::applyObstacleHeightChanges()
   {
-    terrain->recreateCollisionMap();
+		markAllCollisionChanged();
+		collisionEpoch++;
+  }
+
+  void GameMap::markCollisionChanged(int x, int y)
+  {
+		if (terrain != NULL)
+			terrain->updateCollisionMap(VC2I(x, y), VC2I(x + 1, y + 1));
+  }
+
+  void GameMap::markAllCollisionChanged()
+  {
+		if (terrain != NULL)
+			terrain->recreateCollisionMap();
   }
 
   // a hack to get storm terrain height calculation here
@@ -182,6 +199,8 @@ namespace game
   void GameMap::setTerrain(IStorm3D_Terrain *terrain)
   {
     this->terrain = terrain;
+		// changes made before there was a terrain
+		markAllCollisionChanged();
   }
 
   SaveData *GameMap::getSaveData() const
@@ -250,11 +269,15 @@ namespace game
     for (int i = 0; i < pathfindSizeX * pathfindSizeY; i++)
       obstacleHeightMap[i] = 0;
 
+		markAllCollisionChanged();
+		collisionEpoch++;
+
     if (coverMap != NULL)
     {
       delete coverMap;
     }
 		coverMap = new CoverMap(pathfindSizeX, pathfindSizeY);
+		coverMapLoaded = false;
 
 //    if (hideMap != NULL)
 //    {
@@ -306,10 +329,9 @@ namespace game
 	}
 
 
-  void GameMap::createCoverMap()
+  bool GameMap::loadCoverMap()
   {
-		// now either create the covermap and save it to disk, or load
-		// directly from disk if it's up-to-date...
+		// load directly from disk if it's up-to-date...
 		char *bin_filename = new char[strlen(coverFilename) + 16];
 		strcpy(bin_filename, coverFilename);
 		if (strlen(coverFilename) > 10)
@@ -328,7 +350,7 @@ namespace game
 		{
 			if (!upToDate)
 			{
-				Logger::getInstance()->warning("GameMap::createCoverMap - Covermap is not up to date, but it will not be recreated (auto recreate off).");
+				Logger::getInstance()->warning("GameMap::loadCoverMap - Covermap is not up to date, but it will not be recreated (auto recreate off).");
 				upToDate = true;
 			}
 		}
@@ -336,7 +358,7 @@ namespace game
 		// if force is on, treat as being out-of-date
 		if (SimpleOptions::getBool(DH_OPT_B_FORCE_COVER_BIN_RECREATE))
 		{
-			Logger::getInstance()->debug("GameMap::createCoverMap - Covermap is recreated (force recreate on).");
+			Logger::getInstance()->debug("GameMap::loadCoverMap - Covermap is recreated (force recreate on).");
 			upToDate = false;
 		}
 
@@ -351,11 +373,31 @@ namespace game
 		} else {
 			if (upToDate && !loaded)
 			{
-				Logger::getInstance()->warning("GameMap::setData - Failed to load covermap (will attempt to recreate it).");
+				Logger::getInstance()->warning("GameMap::loadCoverMap - Failed to load covermap (will attempt to recreate it).");
 			}
 		}
-		if (!loaded)
+		delete [] bin_filename;
+
+		coverMapLoaded = loaded;
+		return loaded;
+  }
+
+  void GameMap::createCoverMap()
+  {
+		// loadCoverMap has been run before (possibly on a loader worker)
+		if (!coverMapLoaded)
 		{
+			// NOTE: copy&pasted from loadCoverMap above
+			char *bin_filename = new char[strlen(coverFilename) + 16];
+			strcpy(bin_filename, coverFilename);
+			if (strlen(coverFilename) > 10)
+			{
+				strcpy(&bin_filename[strlen(coverFilename) - 4-5], "cover.bin");
+			} else {
+				strcpy(&bin_filename[strlen(coverFilename)], "cover.bin");
+				assert(0); // umm, bin filename sucked?
+			}
+
 #ifndef PROJECT_SURVIVOR
 			LoadingMessage::showLoadingMessage(getLocaleGuiString("gui_loading_regen_bin_convermap"));
 #endif
@@ -364,10 +406,11 @@ namespace game
 			bool saved = coverMap->save(bin_filename);
 			if (!saved)
 			{
-				Logger::getInstance()->warning("GameMap::setData - Failed to save covermap.");
+				Logger::getInstance()->warning("GameMap::createCoverMap - Failed to save covermap.");
 			}
+			delete [] bin_filename;
+			coverMapLoaded = true;
 		}
-		delete [] bin_filename;
   }
 
 
@@ -525,12 +568,9 @@ namespace game
 				Logger::getInstance()->warning("GameMap::loadObstacleAndAreaMap - Failed to load obstacle/area map (will attempt to recreate it).");
 			}
 		}
-#ifndef PROJECT_SURVIVOR
-		if (!loaded)
-		{
-			LoadingMessage::showLoadingMessage(getLocaleGuiString("gui_loading_regen_bin_obstaclemap"));
-		}
-#endif
+		// (no loading message here for a failed load, this may be run
+		// on a loader worker thread, caller shows it. for the same reason
+		// caller has to applyObstacleHeightChanges afterwards.)
 		delete [] bin_filename;
 
 		obstacleAndAreaMapLoaded = loaded;
@@ -560,6 +600,8 @@ namespace game
 			}
 			delete [] this->precalcedPathfindHeightMap;
 			this->precalcedPathfindHeightMap = NULL;
+			markAllCollisionChanged();
+			collisionEpoch++;
 		}
 
 		// NOTE: copy&pasted from loadHideMap above
@@ -647,6 +689,8 @@ namespace game
       if (x < 0 || y < 0 || x >= sizeX * GAMEMAP_HEIGHTMAP_MULTIPLIER || y >= sizeY * GAMEMAP_HEIGHTMAP_MULTIPLIER) abort();
     #endif
     pathfindHeightMap[x + y * sizeX * GAMEMAP_HEIGHTMAP_MULTIPLIER] = value;
+		markCollisionChanged(x * GAMEMAP_PATHFIND_ACCURACY, y * GAMEMAP_PATHFIND_ACCURACY);
+		collisionEpoch++;
     //return (int)heightMap[x + y * sizeX];
   }
 
@@ -741,7 +785,65 @@ namespace game
 	}
 
 
+	// planes of obstacle.bin, in file order
+	static void addObstacleMapPlanes(ObstacleMapFile &file, WORD *obstacleHeightMap, AREAMAP_DATATYPE *amap,
+		int pathfindSizeX, int pathfindSizeY, frozenbyte::ai::PathFind *pathfinder,
+		WORD *pathfindHeightMap, int xResolution, int yResolution)
+	{
+		file.addPlane(sizeof(WORD), pathfindSizeX, pathfindSizeY, [=](int row)
+		{
+			return (unsigned char *)&obstacleHeightMap[row * pathfindSizeX];
+		});
+		file.addPlane(sizeof(AREAMAP_DATATYPE), pathfindSizeX, pathfindSizeY, [=](int row)
+		{
+			return (unsigned char *)&amap[row * pathfindSizeX];
+		});
+		// pathfinder keeps blocking counts per x column
+		file.addPlane(sizeof(signed char), pathfindSizeY, pathfindSizeX, [=](int column)
+		{
+			return (unsigned char *)pathfinder->getBlockingColumn(column);
+		});
+		file.addPlane(sizeof(WORD), xResolution, yResolution, [=](int row)
+		{
+			return (unsigned char *)&pathfindHeightMap[row * xResolution];
+		});
+	}
+
+
 	bool GameMap::loadObstacleAndAreaImpl(const char *filename, frozenbyte::ai::PathFind *pathfinder)
+	{
+		assert(filename != NULL);
+		assert(this->obstacleHeightMap != NULL);
+		assert(this->areaMap != NULL);
+		assert(this->precalcedPathfindHeightMap == NULL);
+		assert(pathfinder != NULL);
+
+		int xResolution = this->sizeX * GAMEMAP_HEIGHTMAP_MULTIPLIER;
+		int yResolution = this->sizeY * GAMEMAP_HEIGHTMAP_MULTIPLIER;
+		this->precalcedPathfindHeightMap = new unsigned short[xResolution * yResolution];
+
+		ObstacleMapFile file;
+		addObstacleMapPlanes(file, obstacleHeightMap, areaMap->getInternalBuffer(), pathfindSizeX, pathfindSizeY,
+			pathfinder, precalcedPathfindHeightMap, xResolution, yResolution);
+
+		ObstacleMapFile::READ_RESULT result = file.read(filename, LoadTaskGraph::getDefaultWorkerAmount() + 1);
+		if (result == ObstacleMapFile::READ_OK)
+		{
+			Logger::getInstance()->debug("GameMap::loadObstacleAndAreaImpl - Obstacle/area map successfully loaded.");
+			return true;
+		}
+
+		delete [] this->precalcedPathfindHeightMap;
+		this->precalcedPathfindHeightMap = NULL;
+
+		if (result == ObstacleMapFile::READ_OTHER_FORMAT)
+			return loadObstacleAndAreaRle(filename, pathfinder);
+
+		return false;
+	}
+
+
+	bool GameMap::loadObstacleAndAreaRle(const char *filename, frozenbyte::ai::PathFind *pathfinder)
 	{
 		assert(filename != NULL);
 		assert(this->obstacleHeightMap != NULL);
@@ -763,7 +865,7 @@ namespace game
 			}
 			if (got != pathfindSizeY)
 			{
-				Logger::getInstance()->error("GameMap::loadObstacleAndAreaImpl - Error reading file (at obstaclemap).");
+				Logger::getInstance()->error("GameMap::loadObstacleAndAreaRle - Error reading file (at obstaclemap).");
 				Logger::getInstance()->debug(filename);
 			} else {
 				int got2 = 0;
@@ -774,7 +876,7 @@ namespace game
 				}
 				if (got2 != pathfindSizeY)
 				{
-					Logger::getInstance()->error("GameMap::loadObstacleAndAreaImpl - Error reading file (at areamap).");
+					Logger::getInstance()->error("GameMap::loadObstacleAndAreaRle - Error reading file (at areamap).");
 					Logger::getInstance()->debug(filename);
 				} else {
 					int got3 = 0;
@@ -790,7 +892,7 @@ namespace game
 					delete [] tmpbuf;
 					if (got3 != pathfindSizeY)
 					{
-						Logger::getInstance()->error("GameMap::loadObstacleAndAreaImpl - Error reading file (at pathfinder).");
+						Logger::getInstance()->error("GameMap::loadObstacleAndAreaRle - Error reading file (at pathfinder).");
 						Logger::getInstance()->debug(filename);
 					} else {
 						int xResolution = this->sizeX * GAMEMAP_HEIGHTMAP_MULTIPLIER;
@@ -806,10 +908,10 @@ namespace game
 						}
 						if (got4 != yResolution)
 						{
-							Logger::getInstance()->error("GameMap::loadObstacleAndAreaImpl - Error reading file (at heightmap).");
+							Logger::getInstance()->error("GameMap::loadObstacleAndAreaRle - Error reading file (at heightmap).");
 							Logger::getInstance()->debug(filename);
 						} else {
-							Logger::getInstance()->debug("GameMap::loadObstacleAndAreaImpl - Obstacle/area map successfully loaded.");
+							Logger::getInstance()->debug("GameMap::loadObstacleAndAreaRle - Obstacle/area map successfully loaded.");
 							success = true;
 						}
 					}
@@ -817,12 +919,12 @@ namespace game
 			}
 			if (rle_packed_was_error(f))
 			{
-				Logger::getInstance()->error("GameMap::loadObstacleAndAreaImpl - Error while reading/unpacking file.");
+				Logger::getInstance()->error("GameMap::loadObstacleAndAreaRle - Error while reading/unpacking file.");
 				Logger::getInstance()->debug(filename);
 			}
 			rle_packed_fclose(f);
 		} else {
-			Logger::getInstance()->error("GameMap::loadObstacleAndAreaImpl - Could not open file.");
+			Logger::getInstance()->error("GameMap::loadObstacleAndAreaRle - Could not open file.");
 			Logger::getInstance()->debug(filename);
 		}
 
@@ -833,105 +935,21 @@ namespace game
 	bool GameMap::saveObstacleAndAreaImpl(const char *filename, frozenbyte::ai::PathFind *pathfinder)
 	{
 		assert(filename != NULL);
+		assert(areaMap != NULL);
+		assert(pathfinder != NULL);
 
-		bool success = false;
-
-		//FILE *f = fopen(filename, "wb");
-		RLE_PACKED_FILE *f = rle_packed_fopen(filename, "wb");
-
-		if (f != NULL)
-		{
-			// can't write the file in one block? too big? chop to pieces...
-			int got = 0;
-			for (int i = 0; i < pathfindSizeY; i++)
-			{
-				got += rle_packed_fwrite(&obstacleHeightMap[i * pathfindSizeX], sizeof(unsigned short) * pathfindSizeX, 1, f);
-			}
-			if (got != pathfindSizeY)
-			{
-				Logger::getInstance()->error("GameMap::saveObstacleAndAreaImpl - Error writing file (at obstaclemap).");
-				Logger::getInstance()->debug(filename);
-			} else {
-				int got2 = 0;
-				assert(areaMap != NULL);
-				AREAMAP_DATATYPE *amap = areaMap->getInternalBuffer();
-				assert(amap != NULL);
-				for (int i = 0; i < pathfindSizeY; i++)
-				{
-					got2 += rle_packed_fwrite(&amap[i * pathfindSizeX], sizeof(AREAMAP_DATATYPE) * pathfindSizeX, 1, f);
-				}
-				if (got2 != pathfindSizeY)
-				{
-					Logger::getInstance()->error("GameMap::saveObstacleAndAreaImpl - Error writing file (at areamap).");
-					Logger::getInstance()->debug(filename);
-				} else {
-					int got3 = 0;
-					assert(pathfinder != NULL);
-
-					unsigned char *tmpbuf = new unsigned char[pathfindSizeX];
-					for (int i = 0; i < pathfindSizeY; i++)
-					{
-						for (int xfill = 0; xfill < pathfindSizeX; xfill++)
-						{
-							tmpbuf[xfill] = pathfinder->getBlockingCount(xfill, i);
-						}
-						got3 += rle_packed_fwrite(tmpbuf, sizeof(signed char) * pathfindSizeX, 1, f);
-					}
-					delete [] tmpbuf;
-
-					if (got3 != pathfindSizeY)
-					{
-						Logger::getInstance()->error("GameMap::saveObstacleAndAreaImpl - Error writing file (at pathfinder).");
-						Logger::getInstance()->debug(filename);
-					} else {
+		int xResolution = this->sizeX * GAMEMAP_HEIGHTMAP_MULTIPLIER;
+		int yResolution = this->sizeY * GAMEMAP_HEIGHTMAP_MULTIPLIER;
 
-						// --- TEMP: write heightmap to own file ---
-						/*
-						FILE *fhe = fopen("heightmap_temp.raw", "wb");
-						if (fhe != NULL)
-						{
-							int xResolution = this->sizeX * GAMEMAP_HEIGHTMAP_MULTIPLIER;
-							int yResolution = this->sizeY * GAMEMAP_HEIGHTMAP_MULTIPLIER;
-							int gotfoo = 0;
-							for (int i = 0; i < yResolution; i++)
-							{
-								gotfoo += fwrite(&pathfindHeightMap[i * xResolution], sizeof(unsigned short) * xResolution, 1, fhe);
-							}
-							fclose(fhe);
-						}
-						*/
-						// --- TEMP: end of temp ---
+		ObstacleMapFile file;
+		addObstacleMapPlanes(file, obstacleHeightMap, areaMap->getInternalBuffer(), pathfindSizeX, pathfindSizeY,
+			pathfinder, pathfindHeightMap, xResolution, yResolution);
 
-						int xResolution = this->sizeX * GAMEMAP_HEIGHTMAP_MULTIPLIER;
-						int yResolution = this->sizeY * GAMEMAP_HEIGHTMAP_MULTIPLIER;
-						int got4 = 0;
-						for (int i = 0; i < yResolution; i++)
-						{
-							got4 += rle_packed_fwrite(&pathfindHeightMap[i * xResolution], sizeof(unsigned short) * xResolution, 1, f);
-						}
-						if (got4 != yResolution)
-						{
-							Logger::getInstance()->error("GameMap::saveObstacleAndAreaImpl - Error writing file (at heightmap).");
-							Logger::getInstance()->debug(filename);
-						} else {
-							Logger::getInstance()->debug("GameMap::saveObstacleAndAreaImpl - Obstacle/area map successfully saved.");
-							success = true;
-						}
-					}
-				}
-			}
-			if (rle_packed_was_error(f))
-			{
-				Logger::getInstance()->error("GameMap::saveObstacleAndAreaImpl - Error while writing/packing file.");
-				Logger::getInstance()->debug(filename);
-			}
-			rle_packed_fclose(f);
-		} else {
-			Logger::getInstance()->error("GameMap::saveObstacleAndAreaImpl - Could not open file.");
-			Logger::getInstance()->debug(filename);
-		}
+		if (!file.write(filename))
+			return false;
 
-		return success;
+		Logger::getInstance()->debug("GameMap::saveObstacleAndAreaImpl - Obstacle/area map successfully saved.");
+		return true;
 	}
 
 }
@@ -86,8 +86,14 @@ namespace game
     void setData(WORD *heightMap, WORD *doubledMap, VC2I size, VC2 scaledSize, float scaledHeight,
 			const char *vegeFilename);
 
+		// loads the cover map if it is up to date on disk, touches only
+		// cover map data (may be run on a loader worker thread).
+		// returns false if createCoverMap has to recreate it.
+		bool loadCoverMap();
+
 		// should call this after obstacle map is complete.
 		// (after adding buildings and terrain objects)
+		// recreates the cover map unless loadCoverMap (called before this) loaded it.
 		void createCoverMap();
 
     void setTerrain(IStorm3D_Terrain *terrain);
@@ -129,10 +135,18 @@ namespace game
 
     void applyObstacleHeightChanges();
 
+		// changes whenever the static collision (obstacles, heightmap) does,
+		// for anything caching raytrace results
+		inline int getCollisionEpoch() const { return collisionEpoch; }
+		inline void bumpCollisionEpoch() { collisionEpoch++; }
+
 //		void loadHideMap();
 //		bool isHideMapLoaded();
 //		void saveHideMap();
 
+		// touches only map and pathfinder data (may be run on a loader worker
+		// thread), if not loaded the caller should show the regen message.
+		// caller must call applyObstacleHeightChanges afterwards.
 		void loadObstacleAndAreaMap(frozenbyte::ai::PathFind *pathfinder);
 		bool isObstacleAndAreaMapLoaded();
 		void saveObstacleAndAreaMap(frozenbyte::ai::PathFind *pathfinder);
@@ -193,6 +207,9 @@ private:
 
     IStorm3D_Terrain *terrain;
 
+		// bumped by static obstacle and heightmap changes (not moving ones)
+		int collisionEpoch;
+
 // for efficiency
 public:
     WORD *obstacleHeightMap;
@@ -205,6 +222,7 @@ private:
 //		bool hideMapLoaded;
 
 		bool obstacleAndAreaMapLoaded;
+		bool coverMapLoaded;
 
 		util::AreaMap *areaMap;
 
@@ -214,6 +232,8 @@ public:
 
 		bool loadObstacleAndAreaImpl(const char *filename, frozenbyte::ai::PathFind *pathfinder);
 		bool saveObstacleAndAreaImpl(const char *filename, frozenbyte::ai::PathFind *pathfinder);
+		// older row by row rle packed format
+		bool loadObstacleAndAreaRle(const char *filename, frozenbyte::ai::PathFind *pathfinder);
 
   public:
 		inline CoverMap *getCoverMap() 
@@ -442,6 +462,8 @@ public:
 
 			//assert(obstacleHeightMap[x + y * pathfindSizeX] < OBSTACLE_MAP_MAX_HEIGHT - height);
       obstacleHeightMap[x + y * pathfindSizeX] += height;
+			markCollisionChanged(x, y);
+			collisionEpoch++;
 			areaMap->setAreaValue(x, y, AREAMASK_OBSTACLE_ALL, obstacleMask);
 
 			// TODO: clear other flags??? (seethrough, unhittable, etc.)
@@ -458,6 +480,8 @@ public:
 			  obstacleHeightMap[x + y * pathfindSizeX] -= height;
 		  else
 			  obstacleHeightMap[x + y * pathfindSizeX] = 0;
+		  markCollisionChanged(x, y);
+		  collisionEpoch++;
 		}
     } 
   
@@ -514,6 +538,7 @@ public:
 				areaMap->setAreaValue(x, y, AREAMASK_OBSTACLE_ALL, obstacleMask);
 				//areaMap->setAreaValue(x, y, AREAMASK_OBSTACLE_MOVABLE, AREAVALUE_OBSTACLE_MOVABLE_YES);
 	      obstacleHeightMap[x + y * pathfindSizeX] += height;
+				markCollisionChanged(x, y);
 			}
     }
   
@@ -533,6 +558,7 @@ public:
 			{
 //        assert(obstacleHeightMap[x + y * pathfindSizeX] >= height);
 	      obstacleHeightMap[x + y * pathfindSizeX] -= height;
+				markCollisionChanged(x, y);
 			}
     }
 
@@ -555,6 +581,11 @@ public:
 
 		void makeHeightAreaBlocked(int heightMapX, int heightMapY);
 
+		// tells terrain raytrace about obstacle and collision height changes
+		// (obstacle map coordinates)
+		void markCollisionChanged(int x, int y);
+		void markAllCollisionChanged();
+
   };
 
 }
@@ -641,6 +641,11 @@ namespace game
 		"joystick2_deadzone", "i+", "Controllers", "250", "1000", "-",
 		"joystick3_deadzone", "i+", "Controllers", "250", "1000", "-",
 		"joystick4_deadzone", "i+", "Controllers", "250", "1000", "-",
+		"unitlist_grid", "b", "Game", "0", "-", "-",
+		"unitlist_grid_cell_size", "f", "Game", "8.0f", "-", "-",
+		"los_cache_lifetime", "i", "Game", "10", "-", "-",
+		"unit_collision_broadphase", "b", "Game", "1", "-", "-",
+		"job_worker_amount", "i", "Game", "-1", "-", "-",
 
 		// first fill the _reserved_ options with something useful
 		// then add more if necessary..
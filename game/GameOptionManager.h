@@ -5,7 +5,7 @@
 
 // NOTE: option id defines moved under game/options/ directory.
 
-#define DH_OPT_AMOUNT 370
+#define DH_OPT_AMOUNT 375
 #include <string>
 #include <memory>
 
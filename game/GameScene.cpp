@@ -3,6 +3,9 @@
 
 #include "GameScene.h"
 
+#include <vector>
+#include <algorithm>
+
 #include <Storm3D_UI.h>
 #include "../ui/Terrain.h"
 #include "../ui/VisualObject.h"
@@ -202,11 +205,113 @@ namespace game
 
 
 
+	// State kept between the terrain and scene parts of a raytrace
+	struct GameSceneRayTraceState
+	{
+		Storm3D_CollisionInfo sceneColl;
+		Storm3D_CollisionInfo terrainColl;
+		ObstacleCollisionInfo obstacleColl;
+
+		// result already decided by terrain/obstacles (or no ray at all)
+		bool finished;
+		bool traceScene;
+		float sceneRayLength;
+
+		bool farObstacleHit;
+		VC3 farObstaclePlane;
+		VC3 farObstaclePosition;
+		float farObstacleRange;
+
+#ifdef DUMP_GAMESCENE_STATS
+		int startTime;
+#endif
+	};
+
+
 	void GameScene::rayTrace(const VC3 &origin, const VC3 &direction, float rayLength, GameCollisionInfo &cinfo, bool accurate, bool loscheck, bool terrainOnly, bool terrainOnlyForReal)
 	{
+		GameSceneRayTraceState state;
+		rayTraceBegin(origin, direction, rayLength, cinfo, loscheck, terrainOnly, terrainOnlyForReal, state);
+		if (state.finished)
+			return;
+
+		if (state.traceScene)
+		{
+ 			stormScene->RayTrace(origin, direction, 
+				state.sceneRayLength, state.sceneColl, accurate);
+		}
+
+		rayTraceFinish(origin, direction, rayLength, cinfo, accurate, loscheck, terrainOnlyForReal, state);
+	}
+
+
+	void GameScene::rayTraceBundle(const VC3 &origin, const VC3 *directions, int rayAmount, float rayLength, GameCollisionInfo *results, bool accurate)
+	{
+		if (rayAmount <= 0)
+			return;
+
+		std::vector<GameSceneRayTraceState> states(rayAmount);
+		std::vector<int> sceneRays;
+		sceneRays.reserve(rayAmount);
+
+		// terrain (heightmap and obstacles) is still traced one ray at a time
+		for (int i = 0; i < rayAmount; i++)
+		{
+			rayTraceBegin(origin, directions[i], rayLength, results[i], 
+				false, false, false, states[i]);
+
+			if (!states[i].finished && states[i].traceScene)
+				sceneRays.push_back(i);
+		}
+
+		int sceneRayAmount = (int)sceneRays.size();
+		if (sceneRayAmount == 1)
+		{
+			GameSceneRayTraceState &state = states[sceneRays[0]];
+			stormScene->RayTrace(origin, directions[sceneRays[0]], 
+				state.sceneRayLength, state.sceneColl, accurate);
+		}
+		else if (sceneRayAmount > 1)
+		{
+			std::vector<VC3> sceneDirections(sceneRayAmount);
+			std::vector<float> sceneRayLengths(sceneRayAmount);
+			std::vector<Storm3D_CollisionInfo> sceneColls(sceneRayAmount);
+
+			for (int j = 0; j < sceneRayAmount; j++)
+			{
+				sceneDirections[j] = directions[sceneRays[j]];
+				sceneRayLengths[j] = states[sceneRays[j]].sceneRayLength;
+			}
+
+			stormScene->RayTraceBundle(origin, &sceneDirections[0], 
+				&sceneRayLengths[0], sceneRayAmount, &sceneColls[0], accurate);
+
+			for (int j = 0; j < sceneRayAmount; j++)
+			{
+				states[sceneRays[j]].sceneColl = sceneColls[j];
+			}
+		}
+
+		for (int i = 0; i < rayAmount; i++)
+		{
+			if (states[i].finished)
+				continue;
+
+			rayTraceFinish(origin, directions[i], rayLength, results[i], 
+				accurate, false, false, states[i]);
+		}
+	}
+
+
+	void GameScene::rayTraceBegin(const VC3 &origin, const VC3 &direction, float rayLength, GameCollisionInfo &cinfo, bool loscheck, bool terrainOnly, bool terrainOnlyForReal, GameSceneRayTraceState &state)
+	{
+		state.finished = false;
+		state.traceScene = false;
+
 #ifdef DUMP_GAMESCENE_STATS
 		Timer::update();
 		int startTime = Timer::getTime();
+		state.startTime = startTime;
 #endif
 
 #ifndef PHYSICS_NONE
@@ -228,12 +333,12 @@ namespace game
 		if (rayLength <= 0.0f)
 		{
 			cinfo.hit = false;
+			state.finished = true;
 			return;
 		}
 
-		Storm3D_CollisionInfo sceneColl;
-		Storm3D_CollisionInfo terrainColl;
-		ObstacleCollisionInfo obstacleColl;
+		Storm3D_CollisionInfo &terrainColl = state.terrainColl;
+		ObstacleCollisionInfo &obstacleColl = state.obstacleColl;
 
 		// must not already be a used collisioninfo.
 		assert(!cinfo.hit);
@@ -270,6 +375,7 @@ namespace game
 			statLOStracePartialAmount++;
 			statLOStraceToTerrainAmount++;
 #endif
+			state.finished = true;
 			return;
 		}
 		// in case of los check we must collide at least 3 obstacles for it 
@@ -337,7 +443,8 @@ namespace game
 				statLOStracePartialAmount++;
 				statLOStraceToObstacleAmount++;
 #endif
-				return; 			 
+				state.finished = true;
+				return;
 			}
 		}
 
@@ -383,11 +490,27 @@ namespace game
 				sceneRayLength = terrainColl.range + 2;
 		}
 
-		if(!terrainOnly)
-		{
- 			stormScene->RayTrace(origin, direction, 
-				sceneRayLength, sceneColl, accurate);
-		}
+		state.traceScene = !terrainOnly;
+		state.sceneRayLength = sceneRayLength;
+		state.farObstacleHit = farObstacleHit;
+		state.farObstaclePlane = farObstaclePlane;
+		state.farObstaclePosition = farObstaclePosition;
+		state.farObstacleRange = farObstacleRange;
+	}
+
+
+	void GameScene::rayTraceFinish(const VC3 &origin, const VC3 &direction, float rayLength, GameCollisionInfo &cinfo, bool accurate, bool loscheck, bool terrainOnlyForReal, GameSceneRayTraceState &state)
+	{
+#ifdef DUMP_GAMESCENE_STATS
+		int startTime = state.startTime;
+#endif
+
+		const Storm3D_CollisionInfo &sceneColl = state.sceneColl;
+		const Storm3D_CollisionInfo &terrainColl = state.terrainColl;
+		bool farObstacleHit = state.farObstacleHit;
+		const VC3 &farObstaclePlane = state.farObstaclePlane;
+		const VC3 &farObstaclePosition = state.farObstaclePosition;
+		float farObstacleRange = state.farObstacleRange;
 
 		// horrible if mixture... redo before extending...
 		float terrHitRange = terrainColl.range;
@@ -26,6 +26,7 @@ namespace game
 {
   class GameMap;
   class Building;
+  struct GameSceneRayTraceState;
 
   class GameScene
   {
@@ -42,6 +43,13 @@ namespace game
     void rayTrace(const VC3 &origin, const VC3 &direction, float rayLength, 
       GameCollisionInfo &cinfo, bool accurate, bool loscheck, bool terrainOnly = false, bool terrainOnlyForReal = false);
 
+    // raytrace a number of rays from one origin (directions must be normalized,
+    // results must be unused collision infos). gives the same results as 
+    // separate rayTrace calls without loscheck, but the rays walk the scene 
+    // model tree together. terrain is still traced ray by ray.
+    void rayTraceBundle(const VC3 &origin, const VC3 *directions, int rayAmount, 
+      float rayLength, GameCollisionInfo *results, bool accurate);
+
     // pathfinding
     bool findPath(frozenbyte::ai::Path *path, float startX, float startY, 
       float endX, float endY, float maxHeightDifference, float climbPenalty,
@@ -107,6 +115,11 @@ namespace game
 
     void modifyTerrainObstaclesImpl(std::vector<TerrainObstacle> &obstacleList, bool add);
 
+    void rayTraceBegin(const VC3 &origin, const VC3 &direction, float rayLength, 
+      GameCollisionInfo &cinfo, bool loscheck, bool terrainOnly, bool terrainOnlyForReal, GameSceneRayTraceState &state);
+    void rayTraceFinish(const VC3 &origin, const VC3 &direction, float rayLength, 
+      GameCollisionInfo &cinfo, bool accurate, bool loscheck, bool terrainOnlyForReal, GameSceneRayTraceState &state);
+
 #ifdef DUMP_GAMESCENE_STATS
     int statPathfindAmount;
     int statLOStraceAmount;
@@ -5,6 +5,8 @@
 #include <DatatypeDef.h>
 #include <string>
 
+#include "../container/SlotMap.h"
+
 namespace ui
 {
   class VisualObject;
@@ -127,6 +129,11 @@ namespace game
 
 			AbstractPhysicsObject* physicsObject;
 
+			// handle in ItemList
+			SlotMapHandle listHandle;
+
+			friend class ItemList;
+
 		public:
 			struct ItemSpawner *spawner;
 	};
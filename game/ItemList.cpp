@@ -6,6 +6,7 @@
 #include "Item.h"
 #include "gamedefs.h"
 #include "../container/LinkedList.h"
+#include "../container/SlotMap.h"
 #include "../util/Debug_MemoryManager.h"
 
 namespace game
@@ -13,16 +14,12 @@ namespace game
 
 	ItemList::ItemList()
 	{
-		allItems = new LinkedList();
+		allItems = new LinkedSlotMap<Item>();
 	}
 
 	// NOTE, does not delete the items inside this but just the list of them
 	ItemList::~ItemList()
 	{
-		while (!allItems->isEmpty())
-		{
-			allItems->popLast();
-		}
 		delete allItems;
 	}
 
@@ -39,32 +36,35 @@ namespace game
 
 	int ItemList::getAllItemAmount()
 	{
-		// TODO, optimize, not thread safe! (caller may not be using iterator)
-		int count = 0;
-		allItems->resetIterate();
-		while (allItems->iterateAvailable())
-		{
-			allItems->iterateNext();
-			count++;
-		}
-		return count;
+		return allItems->getAmount();
 	}
 
 	LinkedList *ItemList::getAllItems()
 	{
-		return allItems;
+		return allItems->getLinkedList();
 	}
 
-	void ItemList::addItem(Item *item)
+	const SlotMap<Item> *ItemList::getAllItemSlots()
 	{
-		allItems->append(item);
+		return allItems->getSlotMap();
+	}
+
+	SlotMapHandle ItemList::addItem(Item *item)
+	{
+		item->listHandle = allItems->insert(item);
+		return item->listHandle;
 	}
 
 	// does not delete the projectile, just removes it from the list
 	void ItemList::removeItem(Item *item)
 	{
-		allItems->remove(item);
+		allItems->erase(item->listHandle);
+		item->listHandle = SlotMapHandle();
 	}
 
-}
+	Item *ItemList::getItemBySlotHandle(const SlotMapHandle &handle)
+	{
+		return allItems->get(handle);
+	}
 
+}
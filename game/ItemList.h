@@ -4,6 +4,8 @@
 
 #include "GameObject.h"
 
+#include "../container/SlotMap.h"
+
 class LinkedList;
 
 namespace game
@@ -34,11 +36,18 @@ namespace game
 
 		LinkedList *getAllItems();
 
-		void addItem(Item *item);
+		// same items in the same order, without the list nodes
+		const SlotMap<Item> *getAllItemSlots();
+
+		// returns the handle in getAllItemSlots
+		SlotMapHandle addItem(Item *item);
 		void removeItem(Item *item);
 
+		// NULL if the item has been removed
+		Item *getItemBySlotHandle(const SlotMapHandle &handle);
+
 	private:
-		LinkedList *allItems;
+		LinkedSlotMap<Item> *allItems;
 	};
 
 }
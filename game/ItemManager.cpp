@@ -20,6 +20,7 @@
 #include "../game/DHLocaleManager.h"
 #include "../ui/Spotlight.h"
 #include "../container/LinkedList.h"
+#include "../container/SlotMap.h"
 #include "../convert/str2int.h"
 #include "../util/SimpleParser.h"
 #include "../system/Logger.h"
@@ -159,11 +160,12 @@ void createPhysicsForItem( Item* item, GamePhysics* physics, float mass )
 	{
 		clearAllSpawners();
 
-		LinkedList *items = game->items->getAllItems();
-
-		while(!items->isEmpty())
+		// (removed through the item list, to keep its slot map in sync)
+		SlotMap<Item>::Iterator iter(game->items->getAllItemSlots());
+		while (iter.iterateAvailable())
 		{
-			Item *item = (Item *)items->popLast();
+			Item *item = iter.iterateNext();
+			game->items->removeItem(item);
 			delete item;
 		}
 
@@ -366,13 +368,12 @@ void createPhysicsForItem( Item* item, GamePhysics* physics, float mass )
 
 	void ItemManager::run()
 	{
-		LinkedList *ilist = game->items->getAllItems();
-		// NOTE: need to use safe iterator, as running an item script may
-		// delete it.
-		SafeLinkedListIterator iter(ilist);
+		// NOTE: running an item script may delete it (the slot map
+		// iterator allows that, without copying the list).
+		SlotMap<Item>::Iterator iter(game->items->getAllItemSlots());
 		while(iter.iterateAvailable())
 		{
-			Item *item = (Item *)iter.iterateNext();
+			Item *item = iter.iterateNext();
 
 			if (item->advanceReEnable())
 			{
@@ -908,13 +909,12 @@ void createPhysicsForItem( Item* item, GamePhysics* physics, float mass )
 
 		bool didExecute = false;
 
-		LinkedList *ilist = game->items->getAllItems();
-		// NOTE: need to use safe iterator, as running an item script may
-		// delete it.
-		SafeLinkedListIterator iter(ilist);
+		// NOTE: running an item script may delete it (the slot map
+		// iterator allows that, without copying the list).
+		SlotMap<Item>::Iterator iter(game->items->getAllItemSlots());
 		while(iter.iterateAvailable())
 		{
-			Item *item = (Item *)iter.iterateNext();
+			Item *item = iter.iterateNext();
 
 			// run executes...
 			if (item->isEnabled())
@@ -958,12 +958,11 @@ void createPhysicsForItem( Item* item, GamePhysics* physics, float mass )
 
 	void ItemManager::deleteAllLongTimeDisabledItems()
 	{
-		LinkedList *ilist = game->items->getAllItems();
-		// NOTE: need to use safe iterator, as this may delete items
-		SafeLinkedListIterator iter(ilist);
+		// NOTE: this may delete items (the slot map iterator allows that)
+		SlotMap<Item>::Iterator iter(game->items->getAllItemSlots());
 		while(iter.iterateAvailable())
 		{
-			Item *item = (Item *)iter.iterateNext();
+			Item *item = iter.iterateNext();
 
 			// run executes...
 			if (!item->isEnabled())
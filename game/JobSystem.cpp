@@ -0,0 +1,367 @@
+
+#include "precompiled.h"
+
+#include "JobSystem.h"
+
+#include <assert.h>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "../util/Debug_MemoryManager.h"
+
+namespace game
+{
+	struct JobSystemJob
+	{
+		JobSystem::JobFunction function;
+		JobCounter *counter;
+	};
+
+	struct JobSystemQueue
+	{
+		std::mutex mutex;
+		std::deque<JobSystemJob *> jobs;
+	};
+
+	// queue of the current thread, 0 for the thread that created the job system
+	// (and any other non-worker thread)
+	static thread_local int jobsystem_queueIndex = 0;
+
+
+	class JobSystemImpl
+	{
+	public:
+		int workerAmount;
+		std::vector<std::thread> workers;
+		// [0] for the creating thread, then one per worker
+		std::vector<JobSystemQueue *> queues;
+
+		// jobs in queues (not waiting for dependencies)
+		std::atomic<int> queuedAmount;
+		std::mutex sleepMutex;
+		// idle workers
+		std::condition_variable sleepCondition;
+		// threads in wait, woken by new jobs and by counters reaching zero
+		std::condition_variable waitCondition;
+		int waiterAmount;
+		bool quit;
+
+		// guards JobCounter::waitingJobs
+		std::mutex dependencyMutex;
+
+		std::atomic<int> jobAmount;
+		std::atomic<int> stealAmount;
+
+		JobSystemImpl(int workerAmount)
+			: workerAmount(workerAmount),
+			queuedAmount(0),
+			waiterAmount(0),
+			quit(false),
+			jobAmount(0),
+			stealAmount(0)
+		{
+			for (int i = 0; i < workerAmount + 1; i++)
+				queues.push_back(new JobSystemQueue());
+		}
+
+		~JobSystemImpl()
+		{
+			for (int i = 0; i < (int)queues.size(); i++)
+			{
+				assert(queues[i]->jobs.empty());
+				delete queues[i];
+			}
+		}
+
+		int getQueueIndex() const
+		{
+			int index = jobsystem_queueIndex;
+			if (index < 0 || index >= (int)queues.size())
+				index = 0;
+			return index;
+		}
+
+		void enqueue(JobSystemJob *job)
+		{
+			JobSystemQueue *queue = queues[getQueueIndex()];
+			{
+				std::unique_lock<std::mutex> lock(queue->mutex);
+				queue->jobs.push_back(job);
+			}
+			++queuedAmount;
+
+			// (taking the lock makes sure a worker checking queuedAmount
+			// is either before the check or already waiting)
+			bool waiters = false;
+			{
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				waiters = (waiterAmount > 0);
+			}
+			sleepCondition.notify_one();
+			if (waiters)
+				waitCondition.notify_all();
+		}
+
+		// own newest job first, then oldest job of the others
+		JobSystemJob *takeJob(int index)
+		{
+			if (queuedAmount.load() == 0)
+				return NULL;
+
+			{
+				JobSystemQueue *queue = queues[index];
+				std::unique_lock<std::mutex> lock(queue->mutex);
+				if (!queue->jobs.empty())
+				{
+					JobSystemJob *job = queue->jobs.back();
+					queue->jobs.pop_back();
+					--queuedAmount;
+					return job;
+				}
+			}
+
+			int queueAmount = (int)queues.size();
+			for (int i = 1; i < queueAmount; i++)
+			{
+				JobSystemQueue *queue = queues[(index + i) % queueAmount];
+				std::unique_lock<std::mutex> lock(queue->mutex);
+				if (!queue->jobs.empty())
+				{
+					JobSystemJob *job = queue->jobs.front();
+					queue->jobs.pop_front();
+					--queuedAmount;
+					++stealAmount;
+					return job;
+				}
+			}
+			return NULL;
+		}
+
+		void runJob(JobSystemJob *job)
+		{
+			job->function();
+			JobCounter *counter = job->counter;
+			delete job;
+
+			++jobAmount;
+
+			if (counter != NULL)
+			{
+				// waiting jobs must be taken before the counter reaches zero,
+				// the counter may be gone right after that
+				std::vector<JobSystemJob *> ready;
+				bool done = false;
+				{
+					std::unique_lock<std::mutex> lock(dependencyMutex);
+					if (counter->value.load() == 1)
+					{
+						ready.swap(counter->waitingJobs);
+						done = true;
+					}
+					--counter->value;
+				}
+				for (int i = 0; i < (int)ready.size(); i++)
+					enqueue(ready[i]);
+
+				if (done)
+				{
+					// (same as in enqueue, a waiter is either before its
+					// counter check or already waiting)
+					bool waiters = false;
+					{
+						std::unique_lock<std::mutex> lock(sleepMutex);
+						waiters = (waiterAmount > 0);
+					}
+					if (waiters)
+						waitCondition.notify_all();
+				}
+			}
+		}
+
+		void runWorker(int index)
+		{
+			jobsystem_queueIndex = index;
+
+			while (true)
+			{
+				JobSystemJob *job = takeJob(index);
+				if (job != NULL)
+				{
+					runJob(job);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				while (!quit && queuedAmount.load() == 0)
+					sleepCondition.wait(lock);
+				if (quit)
+					break;
+			}
+		}
+	};
+
+
+	JobCounter::JobCounter()
+		: value(0)
+	{
+	}
+
+	JobCounter::~JobCounter()
+	{
+		assert(value.load() == 0);
+		assert(waitingJobs.empty());
+	}
+
+	int JobCounter::getValue() const
+	{
+		return value.load();
+	}
+
+
+	JobSystem::JobSystem(int workerAmount)
+	{
+		if (workerAmount < 0)
+			workerAmount = 0;
+
+		impl = new JobSystemImpl(workerAmount);
+		for (int i = 0; i < workerAmount; i++)
+			impl->workers.push_back(std::thread(&JobSystemImpl::runWorker, impl, i + 1));
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::unique_lock<std::mutex> lock(impl->sleepMutex);
+			impl->quit = true;
+		}
+		impl->sleepCondition.notify_all();
+
+		for (int i = 0; i < (int)impl->workers.size(); i++)
+			impl->workers[i].join();
+
+		delete impl;
+	}
+
+	int JobSystem::getWorkerAmount() const
+	{
+		return impl->workerAmount;
+	}
+
+	void JobSystem::addJob(const JobFunction &function, JobCounter *counter, JobCounter *dependency)
+	{
+		JobSystemJob *job = new JobSystemJob();
+		job->function = function;
+		job->counter = counter;
+
+		if (counter != NULL)
+			++counter->value;
+
+		if (dependency != NULL && dependency->value.load() > 0)
+		{
+			std::unique_lock<std::mutex> lock(impl->dependencyMutex);
+			// (check again, the last job might have finished meanwhile)
+			if (dependency->value.load() > 0)
+			{
+				dependency->waitingJobs.push_back(job);
+				return;
+			}
+		}
+
+		impl->enqueue(job);
+	}
+
+	void JobSystem::wait(JobCounter *counter)
+	{
+		assert(counter != NULL);
+
+		int index = impl->getQueueIndex();
+		while (counter->value.load() > 0)
+		{
+			JobSystemJob *job = impl->takeJob(index);
+			if (job != NULL)
+			{
+				impl->runJob(job);
+				continue;
+			}
+
+			// the rest are running elsewhere (or waiting for them),
+			// sleep until something is queued or the counter is done
+			std::unique_lock<std::mutex> lock(impl->sleepMutex);
+			impl->waiterAmount++;
+			while (counter->value.load() > 0 && impl->queuedAmount.load() == 0)
+				impl->waitCondition.wait(lock);
+			impl->waiterAmount--;
+		}
+	}
+
+	int JobSystem::getChunkAmount(int start, int end, int chunkSize)
+	{
+		if (end <= start)
+			return 0;
+		if (chunkSize < 1)
+			chunkSize = 1;
+		return (end - start + chunkSize - 1) / chunkSize;
+	}
+
+	void JobSystem::parallelFor(int start, int end, int chunkSize, const ParallelForFunction &function)
+	{
+		if (chunkSize < 1)
+			chunkSize = 1;
+
+		int chunkAmount = getChunkAmount(start, end, chunkSize);
+		if (chunkAmount == 0)
+			return;
+
+		// not worth the job overhead
+		if (chunkAmount == 1 || impl->workerAmount == 0)
+		{
+			for (int i = 0; i < chunkAmount; i++)
+			{
+				int chunkStart = start + i * chunkSize;
+				int chunkEnd = chunkStart + chunkSize;
+				if (chunkEnd > end)
+					chunkEnd = end;
+				function(chunkStart, chunkEnd, i);
+			}
+			return;
+		}
+
+		JobCounter counter;
+		// (added last chunk first, so the calling thread starts from the first one)
+		for (int i = chunkAmount - 1; i >= 0; i--)
+		{
+			int chunkStart = start + i * chunkSize;
+			int chunkEnd = chunkStart + chunkSize;
+			if (chunkEnd > end)
+				chunkEnd = end;
+			const ParallelForFunction *func = &function;
+			addJob([func, chunkStart, chunkEnd, i]() { (*func)(chunkStart, chunkEnd, i); }, &counter);
+		}
+		wait(&counter);
+	}
+
+	int JobSystem::getJobAmount() const
+	{
+		return impl->jobAmount.load();
+	}
+
+	int JobSystem::getStealAmount() const
+	{
+		return impl->stealAmount.load();
+	}
+
+	int JobSystem::getDefaultWorkerAmount()
+	{
+		// the game thread runs jobs too while waiting
+		int cores = (int)std::thread::hardware_concurrency();
+		int workers = cores - 1;
+		if (workers < 0)
+			workers = 0;
+		if (workers > 7)
+			workers = 7;
+		return workers;
+	}
+}
+
@@ -0,0 +1,92 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <functional>
+#include <vector>
+#include <atomic>
+
+namespace game
+{
+	class JobSystemImpl;
+	struct JobSystemJob;
+
+	/**
+	 * Counts unfinished jobs. A job given a counter adds one to it when
+	 * added and takes one off when done, jobs may also wait for a counter
+	 * to reach zero before they start.
+	 */
+	class JobCounter
+	{
+	public:
+		JobCounter();
+		~JobCounter();
+
+		int getValue() const;
+
+	private:
+		std::atomic<int> value;
+		// jobs waiting for this to reach zero (guarded by the job system)
+		std::vector<JobSystemJob *> waitingJobs;
+
+		JobCounter(const JobCounter &);
+		JobCounter &operator= (const JobCounter &);
+
+		friend class JobSystem;
+		friend class JobSystemImpl;
+	};
+
+	/**
+	 * Game tick job system.
+	 *
+	 * Each worker thread (and the thread that created the job system) has
+	 * a deque of jobs. Jobs added from a thread go to its own deque, a
+	 * thread runs its newest jobs first and steals the oldest ones from
+	 * others when it runs out. The creating thread runs jobs while it
+	 * waits for a counter, and sleeps when the rest are running elsewhere.
+	 *
+	 * Jobs may run in any order on any thread. For deterministic results
+	 * (anything that feeds GameRandom or game state), have each job write
+	 * to its own slot and merge the slots in order afterwards, as
+	 * parallelFor chunks do. Chunk boundaries only depend on the range and
+	 * chunk size, never on the worker amount.
+	 *
+	 * @author Frozenbyte
+	 */
+	class JobSystem
+	{
+	public:
+		typedef std::function<void()> JobFunction;
+		// start and end of the chunk, chunk number (0 based, in range order)
+		typedef std::function<void(int, int, int)> ParallelForFunction;
+
+		// workerAmount 0 runs all jobs on the creating thread (in wait)
+		JobSystem(int workerAmount);
+		~JobSystem();
+
+		int getWorkerAmount() const;
+
+		// counter (if given) is increased now and decreased when the job is done.
+		// if dependency is given, the job will not start before it reaches zero.
+		void addJob(const JobFunction &function, JobCounter *counter, JobCounter *dependency = 0);
+
+		// runs jobs until counter reaches zero (sleeps while none can be taken)
+		void wait(JobCounter *counter);
+
+		// runs function for [start, end) split in chunks of chunkSize, blocks until done
+		void parallelFor(int start, int end, int chunkSize, const ParallelForFunction &function);
+		static int getChunkAmount(int start, int end, int chunkSize);
+
+		// statistics, since creation
+		int getJobAmount() const;
+		int getStealAmount() const;
+
+		// worker count suitable for this machine (creating thread not counted)
+		static int getDefaultWorkerAmount();
+
+	private:
+		JobSystemImpl *impl;
+	};
+}
+
+#endif
+
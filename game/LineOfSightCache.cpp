@@ -0,0 +1,214 @@
+
+#include "precompiled.h"
+
+#include "LineOfSightCache.h"
+
+#include <math.h>
+#include <assert.h>
+#include <unordered_map>
+
+#include "../util/Debug_MemoryManager.h"
+
+// end points closer than this (meters) share results
+#define LOS_CACHE_CELL_SIZE 0.5f
+
+// when there are more results than this, old ones are dropped
+#define LOS_CACHE_MAX_ENTRIES 8192
+
+namespace game
+{
+	struct LineOfSightCacheKey
+	{
+		int ax, ay, az;
+		int bx, by, bz;
+
+		bool operator== (const LineOfSightCacheKey &other) const
+		{
+			return ax == other.ax && ay == other.ay && az == other.az
+				&& bx == other.bx && by == other.by && bz == other.bz;
+		}
+	};
+
+	struct LineOfSightCacheKeyHash
+	{
+		size_t operator() (const LineOfSightCacheKey &key) const
+		{
+			size_t h = (size_t)key.ax;
+			h = h * 31 + (size_t)key.ay;
+			h = h * 31 + (size_t)key.az;
+			h = h * 31 + (size_t)key.bx;
+			h = h * 31 + (size_t)key.by;
+			h = h * 31 + (size_t)key.bz;
+			return h;
+		}
+	};
+
+	struct LineOfSightCacheEntry
+	{
+		int collisionEpoch;
+		int tick;
+		bool visible;
+	};
+
+	class LineOfSightCacheImpl
+	{
+		private:
+			LineOfSightCacheImpl()
+			:	lifetime(0),
+				hits(0),
+				misses(0)
+			{
+			}
+
+			static int quantize(float value)
+			{
+				return (int)floorf(value * (1.0f / LOS_CACHE_CELL_SIZE));
+			}
+
+			// same key for both directions
+			static LineOfSightCacheKey makeKey(const VC3 &from, const VC3 &to)
+			{
+				LineOfSightCacheKey key;
+				key.ax = quantize(from.x);
+				key.ay = quantize(from.y);
+				key.az = quantize(from.z);
+				key.bx = quantize(to.x);
+				key.by = quantize(to.y);
+				key.bz = quantize(to.z);
+
+				if (key.bx < key.ax
+					|| (key.bx == key.ax && (key.bz < key.az
+					|| (key.bz == key.az && key.by < key.ay))))
+				{
+					LineOfSightCacheKey swapped;
+					swapped.ax = key.bx;
+					swapped.ay = key.by;
+					swapped.az = key.bz;
+					swapped.bx = key.ax;
+					swapped.by = key.ay;
+					swapped.bz = key.az;
+					return swapped;
+				}
+				return key;
+			}
+
+			bool isValid(const LineOfSightCacheEntry &entry, int collisionEpoch, int tick) const
+			{
+				return entry.collisionEpoch == collisionEpoch
+					&& tick - entry.tick < lifetime
+					&& tick >= entry.tick;
+			}
+
+			void removeExpired(int collisionEpoch, int tick)
+			{
+				EntryMap::iterator it = entries.begin();
+				while (it != entries.end())
+				{
+					if (isValid(it->second, collisionEpoch, tick))
+						++it;
+					else
+						it = entries.erase(it);
+				}
+			}
+
+			typedef std::unordered_map<LineOfSightCacheKey, LineOfSightCacheEntry, LineOfSightCacheKeyHash> EntryMap;
+			EntryMap entries;
+
+			int lifetime;
+			int hits;
+			int misses;
+
+		friend class LineOfSightCache;
+	};
+
+
+	LineOfSightCache::LineOfSightCache()
+	{
+		impl = new LineOfSightCacheImpl();
+	}
+
+	LineOfSightCache::~LineOfSightCache()
+	{
+		delete impl;
+	}
+
+	void LineOfSightCache::setLifetime(int ticks)
+	{
+		if (ticks < 0)
+			ticks = 0;
+		if (ticks == 0 && impl->lifetime != 0)
+			impl->entries.clear();
+		impl->lifetime = ticks;
+	}
+
+	int LineOfSightCache::getLifetime() const
+	{
+		return impl->lifetime;
+	}
+
+	bool LineOfSightCache::getResult(const VC3 &from, const VC3 &to, int collisionEpoch, int tick, bool &visible)
+	{
+		if (impl->lifetime == 0)
+			return false;
+
+		LineOfSightCacheImpl::EntryMap::const_iterator it = impl->entries.find(LineOfSightCacheImpl::makeKey(from, to));
+		if (it != impl->entries.end()
+			&& impl->isValid(it->second, collisionEpoch, tick))
+		{
+			visible = it->second.visible;
+			impl->hits++;
+			return true;
+		}
+
+		impl->misses++;
+		return false;
+	}
+
+	void LineOfSightCache::setResult(const VC3 &from, const VC3 &to, int collisionEpoch, int tick, bool visible)
+	{
+		if (impl->lifetime == 0)
+			return;
+
+		if (impl->entries.size() >= LOS_CACHE_MAX_ENTRIES)
+		{
+			impl->removeExpired(collisionEpoch, tick);
+			if (impl->entries.size() >= LOS_CACHE_MAX_ENTRIES)
+				impl->entries.clear();
+		}
+
+		LineOfSightCacheEntry &entry = impl->entries[LineOfSightCacheImpl::makeKey(from, to)];
+		entry.collisionEpoch = collisionEpoch;
+		entry.tick = tick;
+		entry.visible = visible;
+	}
+
+	void LineOfSightCache::clear()
+	{
+		impl->entries.clear();
+	}
+
+	int LineOfSightCache::getHitAmount() const
+	{
+		return impl->hits;
+	}
+
+	int LineOfSightCache::getMissAmount() const
+	{
+		return impl->misses;
+	}
+
+	float LineOfSightCache::getHitRate() const
+	{
+		int total = impl->hits + impl->misses;
+		if (total == 0)
+			return 0.0f;
+		return (float)impl->hits / (float)total;
+	}
+
+	void LineOfSightCache::resetStats()
+	{
+		impl->hits = 0;
+		impl->misses = 0;
+	}
+}
+
@@ -0,0 +1,49 @@
+
+#ifndef LINEOFSIGHTCACHE_H
+#define LINEOFSIGHTCACHE_H
+
+#include <DatatypeDef.h>
+
+namespace game
+{
+	class LineOfSightCacheImpl;
+
+	/**
+	 * Remembers line of sight raytrace results for a few ticks.
+	 *
+	 * Results are keyed by the quantized end points, either way round
+	 * (A seeing B gives B seeing A), and the GameMap collision epoch at
+	 * the time of the trace. Static collision changes thus drop all old
+	 * results, moving things (units, doors) are only covered by the
+	 * lifetime, which should be kept short.
+	 */
+	class LineOfSightCache
+	{
+	public:
+		LineOfSightCache();
+		~LineOfSightCache();
+
+		// in game ticks, 0 disables the cache
+		void setLifetime(int ticks);
+		int getLifetime() const;
+
+		// returns true if the result is known (given in visible)
+		bool getResult(const VC3 &from, const VC3 &to, int collisionEpoch, int tick, bool &visible);
+		void setResult(const VC3 &from, const VC3 &to, int collisionEpoch, int tick, bool visible);
+
+		void clear();
+
+		// statistics, since last resetStats
+		int getHitAmount() const;
+		int getMissAmount() const;
+		// hits / (hits + misses), 0 if nothing asked yet
+		float getHitRate() const;
+		void resetStats();
+
+	private:
+		LineOfSightCacheImpl *impl;
+	};
+}
+
+#endif
+
@@ -0,0 +1,295 @@
+
+#include "precompiled.h"
+
+#include "LoadTaskGraph.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "../system/Logger.h"
+#include "../system/LoadTrace.h"
+
+#include "../util/Debug_MemoryManager.h"
+
+namespace game
+{
+	typedef std::chrono::steady_clock LoadTaskClock;
+
+	struct LoadTask
+	{
+		std::string name;
+		LoadTaskGraph::TASK_THREAD thread;
+		LoadTaskGraph::TaskFunction function;
+
+		std::vector<int> dependents;
+		int dependencyAmount;
+		int pendingDependencies;
+
+		// msec from start of run
+		int startTime;
+		int endTime;
+		bool ranOnWorker;
+
+		LoadTask()
+			: thread(LoadTaskGraph::TASK_THREAD_MAIN),
+			dependencyAmount(0),
+			pendingDependencies(0),
+			startTime(0),
+			endTime(0),
+			ranOnWorker(false)
+		{
+		}
+	};
+
+
+	class LoadTaskGraphImpl
+	{
+	public:
+		int workerAmount;
+		std::vector<LoadTask> tasks;
+
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<int> mainReady;
+		std::deque<int> workerReady;
+		int finishedAmount;
+		int runningAmount;
+		bool failed;
+
+		LoadTaskClock::time_point runStartTime;
+		int runTime;
+
+		LoadTaskGraphImpl(int workerAmount)
+			: workerAmount(workerAmount),
+			finishedAmount(0),
+			runningAmount(0),
+			failed(false),
+			runTime(0)
+		{
+		}
+
+		int getTime() const
+		{
+			LoadTaskClock::duration time = LoadTaskClock::now() - runStartTime;
+			return (int)std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+		}
+
+		bool isDone() const
+		{
+			return failed || finishedAmount == (int)tasks.size();
+		}
+
+		void makeReady(int task)
+		{
+			if (tasks[task].thread == LoadTaskGraph::TASK_THREAD_WORKER && workerAmount > 0)
+				workerReady.push_back(task);
+			else
+				mainReady.push_back(task);
+		}
+
+		// mutex must be locked
+		void checkStall()
+		{
+			// dependency cycle, nothing can become ready anymore
+			if (!isDone() && runningAmount == 0 && mainReady.empty() && workerReady.empty())
+			{
+				failed = true;
+				condition.notify_all();
+			}
+		}
+
+		void runTask(int task, bool onWorker)
+		{
+			LoadTask &t = tasks[task];
+			t.startTime = getTime();
+			t.ranOnWorker = onWorker;
+
+			if (t.function)
+			{
+				LoadTraceScope trace("load", t.name.c_str());
+				t.function();
+			}
+
+			t.endTime = getTime();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			--runningAmount;
+			++finishedAmount;
+			for (int i = 0; i < (int)t.dependents.size(); i++)
+			{
+				LoadTask &dependent = tasks[t.dependents[i]];
+				assert(dependent.pendingDependencies > 0);
+				if (--dependent.pendingDependencies == 0)
+					makeReady(t.dependents[i]);
+			}
+			checkStall();
+			condition.notify_all();
+		}
+
+		void runWorker()
+		{
+			while (true)
+			{
+				int task = -1;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					while (workerReady.empty() && !isDone())
+						condition.wait(lock);
+
+					if (workerReady.empty())
+						return;
+
+					task = workerReady.front();
+					workerReady.pop_front();
+					++runningAmount;
+				}
+
+				runTask(task, true);
+			}
+		}
+	};
+
+
+	LoadTaskGraph::LoadTaskGraph(int workerAmount)
+	{
+		assert(workerAmount >= 0);
+		impl = new LoadTaskGraphImpl(workerAmount);
+	}
+
+	LoadTaskGraph::~LoadTaskGraph()
+	{
+		assert(impl != NULL);
+		delete impl;
+	}
+
+	int LoadTaskGraph::addTask(const char *name, TASK_THREAD thread, const TaskFunction &function)
+	{
+		assert(name != NULL);
+
+		LoadTask task;
+		task.name = name;
+		task.thread = thread;
+		task.function = function;
+		impl->tasks.push_back(task);
+
+		return (int)impl->tasks.size() - 1;
+	}
+
+	void LoadTaskGraph::addDependency(int task, int dependsOnTask)
+	{
+		assert(task >= 0 && task < (int)impl->tasks.size());
+		assert(dependsOnTask >= 0 && dependsOnTask < (int)impl->tasks.size());
+		assert(task != dependsOnTask);
+
+		impl->tasks[dependsOnTask].dependents.push_back(task);
+		impl->tasks[task].dependencyAmount++;
+	}
+
+	void LoadTaskGraph::run()
+	{
+		LoadTaskGraphImpl &g = *impl;
+
+		g.mainReady.clear();
+		g.workerReady.clear();
+		g.finishedAmount = 0;
+		g.runningAmount = 0;
+		g.failed = false;
+		g.runStartTime = LoadTaskClock::now();
+
+		bool hasWorkerTasks = false;
+		for (int i = 0; i < (int)g.tasks.size(); i++)
+		{
+			LoadTask &t = g.tasks[i];
+			t.pendingDependencies = t.dependencyAmount;
+			t.startTime = 0;
+			t.endTime = 0;
+			if (t.thread == TASK_THREAD_WORKER)
+				hasWorkerTasks = true;
+			if (t.pendingDependencies == 0)
+				g.makeReady(i);
+		}
+
+		std::vector<std::thread> workers;
+		if (hasWorkerTasks)
+		{
+			for (int i = 0; i < g.workerAmount; i++)
+				workers.push_back(std::thread(&LoadTaskGraphImpl::runWorker, &g));
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(g.mutex);
+			g.checkStall();
+		}
+
+		while (true)
+		{
+			int task = -1;
+			{
+				std::unique_lock<std::mutex> lock(g.mutex);
+				while (g.mainReady.empty() && !g.isDone())
+					g.condition.wait(lock);
+
+				if (g.mainReady.empty())
+					break;
+
+				task = g.mainReady.front();
+				g.mainReady.pop_front();
+				++g.runningAmount;
+			}
+
+			g.runTask(task, false);
+		}
+
+		for (int i = 0; i < (int)workers.size(); i++)
+			workers[i].join();
+
+		g.runTime = g.getTime();
+
+		if (g.failed)
+		{
+			Logger::getInstance()->error("LoadTaskGraph::run - Tasks have cyclic dependencies, some were not run.");
+			assert(!"LoadTaskGraph::run - Tasks have cyclic dependencies.");
+		}
+	}
+
+	void LoadTaskGraph::logTimings() const
+	{
+		const LoadTaskGraphImpl &g = *impl;
+
+		int taskTimeTotal = 0;
+		Logger::getInstance()->debug("LoadTaskGraph - Task timings follow (start / duration msec):");
+		for (int i = 0; i < (int)g.tasks.size(); i++)
+		{
+			const LoadTask &t = g.tasks[i];
+			int duration = t.endTime - t.startTime;
+			taskTimeTotal += duration;
+
+			char buf[256];
+			sprintf(buf, "%-24s %6d / %6d (%s)", t.name.c_str(), t.startTime, duration, t.ranOnWorker ? "worker" : "main");
+			Logger::getInstance()->debug(buf);
+		}
+
+		char buf[256];
+		sprintf(buf, "LoadTaskGraph - Total %d msec, task time sum %d msec, %d worker threads.", g.runTime, taskTimeTotal, g.workerAmount);
+		Logger::getInstance()->debug(buf);
+	}
+
+	int LoadTaskGraph::getDefaultWorkerAmount()
+	{
+		// main thread is busy with its own tasks
+		int cores = (int)std::thread::hardware_concurrency();
+		int workers = cores - 1;
+		if (workers < 1)
+			workers = 1;
+		if (workers > 4)
+			workers = 4;
+		return workers;
+	}
+}
+
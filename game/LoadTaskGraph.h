@@ -0,0 +1,57 @@
+
+#ifndef LOADTASKGRAPH_H
+#define LOADTASKGRAPH_H
+
+#include <functional>
+
+namespace game
+{
+	class LoadTaskGraphImpl;
+
+	/**
+	 * Runs mission loading stages in dependency order.
+	 *
+	 * Each task declares the tasks whose results it needs. Worker tasks
+	 * (file reading, decompression, other pure data work) run on worker
+	 * threads, main thread tasks (anything touching the renderer, scripts
+	 * or physics) run on the thread that calls run(), in the order they
+	 * become ready. Per task timings are written to log.
+	 *
+	 * @author Frozenbyte
+	 */
+	class LoadTaskGraph
+	{
+	public:
+		enum TASK_THREAD
+		{
+			TASK_THREAD_MAIN = 1,
+			TASK_THREAD_WORKER = 2
+		};
+
+		typedef std::function<void()> TaskFunction;
+
+		// workerAmount 0 runs worker tasks on main thread as well
+		LoadTaskGraph(int workerAmount);
+		~LoadTaskGraph();
+
+		// returns task id, used for adding dependencies
+		int addTask(const char *name, TASK_THREAD thread, const TaskFunction &function);
+
+		// task will not start before dependsOnTask has finished
+		void addDependency(int task, int dependsOnTask);
+
+		// blocks until all tasks are done
+		void run();
+
+		void logTimings() const;
+
+		// worker count suitable for this machine (at least 1)
+		static int getDefaultWorkerAmount();
+
+	private:
+		LoadTaskGraphImpl *impl;
+	};
+}
+
+#endif
+
@@ -0,0 +1,365 @@
+
+#include "precompiled.h"
+
+#include "ObstacleMapFile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "../filesystem/input_stream_wrapper.h"
+#include "../filesystem/crc32.h"
+#include "../filesystem/detail/lz_codec.h"
+#include "../filesystem/detail/lz_package_format.h"
+#include "../system/Logger.h"
+
+#include "../util/Debug_MemoryManager.h"
+
+using namespace frozenbyte::filesystem;
+
+namespace game
+{
+	static const char OBSTACLEMAP_ID[4] = { 'O', 'B', 'M', 'P' };
+	static const unsigned int OBSTACLEMAP_VERSION = 1;
+	static const int OBSTACLEMAP_HEADER_SIZE = 16;
+	static const int OBSTACLEMAP_PLANE_SIZE = 20;
+	static const int OBSTACLEMAP_BLOCK_SIZE = 16;
+
+	// uncompressed size of a block, roughly
+	static const int OBSTACLEMAP_BLOCK_BYTES = 64 * 1024;
+
+	struct ObstacleMapPlane
+	{
+		int elementSize;
+		int rowSize;
+		int rowAmount;
+		int rowsPerBlock;
+		ObstacleMapFile::RowFunction rowFunction;
+
+		int getRowBytes() const
+		{
+			return elementSize * rowSize;
+		}
+
+		int getBlockAmount() const
+		{
+			return (rowAmount + rowsPerBlock - 1) / rowsPerBlock;
+		}
+	};
+
+	struct ObstacleMapBlock
+	{
+		int plane;
+		int firstRow;
+		int rowAmount;
+
+		unsigned int offset;
+		unsigned int packedSize;
+		unsigned int size;
+		unsigned int crc;
+	};
+
+
+	class ObstacleMapFileImpl
+	{
+	public:
+		std::vector<ObstacleMapPlane> planes;
+
+		void makeBlocks(std::vector<ObstacleMapBlock> &result) const
+		{
+			result.clear();
+			for (int p = 0; p < (int)planes.size(); p++)
+			{
+				const ObstacleMapPlane &plane = planes[p];
+				for (int row = 0; row < plane.rowAmount; row += plane.rowsPerBlock)
+				{
+					ObstacleMapBlock block;
+					block.plane = p;
+					block.firstRow = row;
+					block.rowAmount = plane.rowAmount - row;
+					if (block.rowAmount > plane.rowsPerBlock)
+						block.rowAmount = plane.rowsPerBlock;
+					block.offset = 0;
+					block.packedSize = 0;
+					block.size = block.rowAmount * plane.getRowBytes();
+					block.crc = 0;
+					result.push_back(block);
+				}
+			}
+		}
+
+		// rows of the block are one contiguous range in memory
+		unsigned char *getContiguousRows(const ObstacleMapBlock &block) const
+		{
+			const ObstacleMapPlane &plane = planes[block.plane];
+			unsigned char *first = plane.rowFunction(block.firstRow);
+			for (int i = 1; i < block.rowAmount; i++)
+			{
+				if (plane.rowFunction(block.firstRow + i) != first + i * plane.getRowBytes())
+					return NULL;
+			}
+			return first;
+		}
+
+		bool unpackBlock(const ObstacleMapBlock &block, const unsigned char *source, std::vector<unsigned char> &tempBuffer) const
+		{
+			const ObstacleMapPlane &plane = planes[block.plane];
+			int rowBytes = plane.getRowBytes();
+
+			if (calculateCrc32(source, block.packedSize) != block.crc)
+				return false;
+
+			const unsigned char *rows = source;
+			if (block.packedSize != block.size)
+			{
+				unsigned char *destination = getContiguousRows(block);
+				if (destination != NULL)
+					return lz::decompress(source, block.packedSize, destination, block.size);
+
+				tempBuffer.resize(block.size);
+				if (!lz::decompress(source, block.packedSize, &tempBuffer[0], block.size))
+					return false;
+				rows = &tempBuffer[0];
+			}
+
+			for (int i = 0; i < block.rowAmount; i++)
+				memcpy(plane.rowFunction(block.firstRow + i), rows + i * rowBytes, rowBytes);
+
+			return true;
+		}
+	};
+
+
+	ObstacleMapFile::ObstacleMapFile()
+	{
+		impl = new ObstacleMapFileImpl();
+	}
+
+	ObstacleMapFile::~ObstacleMapFile()
+	{
+		assert(impl != NULL);
+		delete impl;
+	}
+
+	void ObstacleMapFile::addPlane(int elementSize, int rowSize, int rowAmount, const RowFunction &rowFunction)
+	{
+		assert(elementSize > 0 && rowSize > 0 && rowAmount > 0);
+
+		ObstacleMapPlane plane;
+		plane.elementSize = elementSize;
+		plane.rowSize = rowSize;
+		plane.rowAmount = rowAmount;
+		plane.rowsPerBlock = OBSTACLEMAP_BLOCK_BYTES / plane.getRowBytes();
+		if (plane.rowsPerBlock < 1)
+			plane.rowsPerBlock = 1;
+		plane.rowFunction = rowFunction;
+		impl->planes.push_back(plane);
+	}
+
+	bool ObstacleMapFile::write(const char *filename) const
+	{
+		assert(filename != NULL);
+
+		std::vector<ObstacleMapBlock> blocks;
+		impl->makeBlocks(blocks);
+
+		std::vector<unsigned char> blockData;
+		std::vector<unsigned char> rows;
+		std::vector<unsigned char> packed;
+		for (int b = 0; b < (int)blocks.size(); b++)
+		{
+			ObstacleMapBlock &block = blocks[b];
+			const ObstacleMapPlane &plane = impl->planes[block.plane];
+			int rowBytes = plane.getRowBytes();
+
+			rows.resize(block.size);
+			for (int i = 0; i < block.rowAmount; i++)
+				memcpy(&rows[i * rowBytes], plane.rowFunction(block.firstRow + i), rowBytes);
+
+			packed.resize(lz::compressBound(block.size));
+			int packedSize = lz::compress(&rows[0], block.size, &packed[0], (int)packed.size());
+
+			const unsigned char *stored = &rows[0];
+			block.packedSize = block.size;
+			if (packedSize > 0 && packedSize < (int)block.size)
+			{
+				stored = &packed[0];
+				block.packedSize = packedSize;
+			}
+
+			block.offset = blockData.size();
+			block.crc = calculateCrc32(stored, block.packedSize);
+			blockData.insert(blockData.end(), stored, stored + block.packedSize);
+		}
+
+		unsigned int dataStart = OBSTACLEMAP_HEADER_SIZE + impl->planes.size() * OBSTACLEMAP_PLANE_SIZE + blocks.size() * OBSTACLEMAP_BLOCK_SIZE;
+
+		std::vector<unsigned char> header;
+		header.insert(header.end(), OBSTACLEMAP_ID, OBSTACLEMAP_ID + 4);
+		lz::putUInt(header, OBSTACLEMAP_VERSION);
+		lz::putUInt(header, dataStart + blockData.size());
+		lz::putUInt(header, impl->planes.size());
+		for (int p = 0; p < (int)impl->planes.size(); p++)
+		{
+			const ObstacleMapPlane &plane = impl->planes[p];
+			lz::putUInt(header, plane.elementSize);
+			lz::putUInt(header, plane.rowSize);
+			lz::putUInt(header, plane.rowAmount);
+			lz::putUInt(header, plane.rowsPerBlock);
+			lz::putUInt(header, plane.getBlockAmount());
+		}
+		for (int b = 0; b < (int)blocks.size(); b++)
+		{
+			lz::putUInt(header, dataStart + blocks[b].offset);
+			lz::putUInt(header, blocks[b].packedSize);
+			lz::putUInt(header, blocks[b].size);
+			lz::putUInt(header, blocks[b].crc);
+		}
+		assert(header.size() == dataStart);
+
+		FILE *f = fopen(filename, "wb");
+		if (f == NULL)
+		{
+			Logger::getInstance()->error("ObstacleMapFile::write - Could not open file.");
+			Logger::getInstance()->debug(filename);
+			return false;
+		}
+
+		bool success = fwrite(&header[0], header.size(), 1, f) == 1;
+		if (success && !blockData.empty())
+			success = fwrite(&blockData[0], blockData.size(), 1, f) == 1;
+		fclose(f);
+
+		if (!success)
+		{
+			Logger::getInstance()->error("ObstacleMapFile::write - Error writing file.");
+			Logger::getInstance()->debug(filename);
+		}
+		return success;
+	}
+
+	ObstacleMapFile::READ_RESULT ObstacleMapFile::read(const char *filename, int threadAmount)
+	{
+		assert(filename != NULL);
+
+		std::vector<unsigned char> file;
+		{
+			FB_FILE *f = fb_fopen(filename, "rb");
+			if (f == NULL)
+			{
+				Logger::getInstance()->error("ObstacleMapFile::read - Could not open file.");
+				Logger::getInstance()->debug(filename);
+				return READ_FAILED;
+			}
+
+			file.resize(fb_fsize(f));
+			bool got = file.empty() || fb_fread(&file[0], file.size(), 1, f) == 1;
+			fb_fclose(f);
+
+			if (!got)
+			{
+				Logger::getInstance()->error("ObstacleMapFile::read - Error reading file.");
+				Logger::getInstance()->debug(filename);
+				return READ_FAILED;
+			}
+		}
+
+		if (file.size() < (size_t)OBSTACLEMAP_HEADER_SIZE || memcmp(&file[0], OBSTACLEMAP_ID, 4) != 0)
+			return READ_OTHER_FORMAT;
+
+		std::vector<ObstacleMapBlock> blocks;
+		impl->makeBlocks(blocks);
+
+		const unsigned char *header = &file[0];
+		unsigned int planeAmount = lz::getUInt(header + 12);
+		size_t dataStart = OBSTACLEMAP_HEADER_SIZE + (size_t)planeAmount * OBSTACLEMAP_PLANE_SIZE + blocks.size() * OBSTACLEMAP_BLOCK_SIZE;
+
+		if (lz::getUInt(header + 4) != OBSTACLEMAP_VERSION
+			|| lz::getUInt(header + 8) != file.size()
+			|| planeAmount != impl->planes.size()
+			|| dataStart > file.size())
+		{
+			Logger::getInstance()->error("ObstacleMapFile::read - Unsupported version or map size mismatch.");
+			Logger::getInstance()->debug(filename);
+			return READ_FAILED;
+		}
+
+		const unsigned char *planeData = header + OBSTACLEMAP_HEADER_SIZE;
+		for (int p = 0; p < (int)impl->planes.size(); p++)
+		{
+			const ObstacleMapPlane &plane = impl->planes[p];
+			const unsigned char *entry = planeData + p * OBSTACLEMAP_PLANE_SIZE;
+			if (lz::getUInt(entry) != (unsigned int)plane.elementSize
+				|| lz::getUInt(entry + 4) != (unsigned int)plane.rowSize
+				|| lz::getUInt(entry + 8) != (unsigned int)plane.rowAmount
+				|| lz::getUInt(entry + 12) != (unsigned int)plane.rowsPerBlock
+				|| lz::getUInt(entry + 16) != (unsigned int)plane.getBlockAmount())
+			{
+				Logger::getInstance()->error("ObstacleMapFile::read - Map size mismatch.");
+				Logger::getInstance()->debug(filename);
+				return READ_FAILED;
+			}
+		}
+
+		const unsigned char *blockData = planeData + impl->planes.size() * OBSTACLEMAP_PLANE_SIZE;
+		for (int b = 0; b < (int)blocks.size(); b++)
+		{
+			ObstacleMapBlock &block = blocks[b];
+			const unsigned char *entry = blockData + b * OBSTACLEMAP_BLOCK_SIZE;
+			block.offset = lz::getUInt(entry);
+			block.packedSize = lz::getUInt(entry + 4);
+			block.crc = lz::getUInt(entry + 12);
+
+			if (lz::getUInt(entry + 8) != block.size
+				|| block.packedSize > block.size
+				|| block.offset < dataStart
+				|| block.offset > file.size()
+				|| block.packedSize > file.size() - block.offset)
+			{
+				Logger::getInstance()->error("ObstacleMapFile::read - Invalid block table.");
+				Logger::getInstance()->debug(filename);
+				return READ_FAILED;
+			}
+		}
+
+		// blocks do not share rows, so they can be unpacked in any order
+		std::atomic<int> nextBlock(0);
+		std::atomic<bool> failed(false);
+		const unsigned char *fileData = &file[0];
+		auto unpackBlocks = [&]()
+		{
+			std::vector<unsigned char> tempBuffer;
+			while (!failed)
+			{
+				int b = nextBlock++;
+				if (b >= (int)blocks.size())
+					break;
+
+				if (!impl->unpackBlock(blocks[b], fileData + blocks[b].offset, tempBuffer))
+					failed = true;
+			}
+		};
+
+		if (threadAmount > (int)blocks.size())
+			threadAmount = (int)blocks.size();
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadAmount; i++)
+			threads.push_back(std::thread(unpackBlocks));
+		unpackBlocks();
+		for (int i = 0; i < (int)threads.size(); i++)
+			threads[i].join();
+
+		if (failed)
+		{
+			Logger::getInstance()->error("ObstacleMapFile::read - Corrupted block data.");
+			Logger::getInstance()->debug(filename);
+			return READ_FAILED;
+		}
+
+		return READ_OK;
+	}
+}
+
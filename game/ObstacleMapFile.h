@@ -0,0 +1,63 @@
+
+#ifndef OBSTACLEMAPFILE_H
+#define OBSTACLEMAPFILE_H
+
+#include <functional>
+
+namespace game
+{
+	class ObstacleMapFileImpl;
+
+	/**
+	 * Block compressed obstacle/area map file (obstacle.bin).
+	 *
+	 * The file holds a number of 2D planes (obstacle heights, area masks,
+	 * pathfind blocking counts, pathfind heights). Each plane is split into
+	 * bands of rows, and each band is LZ compressed on its own (or stored
+	 * as is if it does not compress), so bands can be unpacked in parallel
+	 * and straight into the buffers the game uses.
+	 *
+	 * Planes are described by a row function returning where each row
+	 * lives in memory, so a plane may be a plain array or something like
+	 * per column vectors. Planes must be added in the same order and with
+	 * the same sizes for writing and reading.
+	 *
+	 * Format:
+	 *   header: id "OBMP", version, file size, plane amount
+	 *   planes: element size, row size (elements), row amount, rows per block, block amount
+	 *   blocks: offset, packed size, size, crc32 of packed data
+	 *   block data
+	 * All values 32 bit little endian. Packed size equal to size means stored.
+	 *
+	 * @author Frozenbyte
+	 */
+	class ObstacleMapFile
+	{
+	public:
+		enum READ_RESULT
+		{
+			READ_OK = 1,
+			READ_FAILED = 2,
+			// file is something else (the older rle packed format)
+			READ_OTHER_FORMAT = 3
+		};
+
+		typedef std::function<unsigned char *(int row)> RowFunction;
+
+		ObstacleMapFile();
+		~ObstacleMapFile();
+
+		void addPlane(int elementSize, int rowSize, int rowAmount, const RowFunction &rowFunction);
+
+		bool write(const char *filename) const;
+
+		// Unpacks blocks with threadAmount threads (calling thread included)
+		READ_RESULT read(const char *filename, int threadAmount);
+
+	private:
+		ObstacleMapFileImpl *impl;
+	};
+}
+
+#endif
+
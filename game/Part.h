@@ -16,6 +16,7 @@
 
 #include "GameObject.h"
 #include "PartType.h"
+#include "../container/SlotMap.h"
 
 #include "../ui/VisualObject.h"
 
@@ -98,6 +99,11 @@ namespace game
     // not yet paid for, deleted upon exit from armor construction
     bool purchasePending; 
 
+    // handles in PartList (all parts and the owner's parts)
+    SlotMapHandle listHandle;
+    SlotMapHandle ownedListHandle;
+
+    friend class PartList;
   };
 
 }
@@ -11,28 +11,20 @@ namespace game
 
   PartList::PartList()
   {
-    allParts = new LinkedList();
-    ownedParts = new LinkedList *[ABS_MAX_PLAYERS];
+    allParts = new LinkedSlotMap<Part>();
+    ownedParts = new LinkedSlotMap<Part> *[ABS_MAX_PLAYERS];
     for (int i = 0; i < ABS_MAX_PLAYERS; i++)
     {
-      ownedParts[i] = new LinkedList();
+      ownedParts[i] = new LinkedSlotMap<Part>();
     }
   }
 
   // NOTE, does not delete the parts inside this but just the list of them
   PartList::~PartList()
   {
-    while (!allParts->isEmpty())
-    {
-      allParts->popLast();
-    }
     delete allParts;
     for (int i = 0; i < ABS_MAX_PLAYERS; i++)
     {
-      while (!ownedParts[i]->isEmpty())
-      {
-        ownedParts[i]->popLast();
-      }
       delete ownedParts[i];
     }
     delete [] ownedParts;
@@ -51,62 +43,66 @@ namespace game
 
   int PartList::getAllPartAmount()
   {
-    // TODO, optimize, not thread safe! (caller may not be using iterator)
-    int count = 0;
-    allParts->resetIterate();
-    while (allParts->iterateAvailable())
-    {
-      allParts->iterateNext();
-      count++;
-    }
-    return count;
+    return allParts->getAmount();
   }
 
   int PartList::getOwnedPartAmount(int player)
   {
-    // TODO, optimize, not thread safe! (caller may not be using iterator)
-    int count = 0;
-    ownedParts[player]->resetIterate();
-    while (ownedParts[player]->iterateAvailable())
-    {
-      ownedParts[player]->iterateNext();
-      count++;
-    }
-    return count;
+    return ownedParts[player]->getAmount();
   }
 
   LinkedList *PartList::getAllParts()
   {
-    return allParts;
+    return allParts->getLinkedList();
   }
 
   LinkedList *PartList::getOwnedParts(int player)
   {
-    return ownedParts[player];
+    return ownedParts[player]->getLinkedList();
+  }
+
+  const SlotMap<Part> *PartList::getAllPartSlots()
+  {
+    return allParts->getSlotMap();
+  }
+
+  const SlotMap<Part> *PartList::getOwnedPartSlots(int player)
+  {
+    return ownedParts[player]->getSlotMap();
   }
 
-  void PartList::addPart(Part *part)
+  SlotMapHandle PartList::addPart(Part *part)
   {
-    allParts->append(part);
+    part->listHandle = allParts->insert(part);
     int own = part->getOwner();
     if (own != NO_PART_OWNER)
     {
       if (own < 0 || own >= ABS_MAX_PLAYERS) abort();
-      ownedParts[own]->append(part);
+      part->ownedListHandle = ownedParts[own]->insert(part);
     }
+    return part->listHandle;
   }
 
   // does not delete the part, just removes it from the list
   void PartList::removePart(Part *part)
   {
-    allParts->remove(part);
+    allParts->erase(part->listHandle);
+    part->listHandle = SlotMapHandle();
     int own = part->getOwner();
     if (own != NO_PART_OWNER)
     {
       if (own < 0 || own >= ABS_MAX_PLAYERS) abort();
-      ownedParts[own]->remove(part);
+      // (owner may have been changed after adding, then the handle
+      // is from another owner's list)
+      if (ownedParts[own]->get(part->ownedListHandle) == part)
+        ownedParts[own]->erase(part->ownedListHandle);
     }    
+    part->ownedListHandle = SlotMapHandle();
   }
 
-}
+  Part *PartList::getPartBySlotHandle(const SlotMapHandle &handle)
+  {
+    return allParts->get(handle);
+  }
 
+}
@@ -3,6 +3,7 @@
 #define PARTLIST_H
 
 #include "../container/LinkedList.h"
+#include "../container/SlotMap.h"
 #include "GameObject.h"
 #include "Part.h"
 
@@ -26,12 +27,20 @@ namespace game
     LinkedList *getAllParts();
     LinkedList *getOwnedParts(int player);
 
-    void addPart(Part *part);
+    // same parts in the same order, without the list nodes
+    const SlotMap<Part> *getAllPartSlots();
+    const SlotMap<Part> *getOwnedPartSlots(int player);
+
+    // returns the handle in getAllPartSlots
+    SlotMapHandle addPart(Part *part);
     void removePart(Part *part);
 
+    // NULL if the part has been removed
+    Part *getPartBySlotHandle(const SlotMapHandle &handle);
+
   private:
-    LinkedList *allParts;
-    LinkedList **ownedParts;
+    LinkedSlotMap<Part> *allParts;
+    LinkedSlotMap<Part> **ownedParts;
   };
 
 }
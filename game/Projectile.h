@@ -13,6 +13,7 @@
 #include "tracking/ITrackerObjectType.h"
 #include "tracking/ITrackableObject.h"
 #include "IProjectileTrackerFactory.h"
+#include "../container/SlotMap.h"
 
 namespace ui
 {
@@ -247,6 +248,11 @@ namespace game
 
 		Unit *forceGoreExplosionUnit;
 
+		// handle in ProjectileList
+		SlotMapHandle listHandle;
+
+		friend class ProjectileList;
+
 	public:
 		int criticalHitDamageMax;
 		float criticalHitDamageMultiplier;
@@ -1025,7 +1025,8 @@ if (ltime < 1) ltime = 1;
 					
 					// WARNING: some magic number here
 					// (max. 35 meter radius for area damage checks)
-					IUnitListIterator *uiter = game->units->getNearbyAllUnits(projectile->getPosition(), 35.0f);
+					NearbyUnitBuffer nearUnits;
+					game->units->collectNearbyUnits(nearUnits, projectile->getPosition(), 35.0f);
 
 					float drangeSq = (float)(drange * drange);
 
@@ -1053,9 +1054,9 @@ if (ltime < 1) ltime = 1;
 					}
 
 					VC3 ppos = projectile->getPosition();
-					while (uiter->iterateAvailable())
+					for (int i = 0; i < nearUnits.getAmount(); i++)
 					{
-						Unit *u = (Unit *)uiter->iterateNext();
+						Unit *u = nearUnits.get(i);
 						if (u->isActive()
 							&& (!projectile->getBulletType()->doesNoSelfDamage()
 								|| u != projectile->getShooter())
@@ -1119,8 +1120,6 @@ if (ltime < 1) ltime = 1;
 							}
 						}
 					}
-
-					delete uiter;
 				}
 
 
@@ -1642,11 +1641,12 @@ if (ltime < 1) ltime = 1;
 		VC3 radiusPos = (projectile->getPosition() + shooterPos) / 2.0f;
 		// WARNING: some magic number here
 		// (max. 35 meter radius for hit miss checks)
-		IUnitListIterator *iter = game->units->getNearbyAllUnits(radiusPos, 35.0f);
+		NearbyUnitBuffer nearUnits;
+		game->units->collectNearbyUnits(nearUnits, radiusPos, 35.0f);
 
-		while (iter->iterateAvailable())
+		for (int i = 0; i < nearUnits.getAmount(); i++)
 		{
-			Unit *u = (Unit *)iter->iterateNext();
+			Unit *u = nearUnits.get(i);
 			if (u->isActive() && !u->isDestroyed()
 				&& game->isHostile(u->getOwner(), shooterOwner)
 				&& u != hitUnit && u != shooter)
@@ -1688,8 +1688,6 @@ if (ltime < 1) ltime = 1;
 				}
 			}
 		}
-
-		delete iter;
 	}
 
 
@@ -3009,6 +3007,8 @@ if (ltime < 1) ltime = 1;
 			}
 #endif
 
+			// one query for all the allied players
+			unsigned int allyMask = 0;
 			for (int ally = 0; ally < ABS_MAX_PLAYERS; ally++)
 			{
 				// HACK: assuming player is 0 and ally is 3. (thus, possible ally combos are 3,0 or 0,3)
@@ -3018,43 +3018,43 @@ if (ltime < 1) ltime = 1;
 					|| (ally == 3 && unit->getOwner() == 0)
 					|| (ally == 0 && unit->getIdString() != NULL && strcmp(unit->getIdString(), "arwyn") == 0))
 				{
+					allyMask |= UNITLIST_OWNER_BIT(ally);
+				}
+			}
+
+			if (allyMask != 0)
+			{
+				NearbyUnitBuffer ownUnits;
 #if defined(PROJECT_SHADOWGROUNDS)
-					// WARNING: some magic number here (range)
-					// collect units within max. 30 meters range.
-					IUnitListIterator *ownUnitsIter = game->units->getNearbyOwnedUnits(ally, weaponPosition, 30.0f);
+				// WARNING: some magic number here (range)
+				// collect units within max. 30 meters range.
+				game->units->collectNearbyUnits(ownUnits, weaponPosition, 30.0f, allyMask);
 #else
-					IUnitListIterator *ownUnitsIter = game->units->getNearbyOwnedUnits(ally, weaponPosition, UNITACTOR_DONT_HIT_FRIENDLY_RANGE);
+				game->units->collectNearbyUnits(ownUnits, weaponPosition, UNITACTOR_DONT_HIT_FRIENDLY_RANGE, allyMask);
 #endif
 
-					//LinkedList *ownulist = game->units->getOwnedUnits(ally);
-					//LinkedListIterator ownUnitsIter = LinkedListIterator(ownulist);
+				for (int i = 0; i < ownUnits.getAmount(); i++)
+				{
+					Unit *ownu = ownUnits.get(i);
 
 					// hack: when friendly fire is allowed, no player owned units are
 					// included in here, except for the unit itself
-					bool ignore_all_but_self = friendly_fire && unit->getOwner() == 0 && ally == 0;
+					bool ignore_all_but_self = friendly_fire && unit->getOwner() == 0 && ownu->getOwner() == 0;
+					if(ignore_all_but_self && ownu != unit) continue;
 
-					while (ownUnitsIter->iterateAvailable())
+					if (ownu->isActive())
 					{
-						Unit *ownu = (Unit *)ownUnitsIter->iterateNext();
-						
-						if(ignore_all_but_self && ownu != unit) continue;
-
-						if (ownu->isActive())
+						VC3 posdiff = ownu->getPosition() - weaponPosition;
+						// x meters safe distance inside which we won't hit own units
+						if (posdiff.GetSquareLength() < UNITACTOR_DONT_HIT_FRIENDLY_RANGE * UNITACTOR_DONT_HIT_FRIENDLY_RANGE)
 						{
-							VC3 posdiff = ownu->getPosition() - weaponPosition;
-							// x meters safe distance inside which we won't hit own units
-							if (posdiff.GetSquareLength() < UNITACTOR_DONT_HIT_FRIENDLY_RANGE * UNITACTOR_DONT_HIT_FRIENDLY_RANGE)
-							{
-								//if (unit->targeting.getTargetUnit() != ownu)
-								//{
-									noCollUnits.append(ownu);
-									ownu->getVisualObject()->setCollidable(false);
-								//}
-							}
+							//if (unit->targeting.getTargetUnit() != ownu)
+							//{
+								noCollUnits.append(ownu);
+								ownu->getVisualObject()->setCollidable(false);
+							//}
 						}
 					}
-
-					delete ownUnitsIter;
 				}
 			}
 		}
@@ -3488,6 +3488,10 @@ if (ltime < 1) ltime = 1;
 		if (removedAmount > 0)
 		{
 			game->getGameScene()->removeTerrainObstacles(removedObjects);
+
+			// broken objects may not have had any obstacles, but they did
+			// block raytraces (old line of sight results are useless)
+			game->gameMap->bumpCollisionEpoch();
 		}
 		// TODO: delete contents of removedObjects (objects within) 
 		// not relevant anymore. should be handled automagically...?
@@ -6,6 +6,7 @@
 #include "Projectile.h"
 #include "gamedefs.h"
 #include "../container/LinkedList.h"
+#include "../container/SlotMap.h"
 #include "../util/Debug_MemoryManager.h"
 
 namespace game
@@ -13,16 +14,12 @@ namespace game
 
 	ProjectileList::ProjectileList()
 	{
-		allProjectiles = new LinkedList();
+		allProjectiles = new LinkedSlotMap<Projectile>();
 	}
 
 	// NOTE, does not delete the projectiles inside this but just the list of them
 	ProjectileList::~ProjectileList()
 	{
-		while (!allProjectiles->isEmpty())
-		{
-			allProjectiles->popLast();
-		}
 		delete allProjectiles;
 	}
 
@@ -39,41 +36,45 @@ namespace game
 
 	int ProjectileList::getAllProjectileAmount()
 	{
-		// TODO, optimize, not thread safe! (caller may not be using iterator)
-		int count = 0;
-		allProjectiles->resetIterate();
-		while (allProjectiles->iterateAvailable())
-		{
-			allProjectiles->iterateNext();
-			count++;
-		}
-		return count;
+		return allProjectiles->getAmount();
 	}
 
 	LinkedList *ProjectileList::getAllProjectiles()
 	{
-		return allProjectiles;
+		return allProjectiles->getLinkedList();
+	}
+
+	const SlotMap<Projectile> *ProjectileList::getAllProjectileSlots()
+	{
+		return allProjectiles->getSlotMap();
 	}
 
-	void ProjectileList::addProjectile(Projectile *projectile)
+	SlotMapHandle ProjectileList::addProjectile(Projectile *projectile)
 	{
-		allProjectiles->append(projectile);
+		projectile->listHandle = allProjectiles->insert(projectile);
+		return projectile->listHandle;
 	}
 
 	// does not delete the projectile, just removes it from the list
 	void ProjectileList::removeProjectile(Projectile *projectile)
 	{
-		allProjectiles->remove(projectile);
+		allProjectiles->erase(projectile->listHandle);
+		projectile->listHandle = SlotMapHandle();
+	}
+
+	Projectile *ProjectileList::getProjectileBySlotHandle(const SlotMapHandle &handle)
+	{
+		return allProjectiles->get(handle);
 	}
 
 	Projectile *ProjectileList::getProjectileByHandle(int handle)
 	{
 		Projectile *ret = NULL;
 
-		allProjectiles->resetIterate();
-		while (allProjectiles->iterateAvailable())
+		SlotMap<Projectile>::Iterator iter(allProjectiles->getSlotMap());
+		while (iter.iterateAvailable())
 		{
-			Projectile *p = (Projectile *)allProjectiles->iterateNext();
+			Projectile *p = iter.iterateNext();
 			if (p->getHandle() == handle)
 				ret = p;
 		}
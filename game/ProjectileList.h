@@ -4,6 +4,8 @@
 
 #include "GameObject.h"
 
+#include "../container/SlotMap.h"
+
 class LinkedList;
 
 namespace game
@@ -34,13 +36,20 @@ namespace game
 
 		LinkedList *getAllProjectiles();
 
-		void addProjectile(Projectile *projectile);
+		// same projectiles in the same order, without the list nodes
+		const SlotMap<Projectile> *getAllProjectileSlots();
+
+		// returns the handle in getAllProjectileSlots
+		SlotMapHandle addProjectile(Projectile *projectile);
 		void removeProjectile(Projectile *projectile);
 
+		// NULL if the projectile has been removed
+		Projectile *getProjectileBySlotHandle(const SlotMapHandle &handle);
+
 		Projectile *getProjectileByHandle(int handle);
 
 	private:
-		LinkedList *allProjectiles;
+		LinkedSlotMap<Projectile> *allProjectiles;
 	};
 
 }
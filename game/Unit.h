@@ -914,6 +914,7 @@ namespace game
 		bool hasAttemptedToMoveAllBacktrackTime() const;
 
 		const char *getIdString() const;
+		// (units in a UnitList should go through UnitList::setUnitIdString)
 		void setIdString(const char *idstring);
 
 		int getIdNumber() const;
@@ -1671,6 +1672,7 @@ namespace game
 		bool shielded;
 
 	public:
+		// (UnitListGrid::getCellRange relies on how far this test reaches)
 		void SphereCollision(const VC3 &position, float radius, Storm3D_CollisionInfo &info, bool) const
 		{
 			if (this->unitListEntity)
@@ -6,6 +6,7 @@
 #include "Unit.h"
 #include "UnitType.h"
 #include "Game.h"
+#include "UnitCollisionBroadphase.h"
 #include "GameMap.h"
 #include "GameUI.h"
 #include "UnitLevelAI.h"
@@ -5725,9 +5726,13 @@ if (unit->getDirectControlType() == Unit::UNIT_DIRECT_CONTROL_TYPE_LOCAL_PLAYER
 
 		int collRadius = unitType->getCollisionCheckRadius();
 
+		// unit to unit pushes already found for all units before acting?
+		// (see UnitCollisionBroadphase)
+		bool pushedByBroadphase = SimpleOptions::getBool(DH_OPT_B_UNIT_COLLISION_BROADPHASE);
+
 		//if (!unit->isGhostOfFuture())
 		{
-			if (collRadius > 0 && 
+			if (collRadius > 0 && !pushedByBroadphase &&
 				(!unit->isDestroyed() || unitType->isBlockIfDestroyed())
 				&& unit->doesCollisionCheck())
 			{
@@ -5739,20 +5744,27 @@ if (unit->getDirectControlType() == Unit::UNIT_DIRECT_CONTROL_TYPE_LOCAL_PLAYER
 				//LinkedList *fulist = game->units->getOwnedUnits(unit->getOwner());
 				//LinkedListIterator iter(fulist);
 				
+				// (no owner mask bit for NO_UNIT_OWNER, check the owner below)
+				int owner = unit->getOwner();
+				unsigned int ownerMask = UNITLIST_ANY_OWNER;
+				if (owner >= 0 && owner < ABS_MAX_PLAYERS)
+					ownerMask = UNITLIST_OWNER_BIT(owner);
+
 				// HACK: 10m radius				
-				IUnitListIterator *iter = game->units->getNearbyOwnedUnits(unit->getOwner(), ownPos, 10.0f);
+				NearbyUnitBuffer nearUnits;
+				game->units->collectNearbyUnits(nearUnits, ownPos, 10.0f, ownerMask);
 
 				assert(scaleX == scaleY);
 				float checkRad = (float)(unitType->getCollisionCheckRadius() - 1) * scaleX;
-				while (iter->iterateAvailable())
+				for (int i = 0; i < nearUnits.getAmount(); i++)
 				{
 					//Unit *u = (Unit *)iter.iterateNext();
-					Unit *u = iter->iterateNext();
+					Unit *u = nearUnits.get(i);
 					UnitType *ut2 = u->getUnitType();
 
 					//if (!u->isGhostOfFuture())
 					{
-						if (u != unit && u->doesCollisionBlockOthers()
+						if (u != unit && u->getOwner() == owner && u->doesCollisionBlockOthers()
 							&& u->isActive() && (!u->isDestroyed() || ut2->isBlockIfDestroyed())
 							&& !ut2->isLineBlock() && ut2->getBlockRadius() > 1
 							&& ut2->getSize() >= unitType->getSize())
@@ -5775,13 +5787,12 @@ if (unit->getDirectControlType() == Unit::UNIT_DIRECT_CONTROL_TYPE_LOCAL_PLAYER
 					}
 				}
 
-				delete iter; 
-
 				unit->setPosition(ownPos);
 			}
 
 			// if this is player, get pushed by "pushplayer" units...
-			if (unit->isDirectControl() && !unit->getUnitType()->hasMechControls())
+			if (!pushedByBroadphase
+				&& unit->isDirectControl() && !unit->getUnitType()->hasMechControls())
 			{
 				// NOTE: COPY & PASTED (AND MODIFIED) FROM ABOVE
 				VC3 ownPos = unit->getPosition();
@@ -5824,6 +5835,14 @@ if (unit->getDirectControlType() == Unit::UNIT_DIRECT_CONTROL_TYPE_LOCAL_PLAYER
 				}
 				unit->setPosition(ownPos);
 			}
+
+			// pushes found by the broadphase before the units acted
+			VC3 broadphasePush;
+			if (pushedByBroadphase
+				&& game->unitBroadphase->takePush(unit, broadphasePush))
+			{
+				unit->setPosition(unit->getPosition() + broadphasePush);
+			}
 		}
 
 		// then the actual collisions
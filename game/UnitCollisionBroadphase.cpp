@@ -0,0 +1,326 @@
+
+#include "precompiled.h"
+
+#include "UnitCollisionBroadphase.h"
+
+#include <math.h>
+#include <assert.h>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "Game.h"
+#include "GameMap.h"
+#include "Unit.h"
+#include "UnitType.h"
+#include "UnitList.h"
+#include "GameScene.h"
+#include "UnitActor.h"
+#include "unittypes.h"
+#include "../container/SlotMap.h"
+
+#include "../util/Debug_MemoryManager.h"
+
+namespace game
+{
+	struct UnitCollisionBody
+	{
+		Unit *unit;
+		VC3 position;
+		VC3 push;
+
+		// sweep axis bounds
+		float minX;
+		float maxX;
+		// how far from position another unit may be (for the z test)
+		float reach;
+
+		// radius used when getting pushed, radius used when pushing others
+		float checkRadius;
+		float blockRadius;
+		float size;
+		int owner;
+		// list order, to keep the sort deterministic
+		int order;
+
+		// gets pushed by same owner blocking units
+		bool checksFriendly;
+		// gets pushed by "pushplayer" units (direct controlled player units)
+		bool checksPushers;
+		bool blocks;
+		bool pushesPlayer;
+	};
+
+	struct UnitCollisionBodySorter
+	{
+		bool operator() (const UnitCollisionBody &a, const UnitCollisionBody &b) const
+		{
+			if (a.minX != b.minX)
+				return a.minX < b.minX;
+			return a.order < b.order;
+		}
+	};
+
+	struct UnitCollisionPair
+	{
+		int a;
+		int b;
+	};
+
+	class UnitCollisionBroadphaseImpl
+	{
+		private:
+			UnitCollisionBroadphaseImpl(Game *game)
+			:	game(game),
+				contactAmount(0)
+			{
+			}
+
+			// how many times does the blocker push the other one (the old
+			// per unit code did the friendly and pushplayer pushes separately)
+			static int getPushCount(const UnitCollisionBody &pushed, const UnitCollisionBody &blocker)
+			{
+				if (!blocker.blocks || blocker.size < pushed.size)
+					return 0;
+
+				int count = 0;
+				if (pushed.checksFriendly && pushed.owner == blocker.owner)
+					count++;
+				if (pushed.checksPushers && blocker.pushesPlayer)
+					count++;
+				return count;
+			}
+
+			void collectBodies();
+			void findPairs();
+			void resolvePairs();
+
+			// adds push to a, when b is closer than their radius sum
+			bool addPush(UnitCollisionBody &a, const UnitCollisionBody &b, int count);
+
+			Game *game;
+
+			std::vector<UnitCollisionBody> bodies;
+			std::vector<UnitCollisionPair> pairs;
+			// by unit id, so a unit deleted during the tick and one created
+			// at the same address do not share a push
+			std::unordered_map<int, VC3> pushes;
+			int contactAmount;
+
+		friend class UnitCollisionBroadphase;
+	};
+
+
+	void UnitCollisionBroadphaseImpl::collectBodies()
+	{
+		bodies.clear();
+
+		float scale = game->gameMap->getScaleX() / GAMEMAP_HEIGHTMAP_MULTIPLIER;
+
+		int order = 0;
+		SlotMap<Unit>::Iterator iter(game->units->getAllUnitSlots());
+		while (iter.iterateAvailable())
+		{
+			Unit *u = iter.iterateNext();
+			order++;
+
+			if (!u->isActive())
+				continue;
+
+			UnitType *ut = u->getUnitType();
+			bool destroyedBlock = !u->isDestroyed() || ut->isBlockIfDestroyed();
+
+			// units of a type that never acts never got pushed
+			bool acts = ut->doesAct();
+
+			UnitCollisionBody body;
+			body.checksFriendly = acts && ut->getCollisionCheckRadius() > 0
+				&& destroyedBlock && u->doesCollisionCheck();
+			body.checksPushers = acts && u->isDirectControl() && !ut->hasMechControls();
+			body.blocks = u->doesCollisionBlockOthers() && destroyedBlock
+				&& !ut->isLineBlock() && ut->getBlockRadius() > 1;
+			body.pushesPlayer = body.blocks && ut->doesPushPlayer();
+
+			if (!body.checksFriendly && !body.checksPushers && !body.blocks)
+				continue;
+
+			body.unit = u;
+			body.position = u->getPosition();
+			body.push = VC3(0,0,0);
+			body.checkRadius = (float)(ut->getCollisionCheckRadius() - 1) * scale;
+			body.blockRadius = (float)(ut->getBlockRadius() - 1) * scale;
+			body.size = ut->getSize();
+			body.owner = u->getOwner();
+			body.order = order;
+
+			body.reach = 0.0f;
+			if ((body.checksFriendly || body.checksPushers) && body.checkRadius > body.reach)
+				body.reach = body.checkRadius;
+			if (body.blocks && body.blockRadius > body.reach)
+				body.reach = body.blockRadius;
+
+			body.minX = body.position.x - body.reach;
+			body.maxX = body.position.x + body.reach;
+
+			bodies.push_back(body);
+		}
+
+		std::sort(bodies.begin(), bodies.end(), UnitCollisionBodySorter());
+	}
+
+	void UnitCollisionBroadphaseImpl::findPairs()
+	{
+		pairs.clear();
+
+		int amount = (int)bodies.size();
+		for (int i = 0; i < amount; i++)
+		{
+			const UnitCollisionBody &a = bodies[i];
+			for (int j = i + 1; j < amount && bodies[j].minX < a.maxX; j++)
+			{
+				const UnitCollisionBody &b = bodies[j];
+				if (fabsf(b.position.z - a.position.z) >= a.reach + b.reach)
+					continue;
+
+				if (getPushCount(a, b) == 0 && getPushCount(b, a) == 0)
+					continue;
+
+				UnitCollisionPair pair;
+				pair.a = i;
+				pair.b = j;
+				pairs.push_back(pair);
+			}
+		}
+	}
+
+	bool UnitCollisionBroadphaseImpl::addPush(UnitCollisionBody &a, const UnitCollisionBody &b, int count)
+	{
+		VC3 diff = b.position - a.position;
+		diff.y = 0;
+		if (fabs(diff.x) <= 0.001f && fabs(diff.z) <= 0.001f)
+			return false;
+
+		float totalRad = b.blockRadius + a.checkRadius;
+		float diffLenSq = diff.GetSquareLength();
+		if (diffLenSq >= totalRad * totalRad)
+			return false;
+
+		float intrusionDepth = totalRad - sqrtf(diffLenSq);
+		diff.Normalize();
+		a.push -= diff * (intrusionDepth * (float)count);
+		return true;
+	}
+
+	void UnitCollisionBroadphaseImpl::resolvePairs()
+	{
+		contactAmount = 0;
+
+		for (int i = 0; i < (int)pairs.size(); i++)
+		{
+			UnitCollisionBody &a = bodies[pairs[i].a];
+			UnitCollisionBody &b = bodies[pairs[i].b];
+
+			int countA = getPushCount(a, b);
+			int countB = getPushCount(b, a);
+
+			bool contact = false;
+			if (countA > 0 && addPush(a, b, countA))
+				contact = true;
+			if (countB > 0 && addPush(b, a, countB))
+				contact = true;
+			if (contact)
+				contactAmount++;
+		}
+
+		// taken by actCollisions after the unit has moved, the rest are
+		// applied by applyRemainingPushes at the end of the tick
+		pushes.clear();
+		for (int i = 0; i < (int)bodies.size(); i++)
+		{
+			UnitCollisionBody &body = bodies[i];
+			if (body.push.x != 0 || body.push.z != 0)
+				pushes[body.unit->getIdNumber()] = body.push;
+		}
+	}
+
+
+	UnitCollisionBroadphase::UnitCollisionBroadphase(Game *game)
+	{
+		impl = new UnitCollisionBroadphaseImpl(game);
+	}
+
+	UnitCollisionBroadphase::~UnitCollisionBroadphase()
+	{
+		delete impl;
+	}
+
+	void UnitCollisionBroadphase::run()
+	{
+		impl->collectBodies();
+		impl->findPairs();
+		impl->resolvePairs();
+	}
+
+	bool UnitCollisionBroadphase::takePush(Unit *unit, VC3 &push)
+	{
+		std::unordered_map<int, VC3>::iterator it = impl->pushes.find(unit->getIdNumber());
+		if (it == impl->pushes.end())
+			return false;
+
+		push = it->second;
+		impl->pushes.erase(it);
+		return true;
+	}
+
+	void UnitCollisionBroadphase::applyRemainingPushes()
+	{
+		Game *game = impl->game;
+
+		SlotMap<Unit>::Iterator iter(game->units->getAllUnitSlots());
+		while (!impl->pushes.empty() && iter.iterateAvailable())
+		{
+			Unit *u = iter.iterateNext();
+
+			std::unordered_map<int, VC3>::iterator it = impl->pushes.find(u->getIdNumber());
+			if (it == impl->pushes.end())
+				continue;
+
+			VC3 position = u->getPosition() + it->second;
+			impl->pushes.erase(it);
+
+			if (!u->isActive()
+				|| !game->gameMap->isWellInScaledBoundaries(position.x, position.z))
+				continue;
+
+			// no obstacle map checks follow here (as they do in actCollisions),
+			// so do not push into an obstacle
+			UnitActor *ua = getUnitActorForUnit(u);
+			if (ua == NULL)
+				continue;
+
+			ua->removeUnitObstacle(u);
+			if (!game->getGameScene()->isBlockedAtScaled(position.x, position.z, position.y))
+				u->setPosition(position);
+			ua->addUnitObstacle(u);
+		}
+
+		// (units deleted during the tick)
+		impl->pushes.clear();
+	}
+
+	int UnitCollisionBroadphase::getUnitAmount() const
+	{
+		return (int)impl->bodies.size();
+	}
+
+	int UnitCollisionBroadphase::getPairAmount() const
+	{
+		return (int)impl->pairs.size();
+	}
+
+	int UnitCollisionBroadphase::getContactAmount() const
+	{
+		return impl->contactAmount;
+	}
+}
+
@@ -0,0 +1,54 @@
+
+#ifndef UNITCOLLISIONBROADPHASE_H
+#define UNITCOLLISIONBROADPHASE_H
+
+#include <DatatypeDef.h>
+
+namespace game
+{
+	class Game;
+	class Unit;
+	class UnitCollisionBroadphaseImpl;
+
+	/**
+	 * Unit to unit pushing (friendly units and "pushplayer" units), found
+	 * for all units at once before they act.
+	 *
+	 * Unit bounds (the larger of collision check and block radius) are
+	 * sorted along x and swept, which gives each overlapping pair once.
+	 * Pushes are computed from the positions at the start of the pass
+	 * and summed, so the result does not depend on unit list order.
+	 *
+	 * Units are not moved by run. UnitActor::actCollisions takes the push
+	 * after the unit has moved, where the per unit pushing used to be,
+	 * so the obstacle map checks and the map boundary check that follow
+	 * also cover the pushed position. Units that did not act this tick
+	 * get their push from applyRemainingPushes after all units have acted.
+	 */
+	class UnitCollisionBroadphase
+	{
+	public:
+		UnitCollisionBroadphase(Game *game);
+		~UnitCollisionBroadphase();
+
+		void run();
+
+		// push found for the unit on the last run, if any (only given once)
+		bool takePush(Unit *unit, VC3 &push);
+
+		// moves the units whose push was not taken, then forgets all pushes
+		// (call once per tick, after the units have acted)
+		void applyRemainingPushes();
+
+		// statistics of the last run
+		int getUnitAmount() const;
+		int getPairAmount() const;
+		int getContactAmount() const;
+
+	private:
+		UnitCollisionBroadphaseImpl *impl;
+	};
+}
+
+#endif
+
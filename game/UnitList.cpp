@@ -4,14 +4,21 @@
 #include "UnitList.h"
 
 #include "Unit.h"
+#include "UnitListGrid.h"
 #include "UnitType.h"
 #include "gamedefs.h"
 #include "scaledefs.h"
 #include "../container/LinkedList.h"
+#include "../container/SlotMap.h"
 #include "../system/Logger.h"
+#include "SimpleOptions.h"
+#include "options/options_game.h"
 
 #include <c2_qtree.h>
 #include <vector>
+#include <deque>
+#include <string>
+#include <unordered_map>
 
 #include "tracking/SimpleTrackableUnifiedHandleObjectIterator.h"
 #include "tracking/trackable_types.h"
@@ -27,11 +34,26 @@
 // if the unit is slightly "shaking" due to being squeezed.
 #define UNIT_QTREE_UPDATE_TRESHOLD 0.5f
 
+// how far a unit may move between updateLists calls (grid queries are widened by this)
+#define UNIT_GRID_MOVE_SLACK 0.5f
+
+// unit id is (generation << UNITID_SLOT_BITS) | slot, on top of UNITID_LOWEST_POSSIBLE_VALUE
+// slot generation is bumped when a unit leaves it, so stale ids stop resolving
+#define UNITID_SLOT_BITS 15
+#define UNITID_SLOT_MASK ((1 << UNITID_SLOT_BITS) - 1)
+#define UNITID_GENERATION_MASK ((UNITID_HIGHEST_POSSIBLE_VALUE - UNITID_LOWEST_POSSIBLE_VALUE) >> UNITID_SLOT_BITS)
+
+// freed slots are not reused before there are this many of them
+// (keeps a stale id from hitting the same slot generation soon)
+#define UNITID_MIN_FREE_SLOTS 1024
+
 namespace game
 {
 	typedef Quadtree<Unit> UnitQTree;
 
-	static int unitlist_nextIdNumber = UNITID_LOWEST_POSSIBLE_VALUE;
+	// new slots start from a different generation for every list,
+	// so ids from the previous game do not resolve in the next one
+	static int unitlist_nextListGeneration = 0;
 
 	class UnitListEntity
 	{
@@ -39,10 +61,19 @@ namespace game
 			UnitListEntity()
 			{
 				entity = NULL;
+				gridHandle = -1;
+				listOrder = 0;
 				lastUpdatePosition = VC3(0,0,0);
 			}
 
 			Quadtree<Unit>::Entity *entity;
+			int gridHandle;
+			// handle in allUnits
+			SlotMapHandle slotHandle;
+			// handle in ownedUnits of the unit's owner
+			SlotMapHandle ownedSlotHandle;
+			// order in allUnits (first found wins with duplicate id-strings)
+			int listOrder;
 			VC3 lastUpdatePosition;
 
 			friend class UnitList;
@@ -54,10 +85,63 @@ namespace game
 		private:
 			UnitListImpl()
 			{
-				// nop?
+				nextListOrder = 0;
+				slotGeneration = unitlist_nextListGeneration;
+				unitlist_nextListGeneration = (unitlist_nextListGeneration + 1) & UNITID_GENERATION_MASK;
+			}
+
+			struct IdSlot
+			{
+				Unit *unit;
+				int generation;
+			};
+
+			void addIdString(Unit *unit)
+			{
+				if (unit->getIdString() != NULL)
+					idStrings[unit->getIdString()].push_back(unit);
+			}
+
+			void removeIdString(Unit *unit)
+			{
+				if (unit->getIdString() == NULL)
+					return;
+
+				IdStringMap::iterator it = idStrings.find(unit->getIdString());
+				fb_assert(it != idStrings.end());
+				if (it == idStrings.end())
+					return;
+
+				std::vector<Unit *> &units = it->second;
+				for (int i = 0; i < (int)units.size(); i++)
+				{
+					if (units[i] == unit)
+					{
+						units.erase(units.begin() + i);
+						break;
+					}
+				}
+				if (units.empty())
+					idStrings.erase(it);
 			}
 
+			// only one of these exists, grid if unitlist_grid option is set
+			// (global, read again whenever the lists are recreated for a map)
 			std::unique_ptr<UnitQTree> tree;
+			std::unique_ptr<UnitListGrid> grid;
+
+			std::vector<IdSlot> idSlots;
+			std::deque<int> freeIdSlots;
+			int slotGeneration;
+			int nextListOrder;
+
+			// units with an id-string (usually just one per string)
+			typedef std::unordered_map<std::string, std::vector<Unit *> > IdStringMap;
+			IdStringMap idStrings;
+
+			// nearby units (owner in the mask) to the given consumer
+			template<class Consumer>
+			void traverseNearby(Consumer &consumer, const VC3 &position, float radius, unsigned int ownerMask);
 
 		friend class UnitList;
 	};
@@ -170,15 +254,140 @@ namespace game
 	};
 
 
+	// Passes units with an owner in the mask on to the actual consumer,
+	// testing grid candidates against the sphere first (the quadtree
+	// only hands out units that already passed Unit::SphereCollision).
+	template<class Consumer>
+	struct UnitListNearbyFilter
+	{
+		Consumer &consumer;
+		unsigned int ownerMask;
+		const VC3 &position;
+		float radius;
+		bool testSphere;
+
+		UnitListNearbyFilter(Consumer &consumer_, unsigned int ownerMask_, const VC3 &position_, float radius_, bool testSphere_)
+		:	consumer(consumer_),
+			ownerMask(ownerMask_),
+			position(position_),
+			radius(radius_),
+			testSphere(testSphere_)
+		{
+		}
+
+		void operator() (Unit *unit)
+		{
+			if (ownerMask != UNITLIST_ANY_OWNER)
+			{
+				int owner = unit->getOwner();
+				if (owner < 0 || owner >= 32
+					|| (ownerMask & UNITLIST_OWNER_BIT(owner)) == 0)
+					return;
+			}
+			if (testSphere)
+			{
+				Storm3D_CollisionInfo info;
+				unit->SphereCollision(position, radius, info, true);
+				if (!info.hit)
+					return;
+			}
+			consumer(unit);
+		}
+	};
+
+	template<class Consumer>
+	void UnitListImpl::traverseNearby(Consumer &consumer, const VC3 &position, float radius, unsigned int ownerMask)
+	{
+		if (grid)
+		{
+			UnitListNearbyFilter<Consumer> filter(consumer, ownerMask, position, radius, true);
+			grid->visitCandidates(filter, position, radius, UNIT_GRID_MOVE_SLACK);
+		}
+		else if (tree)
+		{
+			UnitListNearbyFilter<Consumer> filter(consumer, ownerMask, position, radius, false);
+			tree->visitSphere(filter, position, radius);
+		}
+	}
+
+	struct UnitListVectorConsumer
+	{
+		std::vector<Unit *> &result;
+
+		explicit UnitListVectorConsumer(std::vector<Unit *> &result_)
+		:	result(result_)
+		{
+		}
+
+		void operator() (Unit *unit)
+		{
+			result.push_back(unit);
+		}
+	};
+
+	struct UnitListBufferConsumer
+	{
+		NearbyUnitBuffer &result;
+
+		explicit UnitListBufferConsumer(NearbyUnitBuffer &result_)
+		:	result(result_)
+		{
+		}
+
+		void operator() (Unit *unit)
+		{
+			result.add(unit);
+		}
+	};
+
+	struct UnitListCallbackConsumer
+	{
+		NearbyUnitVisitor visitor;
+		void *data;
+
+		UnitListCallbackConsumer(NearbyUnitVisitor visitor_, void *data_)
+		:	visitor(visitor_),
+			data(data_)
+		{
+		}
+
+		void operator() (Unit *unit)
+		{
+			visitor(unit, data);
+		}
+	};
+
+	struct UnitListTrackableConsumer
+	{
+		UnitList *unitList;
+		game::tracking::SimpleTrackableUnifiedHandleObjectIterator *iter;
+		TRACKABLE_TYPEID_DATATYPE typeMask;
+
+		UnitListTrackableConsumer(UnitList *unitList_, game::tracking::SimpleTrackableUnifiedHandleObjectIterator *iter_, TRACKABLE_TYPEID_DATATYPE typeMask_)
+		:	unitList(unitList_),
+			iter(iter_),
+			typeMask(typeMask_)
+		{
+		}
+
+		void operator() (Unit *unit)
+		{
+			if ((unit->getUnitType()->getTrackableTypeMask() & typeMask) != 0)
+			{
+				iter->addEntry(unitList->getUnifiedHandle(unitList->getIdForUnit(unit)));
+			}
+		}
+	};
+
 
 
 	UnitList::UnitList()
 	{
-		allUnits = new LinkedList();
-		ownedUnits = new LinkedList *[ABS_MAX_PLAYERS];
+		allUnits = new LinkedSlotMap<Unit>();
+		ownedUnits = new LinkedSlotMap<Unit> *[ABS_MAX_PLAYERS];
 		for (int i = 0; i < ABS_MAX_PLAYERS; i++)
 		{
-			ownedUnits[i] = new LinkedList();
+			ownedUnits[i] = new LinkedSlotMap<Unit>();
 			ownedUnitAmount[i] = 0;
 		}
 		allUnitAmount = 0;
@@ -192,20 +401,11 @@ namespace game
 		fb_assert(this->impl != NULL);
 		delete this->impl;
 
-		while (!allUnits->isEmpty())
-		{
-			allUnits->popLast();
-			allUnitAmount--;
-		}
+		assert(allUnitAmount == allUnits->getAmount());
 		delete allUnits;
-		assert(allUnitAmount == 0);
 		for (int i = 0; i < ABS_MAX_PLAYERS; i++)
 		{
-			while (!ownedUnits[i]->isEmpty())
-			{
-				ownedUnits[i]->popLast();
-				ownedUnitAmount[i]--;
-			}
+			assert(ownedUnitAmount[i] == ownedUnits[i]->getAmount());
 			delete ownedUnits[i];
 		}
 		delete [] ownedUnits;
@@ -228,10 +428,10 @@ namespace game
 		// TODO, not thread safe! (caller may not be using iterator)
 		/*
 		int count = 0;
-		allUnits->resetIterate();
-		while (allUnits->iterateAvailable())
+		allUnits->getLinkedList()->resetIterate();
+		while (allUnits->getLinkedList()->iterateAvailable())
 		{
-			allUnits->iterateNext();
+			allUnits->getLinkedList()->iterateNext();
 			count++;
 		}
 		assert(count == allUnitAmount);
@@ -246,10 +446,10 @@ namespace game
 		// TODO, not thread safe! (caller may not be using iterator)
 		/*
 		int count = 0;
-		ownedUnits[player]->resetIterate();
-		while (ownedUnits[player]->iterateAvailable())
+		ownedUnits[player]->getLinkedList()->resetIterate();
+		while (ownedUnits[player]->getLinkedList()->iterateAvailable())
 		{
-			ownedUnits[player]->iterateNext();
+			ownedUnits[player]->getLinkedList()->iterateNext();
 			count++;
 		}
 		assert(count == ownedUnitAmount[player]);
@@ -260,12 +460,35 @@ namespace game
 
 	LinkedList *UnitList::getAllUnits()
 	{
-		return allUnits;
+		return allUnits->getLinkedList();
 	}
 
 	LinkedList *UnitList::getOwnedUnits(int player)
 	{
-		return ownedUnits[player];
+		return ownedUnits[player]->getLinkedList();
+	}
+
+	const SlotMap<Unit> *UnitList::getAllUnitSlots()
+	{
+		return allUnits->getSlotMap();
+	}
+
+	const SlotMap<Unit> *UnitList::getOwnedUnitSlots(int player)
+	{
+		return ownedUnits[player]->getSlotMap();
+	}
+
+	SlotMapHandle UnitList::getUnitSlotHandle(Unit *unit)
+	{
+		fb_assert(unit != NULL);
+		if (unit->getUnitListEntity() == NULL)
+			return SlotMapHandle();
+		return unit->getUnitListEntity()->slotHandle;
+	}
+
+	Unit *UnitList::getUnitBySlotHandle(const SlotMapHandle &handle)
+	{
+		return allUnits->get(handle);
 	}
 
 	void UnitList::updateUnitRadius(Unit *unit)
@@ -279,7 +502,10 @@ namespace game
 		}
 
 		//Logger::getInstance()->info(int2str(radius));
-		unit->getUnitListEntity()->entity->setRadius(radius);
+		if (impl->grid)
+			impl->grid->setRadius(unit->getUnitListEntity()->gridHandle, radius);
+		else
+			unit->getUnitListEntity()->entity->setRadius(radius);
 		unit->setUnitListRadius(radius);
 	}
 
@@ -288,7 +514,7 @@ namespace game
 		fb_assert(unit != NULL);
 
 		unit->setUnitListEntity(new UnitListEntity());
-		if (impl->tree)
+		if (impl->tree || impl->grid)
 		{
 			float radius = UNIT_QTREE_RADIUS_HACK;
 			// grow the radius for non-boned units only
@@ -303,50 +529,51 @@ namespace game
 				}
 			}
 			//Logger::getInstance()->info(int2str(radius));
-			unit->getUnitListEntity()->entity = impl->tree->insert(unit, unit->getPosition(), radius);
+			if (impl->grid)
+				unit->getUnitListEntity()->gridHandle = impl->grid->insert(unit, unit->getPosition(), radius);
+			else
+				unit->getUnitListEntity()->entity = impl->tree->insert(unit, unit->getPosition(), radius);
 			unit->setUnitListRadius(radius);
 		}
 
-		allUnits->append(unit);
+		unit->getUnitListEntity()->slotHandle = allUnits->insert(unit);
 		int own = unit->getOwner();
 		if (own != NO_UNIT_OWNER)
 		{
 			if (own < 0 || own >= ABS_MAX_PLAYERS) abort();
-			ownedUnits[own]->append(unit);
+			unit->getUnitListEntity()->ownedSlotHandle = ownedUnits[own]->insert(unit);
 			ownedUnitAmount[own]++;
 		}
 		allUnitAmount++;
 
-		unit->setIdNumber(unitlist_nextIdNumber);
-
-		int failsafecount = 0;
-		while (true)
+		int slot = -1;
+		if ((int)impl->freeIdSlots.size() > UNITID_MIN_FREE_SLOTS
+			|| ((int)impl->idSlots.size() > UNITID_SLOT_MASK && !impl->freeIdSlots.empty()))
 		{
-			unitlist_nextIdNumber++;
-			if (unitlist_nextIdNumber > UNITID_HIGHEST_POSSIBLE_VALUE)
-				unitlist_nextIdNumber = UNITID_LOWEST_POSSIBLE_VALUE;
-
-			bool alreadyTaken = false;
-			LinkedListIterator iter(allUnits);
-			while (iter.iterateAvailable())
-			{
-				Unit *u = (Unit *)iter.iterateNext();
-				if (u->getIdNumber() == unitlist_nextIdNumber)
-				{
-					alreadyTaken = true;
-					break;
-				}
-			}
-
-			if (!alreadyTaken)
-				break;
+			slot = impl->freeIdSlots.front();
+			impl->freeIdSlots.pop_front();
+		}
+		else if ((int)impl->idSlots.size() <= UNITID_SLOT_MASK)
+		{
+			slot = (int)impl->idSlots.size();
+			UnitListImpl::IdSlot idSlot;
+			idSlot.unit = NULL;
+			idSlot.generation = impl->slotGeneration;
+			impl->idSlots.push_back(idSlot);
+		}
 
-			failsafecount++;
-			if (failsafecount > (UNITID_HIGHEST_POSSIBLE_VALUE - UNITID_LOWEST_POSSIBLE_VALUE + 1))
-			{
-				break;
-			}
+		if (slot != -1)
+		{
+			impl->idSlots[slot].unit = unit;
+			unit->setIdNumber(UNITID_LOWEST_POSSIBLE_VALUE + ((impl->idSlots[slot].generation << UNITID_SLOT_BITS) | slot));
+		} else {
+			Logger::getInstance()->error("UnitList::addUnit - Out of unit ids.");
+			fb_assert(!"UnitList::addUnit - Out of unit ids.");
+			unit->setIdNumber(0);
 		}
+
+		unit->getUnitListEntity()->listOrder = impl->nextListOrder++;
+		impl->addIdString(unit);
 	}
 
 	// does not delete the unit, just removes it from the list
@@ -354,18 +581,36 @@ namespace game
 	{
 		fb_assert(unit != NULL);
 
-		if (impl->tree)
+		if (impl->grid)
+			impl->grid->erase(unit->getUnitListEntity()->gridHandle);
+		else if (impl->tree)
 			impl->tree->erase(unit->getUnitListEntity()->entity);
 
+		impl->removeIdString(unit);
+
+		int id = unit->getIdNumber();
+		if (id >= UNITID_LOWEST_POSSIBLE_VALUE && id <= UNITID_HIGHEST_POSSIBLE_VALUE)
+		{
+			int slot = (id - UNITID_LOWEST_POSSIBLE_VALUE) & UNITID_SLOT_MASK;
+			fb_assert(slot < (int)impl->idSlots.size() && impl->idSlots[slot].unit == unit);
+
+			UnitListImpl::IdSlot &idSlot = impl->idSlots[slot];
+			idSlot.unit = NULL;
+			idSlot.generation = (idSlot.generation + 1) & UNITID_GENERATION_MASK;
+			impl->freeIdSlots.push_back(slot);
+		}
+
+		allUnits->erase(unit->getUnitListEntity()->slotHandle);
+		SlotMapHandle ownedSlotHandle = unit->getUnitListEntity()->ownedSlotHandle;
+
 		delete unit->getUnitListEntity();
 		unit->setUnitListEntity(NULL);
 
-		allUnits->remove(unit);
 		int own = unit->getOwner();
 		if (own != NO_UNIT_OWNER)
 		{
 			if (own < 0 || own >= ABS_MAX_PLAYERS) abort();
-			ownedUnits[own]->remove(unit);
+			ownedUnits[own]->erase(ownedSlotHandle);
 			ownedUnitAmount[own]--;
 		} 	 
 		allUnitAmount--;
@@ -379,7 +624,8 @@ namespace game
 			if (own != NO_UNIT_OWNER)
 			{
 				if (own < 0 || own >= ABS_MAX_PLAYERS) abort();
-				ownedUnits[own]->remove(unit);
+				ownedUnits[own]->erase(unit->getUnitListEntity()->ownedSlotHandle);
+				unit->getUnitListEntity()->ownedSlotHandle = SlotMapHandle();
 				ownedUnitAmount[own]--;
 			}
 		}
@@ -393,7 +639,7 @@ namespace game
 			if (own != NO_UNIT_OWNER)
 			{
 				if (own < 0 || own >= ABS_MAX_PLAYERS) abort();
-				ownedUnits[own]->append(unit);
+				unit->getUnitListEntity()->ownedSlotHandle = ownedUnits[own]->insert(unit);
 				ownedUnitAmount[own]++;
 			}
 		}
@@ -425,66 +671,74 @@ namespace game
 
 	Unit *UnitList::getUnitById(int id)
 	{
-		// TODO: optimize, need a hash map or something for this!
-
-		LinkedListIterator iter(allUnits);
-		while (iter.iterateAvailable())
+		if (id >= UNITID_LOWEST_POSSIBLE_VALUE && id <= UNITID_HIGHEST_POSSIBLE_VALUE)
 		{
-			Unit *u = (Unit *)iter.iterateNext();
-			if (u->getIdNumber() == id)
-				return u;
-		}
-		Logger::getInstance()->debug("UnitList::getUnitById - Given id did not match any unit.");
-		return NULL;
-
-		/*
-		int i = UNITID_LOWEST_POSSIBLE_VALUE;
+			int value = id - UNITID_LOWEST_POSSIBLE_VALUE;
+			int slot = value & UNITID_SLOT_MASK;
+			int generation = value >> UNITID_SLOT_BITS;
 
-		// TODO: check getAllUnitAmount first before looping.
-		// (could save some time, if there was a proper counter for the amount)
-		
-		LinkedListIterator iter(allUnits);
-		while (iter.iterateAvailable())
-		{
-			Unit *u = (Unit *)iter.iterateNext();
-			if (i == id) return u;
-			i++;
+			if (slot < (int)impl->idSlots.size()
+				&& impl->idSlots[slot].unit != NULL
+				&& impl->idSlots[slot].generation == generation)
+			{
+				return impl->idSlots[slot].unit;
+			}
 		}
 
 		Logger::getInstance()->debug("UnitList::getUnitById - Given id did not match any unit.");
-		//assert(!"UnitList::getUnitById - Given id did not match any unit.");
 		return NULL;
-		*/
 	}
 
 	Unit *UnitList::getUnitByIdString(const char *idString)
 	{
-		LinkedListIterator iter(allUnits);
-		while (iter.iterateAvailable())
+		UnitListImpl::IdStringMap::const_iterator it = impl->idStrings.find(idString);
+		if (it == impl->idStrings.end())
 		{
-			Unit *u = (Unit *)iter.iterateNext();
-			const char *tmp = u->getIdString();
-			if (tmp != NULL)
-			{
-				if (strcmp(tmp, idString) == 0)
-					return u;
-			}
+			//assert(!"UnitList::getUnitByIdString - Given id string did not match any unit.");
+			return NULL;
 		}
 
-		//assert(!"UnitList::getUnitByIdString - Given id string did not match any unit.");
-		return NULL;
+		// the one added first, as the list order used to decide that
+		const std::vector<Unit *> &units = it->second;
+		Unit *first = units[0];
+		for (int i = 1; i < (int)units.size(); i++)
+		{
+			if (units[i]->getUnitListEntity()->listOrder < first->getUnitListEntity()->listOrder)
+				first = units[i];
+		}
+		return first;
+	}
+
+	void UnitList::setUnitIdString(Unit *unit, const char *idString)
+	{
+		fb_assert(unit != NULL);
+
+		bool listed = (unit->getUnitListEntity() != NULL);
+		if (listed)
+			impl->removeIdString(unit);
+
+		unit->setIdString(idString);
+
+		if (listed)
+			impl->addIdString(unit);
 	}
 
 	void UnitList::updateLists()
 	{
-		LinkedListIterator iter(allUnits);
+		SlotMap<Unit>::Iterator iter(allUnits->getSlotMap());
 		while (iter.iterateAvailable())
 		{
-			Unit *u = (Unit *)iter.iterateNext();
+			Unit *u = iter.iterateNext();
 			if (u->isActive())
 			{
 				UnitListEntity *ent = u->getUnitListEntity();
-				if (ent != NULL)
+				if (ent != NULL && impl->grid)
+				{
+					// cheap enough to keep exact
+					ent->lastUpdatePosition = u->getPosition();
+					impl->grid->setPosition(ent->gridHandle, ent->lastUpdatePosition);
+				}
+				else if (ent != NULL)
 				{
 					VC3 pos = u->getPosition();
 					VC3 posdiff = pos - ent->lastUpdatePosition;
@@ -503,7 +757,8 @@ namespace game
 	{
 		NearbyOwnedUnitIterator *iter = new NearbyOwnedUnitIterator(player);
 
-		impl->tree->collectSphere(iter->foundUnits, position, radius);
+		UnitListVectorConsumer consumer(iter->foundUnits);
+		impl->traverseNearby(consumer, position, radius, UNITLIST_ANY_OWNER);
 		iter->atUnit = 0;
 
 		return iter;
@@ -513,7 +768,8 @@ namespace game
 	{
 		NearbyAllUnitIterator *iter = new NearbyAllUnitIterator();
 
-		impl->tree->collectSphere(iter->foundUnits, position, radius);
+		UnitListVectorConsumer consumer(iter->foundUnits);
+		impl->traverseNearby(consumer, position, radius, UNITLIST_ANY_OWNER);
 
 // TEMP: ...
 /*
@@ -537,28 +793,55 @@ for (int i = 0; i < iter->foundUnits.size(); i++)
 		return iter;
 	}
 
+	void UnitList::collectNearbyUnits(NearbyUnitBuffer &result, const VC3 &position, float radius, unsigned int ownerMask)
+	{
+		result.clear();
+
+		UnitListBufferConsumer consumer(result);
+		impl->traverseNearby(consumer, position, radius, ownerMask);
+	}
+
+	void UnitList::visitNearbyUnits(const VC3 &position, float radius, NearbyUnitVisitor visitor, void *data, unsigned int ownerMask)
+	{
+		assert(visitor != NULL);
+
+		UnitListCallbackConsumer consumer(visitor, data);
+		impl->traverseNearby(consumer, position, radius, ownerMask);
+	}
+
 	void UnitList::recreateLists(const VC2 &size)
 	{
 		VC2	mmin(-size.x, -size.y);
 		VC2 mmax( size.x,  size.y);
 
-		LinkedListIterator iter(allUnits);
+		// entities are kept (they hold the list order), only tree/grid data goes
+		SlotMap<Unit>::Iterator iter(allUnits->getSlotMap());
 		while (iter.iterateAvailable())
 		{
-			Unit *u = (Unit *)iter.iterateNext();
+			Unit *u = iter.iterateNext();
 			if (u->getUnitListEntity() != NULL)
 			{
-				delete u->getUnitListEntity();
-				u->setUnitListEntity(NULL);
+				u->getUnitListEntity()->entity = NULL;
+				u->getUnitListEntity()->gridHandle = -1;
 			}
 		}
 
-		impl->tree.reset(new UnitQTree(mmin, mmax));
+		impl->tree.reset();
+		impl->grid.reset();
+		if (SimpleOptions::getBool(DH_OPT_B_UNITLIST_GRID))
+		{
+			float cellSize = SimpleOptions::getFloat(DH_OPT_F_UNITLIST_GRID_CELL_SIZE);
+			if (cellSize < 1.0f)
+				cellSize = 1.0f;
+			impl->grid.reset(new UnitListGrid(mmin, mmax, cellSize));
+		} else {
+			impl->tree.reset(new UnitQTree(mmin, mmax));
+		}
 
-		iter = LinkedListIterator(allUnits);
-		while (iter.iterateAvailable())
+		SlotMap<Unit>::Iterator insertIter(allUnits->getSlotMap());
+		while (insertIter.iterateAvailable())
 		{
-			Unit *u = (Unit *)iter.iterateNext();
+			Unit *u = insertIter.iterateNext();
 			//assert(u->getUnitListEntity() != NULL);
 			//delete u->getUnitListEntity();
 
@@ -574,8 +857,11 @@ for (int i = 0; i < iter->foundUnits.size(); i++)
 					if (radius2 > radius) radius = radius2;
 				}
 			}
-			u->setUnitListEntity(new UnitListEntity());
-			u->getUnitListEntity()->entity = impl->tree->insert(u, u->getPosition(), radius);
+			fb_assert(u->getUnitListEntity() != NULL);
+			if (impl->grid)
+				u->getUnitListEntity()->gridHandle = impl->grid->insert(u, u->getPosition(), radius);
+			else
+				u->getUnitListEntity()->entity = impl->tree->insert(u, u->getPosition(), radius);
 			u->getUnitListEntity()->lastUpdatePosition = u->getPosition();
 		}
 
@@ -662,17 +948,8 @@ for (int i = 0; i < iter->foundUnits.size(); i++)
 			return iter;
 		}
 
-		IUnitListIterator *uli = getNearbyAllUnits(position, radius);
-		while (uli->iterateAvailable())
-		{
-			Unit *u = uli->iterateNext();
-			if ((u->getUnitType()->getTrackableTypeMask() & typeMask) != 0)
-			{
-				iter->addEntry(getUnifiedHandle(getIdForUnit(u)));
-			}
-		}
-
-		delete uli;
+		UnitListTrackableConsumer consumer(this, iter, typeMask);
+		impl->traverseNearby(consumer, position, radius, UNITLIST_ANY_OWNER);
 
 		return iter;
 	}
@@ -9,19 +9,81 @@
 #include "tracking/ITrackableUnifiedHandleObjectImplementationManager.h"
 
 #include <DatatypeDef.h>
+#include <vector>
 
 #define UNITID_LOWEST_POSSIBLE_VALUE UNIFIED_HANDLE_FIRST_UNIT
 #define UNITID_HIGHEST_POSSIBLE_VALUE UNIFIED_HANDLE_LAST_UNIT
 //#define UNITID_LOWEST_POSSIBLE_VALUE 100000
 //#define UNITID_HIGHEST_POSSIBLE_VALUE 9999999
 
+// owner masks for the nearby unit queries
+#define UNITLIST_OWNER_BIT(owner) (1 << (owner))
+// (also includes units with no owner)
+#define UNITLIST_ANY_OWNER 0xffffffff
+
 class LinkedList;
+template<class T> class SlotMap;
+template<class T> class LinkedSlotMap;
+struct SlotMapHandle;
 
 namespace game
 {
 	class Unit;
 	class UnitListImpl;
 
+	// Result buffer for UnitList::collectNearbyUnits, keep one around and
+	// reuse it. The first INLINE_CAPACITY units are kept inside the
+	// buffer itself, only more than that goes to heap.
+	class NearbyUnitBuffer
+	{
+	public:
+		enum { INLINE_CAPACITY = 64 };
+
+		NearbyUnitBuffer()
+		:	amount(0)
+		{
+		}
+
+		void clear()
+		{
+			amount = 0;
+			overflow.clear();
+		}
+
+		void add(Unit *unit)
+		{
+			if (amount < INLINE_CAPACITY)
+				units[amount] = unit;
+			else
+				overflow.push_back(unit);
+			amount++;
+		}
+
+		int getAmount() const
+		{
+			return amount;
+		}
+
+		Unit *get(int index) const
+		{
+			if (index < INLINE_CAPACITY)
+				return units[index];
+			else
+				return overflow[index - INLINE_CAPACITY];
+		}
+
+	private:
+		Unit *units[INLINE_CAPACITY];
+		std::vector<Unit *> overflow;
+		int amount;
+
+		NearbyUnitBuffer(const NearbyUnitBuffer &);
+		NearbyUnitBuffer &operator=(const NearbyUnitBuffer &);
+	};
+
+	// Called for each unit found by UnitList::visitNearbyUnits
+	typedef void (*NearbyUnitVisitor)(Unit *unit, void *data);
+
 	class UnitList : public GameObject, public game::tracking::ITrackableUnifiedHandleObjectImplementationManager
 	{
 	public:
@@ -38,6 +100,17 @@ namespace game
 		LinkedList *getAllUnits();
 		LinkedList *getOwnedUnits(int player);
 
+		// same units in the same order, for walking them without list nodes
+		// (see SlotMap::Iterator, units may be added and removed meanwhile)
+		const SlotMap<Unit> *getAllUnitSlots();
+		const SlotMap<Unit> *getOwnedUnitSlots(int player);
+
+		// handle of the unit in getAllUnitSlots, does not resolve anymore
+		// once the unit has been removed (where a pointer would dangle)
+		SlotMapHandle getUnitSlotHandle(Unit *unit);
+		// NULL if the unit has been removed
+		Unit *getUnitBySlotHandle(const SlotMapHandle &handle);
+
 		void addUnit(Unit *unit);
 		void removeUnit(Unit *unit);
 		void switchUnitSide(Unit *unit, int side);
@@ -52,9 +125,19 @@ namespace game
 
 		Unit *getUnitByIdString(const char *idString);
 
+		// use this rather than Unit::setIdString for units in the list
+		// (keeps the id-string lookup up to date)
+		void setUnitIdString(Unit *unit, const char *idString);
+
 		IUnitListIterator *getNearbyOwnedUnits(int player, const VC3 &position, float radius);
 		IUnitListIterator *getNearbyAllUnits(const VC3 &position, float radius);
 
+		// Same queries without allocations or iterator objects. Only units whose
+		// owner is in ownerMask (see UNITLIST_OWNER_BIT) are returned.
+		// collectNearbyUnits clears the result buffer first.
+		void collectNearbyUnits(NearbyUnitBuffer &result, const VC3 &position, float radius, unsigned int ownerMask = UNITLIST_ANY_OWNER);
+		void visitNearbyUnits(const VC3 &position, float radius, NearbyUnitVisitor visitor, void *data, unsigned int ownerMask = UNITLIST_ANY_OWNER);
+
 		// call this after (or before) every tick
 		void updateLists();
 
@@ -70,8 +153,8 @@ namespace game
 		// ---
 
 	private:
-		LinkedList *allUnits;
-		LinkedList **ownedUnits;
+		LinkedSlotMap<Unit> *allUnits;
+		LinkedSlotMap<Unit> **ownedUnits;
 		int allUnitAmount;
 		int ownedUnitAmount[ABS_MAX_PLAYERS];
 
@@ -0,0 +1,146 @@
+
+#include "precompiled.h"
+
+#include "UnitListGrid.h"
+
+#include <math.h>
+#include <assert.h>
+
+#include "../util/Debug_MemoryManager.h"
+
+namespace game
+{
+	UnitListGrid::UnitListGrid(const VC2 &mmin, const VC2 &mmax, float cellSize)
+	{
+		assert(cellSize > 0.0f);
+
+		this->mmin = mmin;
+		this->cellSize = cellSize;
+		this->cellSizeInv = 1.0f / cellSize;
+		this->maxRadius = 0.0f;
+
+		cellsX = (int)ceilf((mmax.x - mmin.x) * cellSizeInv);
+		cellsY = (int)ceilf((mmax.y - mmin.y) * cellSizeInv);
+		if (cellsX < 1) cellsX = 1;
+		if (cellsY < 1) cellsY = 1;
+
+		cells.resize(cellsX * cellsY);
+	}
+
+	UnitListGrid::~UnitListGrid()
+	{
+	}
+
+	int UnitListGrid::getCell(const VC3 &position) const
+	{
+		int x = (int)floorf((position.x - mmin.x) * cellSizeInv);
+		int y = (int)floorf((position.z - mmin.y) * cellSizeInv);
+		if (x < 0) x = 0;
+		if (y < 0) y = 0;
+		if (x >= cellsX) x = cellsX - 1;
+		if (y >= cellsY) y = cellsY - 1;
+
+		return x + y * cellsX;
+	}
+
+	void UnitListGrid::addToCell(int handle, int cell)
+	{
+		Entry &entry = entries[handle];
+		entry.cell = cell;
+		entry.slot = (int)cells[cell].size();
+
+		CellUnit cu;
+		cu.unit = entry.unit;
+		cu.entry = handle;
+		cells[cell].push_back(cu);
+	}
+
+	void UnitListGrid::removeFromCell(int handle)
+	{
+		Entry &entry = entries[handle];
+		std::vector<CellUnit> &cell = cells[entry.cell];
+		assert(entry.slot < (int)cell.size());
+		assert(cell[entry.slot].entry == handle);
+
+		// swap the last one into our slot
+		if (entry.slot != (int)cell.size() - 1)
+		{
+			cell[entry.slot] = cell.back();
+			entries[cell[entry.slot].entry].slot = entry.slot;
+		}
+		cell.pop_back();
+
+		entry.cell = -1;
+		entry.slot = -1;
+	}
+
+	int UnitListGrid::insert(Unit *unit, const VC3 &position, float radius)
+	{
+		assert(unit != NULL);
+
+		int handle = 0;
+		if (!freeEntries.empty())
+		{
+			handle = freeEntries.back();
+			freeEntries.pop_back();
+		} else {
+			handle = (int)entries.size();
+			entries.push_back(Entry());
+		}
+
+		entries[handle].unit = unit;
+		addToCell(handle, getCell(position));
+
+		if (radius > maxRadius)
+			maxRadius = radius;
+
+		return handle;
+	}
+
+	void UnitListGrid::erase(int handle)
+	{
+		assert(handle >= 0 && handle < (int)entries.size());
+		assert(entries[handle].unit != NULL);
+
+		removeFromCell(handle);
+		entries[handle].unit = NULL;
+		freeEntries.push_back(handle);
+	}
+
+	void UnitListGrid::setPosition(int handle, const VC3 &position)
+	{
+		assert(handle >= 0 && handle < (int)entries.size());
+
+		int cell = getCell(position);
+		if (cell != entries[handle].cell)
+		{
+			removeFromCell(handle);
+			addToCell(handle, cell);
+		}
+	}
+
+	void UnitListGrid::setRadius(int handle, float radius)
+	{
+		assert(handle >= 0 && handle < (int)entries.size());
+
+		if (radius > maxRadius)
+			maxRadius = radius;
+	}
+
+	void UnitListGrid::getCellRange(const VC3 &position, float radius, float moveSlack, int &minX, int &minY, int &maxX, int &maxY) const
+	{
+		// Unit::SphereCollision compares squared distance to the radius
+		// sum, so that is as far as a hit can be (keep these in sync)
+		float reach = sqrtf(radius + maxRadius) + moveSlack;
+
+		minX = (int)floorf((position.x - reach - mmin.x) * cellSizeInv);
+		maxX = (int)floorf((position.x + reach - mmin.x) * cellSizeInv);
+		minY = (int)floorf((position.z - reach - mmin.y) * cellSizeInv);
+		maxY = (int)floorf((position.z + reach - mmin.y) * cellSizeInv);
+		if (minX < 0) minX = 0;
+		if (minY < 0) minY = 0;
+		if (maxX >= cellsX) maxX = cellsX - 1;
+		if (maxY >= cellsY) maxY = cellsY - 1;
+	}
+}
+
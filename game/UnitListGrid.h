@@ -0,0 +1,96 @@
+
+#ifndef UNITLISTGRID_H
+#define UNITLISTGRID_H
+
+#include <DatatypeDef.h>
+#include <vector>
+
+namespace game
+{
+	class Unit;
+
+	/**
+	 * Uniform grid of units for UnitList nearby queries.
+	 *
+	 * Alternative to the loose quadtree: each unit lives in exactly one
+	 * cell, chosen by its position, so moving a unit is a cell index
+	 * compare and (when the cell changes) a swap-remove and an append.
+	 * Cells keep their units in plain arrays.
+	 *
+	 * Queries hand out every unit in the cells a Unit::SphereCollision
+	 * hit could come from, the caller does the exact test (which then
+	 * gives the same units the quadtree would, in different order).
+	 *
+	 * Positions outside the given area are clamped to the edge cells.
+	 */
+	class UnitListGrid
+	{
+	public:
+		UnitListGrid(const VC2 &mmin, const VC2 &mmax, float cellSize);
+		~UnitListGrid();
+
+		// returns a handle for the other calls
+		int insert(Unit *unit, const VC3 &position, float radius);
+		void erase(int handle);
+
+		void setPosition(int handle, const VC3 &position);
+		void setRadius(int handle, float radius);
+
+		// Calls visitor(Unit *) for candidate units (positions may have
+		// moved up to moveSlack since last setPosition)
+		template<class Visitor>
+		void visitCandidates(Visitor &visitor, const VC3 &position, float radius, float moveSlack) const
+		{
+			int minX = 0;
+			int minY = 0;
+			int maxX = 0;
+			int maxY = 0;
+			getCellRange(position, radius, moveSlack, minX, minY, maxX, maxY);
+
+			for (int y = minY; y <= maxY; y++)
+			{
+				for (int x = minX; x <= maxX; x++)
+				{
+					const std::vector<CellUnit> &cell = cells[x + y * cellsX];
+					for (int i = 0; i < (int)cell.size(); i++)
+						visitor(cell[i].unit);
+				}
+			}
+		}
+
+	private:
+		struct Entry
+		{
+			Unit *unit;
+			int cell;
+			int slot;
+		};
+
+		struct CellUnit
+		{
+			Unit *unit;
+			int entry;
+		};
+
+		int getCell(const VC3 &position) const;
+		void getCellRange(const VC3 &position, float radius, float moveSlack, int &minX, int &minY, int &maxX, int &maxY) const;
+		void addToCell(int handle, int cell);
+		void removeFromCell(int handle);
+
+		VC2 mmin;
+		float cellSize;
+		float cellSizeInv;
+		int cellsX;
+		int cellsY;
+
+		std::vector<std::vector<CellUnit> > cells;
+		std::vector<Entry> entries;
+		std::vector<int> freeEntries;
+
+		// never shrinks, widens queries enough for the largest unit
+		float maxRadius;
+	};
+}
+
+#endif
+
@@ -649,7 +649,7 @@ if (unit->isActive())
 
 		spawner_dont_delete_unit = true;
 		retireUnit(game, unit);
-		unit->setIdString(NULL);
+		game->units->setUnitIdString(unit, NULL);
 		spawner_dont_delete_unit = false;
 
 		// don't spawn yet! (that should be done separately by the script)
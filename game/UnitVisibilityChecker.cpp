@@ -22,6 +22,7 @@
 #include "GameMap.h"
 //#include "HiddenessSolver.h"
 #include "GameScene.h"
+#include "LineOfSightCache.h"
 #include "GameCollisionInfo.h"
 #include "scaledefs.h"
 
@@ -308,71 +309,86 @@ bool UnitVisibilityChecker::runCheckImpl()
           if (fovRotate == 0)
           {
             // was within fov, continue to raytrace
-
-						// TEMP!
-						// ignore all small units (1.5m) of that target player...
-						// except the one we're trying to hit
-						LinkedList *oul = game->units->getOwnedUnits(other->getOwner());
-						LinkedListIterator iter = LinkedListIterator(oul);
-						while (iter.iterateAvailable())
+						// (unless there is a recent result for these end points)
+						int collisionEpoch = game->gameMap->getCollisionEpoch();
+
+						// HACK: player 0 units predict enemy movements.
+						// seeing them sooner coming behind corners.
+						bool predict = (player == game->singlePlayerNumber);
+						VC3 otherPosPredict = otherPos;
+						if (predict)
 						{
-							Unit *ou = (Unit *)iter.iterateNext();
-							if (ou != other && ou->getVisualObject() != NULL
-								&& ou->isActive() && ou->getUnitType()->getSize() <= 1.5f)
-								ou->getVisualObject()->setCollidable(false);
+							// 2 seconds prediction.
+							VC3 vel = other->getVelocity();
+							// max 3 m/s.
+							if (vel.GetSquareLength() > 3.0f * 3.0f) 
+								vel = (vel * 3.0f) / vel.GetLength();
+							otherPosPredict += vel * GAME_TICKS_PER_SECOND * 2;
 						}
-						// and those friendly units too
-						if (other->getOwner() != u->getOwner())
+
+						bool visible = false;
+						bool visibleKnown = game->losCache->getResult(ownPos, otherPos, collisionEpoch, game->gameTimer, visible);
+						bool predictVisible = false;
+						bool predictKnown = false;
+						if (visibleKnown && !visible && predict)
+							predictKnown = game->losCache->getResult(ownPos, otherPosPredict, collisionEpoch, game->gameTimer, predictVisible);
+
+						if (!visibleKnown || (!visible && predict && !predictKnown))
 						{
-							oul = game->units->getOwnedUnits(u->getOwner());
-							iter = LinkedListIterator(oul);
+							// TEMP!
+							// ignore all small units (1.5m) of that target player...
+							// except the one we're trying to hit
+							LinkedList *oul = game->units->getOwnedUnits(other->getOwner());
+							LinkedListIterator iter = LinkedListIterator(oul);
 							while (iter.iterateAvailable())
 							{
 								Unit *ou = (Unit *)iter.iterateNext();
-								if (ou != u && ou->isActive() 
-									&& ou->getUnitType()->getSize() <= 1.5f)
+								if (ou != other && ou->getVisualObject() != NULL
+									&& ou->isActive() && ou->getUnitType()->getSize() <= 1.5f)
 									ou->getVisualObject()->setCollidable(false);
 							}
-						}
+							// and those friendly units too
+							if (other->getOwner() != u->getOwner())
+							{
+								oul = game->units->getOwnedUnits(u->getOwner());
+								iter = LinkedListIterator(oul);
+								while (iter.iterateAvailable())
+								{
+									Unit *ou = (Unit *)iter.iterateNext();
+									if (ou != u && ou->isActive() 
+										&& ou->getUnitType()->getSize() <= 1.5f)
+										ou->getVisualObject()->setCollidable(false);
+								}
+							}
 
-            VC3 normDirection = distVector.GetNormalized();
-						if (u->getVisualObject() != NULL)
-							u->getVisualObject()->setCollidable(false);
-//            game->getGameScene()->rayTrace(ownPos, normDirection, dist, cinfo, false, true);
+							if (!visibleKnown)
+							{
+								VC3 normDirection = distVector.GetNormalized();
+								if (u->getVisualObject() != NULL)
+									u->getVisualObject()->setCollidable(false);
+//								game->getGameScene()->rayTrace(ownPos, normDirection, dist, cinfo, false, true);
 #ifdef PROJECT_CLAW_PROTO
-            game->getGameScene()->rayTrace(ownPos, normDirection, dist, cinfo, true, true, true, true);
+								game->getGameScene()->rayTrace(ownPos, normDirection, dist, cinfo, true, true, true, true);
 #else
-            game->getGameScene()->rayTrace(ownPos, normDirection, dist, cinfo, true, true);
+								game->getGameScene()->rayTrace(ownPos, normDirection, dist, cinfo, true, true);
 #endif
-						if (u->getVisualObject() != NULL)
-	            u->getVisualObject()->setCollidable(true);
-						didRaytrace = true;
-
-            // did ray hit the other unit
-            // or nothing (thus no obstacles between units, can be seen)
-            if ((cinfo.hit && cinfo.hitUnit && cinfo.unit == other)
-              || !cinfo.hit)
-            {
-              setSeen = true;
-							// NOTE: new behaviour, seen units no-longer
-							// necessarily are in radar
-              //setRadar = true;
-            }
+								if (u->getVisualObject() != NULL)
+									u->getVisualObject()->setCollidable(true);
+								didRaytrace = true;
 
-						if (!setSeen)
-						{
-							// HACK: player 0 units predict enemy movements.
-							// seeing them sooner coming behind corners.
-							if (player == game->singlePlayerNumber)
+								// did ray hit the other unit
+								// or nothing (thus no obstacles between units, can be seen)
+								visible = ((cinfo.hit && cinfo.hitUnit && cinfo.unit == other)
+									|| !cinfo.hit);
+								game->losCache->setResult(ownPos, otherPos, collisionEpoch, game->gameTimer, visible);
+
+								if (!visible && predict)
+									predictKnown = game->losCache->getResult(ownPos, otherPosPredict, collisionEpoch, game->gameTimer, predictVisible);
+							}
+
+							if (!visible && predict && !predictKnown)
 							{
-								// 2 seconds prediction.
-								VC3 vel = other->getVelocity();
-								// max 3 m/s.
-								if (vel.GetSquareLength() > 3.0f * 3.0f) 
-									vel = (vel * 3.0f) / vel.GetLength();
-								VC3 otherPosPredict = otherPos;
-								otherPosPredict += vel * GAME_TICKS_PER_SECOND * 2;
-				        VC3 distVectorPredict = otherPosPredict - ownPos;
+								VC3 distVectorPredict = otherPosPredict - ownPos;
 
 								GameCollisionInfo cinfoPredict;
 								float distPredict = distVector.GetLength();
@@ -388,42 +404,45 @@ bool UnitVisibilityChecker::runCheckImpl()
 								u->getVisualObject()->setCollidable(true);
 								didRaytrace = true;
 
-								if ((cinfoPredict.hit && cinfoPredict.hitUnit && cinfoPredict.unit == other)
-									|| !cinfoPredict.hit)
-								{
-									setSeen = true;
-									// NOTE: new behaviour, seen units no-longer
-									// necessarily are in radar
-									//setRadar = true;
-								}
+								predictVisible = ((cinfoPredict.hit && cinfoPredict.hitUnit && cinfoPredict.unit == other)
+									|| !cinfoPredict.hit);
+								game->losCache->setResult(ownPos, otherPosPredict, collisionEpoch, game->gameTimer, predictVisible);
 							}
-						}
 
-						// TEMP!
-						// restore them all...
-						oul = game->units->getOwnedUnits(other->getOwner());
-						iter = LinkedListIterator(oul);
-						while (iter.iterateAvailable())
-						{
-							Unit *ou = (Unit *)iter.iterateNext();
-							if (ou != other 
-								&& ou->isActive()
-								&& ou->getUnitType()->getSize() <= 1.5f)
-								ou->getVisualObject()->setCollidable(true);
-						}
-						// and those friendly units too
-						if (other->getOwner() != u->getOwner())
-						{
-							oul = game->units->getOwnedUnits(u->getOwner());
+							// TEMP!
+							// restore them all...
+							oul = game->units->getOwnedUnits(other->getOwner());
 							iter = LinkedListIterator(oul);
 							while (iter.iterateAvailable())
 							{
 								Unit *ou = (Unit *)iter.iterateNext();
-								if (ou != u 
+								if (ou != other 
 									&& ou->isActive()
 									&& ou->getUnitType()->getSize() <= 1.5f)
 									ou->getVisualObject()->setCollidable(true);
 							}
+							// and those friendly units too
+							if (other->getOwner() != u->getOwner())
+							{
+								oul = game->units->getOwnedUnits(u->getOwner());
+								iter = LinkedListIterator(oul);
+								while (iter.iterateAvailable())
+								{
+									Unit *ou = (Unit *)iter.iterateNext();
+									if (ou != u 
+										&& ou->isActive()
+										&& ou->getUnitType()->getSize() <= 1.5f)
+										ou->getVisualObject()->setCollidable(true);
+								}
+							}
+						}
+
+						if (visible || (predict && predictVisible))
+						{
+							setSeen = true;
+							// NOTE: new behaviour, seen units no-longer
+							// necessarily are in radar
+							//setRadar = true;
 						}
           }
 
@@ -22,6 +22,7 @@ FILES:=userdata.cpp AlienSpawner.cpp AmmoPack.cpp AmmoPackObject.cpp Ani.cpp \
 	   GameObjectFactoryList.cpp GameObjectList.cpp GameOption.cpp \
 	   GameOptionManager.cpp GameProfiles.cpp GameProfilesEnumeration.cpp \
 	   GameRandom.cpp GameScene.cpp GameStats.cpp GameUI.cpp goretypedefs.cpp \
+	   LoadTaskGraph.cpp ObstacleMapFile.cpp \
 	   Head.cpp HideMap.cpp IndirectWeapon.cpp Item.cpp ItemList.cpp \
 	   ItemManager.cpp ItemPack.cpp ItemType.cpp Leg.cpp LightBlinker.cpp \
 	   LineOfJumpChecker.cpp MaterialManager.cpp materials.cpp \
@@ -33,7 +34,7 @@ FILES:=userdata.cpp AlienSpawner.cpp AmmoPack.cpp AmmoPackObject.cpp Ani.cpp \
 	   Projectile.cpp ProjectileList.cpp ProjectileTrackerObjectType.cpp \
 	   Reactor.cpp ReconChecker.cpp SaveData.cpp savegamevars.cpp \
 	   ScriptDebugger.cpp SidewaysUnitActor.cpp SidewaysUnit.cpp Tool.cpp \
-	   Torso.cpp UnitList.cpp UnifiedHandleManager.cpp UnitActor.cpp Unit.cpp \
+	   Torso.cpp LineOfSightCache.cpp UnitCollisionBroadphase.cpp JobSystem.cpp UnitList.cpp UnitListGrid.cpp UnifiedHandleManager.cpp UnitActor.cpp Unit.cpp \
 	   UnitFormation.cpp UnitInventory.cpp UnitLevelAI.cpp \
 	   UnitPhysicsUpdater.cpp UnitScriptPaths.cpp UnitSelections.cpp \
 	   UnitSpawner.cpp UnitTargeting.cpp UnitType.cpp unittypes.cpp \
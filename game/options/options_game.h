@@ -62,5 +62,14 @@
 
 #define DH_OPT_B_SHOW_TUTORIAL_HINTS 365
 
+#define DH_OPT_B_UNITLIST_GRID 370
+#define DH_OPT_F_UNITLIST_GRID_CELL_SIZE 371
+
+#define DH_OPT_I_LOS_CACHE_LIFETIME 372
+
+#define DH_OPT_B_UNIT_COLLISION_BROADPHASE 373
+
+#define DH_OPT_I_JOB_WORKER_AMOUNT 374
+
 #endif
 
@@ -7,6 +7,7 @@
 #include "dev_script_commands.h"
 #include "scripting_macros_end.h"
 
+#include <vector>
 #include <DatatypeDef.h>
 #include <IStorm3D.h>
 
@@ -321,16 +322,18 @@ namespace game
 					}
 					VC3 pos = game->gameUI->getFirstPerson(0)->getPosition();
 					pos.y += 1.0f;
+					std::vector<VC3> dirs;
 					for (float b = -2.0f; b < 1.0f; b += 0.5f)
 					{
 						for (float a = 0; a < 2*3.1415f; a += 0.25f)
 						{
 							VC3 dir = VC3(cosf(a), sinf(b / 2.0f), sinf(a));
 							dir.Normalize();
-							GameCollisionInfo cinfo;
-							game->getGameScene()->rayTrace(pos, dir, 20, cinfo, true, false);
+							dirs.push_back(dir);
 						}
 					}
+					std::vector<GameCollisionInfo> cinfos(dirs.size());
+					game->getGameScene()->rayTraceBundle(pos, &dirs[0], (int)dirs.size(), 20, &cinfos[0], true);
 					if (game->gameUI->getFirstPerson(0)->getVisualObject() != NULL)
 					{
 						game->gameUI->getFirstPerson(0)->getVisualObject()->setCollidable(true);
@@ -79,6 +79,7 @@
 #include "../tracking/ObjectTracker.h"
 
 
+#include "../../system/LoadTrace.h"
 #include "../../util/Debug_MemoryManager.h"
 
 
@@ -1185,6 +1186,7 @@ namespace game
 
 	void GameScripting::loadScripts(const char *filename, const char *relativeToFilenamePath)
 	{
+		LoadTraceScope trace("script", filename);
 		ScriptManager::getInstance()->loadScripts(filename, relativeToFilenamePath);
 	}
 
@@ -1145,7 +1145,7 @@ namespace game
 		case GS_CMD_PRELOADTEXTURE:
 			if (stringData != NULL)
 			{
-				game->gameUI->getTextureCache()->loadTexture(stringData, false);
+				game->gameUI->getTextureCache()->requestTexture(stringData, false);
 			} else {
 				sp->error("MiscScripting::process - preloadTexture, parameter missing, texture filename expected.");
 			}
@@ -1154,7 +1154,7 @@ namespace game
 		case GS_CMD_PRELOADTEMPORARYTEXTURE:
 			if (stringData != NULL)
 			{
-				game->gameUI->getTextureCache()->loadTexture(stringData, true);
+				game->gameUI->getTextureCache()->requestTexture(stringData, true);
 			} else {
 				sp->error("MiscScripting::process - preloadTemporaryTexture, parameter missing, texture filename expected.");
 			}
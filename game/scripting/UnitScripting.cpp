@@ -2483,7 +2483,7 @@ namespace game
 					if (stringData[0] == '\0'
 						|| strcmp(stringData, "null") == 0)
 					{
-						unit->setIdString(NULL);
+						game->units->setUnitIdString(unit, NULL);
 					} else {
 						const char *s = stringData;
 						if (stringData[0] == '$'
@@ -2498,7 +2498,7 @@ namespace game
 							{
 								sp->warning("UnitScripting::process - setUnitIdString, Another unit with given id-string already exists.");
 							}
-							unit->setIdString(s);
+							game->units->setUnitIdString(unit, s);
 						} else {
 							sp->error("UnitScripting::process - setUnitIdString, null string value.");
 						}
@@ -2509,7 +2509,7 @@ namespace game
 			} else {
 				if (gsd->unit != NULL)
 				{
-					unit->setIdString(NULL);
+					game->units->setUnitIdString(unit, NULL);
 				} else {
 					sp->error("UnitScripting::process - Attempt to setUnitIdString for null unit.");
 				}
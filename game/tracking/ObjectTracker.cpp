@@ -3,12 +3,15 @@
 
 #include "ObjectTracker.h"
 
+#include <vector>
+#include <algorithm>
+
 #include "ITrackerObjectType.h"
 #include "ITrackableObjectFactory.h"
 #include "ITrackableObject.h"
 #include "ITrackerObject.h"
 #include "tracker_signals.h"
-#include "../system/SystemRandom.h"
+#include "../GameRandom.h"
 #include "../unified_handle.h"
 
 // NOTE: bad dependecy...
@@ -39,6 +42,14 @@
 // (2 is probably ok for most cases?, if not a whole lot of trackers)
 #define OBJECTTRACKER_BALANCING_PREFERRED_SIMULTANEOUS_TRACKERS 3
 
+// the time span (msec) that balancing counts as one run call
+// (one game tick)
+#define OBJECTTRACKER_BALANCING_BUCKET_MSEC 15
+
+// how many of those spans ahead are counted (power of 2), trackers
+// due further than that are not balanced (1024 * 15 msec = about 15 sec)
+#define OBJECTTRACKER_BALANCING_BUCKETS 1024
+
 // how many trackers allowed per call at maximum.
 // (1 would cause very heavy balancing and will not be very successful unless amount of trackers is low enough)
 // (even this limit is not absolute if there are too many trackers with high tick rate to successfully balance..)
@@ -66,6 +77,139 @@ namespace tracking
 	InvalidTrackerType invalidTrackerType_instance;
 
 
+	// Tracker due times, in a hierarchical timing wheel
+	// -------------------------------------------------
+	//
+	// Level 0 has a slot per msec for the next 256 msec, level 1 a slot
+	// per 256 msec for the next 65 sec, level 2 a slot per 65 sec beyond
+	// that. When level 0 wraps, the next level 1 slot is spread to level 0
+	// (and likewise level 2 to level 1), so advancing only ever looks at
+	// the slots of the passed msecs.
+	//
+	// Entries are not removed when a tracker is deleted or rescheduled,
+	// they carry the tracker's schedule stamp and stale ones are skipped.
+
+#define OBJECTTRACKER_WHEEL_LEVELS 3
+#define OBJECTTRACKER_WHEEL_SLOT_BITS 8
+#define OBJECTTRACKER_WHEEL_SLOTS (1 << OBJECTTRACKER_WHEEL_SLOT_BITS)
+#define OBJECTTRACKER_WHEEL_SLOT_MASK (OBJECTTRACKER_WHEEL_SLOTS - 1)
+
+	struct ObjectTrackerWheelEntry
+	{
+		int tracker;
+		int stamp;
+		int dueTime;
+	};
+
+	class ObjectTrackerTimingWheel
+	{
+	public:
+		ObjectTrackerTimingWheel()
+		{
+			wheelTime = 0;
+		}
+
+		void clear()
+		{
+			for (int l = 0; l < OBJECTTRACKER_WHEEL_LEVELS; l++)
+			{
+				for (int i = 0; i < OBJECTTRACKER_WHEEL_SLOTS; i++)
+				{
+					slots[l][i].clear();
+				}
+			}
+			overdue.clear();
+		}
+
+		void insert(const ObjectTrackerWheelEntry &entry)
+		{
+			int delta = entry.dueTime - wheelTime;
+			if (delta <= 0)
+			{
+				// (given out on next advance)
+				overdue.push_back(entry);
+				return;
+			}
+
+			if (delta < (1 << OBJECTTRACKER_WHEEL_SLOT_BITS))
+			{
+				slots[0][entry.dueTime & OBJECTTRACKER_WHEEL_SLOT_MASK].push_back(entry);
+			}
+			else if (delta < (1 << (2 * OBJECTTRACKER_WHEEL_SLOT_BITS)))
+			{
+				slots[1][(entry.dueTime >> OBJECTTRACKER_WHEEL_SLOT_BITS) & OBJECTTRACKER_WHEEL_SLOT_MASK].push_back(entry);
+			} else {
+				// anything further than the last level comes out early,
+				// the caller must check the due time and insert again
+				int maxTime = wheelTime + (1 << (3 * OBJECTTRACKER_WHEEL_SLOT_BITS)) - 1;
+				int time = entry.dueTime;
+				if (time > maxTime)
+					time = maxTime;
+				slots[2][(time >> (2 * OBJECTTRACKER_WHEEL_SLOT_BITS)) & OBJECTTRACKER_WHEEL_SLOT_MASK].push_back(entry);
+			}
+		}
+
+		// moves the wheel up to given time, adding all entries due by then to result
+		void advance(int time, std::vector<ObjectTrackerWheelEntry> &result)
+		{
+			for (int i = 0; i < (int)overdue.size(); i++)
+			{
+				result.push_back(overdue[i]);
+			}
+			overdue.clear();
+
+			while (wheelTime < time)
+			{
+				wheelTime++;
+
+				int slot0 = wheelTime & OBJECTTRACKER_WHEEL_SLOT_MASK;
+				if (slot0 == 0)
+				{
+					int slot1 = (wheelTime >> OBJECTTRACKER_WHEEL_SLOT_BITS) & OBJECTTRACKER_WHEEL_SLOT_MASK;
+					if (slot1 == 0)
+					{
+						cascade(2, (wheelTime >> (2 * OBJECTTRACKER_WHEEL_SLOT_BITS)) & OBJECTTRACKER_WHEEL_SLOT_MASK, result);
+					}
+					cascade(1, slot1, result);
+				}
+
+				std::vector<ObjectTrackerWheelEntry> &slot = slots[0][slot0];
+				for (int i = 0; i < (int)slot.size(); i++)
+				{
+					result.push_back(slot[i]);
+				}
+				slot.clear();
+			}
+		}
+
+		int getTime() const
+		{
+			return wheelTime;
+		}
+
+	private:
+		void cascade(int level, int slotNumber, std::vector<ObjectTrackerWheelEntry> &result)
+		{
+			cascadeTemp.swap(slots[level][slotNumber]);
+			for (int i = 0; i < (int)cascadeTemp.size(); i++)
+			{
+				// (clamped level 2 entries can come out before their time,
+				// those go to the caller)
+				if (cascadeTemp[i].dueTime <= wheelTime)
+					result.push_back(cascadeTemp[i]);
+				else
+					insert(cascadeTemp[i]);
+			}
+			cascadeTemp.clear();
+		}
+
+		std::vector<ObjectTrackerWheelEntry> slots[OBJECTTRACKER_WHEEL_LEVELS][OBJECTTRACKER_WHEEL_SLOTS];
+		std::vector<ObjectTrackerWheelEntry> overdue;
+		std::vector<ObjectTrackerWheelEntry> cascadeTemp;
+		int wheelTime;
+	};
+
+
 	class ObjectTrackerImpl
 	{
 	private:
@@ -81,7 +225,17 @@ namespace tracking
 				trackerLastCallTimes[i] = 0;
 				attachedTrackables[i] = NULL;
 				typeNumbersForTrackers[i] = -1;
+				trackerScheduleStamps[i] = 0;
+				trackerDueTimes[i] = 0;
+				trackerLoadBuckets[i] = -1;
+				trackerDue[i] = false;
+				trackerInAttachedList[i] = false;
 			}
+			for (int i = 0; i < OBJECTTRACKER_BALANCING_BUCKETS; i++)
+			{
+				balancingLoad[i] = 0;
+			}
+			gameRandom = NULL;
 			for (int i = 0; i < OBJECTTRACKER_MAX_TRACKERTYPES; i++)
 			{
 				trackerTypes[i] = NULL;
@@ -117,6 +271,27 @@ namespace tracking
 		int lastTracker;
 		int currentTime;
 
+		ObjectTrackerTimingWheel wheel;
+		// bumped whenever the tracker is (re)scheduled or removed, wheel
+		// entries with an older stamp are stale
+		int trackerScheduleStamps[OBJECTTRACKER_MAX_TRACKERS];
+		int trackerDueTimes[OBJECTTRACKER_MAX_TRACKERS];
+		// balancingLoad index the tracker is counted in, -1 if none
+		int trackerLoadBuckets[OBJECTTRACKER_MAX_TRACKERS];
+		bool trackerDue[OBJECTTRACKER_MAX_TRACKERS];
+		// trackers due in each upcoming run (by OBJECTTRACKER_BALANCING_BUCKET_MSEC)
+		int balancingLoad[OBJECTTRACKER_BALANCING_BUCKETS];
+
+		// trackers that (may) have an attached trackable, those need updating every run
+		std::vector<int> attachedTrackerList;
+		bool trackerInAttachedList[OBJECTTRACKER_MAX_TRACKERS];
+
+		// run temporaries
+		std::vector<ObjectTrackerWheelEntry> dueEntries;
+		std::vector<int> runTrackerList;
+
+		GameRandom *gameRandom;
+
 		int nonTrackerRunsSinceTime;
 		int trackerTicksAtLastRun;
 		int balancingTickDelay;
@@ -134,6 +309,93 @@ namespace tracking
 		friend class ObjectTracker;
 
 
+		static int getBalancingBucket(int time)
+		{
+			return (time / OBJECTTRACKER_BALANCING_BUCKET_MSEC) & (OBJECTTRACKER_BALANCING_BUCKETS - 1);
+		}
+
+		void unscheduleTracker(int i)
+		{
+			trackerScheduleStamps[i]++;
+			trackerDue[i] = false;
+			if (trackerLoadBuckets[i] != -1)
+			{
+				balancingLoad[trackerLoadBuckets[i]]--;
+				trackerLoadBuckets[i] = -1;
+			}
+		}
+
+		void scheduleTracker(int i, int dueTime)
+		{
+			unscheduleTracker(i);
+
+			trackerDueTimes[i] = dueTime;
+			if (dueTime > currentTime
+				&& dueTime - currentTime < OBJECTTRACKER_BALANCING_BUCKETS * OBJECTTRACKER_BALANCING_BUCKET_MSEC)
+			{
+				trackerLoadBuckets[i] = getBalancingBucket(dueTime);
+				balancingLoad[trackerLoadBuckets[i]]++;
+			}
+
+			ObjectTrackerWheelEntry entry;
+			entry.tracker = i;
+			entry.stamp = trackerScheduleStamps[i];
+			entry.dueTime = dueTime;
+			wheel.insert(entry);
+		}
+
+		// schedules to the least loaded run within given time span
+		// (ties broken by game random, so that equally loaded runs get filled evenly)
+		void scheduleTrackerBalanced(int i, int earliestTime, int latestTime)
+		{
+			int firstBucket = earliestTime / OBJECTTRACKER_BALANCING_BUCKET_MSEC;
+			int lastBucket = latestTime / OBJECTTRACKER_BALANCING_BUCKET_MSEC;
+			if (earliestTime <= currentTime
+				|| lastBucket >= (currentTime / OBJECTTRACKER_BALANCING_BUCKET_MSEC) + OBJECTTRACKER_BALANCING_BUCKETS)
+			{
+				scheduleTracker(i, earliestTime);
+				return;
+			}
+
+			// (this tracker is not to be counted in its old bucket)
+			unscheduleTracker(i);
+
+			int bestBucket = firstBucket;
+			int bestLoad = balancingLoad[firstBucket & (OBJECTTRACKER_BALANCING_BUCKETS - 1)];
+			int ties = 1;
+			for (int b = firstBucket + 1; b <= lastBucket; b++)
+			{
+				int load = balancingLoad[b & (OBJECTTRACKER_BALANCING_BUCKETS - 1)];
+				if (load < bestLoad)
+				{
+					bestBucket = b;
+					bestLoad = load;
+					ties = 1;
+				}
+				else if (load == bestLoad)
+				{
+					ties++;
+					if (gameRandom != NULL && (gameRandom->nextInt() % ties) == 0)
+						bestBucket = b;
+				}
+			}
+
+			int time = bestBucket * OBJECTTRACKER_BALANCING_BUCKET_MSEC;
+			if (time < earliestTime)
+				time = earliestTime;
+			scheduleTracker(i, time);
+		}
+
+		void addToAttachedList(int i)
+		{
+			if (!trackerInAttachedList[i])
+			{
+				trackerInAttachedList[i] = true;
+				attachedTrackerList.push_back(i);
+			}
+		}
+
+
 		TrackerTypeNumber addTrackerType(ITrackerObjectType *trackerType)
 		{
 			for (int i = 0; i < OBJECTTRACKER_MAX_TRACKERTYPES; i++)
@@ -273,6 +535,7 @@ namespace tracking
 						// do first tick immediately...
 						//trackerLastCallTimes[i] = currentTime;
 						trackerLastCallTimes[i] = currentTime - trackerTypes[trackerTypeNumber]->getTickInterval();
+						scheduleTracker(i, currentTime);
 
 						assert(attachedTrackables[i] == NULL);
 
@@ -319,6 +582,7 @@ namespace tracking
 					if (trackers[i]->getType()->doesGiveOwnershipToObjectTracker())
 						delete trackers[i];
 					trackers[i] = NULL;
+					unscheduleTracker(i);
 					if (attachedTrackables[i] != NULL)
 					{
 						if (attachedTrackables[i]->getTypeId() == TrackableUnifiedHandleObject::typeId)
@@ -345,6 +609,7 @@ namespace tracking
 					if (trackers[i]->getType()->doesGiveOwnershipToObjectTracker())
 						delete trackers[i];
 					trackers[i] = NULL;
+					unscheduleTracker(i);
 					if (attachedTrackables[i] != NULL)
 					{
 						if (attachedTrackables[i]->getTypeId() == TrackableUnifiedHandleObject::typeId)
@@ -400,6 +665,7 @@ namespace tracking
 					if (trackers[i]->getType()->doesGiveOwnershipToObjectTracker())
 						delete tracker;
 					trackers[i] = NULL;
+					unscheduleTracker(i);
 					typeNumbersForTrackers[i] = -1;
 					if (attachedTrackables[i] != NULL)
 					{
@@ -438,6 +704,7 @@ namespace tracking
 					if (trackers[i]->getType()->doesGiveOwnershipToObjectTracker())
 						delete tracker;
 					trackers[i] = NULL;
+					unscheduleTracker(i);
 					typeNumbersForTrackers[i] = -1;
 					if (attachedTrackables[i] != NULL)
 					{
@@ -482,6 +749,7 @@ namespace tracking
 					if (trackers[i]->getType()->doesGiveOwnershipToObjectTracker())
 						delete trackers[i];
 					trackers[i] = NULL;
+					unscheduleTracker(i);
 					typeNumbersForTrackers[i] = -1;
 					if (attachedTrackables[i] != NULL)
 					{
@@ -629,13 +897,62 @@ namespace tracking
 
 			int runTrackerTicks = 0;
 
-			for (int i = 0; i < lastTracker + 1; i++)
+			// due trackers from the wheel...
+			dueEntries.clear();
+			wheel.advance(currentTime, dueEntries);
+
+			runTrackerList.clear();
+			for (int e = 0; e < (int)dueEntries.size(); e++)
+			{
+				const ObjectTrackerWheelEntry &entry = dueEntries[e];
+				int i = entry.tracker;
+				if (trackers[i] == NULL
+					|| entry.stamp != trackerScheduleStamps[i]
+					|| trackerDue[i])
+					continue;
+
+				if (currentTime < trackerDueTimes[i])
+				{
+					// (too far for the wheel, came out early)
+					wheel.insert(entry);
+					continue;
+				}
+
+				trackerDue[i] = true;
+				runTrackerList.push_back(i);
+			}
+
+			// ...and the ones with attached trackables to update
+			int attachedAmount = 0;
+			for (int a = 0; a < (int)attachedTrackerList.size(); a++)
 			{
+				int i = attachedTrackerList[a];
+				if (trackers[i] != NULL && attachedTrackables[i] != NULL)
+				{
+					attachedTrackerList[attachedAmount] = i;
+					attachedAmount++;
+					if (!trackerDue[i])
+						runTrackerList.push_back(i);
+				} else {
+					trackerInAttachedList[i] = false;
+				}
+			}
+			attachedTrackerList.resize(attachedAmount);
+
+			// in tracker order, as the old full scan did
+			std::sort(runTrackerList.begin(), runTrackerList.end());
+
+			for (int r = 0; r < (int)runTrackerList.size(); r++)
+			{
+				int i = runTrackerList[r];
 				if (trackers[i] != NULL)
 				{
 					assert(trackers[i]->getType() != NULL);
-					if (currentTime >= trackerLastCallTimes[i] + trackers[i]->getType()->getTickInterval())
+					if (trackerDue[i])
 					{
+						trackerDue[i] = false;
+
+						int tickInterval = trackers[i]->getType()->getTickInterval();
 						bool runNow = true;
 						if (trackers[i]->getType()->doesAllowTickBalancing())
 						{
@@ -646,7 +963,7 @@ namespace tracking
 								{
 									runNow = false;
 								}
-								if (currentTime < trackerLastCallTimes[i] + (trackers[i]->getType()->getTickInterval() * (100 + OBJECTTRACKER_BALANCING_MAX_TICK_INTERVAL_VARIATION_PERCENTAGE)) / 100)
+								if (currentTime < trackerLastCallTimes[i] + (tickInterval * (100 + OBJECTTRACKER_BALANCING_MAX_TICK_INTERVAL_VARIATION_PERCENTAGE)) / 100)
 								{
 									runNow = false;
 								}
@@ -655,30 +972,34 @@ namespace tracking
 
 						if (runNow)
 						{
+							int stamp = trackerScheduleStamps[i];
+
 							trackers[i]->tick();
+
 							// must check that the tracker has not self-deleted...
-							if (trackers[i] != NULL)
+							// (or been replaced by a new one)
+							if (trackers[i] != NULL
+								&& stamp == trackerScheduleStamps[i])
 							{
 								if (trackers[i]->getType()->doesAllowTickBalancing())
 								{
-									// HACK: a bit random distribution...
-									// FIXME: this should be GameRandom, not SystemRandom
-									if (runTrackerTicks >= OBJECTTRACKER_BALANCING_PREFERRED_SIMULTANEOUS_TRACKERS)
-									{
-										// TODO: proper real balancing, not just reliance on this kinda random...
-										trackerLastCallTimes[i] = currentTime + (SystemRandom::getInstance()->nextInt() & 1) * msec;
-									} else {
-										trackerLastCallTimes[i] = currentTime;
-									}
+									// next tick to the least loaded run within the allowed interval variation
+									trackerLastCallTimes[i] = currentTime;
+									scheduleTrackerBalanced(i, currentTime + tickInterval,
+										currentTime + (tickInterval * (100 + OBJECTTRACKER_BALANCING_MAX_TICK_INTERVAL_VARIATION_PERCENTAGE)) / 100);
 								} else {
-									trackerLastCallTimes[i] += trackers[i]->getType()->getTickInterval();
+									trackerLastCallTimes[i] += tickInterval;
+									scheduleTracker(i, trackerLastCallTimes[i] + tickInterval);
 								}
 							}
 							runTrackerTicks++;
+						} else {
+							// try again next run
+							scheduleTracker(i, currentTime);
 						}
 					}
 
-					if (attachedTrackables[i] != NULL)
+					if (trackers[i] != NULL && attachedTrackables[i] != NULL)
 					{
 						if (!attachedTrackables[i]->doesExist())
 						{
@@ -881,6 +1202,11 @@ namespace tracking
 		impl->run(msec);
 	}
 
+	void ObjectTracker::setGameRandom(GameRandom *gameRandom)
+	{
+		impl->gameRandom = gameRandom;
+	}
+
 	std::vector<ITrackerObject *> ObjectTracker::getAllTrackers()
 	{
 		std::vector<ITrackerObject *> ret;
@@ -915,6 +1241,7 @@ namespace tracking
 				impl->attachedTrackables[i]->release();
 			}
 			impl->attachedTrackables[i] = trackableObject;
+			impl->addToAttachedList(i);
 			if (trackableObject->getTypeId() == TrackableUnifiedHandleObject::typeId)
 			{
 				// WARNING: unsafe cast! (based on check above)
@@ -14,6 +14,8 @@ namespace ui
 
 namespace game
 {
+	class GameRandom;
+
 namespace tracking
 {
 	class ITrackerObject;
@@ -78,6 +80,9 @@ namespace tracking
 
 		void run(int msec);
 
+		// used for tick balancing (may be null, balancing is then less even)
+		void setGameRandom(GameRandom *gameRandom);
+
 		std::string getStatusInfo();
 
 	private:
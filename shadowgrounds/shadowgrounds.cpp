@@ -95,7 +95,10 @@
 #include "../filesystem/ifile_package.h"
 #include "../filesystem/standard_package.h"
 #include "../filesystem/zip_package.h"
+#include "../filesystem/lz_package.h"
 #include "../filesystem/file_package_manager.h"
+#include "../filesystem/file_access_trace.h"
+#include "../system/LoadTrace.h"
 #include "../filesystem/file_list.h"
 
 #include "../util/mod_selector.h"
@@ -190,7 +193,10 @@ static void print_help()
 				 "\t[-v | --version]      Display the game version\n"		\
 				 "\t[-w | --windowed]     Run the game windowed\n"			\
 				 "\t[-f | --fullscreen]   Run the game fullscreen\n"			\
-				 "\t[-s | --nosound]      Do not access the sound card\n");//
+				 "\t[-s | --nosound]      Do not access the sound card\n"		\
+				 "\t[-filetrace=<file>]   Log opened files to a binary trace\n"	\
+				 "\t[-loadtrace=<file>]   Write startup/load timings as Chrome trace JSON\n"	\
+				 "\t[-filecache=<mb>]     Memory for decompressed files (default 48), 0 disables\n");//
 				 //"\t[-g | --withgl] [x]   Use [x] instead of /usr/lib/libGL.so.1 for OpenGL\n");
 }
 
@@ -251,6 +257,39 @@ void parse_commandline(const char *cmdline, int *windowed, bool *compile, bool *
 					*windowed = true;
 					*compile = true;
 				}
+				else if (strcmp(&parseBuf[i], "filecache") == 0)
+				{
+					int j = i + strlen(&parseBuf[i]) + 1;
+					if (j > cmdlineLen)
+						j = cmdlineLen;
+
+					int megabytes = str2int(&parseBuf[j]);
+					if (megabytes < 0)
+						megabytes = 0;
+					// budget is an unsigned int of bytes
+					if (megabytes > 4095)
+						megabytes = 4095;
+
+					Logger::getInstance()->info("File cache budget command line parameter given.");
+					Logger::getInstance()->debug(&parseBuf[j]);
+					frozenbyte::filesystem::FilePackageManager::getInstance().setFileCacheBudget((unsigned int)megabytes * 1024 * 1024);
+				}
+				else if (strcmp(&parseBuf[i], "loadtrace") == 0)
+				{
+					// started already in main, before anything gets loaded
+					if (LoadTrace::isEnabled())
+						Logger::getInstance()->info("Load trace command line parameter given.");
+					else
+						Logger::getInstance()->error("Failed to open load trace (check -loadtrace=<file>).");
+				}
+				else if (strcmp(&parseBuf[i], "filetrace") == 0)
+				{
+					// started already in main, before the first file is opened
+					if (frozenbyte::filesystem::isFileAccessTraceEnabled())
+						Logger::getInstance()->info("File access trace command line parameter given.");
+					else
+						Logger::getInstance()->error("Failed to open file access trace (check -filetrace=<file>).");
+				}
 				GameOption *opt = GameOptionManager::getInstance()->getOptionByName(&parseBuf[i]);
 				if (opt != NULL)
 				{
@@ -497,10 +536,35 @@ static void setsighandler(void) {
 int main(int argc, char *argv[]) __attribute((externally_visible));
 #endif
 
+// -loadtrace=<file> has to be started before the rest of command line is parsed
+static void start_load_trace(int argc, char *argv[])
+{
+	const char *option = "-loadtrace=";
+	for (int i = 1; i < argc; i++)
+	{
+		if (strncmp(argv[i], option, strlen(option)) == 0)
+			LoadTrace::start(argv[i] + strlen(option));
+	}
+}
+
+// -filetrace=<file> has to be started before the first file is opened,
+// so that config and option reads end up in the trace (and lzpacker -order)
+static void start_file_access_trace(int argc, char *argv[])
+{
+	const char *option = "-filetrace=";
+	for (int i = 1; i < argc; i++)
+	{
+		if (strncmp(argv[i], option, strlen(option)) == 0)
+			frozenbyte::filesystem::startFileAccessTrace(argv[i] + strlen(option));
+	}
+}
+
 int main(int argc, char *argv[])
 {
 try {
 	setsighandler();
+	start_load_trace(argc, argv);
+	LoadTrace::begin("engine", "startup");
 	{
 		// change working dir to the directory where the binary is located in
 #ifndef WIN32
@@ -517,6 +581,9 @@ try {
 		}
 #endif
 
+		start_file_access_trace(argc, argv);
+		LoadTraceScope trace("filesystem", "packages");
+
 		using namespace frozenbyte::filesystem;
 		std::shared_ptr<IFilePackage> standardPackage(new StandardPackage());
 		
@@ -532,6 +599,22 @@ try {
 		manager.addPackage(zipPackage2, 2);
 		manager.addPackage(zipPackage3, 3);
 		manager.addPackage(zipPackage4, 4);
+
+		// Fast decompressing versions of the data packages (see lzpacker),
+		// checked before the zip of the same priority
+		std::shared_ptr<IFilePackage> lzPackage1(new LzPackage("data1.fbl"));
+		std::shared_ptr<IFilePackage> lzPackage2(new LzPackage("data2.fbl"));
+		std::shared_ptr<IFilePackage> lzPackage3(new LzPackage("data3.fbl"));
+		std::shared_ptr<IFilePackage> lzPackage4(new LzPackage("data4.fbl"));
+
+		manager.addPackage(lzPackage1, 1);
+		manager.addPackage(lzPackage2, 2);
+		manager.addPackage(lzPackage3, 3);
+		manager.addPackage(lzPackage4, 4);
+
+		// Keeps hot assets decompressed between mission loads. 48MB unless
+		// overridden by -filecache=<megabytes> (0 disables)
+		manager.setFileCacheBudget(48 * 1024 * 1024);
 	}
 
 	// initialize...
@@ -564,6 +647,7 @@ try {
 
 	Timer::init();
 
+	LoadTrace::begin("engine", "options");
 	editor::EditorParser main_config;
 	filesystem::InputStream configFile = filesystem::FilePackageManager::getInstance().getFile("Config/main.txt");
 	configFile >> main_config;
@@ -571,6 +655,7 @@ try {
 	GameOptionManager::getInstance()->load();
 	atexit(&GameConfigs::cleanInstance);
 	atexit(&GameOptionManager::cleanInstance);
+	LoadTrace::end("engine");
 
 	int windowedMode = -1;
 	bool compileOnly = false;
@@ -599,6 +684,7 @@ try {
 	//	game::SimpleOptions::setBool(DH_OPT_B_AUTO_SCRIPT_PREPROCESS, false);
 	//}
 
+	LoadTrace::begin("engine", "storm3d");
 	IStorm3D *s3d = IStorm3D::Create_Storm3D_Interface(window, true, &filesystem::FilePackageManager::getInstance(), Logger::getInstance());
 
 	disposable_s3d = s3d;
@@ -757,6 +843,7 @@ try {
 
 	OptionApplier::applyGammaOptions(s3d);
 	::util::applyRenderer(*s3d, proceduralProperties);
+	LoadTrace::end("engine");
 
 	// keyb3 controller devices
 	int ctrlinit = 0;
@@ -826,6 +913,7 @@ try {
 	disposable_scene->GetCamera()->SetVisibilityRange((float)visRange);
 
 	// create and initialize ogui
+	LoadTrace::begin("engine", "ogui");
 	Ogui *ogui = new Ogui();
 	OguiStormDriver *ogdrv = new OguiStormDriver(s3d, disposable_scene);
 	ogui->SetDriver(ogdrv);
@@ -896,12 +984,14 @@ try {
 	loadDHCursors(ogui, 3); 
 
 	ogui->SetCursorImageState(0, DH_CURSOR_ARROW);
+	LoadTrace::end("engine");
 
 	// sounds
 	SoundLib *soundLib = NULL;
 	SoundMixer *soundMixer = NULL;
 	if(soundCmdOn && SimpleOptions::getBool(DH_OPT_B_SOUNDS_ENABLED))
 	{
+		LoadTraceScope trace("sound", "sound init");
 		soundLib = new SoundLib();
 
 		bool s_use_hardware = SimpleOptions::getBool(DH_OPT_B_SOUND_USE_HARDWARE);
@@ -971,6 +1061,7 @@ try {
 	}
 
 	// create part types (create base types and read data files)
+	LoadTrace::begin("engine", "game data");
 	createPartTypes();
 
 	// player weaponry init
@@ -998,6 +1089,7 @@ try {
 	// init unit actors for unit types
 	createUnitActors(game);
 	createUnitTypes();
+	LoadTrace::end("engine");
 
 	/*
 	GameCamera::CAMERA_MODE cammod = GameCamera::CAMERA_MODE_ZOOM_CENTRIC;
@@ -1017,7 +1109,9 @@ try {
 	gameUI->setCameraTimeFactor(camera_time_factor);
 
 	// start a new single player game
+	LoadTrace::begin("engine", "new game");
 	game->newGame(false);
+	LoadTrace::end("engine");
 
 	if (!compileOnly)
 	{
@@ -1038,6 +1132,7 @@ try {
 		if(soundMixer)
 			builder = soundMixer->getStreamBuilder();
 
+		LoadTraceScope trace("engine", "logo video");
 		ui::GameVideoPlayer::playVideo(disposable_scene, "Data\\Videos\\logo.wmv", builder);
 	}
 	
@@ -1065,7 +1160,7 @@ try {
 
 	Keyb3_UpdateDevices();
 
-	
+	bool firstFrame = true;
 
 	while (!quitRequested)
 	{
@@ -1314,6 +1409,14 @@ try {
 
         s3d->EndFrame();
 
+		if (firstFrame)
+		{
+			// startup ends at first interactive frame, mission loads follow on the same trace
+			LoadTrace::end("engine");
+			LoadTrace::instant("engine", "first frame");
+			firstFrame = false;
+		}
+
 		SelectionBox *sbox = gameUI->getSelectionBox();
 		if (sbox != NULL)
 			sbox->render();
@@ -1509,6 +1612,25 @@ try {
 	
 	delete s3d;
 
+	frozenbyte::filesystem::stopFileAccessTrace();
+	LoadTrace::stop();
+
+	{
+		frozenbyte::filesystem::FileBodyCacheStats stats = frozenbyte::filesystem::FilePackageManager::getInstance().getFileCacheStats();
+
+		// int2str uses a static buffer, one call per statement
+		std::string msg = "File cache: ";
+		msg += int2str(stats.hits);
+		msg += " hits, ";
+		msg += int2str(stats.misses);
+		msg += " misses, ";
+		msg += int2str(stats.evictions);
+		msg += " evictions, ";
+		msg += int2str(stats.cachedBytes / 1024);
+		msg += " kB cached.";
+		Logger::getInstance()->debug(msg.c_str());
+	}
+
 	GameOptionManager::cleanInstance();
 	GameConfigs::cleanInstance();
 
@@ -15,6 +15,7 @@ typedef uint64_t Uint64;
 #include "../game/options/options_debug.h"
 #include "../filesystem/file_package_manager.h"
 #include "../filesystem/input_stream.h"
+#include "../system/LoadTrace.h"
 
 #ifndef PROJECT_VIEWER
 extern bool isThisDeveloper();
@@ -1846,6 +1847,8 @@ Sound *SoundLib::loadSample(const char *file)
 	if(!initialized)
 		return 0;
 
+	LoadTraceScope trace("sound", file);
+
 	if (file == NULL)
 	{
 		string message = "SoundLib::loadSample - Null filename parameter.";
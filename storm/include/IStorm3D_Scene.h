@@ -90,6 +90,12 @@ public:
 
 	// Test collision (to each model in scene)
 	virtual void RayTrace(const VC3 &position,const VC3 &direction_normalized,float ray_length,Storm3D_CollisionInfo &cinf, bool accurate = false)=0;
+	// Rays from one origin traced together (one collision info per ray)
+	virtual void RayTraceBundle(const VC3 &position,const VC3 *directions_normalized,const float *ray_lengths,int ray_amount,Storm3D_CollisionInfo *cinfs, bool accurate = false)
+	{
+		for(int i = 0; i < ray_amount; ++i)
+			RayTrace(position, directions_normalized[i], ray_lengths[i], cinfs[i], accurate);
+	}
 	virtual void SphereCollision(const VC3 &position,float radius,Storm3D_CollisionInfo &cinf, bool accurate = true)=0;
 	virtual void GetEyeVectors(const VC2I &screen_position, Vector &position, Vector &direction) = 0;
 
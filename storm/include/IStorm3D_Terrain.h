@@ -51,6 +51,9 @@ public:
 	virtual void setObstacleHeightmap(const unsigned short *obstacleHeightmap, const util::AreaMap *areaMap) = 0;
 	virtual void recreateCollisionMap() = 0;
 	virtual void forcemapHeight(const VC2 &position, float radius, bool above = true, bool below = false) = 0;
+	// Collision heightmap or obstacle heightmap changed in area (obstacle map coordinates, end exclusive).
+	// Cheap, the raytrace picks up the changes when it needs them
+	virtual void updateCollisionMap(const VC2I &start, const VC2I &end) {}
 
 	// Get shared collision heightmap (2x2 original heightmap size)
 	virtual unsigned short *getCollisionHeightmap() = 0;
@@ -655,7 +655,9 @@ public:
 	void RayTrace(Ray &ray, Storm3D_CollisionInfo &info, bool accurate);
 	void SphereCollision(const Sphere &sphere, Storm3D_CollisionInfo &info, bool accurate);
 
-	void collectSphere(Node *node, std::vector<T *> &list, const VC3 &position, float radius)
+	// Calls visitor(T *) for each instance whose SphereCollision hits
+	template<class Visitor>
+	void visitSphere(Node *node, Visitor &visitor, const VC3 &position, float radius)
 	{
 		typename std::vector<typename QuadtreeEntity<T>::EntityImp *>::iterator it = node->entities.begin();
 		for(; it != node->entities.end(); ++it)
@@ -664,12 +666,12 @@ public:
 			(*it)->instance->SphereCollision(position, radius, info, true);
 
 			if(info.hit)
-				list.push_back((*it)->instance);
+				visitor((*it)->instance);
 
 			//const Sphere &sphere = (*it)->sphere;
 			//float distance = distance2D(position, sphere.position);
 			//if(distance - radius - sphere.radius <= 0)
-			//	list.push_back((*it)->instance);
+			//	visitor((*it)->instance);
 		}
 
 		for(int i = 0; i < 4; ++i)
@@ -682,10 +684,37 @@ public:
 			if(position.x < area.mmax.x + radius)
 			if(position.z > area.mmin.z - radius)
 			if(position.z < area.mmax.z + radius)
-				collectSphere(node->childs[i], list, position, radius);
+				visitSphere(node->childs[i], visitor, position, radius);
 		}
 	}
 
+	template<class Visitor>
+	void visitSphere(Visitor &visitor, const VC3 &position, float radius)
+	{
+		visitSphere(root, visitor, position, radius);
+	}
+
+	struct SphereCollector
+	{
+		std::vector<T *> &list;
+
+		explicit SphereCollector(std::vector<T *> &list_)
+		:	list(list_)
+		{
+		}
+
+		void operator()(T *instance)
+		{
+			list.push_back(instance);
+		}
+	};
+
+	void collectSphere(Node *node, std::vector<T *> &list, const VC3 &position, float radius)
+	{
+		SphereCollector collector(list);
+		visitSphere(node, collector, position, radius);
+	}
+
 	void collectSphere(std::vector<T *> &list, const VC3 &position, float radius)
 	{
 		collectSphere(root, list, position, radius);
@@ -0,0 +1,173 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_S3D_BAKEDMODELFILE_H
+#define INCLUDED_S3D_BAKEDMODELFILE_H
+
+#include <stdint.h>
+
+/*
+Baked model file (.s3b)
+-----------------------
+Preprocessed version of an .s3d (see s3dbaker). Loaded with one read,
+all references are byte offsets from the start of the file so the
+blob can live anywhere in memory.
+
+1. header
+2. textures[]
+3. materials[]
+4. objects[]
+5. helpers[]
+6. strings (zero terminated, referenced by offset)
+7. data: vertices, faces, lod faces, weights and helper keys
+
+The size and crc32 of the .s3d are stored in the header. Loader falls
+back to the .s3d when they no longer match (model edited after baking).
+
+Vertices, faces and weights are stored in the in-memory layout of
+Storm3D_Vertex, Storm3D_Face and Storm3D_Weight and are copied to
+meshes as is. Every section starts at a 16 byte boundary.
+All values little endian.
+*/
+
+static const char S3DB_ID[4] = { 'S', '3', 'D', 'B' };
+static const uint32_t S3DB_VERSION = 2;
+static const int S3DB_ALIGNMENT = 16;
+static const int S3DB_LOD_AMOUNT = 3;
+
+struct S3DB_HEADER
+{
+	char id[4];
+	uint32_t version;
+	uint32_t file_size;
+	uint32_t source_version;	// s3d version baked from
+	uint32_t source_size;		// s3d file size baked from
+	uint32_t source_crc;		// s3d crc32 baked from
+	int32_t bone_id;
+
+	uint32_t texture_amount;
+	uint32_t texture_offset;
+	uint32_t material_amount;
+	uint32_t material_offset;
+	uint32_t object_amount;
+	uint32_t object_offset;
+	uint32_t helper_amount;
+	uint32_t helper_offset;
+	uint32_t string_offset;
+	uint32_t string_size;
+	uint32_t data_offset;
+};
+
+struct S3DB_TEXTURE
+{
+	uint32_t filename;			// string, relative to model path
+	uint32_t identification;
+};
+
+struct S3DB_MATERIAL
+{
+	uint32_t name;				// string
+
+	// Texture indices, -1 if not used
+	int16_t texture_base;
+	int16_t texture_base2;
+	int16_t texture_bump;
+	int16_t texture_reflection;
+	int16_t texture_distortion;
+	int16_t padding;
+
+	float color[3];
+	float self_illum[3];
+	float specular[3];
+	float specular_sharpness;
+
+	uint8_t doublesided;
+	uint8_t wireframe;
+	uint8_t scroll_autostart;
+	uint8_t padding2;
+
+	int32_t reflection_texgen;	// IStorm3D_Material::TEX_GEN
+	int32_t alphablend_type;	// IStorm3D_Material::ATYPE
+	float transparency;
+	float glow;
+	float scroll_speed[2];
+
+	// Texturelayer parameters, valid if base2 / reflection used
+	int32_t base2_blend_op;		// Storm3D_Material::MTL_BOP
+	float base2_blend_factor;
+	int32_t reflection_blend_op;
+	float reflection_blend_factor;
+};
+
+struct S3DB_OBJECT
+{
+	uint32_t name;				// string
+	uint32_t parent;			// string, empty if none
+
+	int16_t material_index;		// -1 if not used
+	uint8_t no_collision;
+	uint8_t no_render;
+	uint8_t light_object;
+	uint8_t has_lods;
+	uint8_t has_weights;
+	uint8_t padding;
+
+	float position[3];
+	float rotation[4];
+	float scale[3];
+
+	uint32_t vertex_amount;
+	uint32_t vertex_offset;		// Storm3D_Vertex[vertex_amount]
+	uint32_t weight_offset;		// Storm3D_Weight[vertex_amount], if has_weights
+
+	// [0] is the full mesh, rest lods if has_lods
+	uint32_t face_amount[S3DB_LOD_AMOUNT];
+	uint32_t face_offset[S3DB_LOD_AMOUNT];	// Storm3D_Face[face_amount]
+};
+
+struct S3DB_HELPER
+{
+	uint32_t name;				// string
+	uint32_t parent;			// string, empty if none
+
+	int32_t helper_type;		// IStorm3D_Helper::HTYPE
+	float position[3];
+	float other[3];
+	float other2[3];
+	int32_t keyframe_endtime;
+
+	// S3DB_KEY arrays, only the ones helper type uses are stored
+	uint32_t poskey_amount;
+	uint32_t o1key_amount;
+	uint32_t o2key_amount;
+	uint32_t key_offset;		// poskeys followed by o1keys and o2keys
+};
+
+struct S3DB_KEY
+{
+	int32_t keytime;
+	float value[3];
+};
+
+struct S3DB_VERTEX
+{
+	float position[3];
+	float normal[3];
+	float texturecoords[2];
+	float texturecoords2[2];
+};
+
+struct S3DB_FACE
+{
+	uint32_t vertex[3];
+};
+
+struct S3DB_WEIGHT
+{
+	int32_t index1;
+	int32_t index2;
+	uint8_t weight1;
+	uint8_t weight2;
+	uint8_t padding[2];
+};
+
+#endif
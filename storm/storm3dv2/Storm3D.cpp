@@ -41,6 +41,7 @@
 
 // HACK!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 #include "../../system/Logger.h"
+#include "../../system/LoadTrace.h"
 
 using namespace frozenbyte;
 
@@ -1399,6 +1400,7 @@ bool Storm3D::GetDSModeStencilSupport(D3DFORMAT &form)
 //------------------------------------------------------------------
 IStorm3D_Texture *Storm3D::CreateNewTexture(const char *originalFilename, DWORD texloadcaps, DWORD texidentity, const void *data, size_t data_size)
 {
+	LoadTraceScope trace("texture", originalFilename);
 	Storm3D_Texture *ex_tex = 0;
 	std::string originalString = originalFilename;
 
@@ -11,82 +11,184 @@
 #include "storm3d.h"
 #include "VertexFormats.h"
 #include <cassert>
+#include <ctype.h>
 #include <stdio.h>
+#include <string.h>
+#include <string>
 
 #include "storm3d_model_object.h"
 #include "storm3d_helper.h"
 #include "storm3d_light.h"
 #include "../../filesystem/input_stream_wrapper.h"
+#include "../../system/FileTimestampChecker.h"
 #include "../../util/Debug_MemoryManager.h"
 
 int storm3d_bone_allocs = 0;
 using namespace frozenbyte;
 
+namespace {
+
+	// Bounds checked reader for .anm data
+	class AnimationReader
+	{
+		const std::vector<unsigned char> &data;
+		unsigned int position;
+		bool failed;
+
+	public:
+		AnimationReader(const std::vector<unsigned char> &data_)
+		:	data(data_),
+			position(0),
+			failed(false)
+		{
+		}
+
+		void read(void *buffer, unsigned int bytes)
+		{
+			if(failed || bytes > data.size() - position)
+			{
+				failed = true;
+				memset(buffer, 0, bytes);
+				return;
+			}
+
+			memcpy(buffer, &data[position], bytes);
+			position += bytes;
+		}
+
+		int readInt()
+		{
+			int value = 0;
+			read(&value, sizeof(int));
+			return value;
+		}
+
+		bool hasFailed() const
+		{
+			return failed;
+		}
+	};
+
+	bool readFile(const char *file_name, std::vector<unsigned char> &result)
+	{
+		filesystem::FB_FILE *fp = filesystem::fb_fopen(file_name, "rb");
+		if(fp == 0)
+			return false;
+
+		result.resize(filesystem::fb_fsize(fp));
+		bool ok = !result.empty() && filesystem::fb_fread(&result[0], 1, result.size(), fp) == result.size();
+
+		filesystem::fb_fclose(fp);
+		return ok;
+	}
+
+	std::string getCompressedFilename(const char *file_name)
+	{
+		std::string result = file_name;
+		if(result.size() < 4 || result[result.size() - 4] != '.')
+			return std::string();
+		if(tolower(result[result.size() - 3]) != 'a' || tolower(result[result.size() - 2]) != 'n' || tolower(result[result.size() - 1]) != 'm')
+			return std::string();
+
+		result[result.size() - 1] = 'c';
+		return result;
+	}
+
+} // unnamed
+
 //------------------------------------------------------------------
 // Storm3D_BoneAnimation
 //------------------------------------------------------------------
 Storm3D_BoneAnimation::Storm3D_BoneAnimation(const char *file_name)
-:	bone_id(0),
-	loop_time(0),
-	reference_count(1)
+:	reference_count(1)
 {
 	successfullyLoaded = false;
 
-	filesystem::FB_FILE *fp = filesystem::fb_fopen(file_name, "rb");
-	if(fp == 0)
-		return;
+	// Prefer precompressed version made by anmcompress, unless the .anm
+	// has been modified after it. (packaged files have no timestamp, so
+	// a loose .anm always wins over a packaged .anc)
+	std::string compressedFilename = getCompressedFilename(file_name);
+	if(!compressedFilename.empty()
+		&& FileTimestampChecker::isFileNewerOrSameThanFile(compressedFilename.c_str(), file_name)
+		&& LoadCompressed(compressedFilename.c_str()))
+		successfullyLoaded = true;
+	else
+		successfullyLoaded = LoadSource(file_name);
+}
+
+bool Storm3D_BoneAnimation::LoadCompressed(const char *file_name)
+{
+	std::vector<unsigned char> data;
+	if(!readFile(file_name, data))
+		return false;
+
+	// Invalid or outdated, original is used instead
+	return animation.read(&data[0], data.size());
+}
+
+// Loads .anm into the in memory format. Keys are kept as they are,
+// dropping them is left to anmcompress (too slow for load time)
+bool Storm3D_BoneAnimation::LoadSource(const char *file_name)
+{
+	std::vector<unsigned char> data;
+	if(!readFile(file_name, data))
+		return false;
+
+	AnimationReader reader(data);
 
 	char header[5] = { 0 };
-	filesystem::fb_fread(header, sizeof(char), 5, fp);
+	reader.read(header, 5);
 	if((memcmp(header,"ANM11",5) != 0))
-	{
-		filesystem::fb_fclose(fp);
-		return;
-	}
+		return false;
 
 	// Bone id
-	filesystem::fb_fread(&bone_id, sizeof(int), 1, fp);
+	int bone_id = reader.readInt();
 
 	// Loop time in ms
-	filesystem::fb_fread(&loop_time, sizeof(int), 1, fp);
+	int loop_time = reader.readInt();
 	
-	int bone_count = 0;
-	filesystem::fb_fread(&bone_count, sizeof(int), 1, fp);
+	int bone_count = reader.readInt();
+	if(bone_count < 0 || unsigned(bone_count) > data.size() || reader.hasFailed())
+		return false;
 
-	// resize containers
-	bone_rotations.resize(bone_count);
-	bone_positions.resize(bone_count);
+	std::vector<Storm3D_CompressedAnimation::SourceTrack> tracks(bone_count);
 
 	// For every bone
 	for(int i = 0; i < bone_count; ++i)
 	{
-		int key_count = 0;
-		filesystem::fb_fread(&key_count, sizeof(int), 1, fp);
-		
-		int position_key_count = 0;
-		filesystem::fb_fread(&position_key_count, sizeof(int), 1, fp);
+		int key_count = reader.readInt();
+		int position_key_count = reader.readInt();
+		if(key_count < 0 || unsigned(key_count) > data.size() || reader.hasFailed())
+			return false;
+
+		Storm3D_CompressedAnimation::SourceTrack &track = tracks[i];
+		track.rotation_times.resize(key_count);
+		track.rotations.resize(key_count);
+		if(position_key_count > 0)
+		{
+			track.position_times.resize(key_count);
+			track.positions.resize(key_count);
+		}
 
 		for(int j = 0; j < key_count; ++j)
 		{
-			int time;
-			Rotation rotation;
-			Vector position;
-
-			filesystem::fb_fread(&time, sizeof(int), 1, fp);
-			filesystem::fb_fread(&rotation, sizeof(float), 4, fp);
-
-			bone_rotations[i].push_back(std::pair<int,Rotation>(time,rotation));
+			int time = reader.readInt();
+			track.rotation_times[j] = time;
+			reader.read(&track.rotations[j], sizeof(float) * 4);
 
 			if(position_key_count > 0)
 			{
-				filesystem::fb_fread(&position, sizeof(float), 3, fp);
-				bone_positions[i].push_back(std::pair<int,Vector>(time,position));
+				track.position_times[j] = time;
+				reader.read(&track.positions[j], sizeof(float) * 3);
 			}
 		}
+
+		if(reader.hasFailed())
+			return false;
 	}
 
-	filesystem::fb_fclose(fp);
-	successfullyLoaded = true;	
+	animation.pack(bone_id, loop_time, tracks);
+	return true;
 }
 
 Storm3D_BoneAnimation::~Storm3D_BoneAnimation()
@@ -112,123 +214,22 @@ void Storm3D_BoneAnimation::Release()
 
 int Storm3D_BoneAnimation::GetLength()
 {
-	return loop_time;
+	return animation.getLoopTime();
 }
 
 int Storm3D_BoneAnimation::GetId()
 {
-	return bone_id;
-}
-
-// Search for key index
-// ToDo: change to binary seach
-template<class T>
-static int SearchIndexNext(const std::vector<T> &keys, int time)
-{
-/*
-	for(int i = 0; i < keys.size(); ++i)
-	{
-		if(keys[i].first > time)
-			return i;
-	}
-
-	return 0;
-*/
-	// Constant fps 25
-	int index =  (time / 40) + 1;
-	if(index < int(keys.size()))
-		return index;
-
-	return 0;
+	return animation.getBoneId();
 }
 
 bool Storm3D_BoneAnimation::GetRotation(int bone_index, int time, Rotation *result) const
 {
-	time %= loop_time;
-
-	// Check
-	assert(int(bone_rotations.size()) > bone_index);
-	const std::vector<BoneRotationKey> &bone_keys = bone_rotations[bone_index];
-	if(bone_keys.size() < 2)
-		return false;
-
-	// Search key index
-	int next_index = SearchIndexNext(bone_keys, time);
-	
-	// Properties
-	const BoneRotationKey &next_key = bone_keys[next_index];
-	BoneRotationKey prev_key;
-	float slerp_amount = 0;
-
-	if(next_key.first > time)
-	{
-		prev_key = bone_keys[next_index - 1];
-		slerp_amount = (float) (time - prev_key.first) / (float) (next_key.first - prev_key.first);
-	}
-	else // between first and last
-	{
-		prev_key = bone_keys[bone_keys.size() - 1];
-		int foo = loop_time - prev_key.first;
-		float step = float(foo + next_key.first);
-		
-		if(time >= prev_key.first)
-			slerp_amount = 1 - (loop_time - time) / step;
-		else
-			slerp_amount = (time + foo) / step;;
-	}
-
-	assert(slerp_amount > -0.01f);
-	assert(slerp_amount <  1.01f);
-
-	// Slerp (interpolate). Now this is final rotation
-	*result = prev_key.second.GetSLInterpolationWith(next_key.second, slerp_amount);
-	//*result = prev_key.second;
-	return true;
+	return animation.getRotation(bone_index, time, *result);
 }
 
 bool Storm3D_BoneAnimation::GetPosition(int bone_index, int time, Vector *result) const
 {
-	time %= loop_time;
-
-	// Check
-	assert(int(bone_positions.size()) > bone_index);
-	const std::vector<BonePositionKey> &bone_keys = bone_positions[bone_index];
-	if(bone_keys.size() < 2)
-		return false;
-
-	// Search key index
-	int next_index = SearchIndexNext(bone_keys, time);
-
-	// Properties
-	const BonePositionKey &next_key = bone_keys[next_index];
-	BonePositionKey prev_key;
-	float interpolate_amount = 0;
-
-	if(next_key.first > time)
-	{
-		prev_key = bone_keys[next_index - 1];
-		interpolate_amount = (float) (time - prev_key.first) / (float) (next_key.first - prev_key.first);
-	}
-	else // between first and last
-	{
-		prev_key = bone_keys[bone_keys.size() - 1];
-		int foo = loop_time - prev_key.first;
-		float step = float(foo + next_key.first);
-		
-		if(time >= prev_key.first)
-			interpolate_amount = 1 - (loop_time - time) / step;
-		else
-			interpolate_amount = (time + foo) / step;;
-	}
-	
-	assert(interpolate_amount > -0.01f);
-	assert(interpolate_amount <  1.01f);
-
-	*result = prev_key.second * (1.f - interpolate_amount);
-	*result += next_key.second * interpolate_amount;
-	//*result = prev_key.second;
-
-	return true;
+	return animation.getPosition(bone_index, time, *result);
 }
 
 
@@ -14,6 +14,7 @@
 #include "IStorm3D_Bone.h"
 
 #include "Storm3D_Datatypes.h"
+#include "Storm3D_CompressedAnimation.h"
 #include <vector>
 
 //------------------------------------------------------------------
@@ -24,20 +25,14 @@ class IStorm3D_Object;
 class Storm3D_Object;
 class Storm3D_Helper_AInterface;
 
-typedef std::pair<int, Rotation> BoneRotationKey;
-typedef std::pair<int, Vector> BonePositionKey;
-
 //------------------------------------------------------------------
 // SnowStorm_BoneAnimation
 //------------------------------------------------------------------
 class Storm3D_BoneAnimation: public IStorm3D_BoneAnimation
 {
-	// [bone_index][key_index] which contains (time/property) pair
-	std::vector<std::vector<BoneRotationKey> > bone_rotations;
-	std::vector<std::vector<BonePositionKey> > bone_positions;
-	
-	int bone_id;
-	int loop_time; // in ms
+	// Quantized and reduced keys of every bone, see Storm3D_CompressedAnimation.h
+	Storm3D_CompressedAnimation animation;
+
 	int reference_count;
 
 	bool successfullyLoaded;
@@ -48,6 +43,9 @@ class Storm3D_BoneAnimation: public IStorm3D_BoneAnimation
 
 	// Use reference methods instead
 	~Storm3D_BoneAnimation();
+
+	bool LoadCompressed(const char *file_name);
+	bool LoadSource(const char *file_name);
 	
 public:	
 	Storm3D_BoneAnimation(const char *file_name);
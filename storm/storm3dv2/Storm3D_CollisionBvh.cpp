@@ -0,0 +1,796 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#endif
+
+//------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------
+#include "Storm3D_CollisionBvh.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define STORM3D_BVH_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "../../util/Debug_MemoryManager.h"
+
+namespace {
+
+	const int BIN_AMOUNT = 16;
+	const int MAX_LEAF_TRIANGLES = 16;
+	const int MAX_BUILD_DEPTH = 48;
+	const int STACK_SIZE = 256;
+
+	// SAH costs: child box test vs one triangle packet test
+	const float TRAVERSAL_COST = 1.f;
+	const float PACKET_COST = 1.f;
+
+	struct Bounds
+	{
+		float mmin[3];
+		float mmax[3];
+
+		Bounds()
+		{
+			for(int i = 0; i < 3; ++i)
+			{
+				mmin[i] = FLT_MAX;
+				mmax[i] = -FLT_MAX;
+			}
+		}
+
+		void add(const float *point)
+		{
+			for(int i = 0; i < 3; ++i)
+			{
+				mmin[i] = std::min(mmin[i], point[i]);
+				mmax[i] = std::max(mmax[i], point[i]);
+			}
+		}
+
+		void add(const Bounds &other)
+		{
+			for(int i = 0; i < 3; ++i)
+			{
+				mmin[i] = std::min(mmin[i], other.mmin[i]);
+				mmax[i] = std::max(mmax[i], other.mmax[i]);
+			}
+		}
+
+		float getArea() const
+		{
+			if(mmin[0] > mmax[0])
+				return 0;
+
+			float x = mmax[0] - mmin[0];
+			float y = mmax[1] - mmin[1];
+			float z = mmax[2] - mmin[2];
+			return x * y + y * z + z * x;
+		}
+	};
+
+	struct BuildTriangle
+	{
+		Bounds bounds;
+		float center[3];
+		int index;
+	};
+
+	struct BinaryNode
+	{
+		Bounds bounds;
+
+		int left;
+		int right;
+
+		// leaf triangles
+		int first;
+		int amount;
+
+		bool isLeaf() const
+		{
+			return left < 0;
+		}
+	};
+
+	int getPacketAmount(int triangles)
+	{
+		return (triangles + 3) / 4;
+	}
+
+	float getComponent(const VC3 &v, int axis)
+	{
+		return (axis == 0) ? v.x : (axis == 1) ? v.y : v.z;
+	}
+
+} // unnamed
+
+struct Storm3D_CollisionBvhBuilder
+{
+	Storm3D_CollisionBvh &bvh;
+	const std::vector<Storm3D_CollisionBvh::Triangle> &triangles;
+
+	std::vector<BuildTriangle> buildTriangles;
+	std::vector<BinaryNode> binaryNodes;
+
+	Storm3D_CollisionBvhBuilder(Storm3D_CollisionBvh &bvh_, const std::vector<Storm3D_CollisionBvh::Triangle> &triangles_)
+	:	bvh(bvh_),
+		triangles(triangles_)
+	{
+	}
+
+	void build()
+	{
+		buildTriangles.resize(triangles.size());
+		for(unsigned int i = 0; i < triangles.size(); ++i)
+		{
+			const Storm3D_CollisionBvh::Triangle &t = triangles[i];
+			BuildTriangle &b = buildTriangles[i];
+
+			const VC3 *v[3] = { &t.vertex0, &t.vertex1, &t.vertex2 };
+			for(int j = 0; j < 3; ++j)
+			{
+				float point[3] = { v[j]->x, v[j]->y, v[j]->z };
+				b.bounds.add(point);
+			}
+			for(int j = 0; j < 3; ++j)
+				b.center[j] = (b.bounds.mmin[j] + b.bounds.mmax[j]) * .5f;
+
+			b.index = i;
+		}
+
+		binaryNodes.reserve(triangles.size() * 2 / 3 + 1);
+		int root = buildNode(0, buildTriangles.size(), 0);
+
+		bvh.nodes.clear();
+		bvh.packets.clear();
+		bvh.nodes.reserve(binaryNodes.size() / 2 + 1);
+		bvh.packets.reserve(getPacketAmount(triangles.size()) * 2);
+
+		if(binaryNodes[root].isLeaf())
+		{
+			// single leaf, still needs a root node
+			bvh.nodes.push_back(makeEmptyNode());
+			setChild(0, 0, root);
+		}
+		else
+			collapse(root);
+	}
+
+	int buildNode(int begin, int end, int depth)
+	{
+		BinaryNode node;
+		node.left = -1;
+		node.right = -1;
+		node.first = begin;
+		node.amount = end - begin;
+
+		Bounds centers;
+		for(int i = begin; i < end; ++i)
+		{
+			node.bounds.add(buildTriangles[i].bounds);
+			centers.add(buildTriangles[i].center);
+		}
+
+		int index = binaryNodes.size();
+		binaryNodes.push_back(node);
+
+		int amount = end - begin;
+		if(amount <= 4)
+			return index;
+
+		int axis = 0;
+		for(int i = 1; i < 3; ++i)
+		{
+			if(centers.mmax[i] - centers.mmin[i] > centers.mmax[axis] - centers.mmin[axis])
+				axis = i;
+		}
+
+		float centerMin = centers.mmin[axis];
+		float extent = centers.mmax[axis] - centers.mmin[axis];
+
+		int split = -1;
+		if(extent > 0.00001f && depth < MAX_BUILD_DEPTH)
+			split = findSahSplit(begin, end, axis, centerMin, extent, node.bounds.getArea());
+		else if(amount <= MAX_LEAF_TRIANGLES)
+			return index;
+
+		// no useful split, cut at median
+		if(split <= begin || split >= end)
+		{
+			if(split == end && amount <= MAX_LEAF_TRIANGLES)
+				return index;
+
+			split = (begin + end) / 2;
+			std::nth_element(buildTriangles.begin() + begin, buildTriangles.begin() + split, buildTriangles.begin() + end, CenterSorter(axis));
+		}
+
+		int left = buildNode(begin, split, depth + 1);
+		int right = buildNode(split, end, depth + 1);
+		binaryNodes[index].left = left;
+		binaryNodes[index].right = right;
+		return index;
+	}
+
+	struct CenterSorter
+	{
+		int axis;
+
+		explicit CenterSorter(int axis_)
+		:	axis(axis_)
+		{
+		}
+
+		bool operator() (const BuildTriangle &a, const BuildTriangle &b) const
+		{
+			return a.center[axis] < b.center[axis];
+		}
+	};
+
+	// Returns partition point, or end if leaf is cheaper
+	int findSahSplit(int begin, int end, int axis, float centerMin, float extent, float area)
+	{
+		int binCounts[BIN_AMOUNT] = { 0 };
+		Bounds binBounds[BIN_AMOUNT];
+
+		float scale = BIN_AMOUNT * 0.9999f / extent;
+		for(int i = begin; i < end; ++i)
+		{
+			const BuildTriangle &t = buildTriangles[i];
+			int bin = int((t.center[axis] - centerMin) * scale);
+			binCounts[bin]++;
+			binBounds[bin].add(t.bounds);
+		}
+
+		// cost of splitting after each bin
+		float rightCosts[BIN_AMOUNT] = { 0 };
+		Bounds rightBounds;
+		int rightCount = 0;
+		for(int i = BIN_AMOUNT - 1; i > 0; --i)
+		{
+			rightBounds.add(binBounds[i]);
+			rightCount += binCounts[i];
+			rightCosts[i - 1] = rightBounds.getArea() * getPacketAmount(rightCount);
+		}
+
+		float bestCost = FLT_MAX;
+		int bestBin = -1;
+		Bounds leftBounds;
+		int leftCount = 0;
+		for(int i = 0; i < BIN_AMOUNT - 1; ++i)
+		{
+			leftBounds.add(binBounds[i]);
+			leftCount += binCounts[i];
+			if(leftCount == 0 || leftCount == end - begin)
+				continue;
+
+			float cost = leftBounds.getArea() * getPacketAmount(leftCount) + rightCosts[i];
+			if(cost < bestCost)
+			{
+				bestCost = cost;
+				bestBin = i;
+			}
+		}
+
+		if(bestBin < 0)
+			return begin;
+
+		int amount = end - begin;
+		float splitCost = TRAVERSAL_COST + PACKET_COST * bestCost / std::max(area, FLT_MIN);
+		float leafCost = PACKET_COST * getPacketAmount(amount);
+		if(amount <= MAX_LEAF_TRIANGLES && leafCost <= splitCost)
+			return end;
+
+		BuildTriangle *first = &buildTriangles[0] + begin;
+		BuildTriangle *last = &buildTriangles[0] + end;
+		BuildTriangle *middle = std::partition(first, last, BinPredicate(axis, centerMin, scale, bestBin));
+		return begin + int(middle - first);
+	}
+
+	struct BinPredicate
+	{
+		int axis;
+		float centerMin;
+		float scale;
+		int bin;
+
+		BinPredicate(int axis_, float centerMin_, float scale_, int bin_)
+		:	axis(axis_),
+			centerMin(centerMin_),
+			scale(scale_),
+			bin(bin_)
+		{
+		}
+
+		bool operator() (const BuildTriangle &t) const
+		{
+			return int((t.center[axis] - centerMin) * scale) <= bin;
+		}
+	};
+
+	Storm3D_CollisionBvh::Node makeEmptyNode() const
+	{
+		Storm3D_CollisionBvh::Node node;
+		for(int i = 0; i < 4; ++i)
+		{
+			for(int j = 0; j < 3; ++j)
+			{
+				// inverted box, never hit
+				node.bounds[j][i] = FLT_MAX;
+				node.bounds[j + 3][i] = -FLT_MAX;
+			}
+
+			node.child[i] = -1;
+			node.packets[i] = 0;
+		}
+
+		return node;
+	}
+
+	// Returns index of created 4 wide node
+	int collapse(int binaryIndex)
+	{
+		int children[4] = { binaryNodes[binaryIndex].left, binaryNodes[binaryIndex].right, -1, -1 };
+		int childAmount = 2;
+
+		// open up the largest inner child until there are four
+		while(childAmount < 4)
+		{
+			int best = -1;
+			float bestArea = -1.f;
+			for(int i = 0; i < childAmount; ++i)
+			{
+				const BinaryNode &child = binaryNodes[children[i]];
+				if(!child.isLeaf() && child.bounds.getArea() > bestArea)
+				{
+					best = i;
+					bestArea = child.bounds.getArea();
+				}
+			}
+
+			if(best < 0)
+				break;
+
+			const BinaryNode &opened = binaryNodes[children[best]];
+			children[best] = opened.left;
+			children[childAmount++] = opened.right;
+		}
+
+		int index = bvh.nodes.size();
+		bvh.nodes.push_back(makeEmptyNode());
+
+		for(int i = 0; i < childAmount; ++i)
+			setChild(index, i, children[i]);
+
+		return index;
+	}
+
+	void setChild(int nodeIndex, int slot, int binaryIndex)
+	{
+		const BinaryNode &child = binaryNodes[binaryIndex];
+		for(int j = 0; j < 3; ++j)
+		{
+			bvh.nodes[nodeIndex].bounds[j][slot] = child.bounds.mmin[j];
+			bvh.nodes[nodeIndex].bounds[j + 3][slot] = child.bounds.mmax[j];
+		}
+
+		if(child.isLeaf())
+		{
+			int first = bvh.packets.size();
+			addPackets(child.first, child.amount);
+
+			bvh.nodes[nodeIndex].child[slot] = first;
+			bvh.nodes[nodeIndex].packets[slot] = bvh.packets.size() - first;
+		}
+		else
+		{
+			// nodes may grow, do not keep references over this
+			int childNode = collapse(binaryIndex);
+			bvh.nodes[nodeIndex].child[slot] = childNode;
+			bvh.nodes[nodeIndex].packets[slot] = 0;
+		}
+	}
+
+	void addPackets(int first, int amount)
+	{
+		for(int i = 0; i < amount; i += 4)
+		{
+			Storm3D_CollisionBvh::TrianglePacket packet;
+			for(int lane = 0; lane < 4; ++lane)
+			{
+				// empty lanes get a zero sized triangle, which never hits
+				VC3 vertex0;
+				VC3 edge1;
+				VC3 edge2;
+				int id = -1;
+
+				if(i + lane < amount)
+				{
+					const Storm3D_CollisionBvh::Triangle &t = triangles[buildTriangles[first + i + lane].index];
+					vertex0 = t.vertex0;
+					edge1 = t.vertex1 - t.vertex0;
+					edge2 = t.vertex2 - t.vertex0;
+					id = t.id;
+				}
+
+				for(int axis = 0; axis < 3; ++axis)
+				{
+					packet.vertex0[axis][lane] = getComponent(vertex0, axis);
+					packet.edge1[axis][lane] = getComponent(edge1, axis);
+					packet.edge2[axis][lane] = getComponent(edge2, axis);
+				}
+				packet.id[lane] = id;
+			}
+
+			bvh.packets.push_back(packet);
+		}
+	}
+};
+
+namespace {
+
+	struct BvhRay
+	{
+		float origin[3];
+		float direction[3];
+		float inverse[3];
+	};
+
+	void initRay(BvhRay &ray, const VC3 &position, const VC3 &direction)
+	{
+		for(int i = 0; i < 3; ++i)
+		{
+			ray.origin[i] = getComponent(position, i);
+			ray.direction[i] = getComponent(direction, i);
+
+			// keep slab math finite on axis aligned rays
+			float d = ray.direction[i];
+			if(fabsf(d) < 1e-20f)
+				d = (d < 0) ? -1e-20f : 1e-20f;
+			ray.inverse[i] = 1.f / d;
+		}
+	}
+
+#ifdef STORM3D_BVH_SSE
+
+	// Returns hit mask (bit per child), entry ranges in near
+	int testBoxes(const float bounds[6][4], const BvhRay &ray, float maxRange, float *near)
+	{
+		__m128 tNear = _mm_setzero_ps();
+		__m128 tFar = _mm_set1_ps(maxRange);
+
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			__m128 origin = _mm_set1_ps(ray.origin[axis]);
+			__m128 inverse = _mm_set1_ps(ray.inverse[axis]);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds[axis]), origin), inverse);
+			__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds[axis + 3]), origin), inverse);
+
+			tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+			tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+		}
+
+		_mm_storeu_ps(near, tNear);
+		return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+	}
+
+	// Moller-Trumbore for four triangles, same rules as CollisionFace::RayTrace.
+	// Returns lane of closest hit below maxRange or -1.
+	int testPacket(const Storm3D_CollisionBvh::TrianglePacket &packet, const BvhRay &ray, float maxRange, float &range)
+	{
+		__m128 dx = _mm_set1_ps(ray.direction[0]);
+		__m128 dy = _mm_set1_ps(ray.direction[1]);
+		__m128 dz = _mm_set1_ps(ray.direction[2]);
+
+		__m128 e1x = _mm_loadu_ps(packet.edge1[0]);
+		__m128 e1y = _mm_loadu_ps(packet.edge1[1]);
+		__m128 e1z = _mm_loadu_ps(packet.edge1[2]);
+		__m128 e2x = _mm_loadu_ps(packet.edge2[0]);
+		__m128 e2y = _mm_loadu_ps(packet.edge2[1]);
+		__m128 e2z = _mm_loadu_ps(packet.edge2[2]);
+
+		// pvec = direction x edge2
+		__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		__m128 mask = _mm_cmpge_ps(det, _mm_set1_ps(0.0001f));
+		if(!_mm_movemask_ps(mask))
+			return -1;
+
+		__m128 tx = _mm_sub_ps(_mm_set1_ps(ray.origin[0]), _mm_loadu_ps(packet.vertex0[0]));
+		__m128 ty = _mm_sub_ps(_mm_set1_ps(ray.origin[1]), _mm_loadu_ps(packet.vertex0[1]));
+		__m128 tz = _mm_sub_ps(_mm_set1_ps(ray.origin[2]), _mm_loadu_ps(packet.vertex0[2]));
+
+		__m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(u, _mm_setzero_ps()));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(u, det));
+
+		// qvec = tvec x edge1
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+
+		__m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(v, _mm_setzero_ps()));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), det));
+		if(!_mm_movemask_ps(mask))
+			return -1;
+
+		__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz));
+		t = _mm_div_ps(t, det);
+		mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, _mm_setzero_ps()));
+		mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(maxRange)));
+
+		int hits = _mm_movemask_ps(mask);
+		if(!hits)
+			return -1;
+
+		float ranges[4];
+		_mm_storeu_ps(ranges, t);
+
+		int result = -1;
+		for(int lane = 0; lane < 4; ++lane)
+		{
+			if((hits & (1 << lane)) && (result < 0 || ranges[lane] < range))
+			{
+				result = lane;
+				range = ranges[lane];
+			}
+		}
+
+		return result;
+	}
+
+	int testBoxesSphere(const float bounds[6][4], const VC3 &position, float radius)
+	{
+		__m128 distance = _mm_setzero_ps();
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			__m128 p = _mm_set1_ps(getComponent(position, axis));
+			__m128 clamped = _mm_max_ps(_mm_loadu_ps(bounds[axis]), _mm_min_ps(p, _mm_loadu_ps(bounds[axis + 3])));
+			__m128 delta = _mm_sub_ps(p, clamped);
+			distance = _mm_add_ps(distance, _mm_mul_ps(delta, delta));
+		}
+
+		return _mm_movemask_ps(_mm_cmple_ps(distance, _mm_set1_ps(radius * radius)));
+	}
+
+#else
+
+	int testBoxes(const float bounds[6][4], const BvhRay &ray, float maxRange, float *near)
+	{
+		int result = 0;
+		for(int lane = 0; lane < 4; ++lane)
+		{
+			float tNear = 0;
+			float tFar = maxRange;
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				float t1 = (bounds[axis][lane] - ray.origin[axis]) * ray.inverse[axis];
+				float t2 = (bounds[axis + 3][lane] - ray.origin[axis]) * ray.inverse[axis];
+				tNear = std::max(tNear, std::min(t1, t2));
+				tFar = std::min(tFar, std::max(t1, t2));
+			}
+
+			near[lane] = tNear;
+			if(tNear <= tFar)
+				result |= 1 << lane;
+		}
+
+		return result;
+	}
+
+	int testPacket(const Storm3D_CollisionBvh::TrianglePacket &packet, const BvhRay &ray, float maxRange, float &range)
+	{
+		const float *d = ray.direction;
+
+		int result = -1;
+		for(int lane = 0; lane < 4; ++lane)
+		{
+			float e1[3] = { packet.edge1[0][lane], packet.edge1[1][lane], packet.edge1[2][lane] };
+			float e2[3] = { packet.edge2[0][lane], packet.edge2[1][lane], packet.edge2[2][lane] };
+
+			float p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+			float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+			if(det < 0.0001f)
+				continue;
+
+			float tv[3];
+			for(int i = 0; i < 3; ++i)
+				tv[i] = ray.origin[i] - packet.vertex0[i][lane];
+
+			float u = tv[0] * p[0] + tv[1] * p[1] + tv[2] * p[2];
+			if(u < 0 || u > det)
+				continue;
+
+			float q[3] = { tv[1] * e1[2] - tv[2] * e1[1], tv[2] * e1[0] - tv[0] * e1[2], tv[0] * e1[1] - tv[1] * e1[0] };
+			float v = d[0] * q[0] + d[1] * q[1] + d[2] * q[2];
+			if(v < 0 || u + v > det)
+				continue;
+
+			float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+			if(t > 0 && t < maxRange && (result < 0 || t < range))
+			{
+				result = lane;
+				range = t;
+			}
+		}
+
+		return result;
+	}
+
+	int testBoxesSphere(const float bounds[6][4], const VC3 &position, float radius)
+	{
+		int result = 0;
+		for(int lane = 0; lane < 4; ++lane)
+		{
+			float distance = 0;
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				float p = getComponent(position, axis);
+				float clamped = std::max(bounds[axis][lane], std::min(p, bounds[axis + 3][lane]));
+				distance += (p - clamped) * (p - clamped);
+			}
+
+			if(distance <= radius * radius)
+				result |= 1 << lane;
+		}
+
+		return result;
+	}
+
+#endif
+
+} // unnamed
+
+Storm3D_CollisionBvh::Storm3D_CollisionBvh()
+{
+}
+
+void Storm3D_CollisionBvh::build(const std::vector<Triangle> &triangles)
+{
+	clear();
+	if(triangles.empty())
+		return;
+
+	Storm3D_CollisionBvhBuilder builder(*this, triangles);
+	builder.build();
+}
+
+void Storm3D_CollisionBvh::clear()
+{
+	std::vector<Node>().swap(nodes);
+	std::vector<TrianglePacket>().swap(packets);
+}
+
+bool Storm3D_CollisionBvh::isEmpty() const
+{
+	return nodes.empty();
+}
+
+int Storm3D_CollisionBvh::rayTrace(const VC3 &position, const VC3 &direction, float max_range, float &range) const
+{
+	if(nodes.empty())
+		return -1;
+
+	BvhRay ray;
+	initRay(ray, position, direction);
+
+	int result = -1;
+	float closest = max_range;
+
+	// leaf entries are stored as -(packet index) - 1
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while(stackSize > 0)
+	{
+		int entry = stack[--stackSize];
+		if(entry < 0)
+		{
+			const Node &leafNode = nodes[(-entry - 1) >> 2];
+			int slot = (-entry - 1) & 3;
+
+			int first = leafNode.child[slot];
+			int amount = leafNode.packets[slot];
+			for(int i = 0; i < amount; ++i)
+			{
+				const TrianglePacket &packet = packets[first + i];
+				int lane = testPacket(packet, ray, closest, closest);
+				if(lane >= 0)
+					result = packet.id[lane];
+			}
+
+			continue;
+		}
+
+		const Node &node = nodes[entry];
+		float near[4];
+		int hits = testBoxes(node.bounds, ray, closest, near);
+		if(!hits)
+			continue;
+
+		// push far ones first so near ones get tested (and shrink range) first
+		int order[4];
+		int orderAmount = 0;
+		for(int i = 0; i < 4; ++i)
+		{
+			if(!(hits & (1 << i)) || node.child[i] < 0)
+				continue;
+
+			int j = orderAmount++;
+			while(j > 0 && near[order[j - 1]] < near[i])
+			{
+				order[j] = order[j - 1];
+				--j;
+			}
+			order[j] = i;
+		}
+
+		for(int i = 0; i < orderAmount; ++i)
+		{
+			int slot = order[i];
+			if(node.packets[slot] > 0)
+				stack[stackSize++] = -((entry << 2) | slot) - 1;
+			else
+				stack[stackSize++] = node.child[slot];
+		}
+	}
+
+	if(result >= 0)
+		range = closest;
+
+	return result;
+}
+
+void Storm3D_CollisionBvh::sphereQuery(const VC3 &position, float radius, SphereVisitor &visitor) const
+{
+	if(nodes.empty())
+		return;
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while(stackSize > 0)
+	{
+		const Node &node = nodes[stack[--stackSize]];
+		int hits = testBoxesSphere(node.bounds, position, radius);
+
+		for(int i = 0; i < 4; ++i)
+		{
+			if(!(hits & (1 << i)) || node.child[i] < 0)
+				continue;
+
+			if(node.packets[i] == 0)
+			{
+				stack[stackSize++] = node.child[i];
+				continue;
+			}
+
+			for(int p = 0; p < node.packets[i]; ++p)
+			{
+				const TrianglePacket &packet = packets[node.child[i] + p];
+				for(int lane = 0; lane < 4; ++lane)
+				{
+					if(packet.id[lane] >= 0)
+						radius = visitor.visit(packet.id[lane], radius);
+				}
+			}
+		}
+	}
+}
+
+unsigned int Storm3D_CollisionBvh::getMemoryUsage() const
+{
+	return nodes.capacity() * sizeof(Node) + packets.capacity() * sizeof(TrianglePacket);
+}
@@ -0,0 +1,90 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_STORM3D_COLLISIONBVH_H
+#define INCLUDED_STORM3D_COLLISIONBVH_H
+
+#include <vector>
+#include "c2_vectors.h"
+
+/*
+Triangle bounding volume hierarchy for mesh collision
+-----------------------------------------------------
+Built with binned SAH into a binary tree, which is then collapsed into
+4 wide nodes. A node keeps the boxes of its (up to) four children side
+by side, so one ray is tested against all of them at once. Leaf
+triangles are stored in packets of four (vertex0 and both edges, each
+component in its own array) for the same reason.
+
+With SSE available (x86) the box and triangle tests run 4 wide,
+elsewhere the same code runs one lane at a time.
+
+Ray test matches CollisionFace::RayTrace: one sided (back faces and
+faces nearly parallel to the ray are ignored), hit range strictly
+between 0 and the given maximum.
+*/
+
+class Storm3D_CollisionBvh
+{
+public:
+	struct Triangle
+	{
+		VC3 vertex0;
+		VC3 vertex1;
+		VC3 vertex2;
+
+		// returned on hit
+		int id;
+	};
+
+	// Called for triangles whose bounds touch the sphere
+	class SphereVisitor
+	{
+	public:
+		virtual ~SphereVisitor() {}
+
+		// Return radius to continue with (smaller to only look for closer hits)
+		virtual float visit(int id, float radius) = 0;
+	};
+
+	Storm3D_CollisionBvh();
+
+	void build(const std::vector<Triangle> &triangles);
+	void clear();
+	bool isEmpty() const;
+
+	// Returns id of closest hit triangle and its range, -1 if none
+	int rayTrace(const VC3 &position, const VC3 &direction_normalized, float max_range, float &range) const;
+
+	void sphereQuery(const VC3 &position, float radius, SphereVisitor &visitor) const;
+
+	unsigned int getMemoryUsage() const;
+
+	// Flat layout, used by the intersection kernels
+	struct Node
+	{
+		// min x, y, z, max x, y, z for each child
+		float bounds[6][4];
+
+		// node index, or packet index for leaves (-1 for empty slot)
+		int child[4];
+		// leaf packet amount, 0 for nodes and empty slots
+		int packets[4];
+	};
+
+	struct TrianglePacket
+	{
+		float vertex0[3][4];
+		float edge1[3][4];
+		float edge2[3][4];
+		int id[4];
+	};
+
+private:
+	// root is nodes[0]
+	std::vector<Node> nodes;
+	std::vector<TrianglePacket> packets;
+
+	friend struct Storm3D_CollisionBvhBuilder;
+};
+
+#endif
@@ -0,0 +1,549 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#endif
+
+//------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------
+#include "Storm3D_CompressedAnimation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <math.h>
+#include <string.h>
+#include "../../util/Debug_MemoryManager.h"
+
+namespace {
+
+	// Smallest three components are within +-1/sqrt(2)
+	const float ROTATION_RANGE = 0.70710678f;
+	const float ROTATION_STEPS = 32767.f;
+	const float POSITION_STEPS = 65535.f;
+
+	// Longest run of keys tested for dropping at once (keeps compression linear)
+	const int MAX_SEGMENT_KEYS = 64;
+
+	void packRotation(const QUAT &rotation, uint16_t *result)
+	{
+		float length = sqrtf(rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z + rotation.w * rotation.w);
+		if(length < 0.0001f)
+			length = 1.f;
+
+		float c[4] = { rotation.x / length, rotation.y / length, rotation.z / length, rotation.w / length };
+
+		int largest = 0;
+		for(int i = 1; i < 4; ++i)
+		{
+			if(fabsf(c[i]) > fabsf(c[largest]))
+				largest = i;
+		}
+
+		// q and -q are the same rotation, make dropped component positive
+		float sign = (c[largest] < 0) ? -1.f : 1.f;
+
+		int index = 0;
+		for(int i = 0; i < 4; ++i)
+		{
+			if(i == largest)
+				continue;
+
+			float value = (c[i] * sign + ROTATION_RANGE) / (2.f * ROTATION_RANGE);
+			value = std::max(0.f, std::min(1.f, value));
+			result[index++] = uint16_t(value * ROTATION_STEPS + 0.5f);
+		}
+
+		result[0] |= uint16_t((largest & 1) << 15);
+		result[1] |= uint16_t((largest >> 1) << 15);
+	}
+
+	QUAT unpackRotation(const uint16_t *packed)
+	{
+		int largest = (packed[0] >> 15) | ((packed[1] >> 15) << 1);
+
+		float c[4];
+		float sum = 0;
+		int index = 0;
+		for(int i = 0; i < 4; ++i)
+		{
+			if(i == largest)
+				continue;
+
+			float value = float(packed[index++] & 0x7FFF) / ROTATION_STEPS;
+			c[i] = value * 2.f * ROTATION_RANGE - ROTATION_RANGE;
+			sum += c[i] * c[i];
+		}
+
+		c[largest] = sqrtf(std::max(0.f, 1.f - sum));
+		return QUAT(c[0], c[1], c[2], c[3]);
+	}
+
+	void packPosition(const ANMC_TRACK &track, const VC3 &position, uint16_t *result)
+	{
+		const float value[3] = { position.x, position.y, position.z };
+		for(int i = 0; i < 3; ++i)
+		{
+			float amount = 0;
+			if(track.position_scale[i] > 0)
+				amount = (value[i] - track.position_min[i]) / track.position_scale[i];
+
+			amount = std::max(0.f, std::min(POSITION_STEPS, amount));
+			result[i] = uint16_t(amount + 0.5f);
+		}
+	}
+
+	VC3 unpackPosition(const ANMC_TRACK &track, const uint16_t *packed)
+	{
+		return VC3(track.position_min[0] + packed[0] * track.position_scale[0],
+			track.position_min[1] + packed[1] * track.position_scale[1],
+			track.position_min[2] + packed[2] * track.position_scale[2]);
+	}
+
+	float getRotationError(const QUAT &a, const QUAT &b)
+	{
+		float dot = fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+		return 2.f * acosf(std::min(1.f, dot));
+	}
+
+	QUAT normalized(const QUAT &rotation)
+	{
+		QUAT result = rotation;
+		float length = sqrtf(result.x * result.x + result.y * result.y + result.z * result.z + result.w * result.w);
+		if(length > 0.0001f)
+			result.Normalize();
+
+		return result;
+	}
+
+	// Greedy reduction: extend each segment while interpolating its end points
+	// reproduces every key in between. First and last key are always kept so
+	// looping behaves as with the full key set.
+	template<class Fits>
+	void reduceKeys(int amount, Fits fits, std::vector<int> &result)
+	{
+		result.clear();
+		if(amount <= 2)
+		{
+			for(int i = 0; i < amount; ++i)
+				result.push_back(i);
+			return;
+		}
+
+		int anchor = 0;
+		result.push_back(anchor);
+
+		for(int end = 2; end < amount; ++end)
+		{
+			if(end - anchor > MAX_SEGMENT_KEYS || !fits(anchor, end))
+			{
+				anchor = end - 1;
+				result.push_back(anchor);
+			}
+		}
+
+		result.push_back(amount - 1);
+	}
+
+	template<class Fits>
+	void keepKeys(int amount, bool reduce, Fits fits, std::vector<int> &result)
+	{
+		if(reduce)
+		{
+			reduceKeys(amount, fits, result);
+			return;
+		}
+
+		result.resize(amount);
+		for(int i = 0; i < amount; ++i)
+			result[i] = i;
+	}
+
+	uint16_t packTime(int time, int time_unit)
+	{
+		int value = std::max(0, time) / time_unit;
+		return uint16_t(std::min(value, 0xFFFF));
+	}
+
+	template<class T>
+	void appendArray(std::vector<unsigned char> &result, const std::vector<T> &array)
+	{
+		if(array.empty())
+			return;
+
+		const unsigned char *data = reinterpret_cast<const unsigned char *> (&array[0]);
+		result.insert(result.end(), data, data + array.size() * sizeof(T));
+	}
+
+	template<class T>
+	void readArray(const unsigned char *&data, std::vector<T> &array, unsigned int amount)
+	{
+		array.resize(amount);
+		if(amount == 0)
+			return;
+
+		memcpy(&array[0], data, amount * sizeof(T));
+		data += amount * sizeof(T);
+	}
+
+} // unnamed
+
+Storm3D_CompressedAnimation::Tolerance::Tolerance()
+:	rotation(0.001f),
+	position(0.001f)
+{
+}
+
+Storm3D_CompressedAnimation::Storm3D_CompressedAnimation()
+:	bone_id(0),
+	loop_time(0),
+	time_unit(1)
+{
+}
+
+void Storm3D_CompressedAnimation::clear()
+{
+	bone_id = 0;
+	loop_time = 0;
+	time_unit = 1;
+
+	tracks.clear();
+	rotation_times.clear();
+	position_times.clear();
+	rotation_keys.clear();
+	position_keys.clear();
+}
+
+void Storm3D_CompressedAnimation::compress(int bone_id_, int loop_time_, const std::vector<SourceTrack> &source, const Tolerance &tolerance)
+{
+	build(bone_id_, loop_time_, source, &tolerance);
+}
+
+void Storm3D_CompressedAnimation::pack(int bone_id_, int loop_time_, const std::vector<SourceTrack> &source)
+{
+	build(bone_id_, loop_time_, source, 0);
+}
+
+// Null tolerance keeps all keys
+void Storm3D_CompressedAnimation::build(int bone_id_, int loop_time_, const std::vector<SourceTrack> &source, const Tolerance *tolerance)
+{
+	clear();
+	bone_id = bone_id_;
+	loop_time = loop_time_;
+	time_unit = std::max(1, (loop_time + 0xFFFE) / 0xFFFF);
+
+	tracks.resize(source.size());
+	std::vector<int> kept;
+
+	for(unsigned int i = 0; i < source.size(); ++i)
+	{
+		const SourceTrack &input = source[i];
+		ANMC_TRACK &track = tracks[i];
+		memset(&track, 0, sizeof(ANMC_TRACK));
+
+		// Rotations
+		{
+			int amount = std::min<int>(input.rotation_times.size(), input.rotations.size());
+
+			std::vector<uint16_t> packed(amount * 3);
+			std::vector<QUAT> original(amount);
+			std::vector<QUAT> decoded(amount);
+			std::vector<int> times(amount);
+			for(int j = 0; j < amount; ++j)
+			{
+				packRotation(input.rotations[j], &packed[j * 3]);
+				original[j] = normalized(input.rotations[j]);
+				decoded[j] = unpackRotation(&packed[j * 3]);
+				times[j] = packTime(input.rotation_times[j], time_unit) * time_unit;
+			}
+
+			keepKeys(amount, tolerance != 0, [&](int a, int b)
+			{
+				if(times[b] <= times[a])
+					return false;
+
+				for(int k = a + 1; k < b; ++k)
+				{
+					float interpolation = float(times[k] - times[a]) / float(times[b] - times[a]);
+					QUAT result = decoded[a].GetSLInterpolationWith(decoded[b], interpolation);
+					if(getRotationError(normalized(result), original[k]) > tolerance->rotation)
+						return false;
+				}
+
+				return true;
+			}, kept);
+
+			track.rotation_first = rotation_times.size();
+			track.rotation_amount = kept.size();
+			for(unsigned int j = 0; j < kept.size(); ++j)
+			{
+				rotation_times.push_back(packTime(input.rotation_times[kept[j]], time_unit));
+				rotation_keys.insert(rotation_keys.end(), &packed[kept[j] * 3], &packed[kept[j] * 3] + 3);
+			}
+		}
+
+		// Positions
+		{
+			int amount = std::min<int>(input.position_times.size(), input.positions.size());
+			if(amount > 0)
+			{
+				VC3 minimum = input.positions[0];
+				VC3 maximum = input.positions[0];
+				for(int j = 1; j < amount; ++j)
+				{
+					const VC3 &p = input.positions[j];
+					minimum.x = std::min(minimum.x, p.x);
+					minimum.y = std::min(minimum.y, p.y);
+					minimum.z = std::min(minimum.z, p.z);
+					maximum.x = std::max(maximum.x, p.x);
+					maximum.y = std::max(maximum.y, p.y);
+					maximum.z = std::max(maximum.z, p.z);
+				}
+
+				track.position_min[0] = minimum.x;
+				track.position_min[1] = minimum.y;
+				track.position_min[2] = minimum.z;
+				track.position_scale[0] = (maximum.x - minimum.x) / POSITION_STEPS;
+				track.position_scale[1] = (maximum.y - minimum.y) / POSITION_STEPS;
+				track.position_scale[2] = (maximum.z - minimum.z) / POSITION_STEPS;
+			}
+
+			std::vector<uint16_t> packed(amount * 3);
+			std::vector<VC3> decoded(amount);
+			std::vector<int> times(amount);
+			for(int j = 0; j < amount; ++j)
+			{
+				packPosition(track, input.positions[j], &packed[j * 3]);
+				decoded[j] = unpackPosition(track, &packed[j * 3]);
+				times[j] = packTime(input.position_times[j], time_unit) * time_unit;
+			}
+
+			keepKeys(amount, tolerance != 0, [&](int a, int b)
+			{
+				if(times[b] <= times[a])
+					return false;
+
+				for(int k = a + 1; k < b; ++k)
+				{
+					float interpolation = float(times[k] - times[a]) / float(times[b] - times[a]);
+					VC3 result = decoded[a] * (1.f - interpolation) + decoded[b] * interpolation;
+					if(result.GetRangeTo(input.positions[k]) > tolerance->position)
+						return false;
+				}
+
+				return true;
+			}, kept);
+
+			track.position_first = position_times.size();
+			track.position_amount = kept.size();
+			for(unsigned int j = 0; j < kept.size(); ++j)
+			{
+				position_times.push_back(packTime(input.position_times[kept[j]], time_unit));
+				position_keys.insert(position_keys.end(), &packed[kept[j] * 3], &packed[kept[j] * 3] + 3);
+			}
+		}
+	}
+}
+
+bool Storm3D_CompressedAnimation::read(const unsigned char *data, unsigned int size)
+{
+	clear();
+
+	if(size < sizeof(ANMC_HEADER))
+		return false;
+
+	ANMC_HEADER header;
+	memcpy(&header, data, sizeof(ANMC_HEADER));
+	if(memcmp(header.id, ANMC_ID, 4) != 0 || header.version != ANMC_VERSION || header.file_size != size)
+		return false;
+	if(header.loop_time <= 0 || header.time_unit == 0)
+		return false;
+
+	// Everything has fixed size, so the header tells exact file size
+	uint64_t expected = sizeof(ANMC_HEADER);
+	expected += uint64_t(header.track_amount) * sizeof(ANMC_TRACK);
+	expected += uint64_t(header.rotation_key_amount) * sizeof(uint16_t) * 4;
+	expected += uint64_t(header.position_key_amount) * sizeof(uint16_t) * 4;
+	if(expected != size)
+		return false;
+
+	const unsigned char *position = data + sizeof(ANMC_HEADER);
+	readArray(position, tracks, header.track_amount);
+
+	for(unsigned int i = 0; i < tracks.size(); ++i)
+	{
+		const ANMC_TRACK &track = tracks[i];
+		if(uint64_t(track.rotation_first) + track.rotation_amount > header.rotation_key_amount
+			|| uint64_t(track.position_first) + track.position_amount > header.position_key_amount)
+		{
+			tracks.clear();
+			return false;
+		}
+	}
+
+	readArray(position, rotation_times, header.rotation_key_amount);
+	readArray(position, position_times, header.position_key_amount);
+	readArray(position, rotation_keys, header.rotation_key_amount * 3);
+	readArray(position, position_keys, header.position_key_amount * 3);
+	assert(position == data + size);
+
+	bone_id = header.bone_id;
+	loop_time = header.loop_time;
+	time_unit = header.time_unit;
+	return true;
+}
+
+void Storm3D_CompressedAnimation::write(std::vector<unsigned char> &result) const
+{
+	ANMC_HEADER header;
+	memset(&header, 0, sizeof(ANMC_HEADER));
+	memcpy(header.id, ANMC_ID, 4);
+	header.version = ANMC_VERSION;
+	header.bone_id = bone_id;
+	header.loop_time = loop_time;
+	header.time_unit = time_unit;
+	header.track_amount = tracks.size();
+	header.rotation_key_amount = rotation_times.size();
+	header.position_key_amount = position_times.size();
+	header.file_size = sizeof(ANMC_HEADER) + tracks.size() * sizeof(ANMC_TRACK) + (rotation_times.size() + position_times.size()) * sizeof(uint16_t) * 4;
+
+	result.clear();
+	result.reserve(header.file_size);
+
+	const unsigned char *headerData = reinterpret_cast<const unsigned char *> (&header);
+	result.insert(result.end(), headerData, headerData + sizeof(ANMC_HEADER));
+	appendArray(result, tracks);
+	appendArray(result, rotation_times);
+	appendArray(result, position_times);
+	appendArray(result, rotation_keys);
+	appendArray(result, position_keys);
+
+	assert(result.size() == header.file_size);
+}
+
+int Storm3D_CompressedAnimation::getBoneId() const
+{
+	return bone_id;
+}
+
+int Storm3D_CompressedAnimation::getLoopTime() const
+{
+	return loop_time;
+}
+
+int Storm3D_CompressedAnimation::getTrackAmount() const
+{
+	return tracks.size();
+}
+
+int Storm3D_CompressedAnimation::getRotationKeyAmount() const
+{
+	return rotation_times.size();
+}
+
+int Storm3D_CompressedAnimation::getPositionKeyAmount() const
+{
+	return position_times.size();
+}
+
+unsigned int Storm3D_CompressedAnimation::getMemoryUsage() const
+{
+	return sizeof(Storm3D_CompressedAnimation) + tracks.capacity() * sizeof(ANMC_TRACK)
+		+ (rotation_times.capacity() + position_times.capacity() + rotation_keys.capacity() + position_keys.capacity()) * sizeof(uint16_t);
+}
+
+// Finds keys around time (binary search, keys are not evenly spaced).
+// Before first or after last key interpolates from last to first over the loop point.
+bool Storm3D_CompressedAnimation::findKeys(const uint16_t *times, int amount, int time, int &prev, int &next, float &interpolation) const
+{
+	if(amount < 2)
+		return false;
+
+	next = int(std::upper_bound(times, times + amount, uint16_t(std::min(time / time_unit, 0xFFFF))) - times);
+	if(next > 0 && next < amount)
+	{
+		prev = next - 1;
+
+		int prevTime = times[prev] * time_unit;
+		int nextTime = times[next] * time_unit;
+		interpolation = (nextTime > prevTime) ? float(time - prevTime) / float(nextTime - prevTime) : 0.f;
+	}
+	else
+	{
+		prev = amount - 1;
+		next = 0;
+
+		int prevTime = times[prev] * time_unit;
+		int nextTime = times[next] * time_unit;
+		int foo = loop_time - prevTime;
+		float step = float(foo + nextTime);
+
+		if(step <= 0)
+			interpolation = 0;
+		else if(time >= prevTime)
+			interpolation = 1 - (loop_time - time) / step;
+		else
+			interpolation = (time + foo) / step;
+	}
+
+	assert(interpolation > -0.01f);
+	assert(interpolation <  1.01f);
+	return true;
+}
+
+bool Storm3D_CompressedAnimation::getRotation(int track_index, int time, QUAT &result) const
+{
+	assert(track_index >= 0 && track_index < int(tracks.size()));
+	if(loop_time <= 0)
+		return false;
+
+	const ANMC_TRACK &track = tracks[track_index];
+	if(track.rotation_amount < 2)
+		return false;
+
+	time %= loop_time;
+	if(time < 0)
+		time += loop_time;
+
+	int prev = 0;
+	int next = 0;
+	float interpolation = 0;
+	if(!findKeys(&rotation_times[track.rotation_first], track.rotation_amount, time, prev, next, interpolation))
+		return false;
+
+	const uint16_t *keys = &rotation_keys[track.rotation_first * 3];
+	QUAT prevKey = unpackRotation(keys + prev * 3);
+	QUAT nextKey = unpackRotation(keys + next * 3);
+
+	result = prevKey.GetSLInterpolationWith(nextKey, interpolation);
+	return true;
+}
+
+bool Storm3D_CompressedAnimation::getPosition(int track_index, int time, VC3 &result) const
+{
+	assert(track_index >= 0 && track_index < int(tracks.size()));
+	if(loop_time <= 0)
+		return false;
+
+	const ANMC_TRACK &track = tracks[track_index];
+	if(track.position_amount < 2)
+		return false;
+
+	time %= loop_time;
+	if(time < 0)
+		time += loop_time;
+
+	int prev = 0;
+	int next = 0;
+	float interpolation = 0;
+	if(!findKeys(&position_times[track.position_first], track.position_amount, time, prev, next, interpolation))
+		return false;
+
+	const uint16_t *keys = &position_keys[track.position_first * 3];
+	VC3 prevKey = unpackPosition(track, keys + prev * 3);
+	VC3 nextKey = unpackPosition(track, keys + next * 3);
+
+	result = prevKey * (1.f - interpolation);
+	result += nextKey * interpolation;
+	return true;
+}
@@ -0,0 +1,122 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_STORM3D_COMPRESSEDANIMATION_H
+#define INCLUDED_STORM3D_COMPRESSEDANIMATION_H
+
+#include <stdint.h>
+#include <vector>
+#include "c2_vectors.h"
+#include "c2_quat.h"
+
+/*
+Compressed bone animation (.anc)
+--------------------------------
+Made from .anm files by anmcompress, or in memory when an .anm is loaded
+(without a usable .anc). Only anmcompress drops keys, runtime conversion
+just quantizes them.
+
+Rotations are stored smallest three: the largest quaternion component is
+dropped (it is solved from the unit length) and the other three are
+quantized to 15 bits. Positions are quantized to 16 bits inside the
+track's bounding box. Keys that interpolation reproduces within
+tolerance are dropped, so key spacing is not constant. Key times are
+16 bit, in units of time_unit ms.
+
+1. header
+2. tracks[], one per bone
+3. rotation times, position times (uint16)
+4. rotation keys, position keys (uint16[3])
+
+All values little endian. In memory the data is kept in the same
+arrays, so a track's times and keys are contiguous.
+*/
+
+static const char ANMC_ID[4] = { 'A', 'N', 'M', 'C' };
+static const uint32_t ANMC_VERSION = 1;
+
+struct ANMC_HEADER
+{
+	char id[4];
+	uint32_t version;
+	uint32_t file_size;
+
+	int32_t bone_id;
+	int32_t loop_time;			// ms
+	uint32_t time_unit;			// ms per stored time unit
+
+	uint32_t track_amount;
+	uint32_t rotation_key_amount;
+	uint32_t position_key_amount;
+};
+
+struct ANMC_TRACK
+{
+	uint32_t rotation_first;
+	uint32_t rotation_amount;
+	uint32_t position_first;
+	uint32_t position_amount;
+
+	float position_min[3];
+	float position_scale[3];	// (max - min) / 65535
+};
+
+class Storm3D_CompressedAnimation
+{
+public:
+	// Largest allowed error for a dropped key
+	struct Tolerance
+	{
+		float rotation;			// radians
+		float position;			// units
+
+		Tolerance();
+	};
+
+	// Uncompressed keys of one bone
+	struct SourceTrack
+	{
+		std::vector<int> rotation_times;
+		std::vector<QUAT> rotations;
+		std::vector<int> position_times;
+		std::vector<VC3> positions;
+	};
+
+	Storm3D_CompressedAnimation();
+
+	// Drops keys within tolerance (slow, meant for anmcompress)
+	void compress(int bone_id, int loop_time, const std::vector<SourceTrack> &source, const Tolerance &tolerance);
+	// Keeps every key, only quantizes
+	void pack(int bone_id, int loop_time, const std::vector<SourceTrack> &source);
+
+	// Validates the whole blob before taking anything in
+	bool read(const unsigned char *data, unsigned int size);
+	void write(std::vector<unsigned char> &result) const;
+
+	int getBoneId() const;
+	int getLoopTime() const;
+	int getTrackAmount() const;
+	int getRotationKeyAmount() const;
+	int getPositionKeyAmount() const;
+	unsigned int getMemoryUsage() const;
+
+	// Result contains interpolated value IFF returns true (track has at least 2 keys)
+	bool getRotation(int track, int time, QUAT &result) const;
+	bool getPosition(int track, int time, VC3 &result) const;
+
+private:
+	int bone_id;
+	int loop_time;
+	int time_unit;
+
+	std::vector<ANMC_TRACK> tracks;
+	std::vector<uint16_t> rotation_times;
+	std::vector<uint16_t> position_times;
+	std::vector<uint16_t> rotation_keys;
+	std::vector<uint16_t> position_keys;
+
+	void clear();
+	void build(int bone_id, int loop_time, const std::vector<SourceTrack> &source, const Tolerance *tolerance);
+	bool findKeys(const uint16_t *times, int amount, int time, int &prev, int &next, float &interpolation) const;
+};
+
+#endif
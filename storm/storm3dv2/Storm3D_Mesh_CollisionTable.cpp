@@ -9,28 +9,17 @@
 //------------------------------------------------------------------
 #include "storm3d_mesh_collisiontable.h"
 #include "storm3d_mesh.h"
+#include "c2_sphere.h"
+#include "c2_plane.h"
+#include "c2_collisioninfo.h"
 #include "../../util/Debug_MemoryManager.h"
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 namespace {
 
-	bool contains2D(const AABB &area, const VC3 &position)
-	{
-		if(position.x < area.mmin.x)
-			return false;
-		if(position.x > area.mmax.x)
-			return false;
-
-		if(position.z < area.mmin.z)
-			return false;
-		if(position.z > area.mmax.z)
-			return false;
-
-		return true;
-	}
-
 	void getClosestPoint(const VC3 &p, const VC3 &a, const VC3 &b, const VC3 &c, VC3 &result)
 	{
 		VC3 ab = b - a;
@@ -106,73 +95,49 @@ struct CollisionFace
 {
 	Sphere sphere;
 
-	// Ray stuff
 	VC3 vertex0;
 	VC3 vertex1;
 	VC3 vertex2;
-
-	VC3 e01;
-	VC3 e02;
 	PLANE plane;
 
 	//VC3 center_position;
 	//float radius;
 
-	void RayTrace(const VC3 &position,const VC3 &direction_normalized,float ray_length,Storm3D_CollisionInfo &rti, bool accurate = true);
 	void SphereCollision(const VC3 &position,float radius,Storm3D_CollisionInfo &rti, bool accurate = true);
-
-	bool fits(const AABB &area) const
-	{
-		if(!contains2D(area, vertex0))
-			return false;
-		if(!contains2D(area, vertex1))
-			return false;
-		if(!contains2D(area, vertex2))
-			return false;
-
-		return true;
-	}
 };
 
-void CollisionFace::RayTrace(const VC3 &position, const VC3 &direction, float ray_length, Storm3D_CollisionInfo &rti, bool accurate)
-{
-	// Begin calculating determinant - also used to calculate U parameter
-	VC3 pvec(direction.y * e02.z - direction.z * e02.y, direction.z * e02.x - direction.x * e02.z, direction.x * e02.y - direction.y * e02.x);
-
-	// If determinant is near zero, ray lies in plane of triangle
-	float det = e01.x * pvec.x + e01.y*pvec.y + e01.z * pvec.z;
-	if(det < 0.0001f) 
-		return;
+namespace {
 
-	// Calculate distance from vert0 to ray origin
-	VC3 tvec(position.x - vertex0.x, position.y - vertex0.y, position.z - vertex0.z);
+	struct FaceSphereVisitor: public Storm3D_CollisionBvh::SphereVisitor
+	{
+		CollisionFace *faces;
+		const VC3 &position;
+		Storm3D_CollisionInfo &colinfo;
+		bool accurate;
+
+		FaceSphereVisitor(CollisionFace *faces_, const VC3 &position_, Storm3D_CollisionInfo &colinfo_, bool accurate_)
+		:	faces(faces_),
+			position(position_),
+			colinfo(colinfo_),
+			accurate(accurate_)
+		{
+		}
 
-	// Calculate U parameter and test bounds
-	float u = tvec.x * pvec.x + tvec.y * pvec.y + tvec.z * pvec.z;
-	if((u < 0) || (u > det)) 
-		return;
+		float visit(int id, float radius)
+		{
+			CollisionFace &face = faces[id];
+			if(face.sphere.position.GetSquareRangeTo(position) > (face.sphere.radius + radius) * (face.sphere.radius + radius))
+				return radius;
 
-	// Prepare to test V parameter
-	VC3 qvec(tvec.y * e01.z - tvec.z * e01.y, tvec.z * e01.x - tvec.x * e01.z, tvec.x * e01.y - tvec.y * e01.x);
-	
-	// Calculate V parameter and test bounds
-	float v = direction.x * qvec.x + direction.y * qvec.y + direction.z * qvec.z;
-	if((v < 0) || ((u + v) > det))
-		return;
+			face.SphereCollision(position, radius, colinfo, accurate);
+			if(colinfo.hit && colinfo.range < radius)
+				return colinfo.range;
 
-	// Calculate t, scale parameters, ray intersects triangle
-	float t = e02.x * qvec.x + e02.y * qvec.y + e02.z * qvec.z;
-	t /= det;
+			return radius;
+		}
+	};
 
-	// Set collision info
-	if((t < rti.range) && (t < ray_length) && (t > 0))
-	{
-		rti.hit = true;
-		rti.range = t;
-		rti.position = position+direction*t;
-		rti.plane_normal = plane.planenormal;
-	}
-}
+} // unnamed
 
 void CollisionFace::SphereCollision(const VC3 &position, float radius, Storm3D_CollisionInfo &colinfo, bool accurate)
 {
@@ -199,8 +164,7 @@ void CollisionFace::SphereCollision(const VC3 &position, float radius, Storm3D_C
 //------------------------------------------------------------------
 Storm3D_Mesh_CollisionTable::Storm3D_Mesh_CollisionTable() :
 	faces(0),
-	face_amount(0),
-	tree(0)
+	face_amount(0)
 {
 }
 
@@ -211,7 +175,6 @@ Storm3D_Mesh_CollisionTable::Storm3D_Mesh_CollisionTable() :
 //------------------------------------------------------------------
 Storm3D_Mesh_CollisionTable::~Storm3D_Mesh_CollisionTable()
 {
-	delete tree;
 	SAFE_DELETE_ARRAY(faces);
 }
 
@@ -227,8 +190,7 @@ void Storm3D_Mesh_CollisionTable::ReBuild(Storm3D_Mesh *mesh)
 	owner=mesh;
 
 	// Allocate memory for collision table
-	delete tree;
-	tree = 0;
+	bvh.clear();
 
 	if(!owner->vertexes || !owner->faces[0])
 		return;
@@ -237,9 +199,6 @@ void Storm3D_Mesh_CollisionTable::ReBuild(Storm3D_Mesh *mesh)
 	SAFE_DELETE_ARRAY(faces);
 	faces = new CollisionFace[face_amount];
 
-	VC2 mmin(10000000.f, 10000000.f);
-	VC2 mmax(-10000000.f, -10000000.f);
-
 	// Create collision table
 	for(int fi = 0; fi < face_amount; ++fi)
 	{
@@ -249,11 +208,11 @@ void Storm3D_Mesh_CollisionTable::ReBuild(Storm3D_Mesh *mesh)
 		faces[fi].vertex2=owner->vertexes[owner->faces[0][fi].vertex_index[2]].position;
 
 		// Create edges
-		faces[fi].e01=owner->vertexes[owner->faces[0][fi].vertex_index[1]].position-owner->vertexes[owner->faces[0][fi].vertex_index[0]].position;
-		faces[fi].e02=owner->vertexes[owner->faces[0][fi].vertex_index[2]].position-owner->vertexes[owner->faces[0][fi].vertex_index[0]].position;
+		VC3 e01=owner->vertexes[owner->faces[0][fi].vertex_index[1]].position-owner->vertexes[owner->faces[0][fi].vertex_index[0]].position;
+		VC3 e02=owner->vertexes[owner->faces[0][fi].vertex_index[2]].position-owner->vertexes[owner->faces[0][fi].vertex_index[0]].position;
 		VC3 e12=owner->vertexes[owner->faces[0][fi].vertex_index[2]].position-owner->vertexes[owner->faces[0][fi].vertex_index[1]].position;
 
-		VC3 cross_e01_e02 = faces[fi].e01.GetCrossWith(faces[fi].e02);
+		VC3 cross_e01_e02 = e01.GetCrossWith(e02);
 		if(cross_e01_e02.GetSquareLength() < 0.0001f)
 		{
 			CollisionFace &face = faces[fi];
@@ -278,35 +237,25 @@ void Storm3D_Mesh_CollisionTable::ReBuild(Storm3D_Mesh *mesh)
 			face->sphere.radius = tmp;
 
 		face->sphere.radius = sqrtf(face->sphere.radius);
-
-		if(face->sphere.position.x - face->sphere.radius < mmin.x)
-			mmin.x = face->sphere.position.x - face->sphere.radius;
-		if(face->sphere.position.z - face->sphere.radius < mmin.y)
-			mmin.y = face->sphere.position.z - face->sphere.radius;
-
-		if(face->sphere.position.x + face->sphere.radius > mmax.x)
-			mmax.x = face->sphere.position.x + face->sphere.radius;
-		if(face->sphere.position.z + face->sphere.radius > mmax.y)
-			mmax.y = face->sphere.position.z + face->sphere.radius;
 	}
 
-	tree = new StaticQuadtree<CollisionFace>(mmin, mmax);
-	//tree = new Quadtree<CollisionFace>(mmin, mmax);
+	std::vector<Storm3D_CollisionBvh::Triangle> triangles;
+	triangles.reserve(face_amount);
 	for(int i = 0; i < face_amount; ++i)
 	{
 		CollisionFace &face = faces[i];
 		if(face.sphere.radius < 0.001f)
 			continue;
 
-		//tree->insert(&face, face.sphere.position, face.sphere.radius);
-
-		float mmin = std::min(face.vertex0.y, face.vertex1.y);
-		mmin = std::min(mmin, face.vertex2.y);
-		float mmax = std::max(face.vertex0.y, face.vertex1.y);
-		mmax = std::max(mmax, face.vertex2.y);
-
-		tree->insert(face, face.sphere.position, face.sphere.radius, mmin, mmax);
+		Storm3D_CollisionBvh::Triangle triangle;
+		triangle.vertex0 = face.vertex0;
+		triangle.vertex1 = face.vertex1;
+		triangle.vertex2 = face.vertex2;
+		triangle.id = i;
+		triangles.push_back(triangle);
 	}
+
+	bvh.build(triangles);
 }
 
 
@@ -316,21 +265,20 @@ void Storm3D_Mesh_CollisionTable::ReBuild(Storm3D_Mesh *mesh)
 //------------------------------------------------------------------
 bool Storm3D_Mesh_CollisionTable::RayTrace(const VC3 &position,const VC3 &direction,float ray_length,Storm3D_CollisionInfo &rti, bool accurate)
 {
-	if(!tree)
+	if(bvh.isEmpty())
 		return false;
 
-	bool oldHit = rti.hit;
-	float oldRange = rti.range;
-
-	Ray ray(position, direction, ray_length);
-	tree->RayTrace(ray, rti, accurate);
-
-	if(oldHit && rti.range < oldRange)
-		return true;
-	if(!oldHit && rti.hit)
-		return true;
+	// Only hits closer than the current one count
+	float range = 0;
+	int face = bvh.rayTrace(position, direction, std::min(ray_length, rti.range), range);
+	if(face < 0)
+		return false;
 
-	return false;
+	rti.hit = true;
+	rti.range = range;
+	rti.position = position + direction * range;
+	rti.plane_normal = faces[face].plane.planenormal;
+	return true;
 }
 
 //------------------------------------------------------------------
@@ -338,14 +286,14 @@ bool Storm3D_Mesh_CollisionTable::RayTrace(const VC3 &position,const VC3 &direct
 //------------------------------------------------------------------
 bool Storm3D_Mesh_CollisionTable::SphereCollision(const VC3 &position,float radius,Storm3D_CollisionInfo &colinfo, bool accurate)
 {
-	if(!tree)
+	if(bvh.isEmpty())
 		return false;
 
 	bool hit = colinfo.hit;
 	float range = colinfo.range;
 
-	Sphere sphere(position, radius);
-	tree->SphereCollision(sphere, colinfo, accurate);
+	FaceSphereVisitor visitor(faces, position, colinfo, accurate);
+	bvh.sphereQuery(position, radius, visitor);
 
 	if(hit && colinfo.range < range)
 		return true;
@@ -357,8 +305,7 @@ bool Storm3D_Mesh_CollisionTable::SphereCollision(const VC3 &position,float radi
 
 void Storm3D_Mesh_CollisionTable::reset()
 {
-	delete tree;
-	tree = 0;
+	bvh.clear();
 
 	delete[] faces;
 	faces = NULL;
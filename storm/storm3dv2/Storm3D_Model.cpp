@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "S3D_ModelFile.h"
+#include "S3D_BakedModelFile.h"
 #include "storm3d.h"
 #include "storm3d_model.h"
 #include "storm3d_model_object.h"
@@ -23,12 +24,15 @@
 #include <map>
 #include <string>
 #include <stdio.h>
+#include <ctype.h>
 #include <cassert>
 #include <algorithm>
 #include <functional>
 #include "Storm3D_Bone.h"
 #include "IStorm3D_Logger.h"
 #include "../../filesystem/input_stream_wrapper.h"
+#include "../../filesystem/file_package_manager.h"
+#include "../../system/LoadTrace.h"
 #include "../../util/Debug_MemoryManager.h"
 
 
@@ -542,6 +546,72 @@ void Storm3D_Model::updateEffectTexture()
 	}
 }
 
+namespace {
+
+	// Material names like "Foo Reflection(0.5)" enable local reflection
+	void setLocalReflectionFromName(Storm3D_Material *material)
+	{
+		const char *searchString = "Reflection(";
+		const char *reflectionString = strstr(material->GetName(), searchString);
+		if(reflectionString != 0)
+		{
+			//MessageBox(0, reflectionString + strlen(searchString), "Woot?!?", MB_OK);
+			//float factor = float(atof(reflectionString + strlen(searchString)));
+			std::string temp = reflectionString + strlen(searchString);
+			for(unsigned int i = 0; i < temp.size(); ++i)
+			{
+				if(temp[i] == ')')
+					temp[i] = ' ';
+			}
+
+			float factor = float(atof(temp.c_str()));
+			if(factor > 0.001f && factor <= 1.0001f)
+				material->SetLocalReflection(true, factor);
+		}
+	}
+
+	IStorm3D_Helper *createHelper(Storm3D_Model &model, int type, const char *name, const float *position, const float *other, const float *other2)
+	{
+		IStorm3D_Helper *helper = NULL;
+		if (type==IStorm3D_Helper::HTYPE_POINT)
+		{
+			helper=model.Helper_Point_New(name,VC3(position));
+		}
+		else if (type==IStorm3D_Helper::HTYPE_VECTOR)
+		{
+			helper=model.Helper_Vector_New(name,VC3(position),VC3(other));
+		}
+		else if (type==IStorm3D_Helper::HTYPE_CAMERA)
+		{
+			helper=model.Helper_Camera_New(name,VC3(position),VC3(other),VC3(other2));
+		}
+		else if (type==IStorm3D_Helper::HTYPE_BOX)
+		{
+			helper=model.Helper_Box_New(name,VC3(position),VC3(other));
+		}
+		else if (type==IStorm3D_Helper::HTYPE_SPHERE)
+		{
+			helper=model.Helper_Sphere_New(name,VC3(position),other[0]);
+		}
+
+		return helper;
+	}
+
+	// foobar.s3d -> foobar.s3b, empty if not an .s3d
+	std::string getBakedFilename(const char *filename)
+	{
+		std::string result = filename;
+		if(result.size() < 4 || result[result.size() - 4] != '.')
+			return std::string();
+		if(tolower(result[result.size() - 3]) != 's' || result[result.size() - 2] != '3' || tolower(result[result.size() - 1]) != 'd')
+			return std::string();
+
+		result[result.size() - 1] = 'b';
+		return result;
+	}
+
+} // unnamed
+
 bool Storm3D_Model::fits(const AABB &area)
 {
 	if(!bones.empty())
@@ -563,6 +633,8 @@ bool Storm3D_Model::fits(const AABB &area)
 //------------------------------------------------------------------
 bool Storm3D_Model::LoadS3D(const char *filename)
 {
+	LoadTraceScope trace("model", filename);
+
 	// First empty model (delete everything)
 //	Empty(false, true);
 
@@ -754,6 +826,22 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 		assert(0);
 		return false;
 	}
+
+	ObjectLoadFlags objectFlags;
+	objectFlags.reflectionMask = reflectionMask;
+	objectFlags.delayedAlpha = delayedAlpha;
+	objectFlags.earlyAlpha = earlyAlpha;
+	objectFlags.alphaTestPass = alphaTestPass;
+	objectFlags.conditionalAlphaTestPass = conditionalAlphaTestPass;
+	objectFlags.alphaTestValue = alphaTestValue;
+
+	// Baked models have no load time geometry modifications, those go through .s3d
+	if(!mirrored && !scaled && !sideways && !fatboy && !blackEdge && hard_rotation == 0)
+	{
+		std::string bakedFilename = getBakedFilename(actual_filename);
+		if(!bakedFilename.empty() && LoadBakedS3D(bakedFilename.c_str(), actual_filename, objectFlags))
+			return true;
+	}
 	
 	// Open file
 	filesystem::FB_FILE *f = filesystem::fb_fopen(actual_filename,"rb");
@@ -794,7 +882,7 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 			s3d_version = header.id[3] - '0';
 
 			if(s3d_version == 0)
-				filesystem::fb_fread(&s3d_version, 1, sizeof(int), f);
+				filesystem::fb_fread_ints(&s3d_version, 1, f);
 			else if((s3d_version != 6) && (s3d_version != 7) && (s3d_version != 8) && (s3d_version != 9))
 			{
 				filesystem::fb_fclose(f);
@@ -819,7 +907,7 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 	else
 	{
 		// Load bone id instead
-		filesystem::fb_fread(&model_boneid, sizeof(int), 1, f);
+		filesystem::fb_fread_ints(&model_boneid, 1, f);
 
 		// If bones already loaded and not compatible, return
 		if((bone_boneid != 0) && (model_boneid != bone_boneid))
@@ -888,26 +976,26 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 			if(s3d_version >= 14)
 				filesystem::fb_fread(&texture_distortion, sizeof(short int), 1, f);
 
-			filesystem::fb_fread(mat.color, sizeof(float), 3, f);
-			filesystem::fb_fread(mat.self_illum, sizeof(float), 3, f);
-			filesystem::fb_fread(mat.specular, sizeof(float), 3, f);
-			filesystem::fb_fread(&mat.specular_sharpness, sizeof(float), 1, f);
+			filesystem::fb_fread_floats(mat.color, 3, f);
+			filesystem::fb_fread_floats(mat.self_illum, 3, f);
+			filesystem::fb_fread_floats(mat.specular, 3, f);
+			filesystem::fb_fread_floats(&mat.specular_sharpness, 1, f);
 			filesystem::fb_fread(&mat.doublesided, sizeof(bool), 1, f);
 			filesystem::fb_fread(&mat.wireframe, sizeof(bool), 1, f);
 			filesystem::fb_fread(&mat.reflection_texgen, sizeof(int), 1, f);
 			filesystem::fb_fread(&mat.alphablend_type, sizeof(int), 1, f);
-			filesystem::fb_fread(&mat.transparency, sizeof(float), 1, f);
+			filesystem::fb_fread_floats(&mat.transparency, 1, f);
 		}
 
 		if(s3d_version >= 12)
-			filesystem::fb_fread(&mat.glow, sizeof(float), 1, f);
+			filesystem::fb_fread_floats(&mat.glow, 1, f);
 
 		VC2 scrollSpeed;
 		bool scrollAutoStart = false;
 
 		if(s3d_version >= 13)
 		{
-			filesystem::fb_fread(&scrollSpeed, sizeof(float), 2, f);
+			filesystem::fb_fread_floats(&scrollSpeed.x, 2, f);
 			char scrollStart = 0;
 			filesystem::fb_fread(&scrollStart, sizeof(char), 1, f);
 			if(scrollStart)
@@ -960,23 +1048,7 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 			tmat->ChangeReflectionTextureParameters(tlayer.blend_op,tlayer.blend_factor,mat.reflection_texgen);
 		}
 
-		const char *searchString = "Reflection(";
-		const char *reflectionString = strstr(tmat->GetName(), searchString);
-		if(reflectionString != 0)
-		{
-			//MessageBox(0, reflectionString + strlen(searchString), "Woot?!?", MB_OK);
-			//float factor = float(atof(reflectionString + strlen(searchString)));
-			std::string temp = reflectionString + strlen(searchString);
-			for(unsigned int i = 0; i < temp.size(); ++i)
-			{
-				if(temp[i] == ')')
-					temp[i] = ' ';
-			}
-
-			float factor = float(atof(temp.c_str()));
-			if(factor > 0.001f && factor <= 1.0001f)
-				tmat->SetLocalReflection(true, factor);
-		}
+		setLocalReflectionFromName(tmat);
 	}
 
 	// Read objects
@@ -1000,9 +1072,9 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 			filesystem::fb_fread(&obj.material_index, sizeof(short int), 1, f);
 			assert(obj.material_index < header.num_materials);
 
-			filesystem::fb_fread(obj.position, sizeof(float), 3, f);
-			filesystem::fb_fread(obj.rotation, sizeof(float), 4, f);
-			filesystem::fb_fread(obj.scale, sizeof(float), 3, f);
+			filesystem::fb_fread_floats(obj.position, 3, f);
+			filesystem::fb_fread_floats(obj.rotation, 4, f);
+			filesystem::fb_fread_floats(obj.scale, 3, f);
 
 			// the haxored hard vertex rotation...
 			// -- jpk
@@ -1079,7 +1151,7 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 
 				filesystem::fb_fread(&obj.is_mirror, sizeof(bool), 1, f);
 				filesystem::fb_fread(&obj.shadow_level, sizeof(BYTE), 1, f);
-				filesystem::fb_fread(&obj.keyframe_endtime, sizeof(int), 1, f);
+				filesystem::fb_fread_ints(&obj.keyframe_endtime, 1, f);
 				filesystem::fb_fread(&obj.lod_amount, sizeof(BYTE), 1, f);
 				filesystem::fb_fread(&obj.poskey_amount, sizeof(WORD), 1, f);
 				filesystem::fb_fread(&obj.rotkey_amount, sizeof(WORD), 1, f);
@@ -1128,23 +1200,7 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 		Storm3D_Mesh *tmesh=(Storm3D_Mesh*)this->Storm3D2->CreateNewMesh();
 		//tobj->mesh=tmesh;
 
-		if (reflectionMask)
-		{
-			tobj->EnableRenderPass(RENDER_PASS_BIT_CAREFLECTION_DEPTH_MASKS);
-		}
-		if (delayedAlpha)
-		{
-			tobj->EnableRenderPass(RENDER_PASS_BIT_DELAYED_ALPHA);
-		}
-		if (earlyAlpha)
-		{
-			tobj->EnableRenderPass(RENDER_PASS_BIT_EARLY_ALPHA);
-		}
-		if (alphaTestPass || conditionalAlphaTestPass)
-		{
-			tobj->EnableRenderPass(RENDER_PASS_BIT_ADDITIONAL_ALPHA_TEST_PASS);
-			tobj->SetAlphaTestPassParams(conditionalAlphaTestPass, alphaTestValue);
-		}
+		applyObjectLoadFlags(tobj, objectFlags);
 			
 		// Set parent (if has)
 		if (strlen(obj.parent.c_str())>0)
@@ -1207,14 +1263,15 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 		if(has_weights)
 			tmesh->bone_weights = new Storm3D_Weight[obj.vertex_amount];
 
-		int vertexSize = (2 * 3 * sizeof(float)) + (2 * 2 * sizeof(float));
-		std::vector<char> vbuffer(originalVertexAmount * vertexSize);
-		filesystem::fb_fread(&vbuffer[0], sizeof(char), vbuffer.size(), f);
+		// (S3D_VERTEX is all floats)
+		int vertexFloats = sizeof(S3D_VERTEX) / sizeof(float);
+		std::vector<float> vbuffer(originalVertexAmount * vertexFloats);
+		filesystem::fb_fread_floats(vbuffer.data(), vbuffer.size(), f);
 
 		// Read vertex data
 		for (int i2=0;i2<originalVertexAmount;i2++)
 		{
-			S3D_VERTEX &vertex = *((S3D_VERTEX *) (&vbuffer[i2 * vertexSize]));
+			S3D_VERTEX &vertex = *((S3D_VERTEX *) (&vbuffer[i2 * vertexFloats]));
 
 			/*
 			// Read data
@@ -1450,12 +1507,13 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 				WORD faceAmount = 0;
 				filesystem::fb_fread(&faceAmount, sizeof(WORD), 1, f);
 
+				std::vector<S3D_FACE> lodFaces(faceAmount);
+				filesystem::fb_fread(lodFaces.data(), sizeof(S3D_FACE), faceAmount, f);
+
 				Storm3D_Face *buffer = new Storm3D_Face[faceAmount];
 				for(int i = 0; i < faceAmount; ++i)
 				{
-					S3D_FACE face;
-					filesystem::fb_fread(&face, sizeof(S3D_FACE), 1, f);
-
+					const S3D_FACE &face = lodFaces[i];
 					buffer[i] = Storm3D_Face(face.vertex[0], face.vertex[1], face.vertex[2], VC3(0,0,0));
 				}
 
@@ -1481,17 +1539,20 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 		/* Bone weights */
 		if(has_weights)
 		{
+			// two bone indices and two weights per vertex
+			int weightSize = 2 * sizeof(int) + 2 * sizeof(signed char);
+			std::vector<char> wbuffer(originalVertexAmount * weightSize);
+			filesystem::fb_fread(wbuffer.data(), sizeof(char), wbuffer.size(), f);
+
 			for(int j = 0; j < originalVertexAmount; j++)
 			{
+				const char *weightData = wbuffer.data() + j * weightSize;
 				int bone1;
 				int bone2;
-				signed char weight1;
-				signed char weight2;
-
-				filesystem::fb_fread(&bone1, sizeof(int), 1, f);
-				filesystem::fb_fread(&bone2, sizeof(int), 1, f);
-				filesystem::fb_fread(&weight1, sizeof(signed char), 1, f);
-				filesystem::fb_fread(&weight2, sizeof(signed char), 1, f);
+				signed char weight1 = weightData[2 * sizeof(int)];
+				signed char weight2 = weightData[2 * sizeof(int) + 1];
+				memcpy(&bone1, weightData, sizeof(int));
+				memcpy(&bone2, weightData + sizeof(int), sizeof(int));
 
 				// bone1 = bone2 = 0;
 				//weight1 = weight2 = 0;
@@ -1517,25 +1578,13 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 
 		// Read animation keyframes
 		//tobj->Animation_SetLoop(obj.keyframe_endtime);
-		for (int i2=0;i2<obj.poskey_amount;i2++)	// Position
+		// Position, QUAT and VC3 keys are not used, skip them in one read
 		{
-			// Read keyframe from disk
-			S3D_V3KEY temp_kf;
-			filesystem::fb_fread(&temp_kf,sizeof(S3D_V3KEY),1,f);
-		}
-
-		for (int i2=0;i2<obj.rotkey_amount;i2++)	// QUAT
-		{
-			// Read keyframe from disk
-			S3D_ROTKEY temp_kf;
-			filesystem::fb_fread(&temp_kf,sizeof(S3D_ROTKEY),1,f);
-		}
-
-		for (int i2=0;i2<obj.scalekey_amount;i2++)	// VC3
-		{
-			// Read keyframe from disk
-			S3D_V3KEY temp_kf;
-			filesystem::fb_fread(&temp_kf,sizeof(S3D_V3KEY),1,f);
+			int keyBytes = obj.poskey_amount * sizeof(S3D_V3KEY)
+				+ obj.rotkey_amount * sizeof(S3D_ROTKEY)
+				+ obj.scalekey_amount * sizeof(S3D_V3KEY);
+			std::vector<char> keyBuffer(keyBytes);
+			filesystem::fb_fread(keyBuffer.data(), sizeof(char), keyBuffer.size(), f);
 		}
 
 		for (int i2=0;i2<obj.meshkey_amount;i2++)	// Mesh
@@ -1548,10 +1597,13 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 			Storm3D_Vertex *temp_vxs=new Storm3D_Vertex[tmesh->vertex_amount];
 
 			// Read vertexes from disk
+			int keyVertexFloats = sizeof(S3D_VERTEX) / sizeof(float);
+			std::vector<float> keyVertices(tmesh->vertex_amount * keyVertexFloats);
+			filesystem::fb_fread_floats(keyVertices.data(), keyVertices.size(), f);
+
 			for (uint32_t vn=0;vn<tmesh->vertex_amount;vn++)
 			{
-				S3D_VERTEX vertex;
-				filesystem::fb_fread(&vertex,sizeof(S3D_VERTEX),1,f);
+				S3D_VERTEX &vertex = *((S3D_VERTEX *) (&keyVertices[vn * keyVertexFloats]));
 
 				// NOTE: animation keyframes do not support blackEdge
 
@@ -1635,36 +1687,7 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 	}
 
 	//if(s3d_version >= 11)
-	{
-		bool hasLightObjects = false;
-
-		std::set<IStorm3D_Model_Object *>::iterator it = objects.begin();
-		for(; it != objects.end(); ++it)
-		{
-			Storm3D_Model_Object *o = static_cast<Storm3D_Model_Object *> (*it);
-			if(o->light_object)
-				hasLightObjects = true;
-		}
-
-		it = objects.begin();
-		for(; it != objects.end(); ++it)
-		{
-			Storm3D_Model_Object *o = static_cast<Storm3D_Model_Object *> (*it);
-
-			if(hasLightObjects)
-			{
-				if(!o->light_object)
-					light_objects.erase(o);
-			}
-		}
-
-		std::string foo;
-		foo += std::string("Objects: ") + std::to_string(objects.size());
-		foo += "\r\n";
-		foo += std::string("Light objects: ") + std::to_string(light_objects.size());
-		foo += "\r\n";
-		//MessageBox(0, foo.c_str(), "Info", MB_OK);
-	}
+	updateLightObjects();
 
 	// Read lights
 	for(int i=0;i<header.num_lights;i++)
@@ -1677,16 +1700,16 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 			lgt.name = LoadStringFromFile(f);
 			lgt.parent = LoadStringFromFile(f);
 
-			filesystem::fb_fread(&lgt.light_type, sizeof(int), 1, f);
-			filesystem::fb_fread(&lgt.lensflare_index, sizeof(int), 1, f);
-			filesystem::fb_fread(lgt.color, sizeof(float), 3, f);
-			filesystem::fb_fread(lgt.position, sizeof(float), 3, f);
-			filesystem::fb_fread(lgt.direction, sizeof(float), 3, f);
-			filesystem::fb_fread(&lgt.cone_inner, sizeof(float), 1, f);
-			filesystem::fb_fread(&lgt.cone_outer, sizeof(float), 1, f);
-			filesystem::fb_fread(&lgt.multiplier, sizeof(float), 1, f);
-			filesystem::fb_fread(&lgt.decay, sizeof(float), 1, f);
-			filesystem::fb_fread(&lgt.keyframe_endtime, sizeof(int), 1, f);
+			filesystem::fb_fread_ints(&lgt.light_type, 1, f);
+			filesystem::fb_fread_ints(&lgt.lensflare_index, 1, f);
+			filesystem::fb_fread_floats(lgt.color, 3, f);
+			filesystem::fb_fread_floats(lgt.position, 3, f);
+			filesystem::fb_fread_floats(lgt.direction, 3, f);
+			filesystem::fb_fread_floats(&lgt.cone_inner, 1, f);
+			filesystem::fb_fread_floats(&lgt.cone_outer, 1, f);
+			filesystem::fb_fread_floats(&lgt.multiplier, 1, f);
+			filesystem::fb_fread_floats(&lgt.decay, 1, f);
+			filesystem::fb_fread_ints(&lgt.keyframe_endtime, 1, f);
 			filesystem::fb_fread(&lgt.poskey_amount, sizeof(WORD), 1, f);
 			filesystem::fb_fread(&lgt.dirkey_amount, sizeof(WORD), 1, f);
 			filesystem::fb_fread(&lgt.lumkey_amount, sizeof(WORD), 1, f);
@@ -1706,10 +1729,10 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 			help.parent = LoadStringFromFile(f);
 
 			filesystem::fb_fread(&help.helper_type, sizeof(int), 1, f);
-			filesystem::fb_fread(help.position, sizeof(float), 3, f);
-			filesystem::fb_fread(help.other, sizeof(float), 3, f);
-			filesystem::fb_fread(help.other2, sizeof(float), 3, f);
-			filesystem::fb_fread(&help.keyframe_endtime, sizeof(int), 1, f);
+			filesystem::fb_fread_floats(help.position, 3, f);
+			filesystem::fb_fread_floats(help.other, 3, f);
+			filesystem::fb_fread_floats(help.other2, 3, f);
+			filesystem::fb_fread_ints(&help.keyframe_endtime, 1, f);
 			filesystem::fb_fread(&help.poskey_amount, sizeof(WORD), 1, f);
 			filesystem::fb_fread(&help.o1key_amount, sizeof(WORD), 1, f);
 			filesystem::fb_fread(&help.o2key_amount, sizeof(WORD), 1, f);
@@ -1755,30 +1778,7 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 		}
 
 		// Create helper
-		IStorm3D_Helper *thelp=NULL;
-		if (help.helper_type==IStorm3D_Helper::HTYPE_POINT)
-		{
-			thelp=Helper_Point_New(help.name.c_str(),VC3(help.position));
-		}
-		else if (help.helper_type==IStorm3D_Helper::HTYPE_VECTOR)
-		{
-			thelp=Helper_Vector_New(help.name.c_str(),VC3(help.position),VC3(help.other));
-		}
-		else if (help.helper_type==IStorm3D_Helper::HTYPE_CAMERA)
-		{
-			thelp=Helper_Camera_New(help.name.c_str(),VC3(help.position),VC3(help.other),VC3(help.other2));
-		}
-		else if (help.helper_type==IStorm3D_Helper::HTYPE_BOX)
-		{
-			thelp=Helper_Box_New(help.name.c_str(),VC3(help.position),VC3(help.other));
-		}
-		else if (help.helper_type==IStorm3D_Helper::HTYPE_SPHERE)
-		{
-			thelp=Helper_Sphere_New(help.name.c_str(),VC3(help.position),help.other[0]);
-			/*char s[100];
-			sprintf(s,"%s (%f,%f,%f) RAD:%f",help.name,help.position[0],help.position[1],help.position[2],help.other[0]);
-			MessageBox(NULL,s,"SPH_DEB",0);*/
-		}
+		IStorm3D_Helper *thelp=createHelper(*this,help.helper_type,help.name.c_str(),help.position,help.other,help.other2);
 
 		// Set animation loop
 		thelp->Animation_SetLoop(help.keyframe_endtime);
@@ -1884,6 +1884,406 @@ bool Storm3D_Model::LoadS3D(const char *filename)
 }
 
 
+//------------------------------------------------------------------
+// Storm3D_Model::applyObjectLoadFlags
+//------------------------------------------------------------------
+void Storm3D_Model::applyObjectLoadFlags(Storm3D_Model_Object *object, const ObjectLoadFlags &flags)
+{
+	if (flags.reflectionMask)
+	{
+		object->EnableRenderPass(RENDER_PASS_BIT_CAREFLECTION_DEPTH_MASKS);
+	}
+	if (flags.delayedAlpha)
+	{
+		object->EnableRenderPass(RENDER_PASS_BIT_DELAYED_ALPHA);
+	}
+	if (flags.earlyAlpha)
+	{
+		object->EnableRenderPass(RENDER_PASS_BIT_EARLY_ALPHA);
+	}
+	if (flags.alphaTestPass || flags.conditionalAlphaTestPass)
+	{
+		object->EnableRenderPass(RENDER_PASS_BIT_ADDITIONAL_ALPHA_TEST_PASS);
+		object->SetAlphaTestPassParams(flags.conditionalAlphaTestPass, flags.alphaTestValue);
+	}
+}
+
+//------------------------------------------------------------------
+// Storm3D_Model::updateLightObjects
+//------------------------------------------------------------------
+void Storm3D_Model::updateLightObjects()
+{
+	// If model has dedicated light objects, only those receive lighting
+	bool hasLightObjects = false;
+
+	std::set<IStorm3D_Model_Object *>::iterator it = objects.begin();
+	for(; it != objects.end(); ++it)
+	{
+		Storm3D_Model_Object *o = static_cast<Storm3D_Model_Object *> (*it);
+		if(o->light_object)
+			hasLightObjects = true;
+	}
+
+	if(!hasLightObjects)
+		return;
+
+	it = objects.begin();
+	for(; it != objects.end(); ++it)
+	{
+		Storm3D_Model_Object *o = static_cast<Storm3D_Model_Object *> (*it);
+		if(!o->light_object)
+			light_objects.erase(o);
+	}
+}
+
+namespace {
+
+	template<class T>
+	bool isInside(unsigned int offset, unsigned int amount, unsigned int size)
+	{
+		if(offset > size || offset % sizeof(int32_t) != 0)
+			return false;
+
+		return amount <= (size - offset) / sizeof(T);
+	}
+
+	template<class T>
+	const T *getBaked(const std::vector<unsigned char> &blob, unsigned int offset)
+	{
+		return reinterpret_cast<const T *> (&blob[offset]);
+	}
+
+	// Everything is checked before anything is created so a broken file
+	// falls back to .s3d without leaving half a model behind
+	bool validateBakedModel(const std::vector<unsigned char> &blob)
+	{
+		unsigned int size = blob.size();
+		if(size < sizeof(S3DB_HEADER))
+			return false;
+
+		const S3DB_HEADER &header = *getBaked<S3DB_HEADER> (blob, 0);
+		if(memcmp(header.id, S3DB_ID, 4) != 0 || header.version != S3DB_VERSION || header.file_size != size)
+			return false;
+
+		if(!isInside<S3DB_TEXTURE> (header.texture_offset, header.texture_amount, size))
+			return false;
+		if(!isInside<S3DB_MATERIAL> (header.material_offset, header.material_amount, size))
+			return false;
+		if(!isInside<S3DB_OBJECT> (header.object_offset, header.object_amount, size))
+			return false;
+		if(!isInside<S3DB_HELPER> (header.helper_offset, header.helper_amount, size))
+			return false;
+		if(header.string_size == 0 || header.string_offset > size || header.string_size > size - header.string_offset)
+			return false;
+		if(blob[header.string_offset + header.string_size - 1] != 0)
+			return false;
+
+		const S3DB_TEXTURE *textures = getBaked<S3DB_TEXTURE> (blob, header.texture_offset);
+		for(unsigned int i = 0; i < header.texture_amount; ++i)
+		{
+			if(textures[i].filename >= header.string_size)
+				return false;
+		}
+
+		const S3DB_MATERIAL *materials = getBaked<S3DB_MATERIAL> (blob, header.material_offset);
+		for(unsigned int i = 0; i < header.material_amount; ++i)
+		{
+			const S3DB_MATERIAL &material = materials[i];
+			if(material.name >= header.string_size)
+				return false;
+
+			const int16_t textureIndices[] = { material.texture_base, material.texture_base2, material.texture_bump, material.texture_reflection, material.texture_distortion };
+			for(int j = 0; j < 5; ++j)
+			{
+				if(textureIndices[j] >= int(header.texture_amount))
+					return false;
+			}
+		}
+
+		const S3DB_OBJECT *objects = getBaked<S3DB_OBJECT> (blob, header.object_offset);
+		for(unsigned int i = 0; i < header.object_amount; ++i)
+		{
+			const S3DB_OBJECT &object = objects[i];
+			if(object.name >= header.string_size || object.parent >= header.string_size)
+				return false;
+			if(object.material_index >= int(header.material_amount))
+				return false;
+			if(!isInside<S3DB_VERTEX> (object.vertex_offset, object.vertex_amount, size))
+				return false;
+			if(object.has_weights && !isInside<S3DB_WEIGHT> (object.weight_offset, object.vertex_amount, size))
+				return false;
+
+			for(int j = 0; j < S3DB_LOD_AMOUNT; ++j)
+			{
+				if(j > 0 && !object.has_lods)
+					break;
+				if(!isInside<S3DB_FACE> (object.face_offset[j], object.face_amount[j], size))
+					return false;
+
+				const S3DB_FACE *faces = getBaked<S3DB_FACE> (blob, object.face_offset[j]);
+				for(unsigned int k = 0; k < object.face_amount[j]; ++k)
+				{
+					if(faces[k].vertex[0] >= object.vertex_amount || faces[k].vertex[1] >= object.vertex_amount || faces[k].vertex[2] >= object.vertex_amount)
+						return false;
+				}
+			}
+		}
+
+		const S3DB_HELPER *helpers = getBaked<S3DB_HELPER> (blob, header.helper_offset);
+		for(unsigned int i = 0; i < header.helper_amount; ++i)
+		{
+			const S3DB_HELPER &helper = helpers[i];
+			if(helper.name >= header.string_size || helper.parent >= header.string_size)
+				return false;
+			if(helper.helper_type < IStorm3D_Helper::HTYPE_POINT || helper.helper_type > IStorm3D_Helper::HTYPE_SPHERE)
+				return false;
+
+			unsigned int keyAmount = helper.poskey_amount + helper.o1key_amount + helper.o2key_amount;
+			if(!isInside<S3DB_KEY> (helper.key_offset, keyAmount, size))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Baked model is stale if the .s3d was changed after baking. Crc comes from
+	// package directory (or is cached for loose files), so this reads no model data.
+	// With no .s3d around the baked model is all there is.
+	bool isBakedModelCurrent(const S3DB_HEADER &header, const char *filename)
+	{
+		filesystem::FB_FILE *f = filesystem::fb_fopen(filename, "rb");
+		if(f == NULL)
+			return true;
+
+		unsigned int size = filesystem::fb_fsize(f);
+		filesystem::fb_fclose(f);
+		if(size != header.source_size)
+			return false;
+
+		return filesystem::FilePackageManager::getInstance().getCrc(filename) == header.source_crc;
+	}
+
+} // unnamed
+
+//------------------------------------------------------------------
+// Storm3D_Model::LoadBakedS3D
+//------------------------------------------------------------------
+bool Storm3D_Model::LoadBakedS3D(const char *bakedFilename, const char *filename, const ObjectLoadFlags &flags)
+{
+	static_assert(sizeof(S3DB_VERTEX) == sizeof(Storm3D_Vertex), "Baked vertices must match Storm3D_Vertex");
+	static_assert(sizeof(S3DB_FACE) == sizeof(Storm3D_Face), "Baked faces must match Storm3D_Face");
+	static_assert(sizeof(S3DB_WEIGHT) == sizeof(Storm3D_Weight), "Baked weights must match Storm3D_Weight");
+	static_assert(S3DB_LOD_AMOUNT == IStorm3D_Mesh::LOD_AMOUNT, "Lod amount mismatch");
+
+	filesystem::FB_FILE *f = filesystem::fb_fopen(bakedFilename, "rb");
+	if(f == NULL)
+		return false;
+
+	// Whole file in one read
+	std::vector<unsigned char> blob(filesystem::fb_fsize(f));
+	if(!blob.empty())
+		filesystem::fb_fread(&blob[0], 1, blob.size(), f);
+	filesystem::fb_fclose(f);
+
+	if(!validateBakedModel(blob) || !isBakedModelCurrent(*getBaked<S3DB_HEADER> (blob, 0), filename))
+	{
+		if (Storm3D2->getLogger() != NULL)
+		{
+			Storm3D2->getLogger()->warning("Storm3D_Model::LoadBakedS3D - Invalid or outdated baked model, using original.");
+			Storm3D2->getLogger()->debug(bakedFilename);
+		}
+		return false;
+	}
+
+	const S3DB_HEADER &header = *getBaked<S3DB_HEADER> (blob, 0);
+	const char *strings = getBaked<char> (blob, header.string_offset);
+
+	// If bones already loaded and not compatible, return
+	if((bone_boneid != 0) && (header.bone_id != bone_boneid))
+		return false;
+	model_boneid = header.bone_id;
+
+	// Textures are loaded from the same path as model
+	std::string path = filename;
+	std::string::size_type pathEnd = path.find_last_of("\\/");
+	path.resize(pathEnd == path.npos ? 0 : pathEnd + 1);
+
+	std::vector<IStorm3D_Texture *> textures(header.texture_amount);
+	const S3DB_TEXTURE *bakedTextures = getBaked<S3DB_TEXTURE> (blob, header.texture_offset);
+	for(unsigned int i = 0; i < header.texture_amount; ++i)
+	{
+		std::string textureName = path + &strings[bakedTextures[i].filename];
+		textures[i] = Storm3D2->CreateNewTexture(textureName.c_str(), bakedTextures[i].identification);
+	}
+
+	std::vector<IStorm3D_Material *> materials(header.material_amount);
+	const S3DB_MATERIAL *bakedMaterials = getBaked<S3DB_MATERIAL> (blob, header.material_offset);
+	for(unsigned int i = 0; i < header.material_amount; ++i)
+	{
+		const S3DB_MATERIAL &mat = bakedMaterials[i];
+
+		Storm3D_Material *tmat = static_cast<Storm3D_Material *> (Storm3D2->CreateNewMaterial(&strings[mat.name]));
+		materials[i] = tmat;
+
+		tmat->SetColor(COL(mat.color));
+		tmat->SetSelfIllumination(COL(mat.self_illum));
+		tmat->SetSpecular(COL(mat.specular), mat.specular_sharpness);
+		tmat->SetSpecial(mat.doublesided != 0, mat.wireframe != 0);
+		tmat->SetAlphaType(IStorm3D_Material::ATYPE(mat.alphablend_type));
+		tmat->SetTransparency(mat.transparency);
+		tmat->SetGlow(mat.glow);
+		tmat->SetScrollSpeed(VC2(mat.scroll_speed[0], mat.scroll_speed[1]));
+		tmat->EnableScroll(mat.scroll_autostart != 0);
+
+		if (mat.texture_base >= 0)
+			tmat->SetBaseTexture(textures[mat.texture_base]);
+		if (mat.texture_base2 >= 0)
+			tmat->SetBaseTexture2(textures[mat.texture_base2]);
+		if (mat.texture_bump >= 0)
+			tmat->SetBumpTexture(textures[mat.texture_bump]);
+		if (mat.texture_reflection >= 0)
+			tmat->SetReflectionTexture(textures[mat.texture_reflection]);
+		if (mat.texture_distortion >= 0)
+			tmat->SetDistortionTexture(textures[mat.texture_distortion]);
+
+		if (mat.texture_base2 >= 0)
+			tmat->ChangeBaseTexture2Parameters(Storm3D_Material::MTL_BOP(mat.base2_blend_op), mat.base2_blend_factor);
+		if (mat.texture_reflection >= 0)
+			tmat->ChangeReflectionTextureParameters(Storm3D_Material::MTL_BOP(mat.reflection_blend_op), mat.reflection_blend_factor, IStorm3D_Material::TEX_GEN(mat.reflection_texgen));
+
+		setLocalReflectionFromName(tmat);
+	}
+
+	const S3DB_OBJECT *bakedObjects = getBaked<S3DB_OBJECT> (blob, header.object_offset);
+	for(unsigned int i = 0; i < header.object_amount; ++i)
+	{
+		const S3DB_OBJECT &obj = bakedObjects[i];
+
+		Storm3D_Model_Object *tobj = (Storm3D_Model_Object *) Object_New(&strings[obj.name]);
+		Storm3D_Mesh *tmesh = (Storm3D_Mesh *) Storm3D2->CreateNewMesh();
+
+		applyObjectLoadFlags(tobj, flags);
+
+		const char *parent = &strings[obj.parent];
+		if(parent[0])
+		{
+			IStorm3D_Model_Object *opar = SearchObject(parent);
+			if(opar)
+				opar->AddChild(tobj);
+			else
+			{
+				// Search for bone parent
+				for(unsigned int j = 0; j < bones.size(); ++j)
+				{
+					if(strcmp(bones[j]->GetName(), parent) == 0)
+					{
+						bones[j]->AddChild(tobj);
+						break;
+					}
+				}
+			}
+		}
+
+		tobj->SetNoCollision(obj.no_collision != 0);
+		tobj->SetNoRender(obj.no_render != 0);
+		tobj->light_object = obj.light_object != 0;
+
+		if (obj.material_index >= 0)
+			tmesh->UseMaterial(materials[obj.material_index]);
+
+		if(obj.has_weights)
+			tmesh->bone_weights = new Storm3D_Weight[obj.vertex_amount];
+
+		// Arrays are in mesh layout already
+		tmesh->ChangeFaceCount(obj.face_amount[0]);
+		if(obj.face_amount[0] > 0)
+			memcpy(tmesh->GetFaceBuffer(), &blob[obj.face_offset[0]], sizeof(Storm3D_Face) * obj.face_amount[0]);
+
+		tmesh->ChangeVertexCount(obj.vertex_amount);
+		if(obj.vertex_amount > 0)
+			memcpy(tmesh->GetVertexBuffer(), &blob[obj.vertex_offset], sizeof(Storm3D_Vertex) * obj.vertex_amount);
+
+		tmesh->hasLods = obj.has_lods != 0;
+		if(obj.has_lods)
+		{
+			for(int j = 1; j < IStorm3D_Mesh::LOD_AMOUNT; ++j)
+			{
+				Storm3D_Face *buffer = new Storm3D_Face[obj.face_amount[j]];
+				if(obj.face_amount[j] > 0)
+					memcpy(buffer, &blob[obj.face_offset[j]], sizeof(Storm3D_Face) * obj.face_amount[j]);
+
+				delete[] tmesh->faces[j];
+
+				tmesh->face_amount[j] = obj.face_amount[j];
+				tmesh->faces[j] = buffer;
+			}
+		}
+
+		tobj->SetPosition(VC3(obj.position));
+		tobj->SetRotation(QUAT(obj.rotation));
+		tobj->SetScale(VC3(obj.scale));
+		tobj->SetMesh(tmesh);
+
+		if(obj.has_weights && obj.vertex_amount > 0)
+			memcpy(tmesh->bone_weights, &blob[obj.weight_offset], sizeof(Storm3D_Weight) * obj.vertex_amount);
+
+		tmesh->ReBuild();
+
+		// Create object's collision table (if has no bones and no_collision not set)
+		if(bones.empty() && !obj.no_collision)
+		{
+			tmesh->collision.ReBuild(tmesh);
+			tmesh->col_rebuild_needed=false;
+		}
+
+		updateRadiusToContain(tobj->position, tmesh->GetRadius());
+	}
+
+	updateLightObjects();
+
+	const S3DB_HELPER *bakedHelpers = getBaked<S3DB_HELPER> (blob, header.helper_offset);
+	for(unsigned int i = 0; i < header.helper_amount; ++i)
+	{
+		const S3DB_HELPER &help = bakedHelpers[i];
+
+		IStorm3D_Helper *thelp = createHelper(*this, help.helper_type, &strings[help.name], help.position, help.other, help.other2);
+		thelp->Animation_SetLoop(help.keyframe_endtime);
+
+		const S3DB_KEY *keys = getBaked<S3DB_KEY> (blob, help.key_offset);
+		for(unsigned int j = 0; j < help.poskey_amount; ++j, ++keys)
+			((IStorm3D_Helper_Point*)thelp)->Animation_AddNewPositionKeyFrame(keys->keytime, VC3(keys->value[0], keys->value[1], keys->value[2]));
+
+		for(unsigned int j = 0; j < help.o1key_amount; ++j, ++keys)
+		{
+			VC3 value(keys->value[0], keys->value[1], keys->value[2]);
+
+			if (thelp->GetHelperType()==IStorm3D_Helper::HTYPE_VECTOR)
+				((IStorm3D_Helper_Vector*)thelp)->Animation_AddNewDirectionKeyFrame(keys->keytime, value);
+			else if (thelp->GetHelperType()==IStorm3D_Helper::HTYPE_BOX)
+				((IStorm3D_Helper_Box*)thelp)->Animation_AddNewSizeKeyFrame(keys->keytime, value);
+			else if (thelp->GetHelperType()==IStorm3D_Helper::HTYPE_CAMERA)
+				((IStorm3D_Helper_Camera*)thelp)->Animation_AddNewDirectionKeyFrame(keys->keytime, value);
+			else if (thelp->GetHelperType()==IStorm3D_Helper::HTYPE_SPHERE)
+				((IStorm3D_Helper_Sphere*)thelp)->Animation_AddNewRadiusKeyFrame(keys->keytime, value.x);
+		}
+
+		for(unsigned int j = 0; j < help.o2key_amount; ++j, ++keys)
+			((IStorm3D_Helper_Camera*)thelp)->Animation_AddNewUpVectorKeyFrame(keys->keytime, VC3(keys->value[0], keys->value[1], keys->value[2]));
+
+		const char *parent = &strings[help.parent];
+		if(parent[0])
+		{
+			IStorm3D_Model_Object *opar = SearchObject(parent);
+			if (opar)
+				opar->AddChild(thelp);
+		}
+	}
+
+	storm3d_model_loads++;
+	updateEffectTexture();
+	return true;
+}
+
 //------------------------------------------------------------------
 // Storm3D_Model::LoadBones
 //------------------------------------------------------------------
@@ -1911,9 +2311,9 @@ bool Storm3D_Model::LoadBones(const char *filename)
 		return false;
 	}
 
-	filesystem::fb_fread(&bone_boneid, sizeof(int), 1, fp); // id
+	filesystem::fb_fread_ints(&bone_boneid, 1, fp); // id
 	int bone_count = 0;
-	filesystem::fb_fread(&bone_count, sizeof(int), 1, fp); // amount
+	filesystem::fb_fread_ints(&bone_count, 1, fp); // amount
 
 	// If not compatible with models bones
 	if((model_boneid != 0) && (model_boneid != bone_boneid))
@@ -1945,15 +2345,15 @@ bool Storm3D_Model::LoadBones(const char *filename)
 
 		int parent_index = -1;
 
-		filesystem::fb_fread(&position, sizeof(float), 3, fp);
-		filesystem::fb_fread(&rotation, sizeof(float), 4, fp);
-		filesystem::fb_fread(&original_position, sizeof(float), 3, fp);
-		filesystem::fb_fread(&original_rotation, sizeof(float), 4, fp);
-		filesystem::fb_fread(&max_angles, sizeof(float), 3, fp);
-		filesystem::fb_fread(&max_angles, sizeof(float), 3, fp);
-		filesystem::fb_fread(&length, sizeof(float), 1, fp);
-		filesystem::fb_fread(&thickness, sizeof(float), 1, fp);
-		filesystem::fb_fread(&parent_index, sizeof(int), 1, fp);
+		filesystem::fb_fread_floats(&position.x, 3, fp);
+		filesystem::fb_fread_floats(&rotation.x, 4, fp);
+		filesystem::fb_fread_floats(&original_position.x, 3, fp);
+		filesystem::fb_fread_floats(&original_rotation.x, 4, fp);
+		filesystem::fb_fread_floats(&max_angles.x, 3, fp);
+		filesystem::fb_fread_floats(&max_angles.x, 3, fp);
+		filesystem::fb_fread_floats(&length, 1, fp);
+		filesystem::fb_fread_floats(&thickness, 1, fp);
+		filesystem::fb_fread_ints(&parent_index, 1, fp);
 
 //length += 2.f * thickness;
 
@@ -1985,7 +2385,7 @@ bool Storm3D_Model::LoadBones(const char *filename)
 	}
 
 	int bone_helper_amount = 0;
-	filesystem::fb_fread(&bone_helper_amount, sizeof(int), 1, fp);
+	filesystem::fb_fread_ints(&bone_helper_amount, 1, fp);
 
 	// No helpers?
 	if(filesystem::fb_feof(fp) != 0)
@@ -2000,17 +2400,17 @@ bool Storm3D_Model::LoadBones(const char *filename)
 		std::string parent = LoadStringFromFile(fp);
 
 		int helper_type = 0;
-		filesystem::fb_fread(&helper_type, sizeof(int), 1, fp);
+		filesystem::fb_fread_ints(&helper_type, 1, fp);
 		Vector position, other, other2;
 
-		filesystem::fb_fread(&position, sizeof(float), 3, fp);
-		filesystem::fb_fread(&other, sizeof(float), 3, fp);
-		filesystem::fb_fread(&other2, sizeof(float), 3, fp);
+		filesystem::fb_fread_floats(&position.x, 3, fp);
+		filesystem::fb_fread_floats(&other.x, 3, fp);
+		filesystem::fb_fread_floats(&other2.x, 3, fp);
 
 		int end_time;
 		WORD foo;
 
-		filesystem::fb_fread(&end_time, sizeof(int), 1, fp);
+		filesystem::fb_fread_ints(&end_time, 1, fp);
 		filesystem::fb_fread(&foo, sizeof(WORD), 1 ,fp);
 		filesystem::fb_fread(&foo, sizeof(WORD), 1 ,fp);
 		filesystem::fb_fread(&foo, sizeof(WORD), 1 ,fp);
@@ -2498,6 +2898,28 @@ void Storm3D_Model::Helper_Delete(IStorm3D_Helper *help)
 
 
 
+//------------------------------------------------------------------
+// Storm3D_Model::InformObserversPosition
+// Storm3D_Model::InformObserversRadius
+//------------------------------------------------------------------
+void Storm3D_Model::InformObserversPosition(const VC3 &position)
+{
+	if(observer)
+		observer->updatePosition(position);
+
+	for(unsigned int i = 0; i < scene_observers.size(); ++i)
+		scene_observers[i]->updatePosition(position);
+}
+
+void Storm3D_Model::InformObserversRadius(float radius)
+{
+	if(observer)
+		observer->updateRadius(radius);
+
+	for(unsigned int i = 0; i < scene_observers.size(); ++i)
+		scene_observers[i]->updateRadius(radius);
+}
+
 //------------------------------------------------------------------
 // Storm3D_Model::InformChangeToChilds
 // Called when model is rotated/scaled/moved
@@ -2597,8 +3019,7 @@ for(unsigned int i = 0; i < bones.size(); ++i)
 
 box_ok = false;
 
-	if(observer)
-		observer->updatePosition(position);
+	InformObserversPosition(position);
 }
 
 
@@ -2648,8 +3069,7 @@ void Storm3D_Model::SetScale(const VC3 &_scale)
 	}
   */
 
-	if(observer)
-		observer->updateRadius(bounding_radius * max_scale);
+	InformObserversRadius(bounding_radius * max_scale);
 
 	box_ok = false;
 	scale=_scale;
@@ -2813,8 +3233,7 @@ void Storm3D_Model::updateRadiusToContain(const VC3 &pos, float radius)
 		bounding_radius = need_radius;
 		box_ok = false;
 		
-		if(observer)
-			observer->updateRadius(bounding_radius * max_scale);
+		InformObserversRadius(bounding_radius * max_scale);
 	}
 
 	original_bounding_radius = bounding_radius;	
@@ -3296,8 +3715,7 @@ bool Storm3D_Model::SetRandomAnimation(IStorm3D_BoneAnimation *animation_)
 		return false;
 
 	bounding_radius = BOUNDING_INITIAL_RADIUS;
-	if(observer)
-		observer->updateRadius(BOUNDING_INITIAL_RADIUS);
+	InformObserversRadius(BOUNDING_INITIAL_RADIUS);
 
 	normal_animations.clear();
 	if(animation_ == 0)
@@ -3323,8 +3741,7 @@ bool Storm3D_Model::SetAnimation(IStorm3D_BoneAnimation *transition_, IStorm3D_B
 		return false;
 
 	bounding_radius = BOUNDING_INITIAL_RADIUS;
-	if(observer)
-		observer->updateRadius(BOUNDING_INITIAL_RADIUS);
+	InformObserversRadius(BOUNDING_INITIAL_RADIUS);
 
 /*
 	if(animation_ == 0)
@@ -3365,8 +3782,7 @@ bool Storm3D_Model::BlendToAnimation(IStorm3D_BoneAnimation *transition_, IStorm
 		return false;
 
 	bounding_radius = BOUNDING_INITIAL_RADIUS;
-	if(observer)
-		observer->updateRadius(BOUNDING_INITIAL_RADIUS);
+	InformObserversRadius(BOUNDING_INITIAL_RADIUS);
 
 	Storm3D_BoneAnimation *animation = static_cast<Storm3D_BoneAnimation*> (animation_);
 	if(animation->GetId() != bone_boneid)
@@ -3426,8 +3842,7 @@ bool Storm3D_Model::BlendWithAnimationIn(IStorm3D_BoneAnimation *transition_, IS
 		return false;
 
 	bounding_radius = BOUNDING_INITIAL_RADIUS;
-	if(observer)
-		observer->updateRadius(BOUNDING_INITIAL_RADIUS);
+	InformObserversRadius(BOUNDING_INITIAL_RADIUS);
 
 	Storm3D_BoneAnimation *animation = static_cast<Storm3D_BoneAnimation*> (animation_);
 	if(animation->GetId() != bone_boneid)
@@ -3703,14 +4118,12 @@ for(unsigned int i = 0; i < bones.size(); ++i)
 	if(maxRadius > original_bounding_radius)
 	{
 		bounding_radius = maxRadius;
-		if(observer)
-			observer->updateRadius(bounding_radius);
+		InformObserversRadius(bounding_radius);
 	}
 	else
 	{
 		bounding_radius = original_bounding_radius;
-		if(observer)
-			observer->updateRadius(original_bounding_radius);
+		InformObserversRadius(original_bounding_radius);
 	}
 
 	std::set<IStorm3D_Model_Object *>::iterator it = objects.begin();
@@ -0,0 +1,718 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#endif
+
+//------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------
+#include "Storm3D_ModelBvh.h"
+#include "storm3d_model.h"
+#include "c2_collision.h"
+
+#include <algorithm>
+#include <cassert>
+#include <float.h>
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define STORM3D_MODELBVH_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "../../util/Debug_MemoryManager.h"
+
+namespace {
+
+	// leaf boxes are enlarged by this much (meters) on each side
+	const float FAT_MARGIN = 1.f;
+	// balanced tree of a few million models stays well below this
+	const int STACK_SIZE = 128;
+	// rays traced through the tree together by RayTraceBundle
+	// (multiple of four, for the sse lanes)
+	const int BUNDLE_SIZE = 16;
+	// or less, if directions are further than this (cosine) from the first
+	const float BUNDLE_MIN_DOT = 0.9f;
+
+	inline AABB combine(const AABB &a, const AABB &b)
+	{
+		AABB result;
+		result.mmin.x = std::min(a.mmin.x, b.mmin.x);
+		result.mmin.y = std::min(a.mmin.y, b.mmin.y);
+		result.mmin.z = std::min(a.mmin.z, b.mmin.z);
+		result.mmax.x = std::max(a.mmax.x, b.mmax.x);
+		result.mmax.y = std::max(a.mmax.y, b.mmax.y);
+		result.mmax.z = std::max(a.mmax.z, b.mmax.z);
+		return result;
+	}
+
+	inline float getArea(const AABB &box)
+	{
+		VC3 size = box.mmax - box.mmin;
+		return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	inline bool contains(const AABB &outer, const AABB &inner)
+	{
+		return outer.mmin.x <= inner.mmin.x && outer.mmin.y <= inner.mmin.y && outer.mmin.z <= inner.mmin.z
+			&& outer.mmax.x >= inner.mmax.x && outer.mmax.y >= inner.mmax.y && outer.mmax.z >= inner.mmax.z;
+	}
+
+	inline AABB getSphereBox(const VC3 &position, float radius, float margin)
+	{
+		VC3 extent(radius + margin, radius + margin, radius + margin);
+		return AABB(position - extent, position + extent);
+	}
+
+	inline float inverse(float value)
+	{
+		if(fabsf(value) < 1e-20f)
+			return (value < 0) ? -1e20f : 1e20f;
+
+		return 1.f / value;
+	}
+
+	// Entry range of the ray to the box, negative if missed within range
+	inline float getEntryRange(const AABB &box, const VC3 &origin, const VC3 &inverseDirection, float range)
+	{
+		float t1 = (box.mmin.x - origin.x) * inverseDirection.x;
+		float t2 = (box.mmax.x - origin.x) * inverseDirection.x;
+		float tmin = std::min(t1, t2);
+		float tmax = std::max(t1, t2);
+
+		t1 = (box.mmin.y - origin.y) * inverseDirection.y;
+		t2 = (box.mmax.y - origin.y) * inverseDirection.y;
+		tmin = std::max(tmin, std::min(t1, t2));
+		tmax = std::min(tmax, std::max(t1, t2));
+
+		t1 = (box.mmin.z - origin.z) * inverseDirection.z;
+		t2 = (box.mmax.z - origin.z) * inverseDirection.z;
+		tmin = std::max(tmin, std::min(t1, t2));
+		tmax = std::min(tmax, std::max(t1, t2));
+
+		tmin = std::max(tmin, 0.f);
+		tmax = std::min(tmax, range);
+		if(tmin > tmax)
+			return -1.f;
+
+		return tmin;
+	}
+
+	struct StackEntry
+	{
+		int node;
+		float range;
+	};
+
+	// Rays of RayTraceBundle, lane per ray. Lanes past the ray amount
+	// have a negative range.
+	struct BundleRays
+	{
+		float inverse[3][BUNDLE_SIZE];
+		float range[BUNDLE_SIZE];
+	};
+
+#ifdef STORM3D_MODELBVH_SSE
+
+	// Nearest entry range of any ray to the box, negative if none enters
+	inline float getBundleEntryRange(const AABB &box, const VC3 &origin, const BundleRays &rays, int rayAmount)
+	{
+		__m128 boxMin[3] = { _mm_set1_ps(box.mmin.x - origin.x), _mm_set1_ps(box.mmin.y - origin.y), _mm_set1_ps(box.mmin.z - origin.z) };
+		__m128 boxMax[3] = { _mm_set1_ps(box.mmax.x - origin.x), _mm_set1_ps(box.mmax.y - origin.y), _mm_set1_ps(box.mmax.z - origin.z) };
+
+		__m128 nearest = _mm_set1_ps(FLT_MAX);
+		int hitMask = 0;
+
+		for(int lane = 0; lane < rayAmount; lane += 4)
+		{
+			__m128 tNear = _mm_setzero_ps();
+			__m128 tFar = _mm_loadu_ps(&rays.range[lane]);
+
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				__m128 inverse = _mm_loadu_ps(&rays.inverse[axis][lane]);
+				__m128 t1 = _mm_mul_ps(boxMin[axis], inverse);
+				__m128 t2 = _mm_mul_ps(boxMax[axis], inverse);
+
+				tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+				tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+			}
+
+			__m128 hit = _mm_cmple_ps(tNear, tFar);
+			hitMask |= _mm_movemask_ps(hit);
+			nearest = _mm_min_ps(nearest, _mm_or_ps(_mm_and_ps(hit, tNear), _mm_andnot_ps(hit, _mm_set1_ps(FLT_MAX))));
+		}
+
+		if(!hitMask)
+			return -1.f;
+
+		float lanes[4];
+		_mm_storeu_ps(lanes, nearest);
+		return std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+	}
+
+#else
+
+	inline float getBundleEntryRange(const AABB &box, const VC3 &origin, const BundleRays &rays, int rayAmount)
+	{
+		float nearest = -1.f;
+		for(int i = 0; i < rayAmount; ++i)
+		{
+			VC3 inverseDirection(rays.inverse[0][i], rays.inverse[1][i], rays.inverse[2][i]);
+			float range = getEntryRange(box, origin, inverseDirection, rays.range[i]);
+			if(range >= 0 && (nearest < 0 || range < nearest))
+				nearest = range;
+		}
+
+		return nearest;
+	}
+
+#endif
+
+} // unnamed
+
+//------------------------------------------------------------------
+// Storm3D_ModelBvh
+//------------------------------------------------------------------
+Storm3D_ModelBvh::Storm3D_ModelBvh()
+:	root(-1),
+	freeList(-1),
+	modelAmount(0)
+{
+}
+
+int Storm3D_ModelBvh::allocateNode()
+{
+	int node = freeList;
+	if(node != -1)
+		freeList = nodes[node].parent;
+	else
+	{
+		node = int(nodes.size());
+		nodes.push_back(Node());
+	}
+
+	Node &n = nodes[node];
+	n.parent = -1;
+	n.child1 = -1;
+	n.child2 = -1;
+	n.height = 0;
+	n.model = 0;
+	n.radius = 0;
+	return node;
+}
+
+void Storm3D_ModelBvh::freeNode(int node)
+{
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	nodes[node].model = 0;
+	freeList = node;
+}
+
+void Storm3D_ModelBvh::setLeafBox(int leaf)
+{
+	Node &n = nodes[leaf];
+	n.box = getSphereBox(n.position, n.radius, FAT_MARGIN);
+}
+
+void Storm3D_ModelBvh::insertLeaf(int leaf)
+{
+	if(root == -1)
+	{
+		root = leaf;
+		nodes[root].parent = -1;
+		return;
+	}
+
+	// Find the sibling adding least area
+	AABB leafBox = nodes[leaf].box;
+	int index = root;
+	while(!nodes[index].isLeaf())
+	{
+		const Node &n = nodes[index];
+		int child1 = n.child1;
+		int child2 = n.child2;
+
+		float area = getArea(n.box);
+		float combinedArea = getArea(combine(n.box, leafBox));
+
+		// new parent here, or push the leaf further down
+		float cost = 2.f * combinedArea;
+		float inheritanceCost = 2.f * (combinedArea - area);
+
+		float cost1 = getArea(combine(leafBox, nodes[child1].box)) + inheritanceCost;
+		if(!nodes[child1].isLeaf())
+			cost1 -= getArea(nodes[child1].box);
+		float cost2 = getArea(combine(leafBox, nodes[child2].box)) + inheritanceCost;
+		if(!nodes[child2].isLeaf())
+			cost2 -= getArea(nodes[child2].box);
+
+		if(cost < cost1 && cost < cost2)
+			break;
+
+		index = (cost1 < cost2) ? child1 : child2;
+	}
+
+	int sibling = index;
+	int oldParent = nodes[sibling].parent;
+	int newParent = allocateNode();
+
+	Node &p = nodes[newParent];
+	p.parent = oldParent;
+	p.box = combine(leafBox, nodes[sibling].box);
+	p.height = nodes[sibling].height + 1;
+	p.child1 = sibling;
+	p.child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if(oldParent != -1)
+	{
+		if(nodes[oldParent].child1 == sibling)
+			nodes[oldParent].child1 = newParent;
+		else
+			nodes[oldParent].child2 = newParent;
+	}
+	else
+		root = newParent;
+
+	refitUpwards(nodes[leaf].parent);
+}
+
+void Storm3D_ModelBvh::removeLeaf(int leaf)
+{
+	if(leaf == root)
+	{
+		root = -1;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+	if(grandParent != -1)
+	{
+		if(nodes[grandParent].child1 == parent)
+			nodes[grandParent].child1 = sibling;
+		else
+			nodes[grandParent].child2 = sibling;
+
+		nodes[sibling].parent = grandParent;
+		freeNode(parent);
+		refitUpwards(grandParent);
+	}
+	else
+	{
+		root = sibling;
+		nodes[sibling].parent = -1;
+		freeNode(parent);
+	}
+}
+
+void Storm3D_ModelBvh::refitUpwards(int node)
+{
+	while(node != -1)
+	{
+		node = balance(node);
+
+		Node &n = nodes[node];
+		n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+		n.box = combine(nodes[n.child1].box, nodes[n.child2].box);
+
+		node = n.parent;
+	}
+}
+
+// Rotates the taller grandchild up if A's subtrees differ in height by
+// more than one, returns the node now in A's place
+int Storm3D_ModelBvh::balance(int iA)
+{
+	Node &A = nodes[iA];
+	if(A.isLeaf() || A.height < 2)
+		return iA;
+
+	int iB = A.child1;
+	int iC = A.child2;
+	Node &B = nodes[iB];
+	Node &C = nodes[iC];
+
+	int difference = C.height - B.height;
+
+	if(difference > 1)
+	{
+		int iF = C.child1;
+		int iG = C.child2;
+		Node &F = nodes[iF];
+		Node &G = nodes[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		if(C.parent != -1)
+		{
+			if(nodes[C.parent].child1 == iA)
+				nodes[C.parent].child1 = iC;
+			else
+				nodes[C.parent].child2 = iC;
+		}
+		else
+			root = iC;
+
+		if(F.height > G.height)
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.box = combine(B.box, G.box);
+			C.box = combine(A.box, F.box);
+			A.height = 1 + std::max(B.height, G.height);
+			C.height = 1 + std::max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.box = combine(B.box, F.box);
+			C.box = combine(A.box, G.box);
+			A.height = 1 + std::max(B.height, F.height);
+			C.height = 1 + std::max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	if(difference < -1)
+	{
+		int iD = B.child1;
+		int iE = B.child2;
+		Node &D = nodes[iD];
+		Node &E = nodes[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		if(B.parent != -1)
+		{
+			if(nodes[B.parent].child1 == iA)
+				nodes[B.parent].child1 = iB;
+			else
+				nodes[B.parent].child2 = iB;
+		}
+		else
+			root = iB;
+
+		if(D.height > E.height)
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.box = combine(C.box, E.box);
+			B.box = combine(A.box, D.box);
+			A.height = 1 + std::max(C.height, E.height);
+			B.height = 1 + std::max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.box = combine(C.box, D.box);
+			B.box = combine(A.box, E.box);
+			A.height = 1 + std::max(C.height, D.height);
+			B.height = 1 + std::max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+int Storm3D_ModelBvh::insert(Storm3D_Model *model, const VC3 &position, float radius)
+{
+	assert(model);
+
+	int leaf = allocateNode();
+	Node &n = nodes[leaf];
+	n.model = model;
+	n.position = position;
+	n.radius = radius;
+	setLeafBox(leaf);
+
+	insertLeaf(leaf);
+	++modelAmount;
+	return leaf;
+}
+
+void Storm3D_ModelBvh::erase(int handle)
+{
+	assert(handle >= 0 && handle < int(nodes.size()));
+	assert(nodes[handle].isLeaf() && nodes[handle].model);
+
+	removeLeaf(handle);
+	freeNode(handle);
+	--modelAmount;
+}
+
+void Storm3D_ModelBvh::setPosition(int handle, const VC3 &position)
+{
+	assert(handle >= 0 && handle < int(nodes.size()));
+
+	Node &n = nodes[handle];
+	n.position = position;
+	if(contains(n.box, getSphereBox(n.position, n.radius, 0)))
+		return;
+
+	removeLeaf(handle);
+	setLeafBox(handle);
+	insertLeaf(handle);
+}
+
+void Storm3D_ModelBvh::setRadius(int handle, float radius)
+{
+	assert(handle >= 0 && handle < int(nodes.size()));
+
+	Node &n = nodes[handle];
+	float oldRadius = n.radius;
+	n.radius = radius;
+
+	// shrinking a lot makes the old box wasteful, refit it too
+	if(contains(n.box, getSphereBox(n.position, n.radius, 0)) && radius > oldRadius * 0.5f)
+		return;
+
+	removeLeaf(handle);
+	setLeafBox(handle);
+	insertLeaf(handle);
+}
+
+void Storm3D_ModelBvh::clear()
+{
+	nodes.clear();
+	root = -1;
+	freeList = -1;
+	modelAmount = 0;
+}
+
+int Storm3D_ModelBvh::getModelAmount() const
+{
+	return modelAmount;
+}
+
+void Storm3D_ModelBvh::RayTrace(const VC3 &position, const VC3 &direction, float rayLength, Storm3D_CollisionInfo &info, bool accurate) const
+{
+	if(root == -1)
+		return;
+
+	Ray ray(position, direction, rayLength);
+	VC3 inverseDirection(inverse(direction.x), inverse(direction.y), inverse(direction.z));
+
+	float rootRange = getEntryRange(nodes[root].box, position, inverseDirection, ray.range);
+	if(rootRange < 0)
+		return;
+
+	StackEntry stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize].node = root;
+	stack[stackSize].range = rootRange;
+	++stackSize;
+
+	while(stackSize > 0)
+	{
+		--stackSize;
+		const StackEntry &entry = stack[stackSize];
+
+		// Something closer was hit after this was pushed?
+		if(entry.range > ray.range)
+			continue;
+
+		const Node &n = nodes[entry.node];
+		if(n.isLeaf())
+		{
+			if(!collision(ray, Sphere(n.position, n.radius)))
+				continue;
+
+			n.model->RayTrace(ray.origin, ray.direction, ray.range, info, accurate);
+			if(info.hit && info.range < ray.range)
+				ray.range = info.range;
+
+			continue;
+		}
+
+		float range1 = getEntryRange(nodes[n.child1].box, position, inverseDirection, ray.range);
+		float range2 = getEntryRange(nodes[n.child2].box, position, inverseDirection, ray.range);
+		int child1 = n.child1;
+		int child2 = n.child2;
+
+		// Nearer one goes on top
+		if(range1 > range2)
+		{
+			std::swap(range1, range2);
+			std::swap(child1, child2);
+		}
+
+		assert(stackSize + 2 <= STACK_SIZE);
+		if(range2 >= 0)
+		{
+			stack[stackSize].node = child2;
+			stack[stackSize].range = range2;
+			++stackSize;
+		}
+		if(range1 >= 0)
+		{
+			stack[stackSize].node = child1;
+			stack[stackSize].range = range1;
+			++stackSize;
+		}
+	}
+}
+
+void Storm3D_ModelBvh::RayTraceBundle(const VC3 &position, const VC3 *directions, const float *rayLengths, int rayAmount, Storm3D_CollisionInfo *infos, bool accurate) const
+{
+	for(int start = 0; start < rayAmount; start += BUNDLE_SIZE)
+	{
+		int amount = std::min(rayAmount - start, BUNDLE_SIZE);
+
+		// Diverging rays would drag each other through most of the tree
+		bool coherent = true;
+		for(int i = 1; i < amount; ++i)
+		{
+			if(directions[start].GetDotWith(directions[start + i]) < BUNDLE_MIN_DOT)
+				coherent = false;
+		}
+
+		if(coherent && amount > 1)
+			RayTraceBundlePart(position, directions + start, rayLengths + start, amount, infos + start, accurate);
+		else
+		{
+			for(int i = start; i < start + amount; ++i)
+				RayTrace(position, directions[i], rayLengths[i], infos[i], accurate);
+		}
+	}
+}
+
+// All rays of the part walk the tree together, a node is visited once
+// if any of them enters it. Leaves are still tested ray by ray.
+void Storm3D_ModelBvh::RayTraceBundlePart(const VC3 &position, const VC3 *directions, const float *rayLengths, int rayAmount, Storm3D_CollisionInfo *infos, bool accurate) const
+{
+	assert(rayAmount <= BUNDLE_SIZE);
+	if(root == -1)
+		return;
+
+	Ray rays[BUNDLE_SIZE];
+	BundleRays bundle;
+	for(int i = 0; i < BUNDLE_SIZE; ++i)
+	{
+		if(i < rayAmount)
+		{
+			rays[i] = Ray(position, directions[i], rayLengths[i]);
+			bundle.inverse[0][i] = inverse(directions[i].x);
+			bundle.inverse[1][i] = inverse(directions[i].y);
+			bundle.inverse[2][i] = inverse(directions[i].z);
+			bundle.range[i] = rayLengths[i];
+		}
+		else
+		{
+			// padding lanes never enter anything
+			bundle.inverse[0][i] = bundle.inverse[1][i] = bundle.inverse[2][i] = 1.f;
+			bundle.range[i] = -1.f;
+		}
+	}
+
+	StackEntry stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize].node = root;
+	stack[stackSize].range = 0;
+	++stackSize;
+
+	while(stackSize > 0)
+	{
+		--stackSize;
+		const Node &n = nodes[stack[stackSize].node];
+
+		if(n.isLeaf())
+		{
+			Sphere sphere(n.position, n.radius);
+			for(int i = 0; i < rayAmount; ++i)
+			{
+				if(!collision(rays[i], sphere))
+					continue;
+
+				n.model->RayTrace(rays[i].origin, rays[i].direction, rays[i].range, infos[i], accurate);
+				if(infos[i].hit && infos[i].range < rays[i].range)
+				{
+					rays[i].range = infos[i].range;
+					bundle.range[i] = infos[i].range;
+				}
+			}
+
+			continue;
+		}
+
+		float range1 = getBundleEntryRange(nodes[n.child1].box, position, bundle, rayAmount);
+		float range2 = getBundleEntryRange(nodes[n.child2].box, position, bundle, rayAmount);
+		int child1 = n.child1;
+		int child2 = n.child2;
+
+		// Nearer one goes on top
+		if(range2 >= 0 && (range1 < 0 || range1 > range2))
+		{
+			std::swap(range1, range2);
+			std::swap(child1, child2);
+		}
+
+		assert(stackSize + 2 <= STACK_SIZE);
+		if(range2 >= 0)
+		{
+			stack[stackSize].node = child2;
+			stack[stackSize].range = range2;
+			++stackSize;
+		}
+		if(range1 >= 0)
+		{
+			stack[stackSize].node = child1;
+			stack[stackSize].range = range1;
+			++stackSize;
+		}
+	}
+}
+
+void Storm3D_ModelBvh::SphereCollision(const VC3 &position, float radius, Storm3D_CollisionInfo &info, bool accurate) const
+{
+	if(root == -1)
+		return;
+
+	Sphere sphere(position, radius);
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = root;
+
+	while(stackSize > 0)
+	{
+		const Node &n = nodes[stack[--stackSize]];
+		if(!collision(sphere, n.box))
+			continue;
+
+		if(n.isLeaf())
+		{
+			if(!collision(sphere, Sphere(n.position, n.radius)))
+				continue;
+
+			n.model->SphereCollision(sphere.position, sphere.radius, info, accurate);
+			if(info.hit && info.range < sphere.radius)
+				sphere.radius = info.range;
+
+			continue;
+		}
+
+		assert(stackSize + 2 <= STACK_SIZE);
+		stack[stackSize++] = n.child2;
+		stack[stackSize++] = n.child1;
+	}
+}
@@ -0,0 +1,95 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_STORM3D_MODELBVH_H
+#define INCLUDED_STORM3D_MODELBVH_H
+
+#include <vector>
+#include "c2_vectors.h"
+#include "c2_aabb.h"
+
+class Storm3D_Model;
+struct Storm3D_CollisionInfo;
+
+/*
+Bounding volume hierarchy over scene models
+-------------------------------------------
+Top level of the scene collision: leaves are model bounding spheres,
+each model then uses its own mesh collision trees (Storm3D_CollisionBvh)
+for the exact test.
+
+Leaves keep a slightly enlarged box, so a model moving a bit only
+updates its sphere. Once it leaves the box, the leaf is taken out and
+reinserted where it adds least surface area, and the boxes above are
+refitted. Tree stays balanced by rotations (height difference of
+siblings at most one), so queries stay logarithmic in model count.
+
+Queries match the loose quadtree they replace: models whose bounding
+sphere the ray (or sphere) touches get their own RayTrace (or
+SphereCollision) called, nearest boxes first, and the ray range (sphere
+radius) shrinks as hits are found.
+
+RayTraceBundle walks the tree once for up to 16 rays from the same
+origin, testing node boxes against four rays at a time (sse). Rays
+pointing in clearly different directions are traced one by one instead.
+*/
+
+class Storm3D_ModelBvh
+{
+	struct Node
+	{
+		// leaves: enlarged box around the sphere
+		AABB box;
+
+		// parent, or next free node
+		int parent;
+		int child1;
+		int child2;
+
+		// leaves have 0, free nodes -1
+		int height;
+
+		Storm3D_Model *model;
+		VC3 position;
+		float radius;
+
+		bool isLeaf() const
+		{
+			return child1 == -1;
+		}
+	};
+
+	std::vector<Node> nodes;
+	int root;
+	int freeList;
+	int modelAmount;
+
+	int allocateNode();
+	void freeNode(int node);
+
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int node);
+	void refitUpwards(int node);
+	void setLeafBox(int leaf);
+
+	void RayTraceBundlePart(const VC3 &position, const VC3 *directions, const float *rayLengths, int rayAmount, Storm3D_CollisionInfo *infos, bool accurate) const;
+
+public:
+	Storm3D_ModelBvh();
+
+	// returns a handle for the other calls
+	int insert(Storm3D_Model *model, const VC3 &position, float radius);
+	void erase(int handle);
+
+	void setPosition(int handle, const VC3 &position);
+	void setRadius(int handle, float radius);
+
+	void clear();
+	int getModelAmount() const;
+
+	void RayTrace(const VC3 &position, const VC3 &direction, float rayLength, Storm3D_CollisionInfo &info, bool accurate) const;
+	void RayTraceBundle(const VC3 &position, const VC3 *directions, const float *rayLengths, int rayAmount, Storm3D_CollisionInfo *infos, bool accurate) const;
+	void SphereCollision(const VC3 &position, float radius, Storm3D_CollisionInfo &info, bool accurate) const;
+};
+
+#endif
@@ -22,6 +22,7 @@
 #include "storm3d_terrain.h"
 #include "storm3d_terrain_renderer.h"
 #include "storm3d_terrain_models.h"
+#include "Storm3D_ModelBvh.h"
 #include "storm3d_video_player.h"
 #include <IStorm3D_Logger.h>
 #include "Iterator.h"
@@ -32,12 +33,56 @@
 #include "Storm3D_Bone.h"
 #include "Storm3D_ShaderManager.h"
 #include "Storm3D_Line.h"
+#include <algorithm>
 #include "../../util/Debug_MemoryManager.h"
 
 
 #undef min
 #undef max
 
+//------------------------------------------------------------------
+// Storm3D_SceneModelObserver
+//	-> Moves models in the scene's model bvh. Kept in the model's
+//	   scene observers, next to the (terrain) observer
+//------------------------------------------------------------------
+struct Storm3D_SceneModelObserver: public IModelObserver
+{
+	Storm3D_ModelBvh &bvh;
+	int handle;
+
+	Storm3D_SceneModelObserver(Storm3D_ModelBvh &bvh_, int handle_)
+	:	bvh(bvh_),
+		handle(handle_)
+	{
+	}
+
+	void updatePosition(const VC3 &position)
+	{
+		bvh.setPosition(handle, position);
+	}
+
+	void updateRadius(float radius)
+	{
+		bvh.setRadius(handle, radius);
+	}
+
+	void updateVisibility(Storm3D_Model_Object *)
+	{
+	}
+
+	void remove(Storm3D_Model *)
+	{
+	}
+
+	void remove(Storm3D_Model_Object *)
+	{
+	}
+
+	void destroy(Storm3D_Model *)
+	{
+	}
+};
+
 //------------------------------------------------------------------
 // Storm3D_Scene::Storm3D_Scene
 //------------------------------------------------------------------
@@ -55,6 +100,8 @@ Storm3D_Scene::Storm3D_Scene(Storm3D *s2) :
 	draw_bones(false),
 	camera(Storm3D2)
 {
+	modelBvh = new Storm3D_ModelBvh();
+
 	// Create iterators
 	ITModel=new ICreateIM_Set<IStorm3D_Model*>(&(models));
 	ITTerrain=new ICreateIM_Set<IStorm3D_Terrain*>(&(terrains));
@@ -84,6 +131,11 @@ Storm3D_Scene::~Storm3D_Scene()
 			terrain->getModels().removeModel(**it);
 	}
 
+	for(std::set<IStorm3D_Model *>::iterator it = models.begin(); it != models.end(); ++it)
+		detachModelObserver(*it);
+	modelObservers.clear();
+	delete modelBvh;
+
 	// Remove from Storm3D's list
 	Storm3D2->Remove(this);
 
@@ -989,8 +1041,12 @@ void Storm3D_Scene::AddModel(IStorm3D_Model *mod)
 		return;
 
 	models.insert((Storm3D_Model*)mod);
-	if(terrains.empty())
-		return;
+
+	Storm3D_Model *model = static_cast<Storm3D_Model *> (mod);
+	int handle = modelBvh->insert(model, model->GetPosition(), model->GetRadius());
+	std::shared_ptr<Storm3D_SceneModelObserver> observer(new Storm3D_SceneModelObserver(*modelBvh, handle));
+	modelObservers[mod] = observer;
+	model->scene_observers.push_back(observer.get());
 
 	std::set<IStorm3D_Terrain *>::iterator it = terrains.begin();
 	for(; it != terrains.end(); ++it)
@@ -1015,9 +1071,28 @@ void Storm3D_Scene::RemoveModel(IStorm3D_Model *mod)
 			models.removeModel(*mod);
 	}
 
+	std::map<IStorm3D_Model *, std::shared_ptr<Storm3D_SceneModelObserver> >::iterator io = modelObservers.find(mod);
+	if(io != modelObservers.end())
+	{
+		detachModelObserver(mod);
+		modelBvh->erase(io->second->handle);
+		modelObservers.erase(io);
+	}
+
 	models.erase((Storm3D_Model*)mod);
 }
 
+void Storm3D_Scene::detachModelObserver(IStorm3D_Model *mod)
+{
+	std::map<IStorm3D_Model *, std::shared_ptr<Storm3D_SceneModelObserver> >::iterator io = modelObservers.find(mod);
+	if(io == modelObservers.end())
+		return;
+
+	Storm3D_Model *model = static_cast<Storm3D_Model *> (mod);
+	std::vector<IModelObserver *> &observers = model->scene_observers;
+	observers.erase(std::remove(observers.begin(), observers.end(), io->second.get()), observers.end());
+}
+
 void Storm3D_Scene::EnableCulling(IStorm3D_Model *mod, bool enable)
 {
 	if(!mod)
@@ -1235,18 +1310,31 @@ void Storm3D_Scene::RayTrace(const VC3 &position,const VC3 &direction_normalized
 		}
 	}
 
-	// Raytrace to each model
-	for(std::set<IStorm3D_Model*>::iterator im=models.begin();im!=models.end();im++)
+	// Raytrace models through the scene's own tree
+	modelBvh->RayTrace(position, direction_normalized, ray_length, rti, accurate);
+
+	// TODO: Add terrain stuff
+}
+
+//------------------------------------------------------------------
+// Storm3D_Scene::RayTraceBundle
+//------------------------------------------------------------------
+void Storm3D_Scene::RayTraceBundle(const VC3 &position,const VC3 *directions_normalized,const float *ray_lengths,int ray_amount,Storm3D_CollisionInfo *rtis, bool accurate)
+{
+	std::set<IStorm3D_Terrain *>::iterator it = terrains.begin();
+	for(; it != terrains.end(); ++it)
 	{
-		// Typecast (to simplify code)
-		//IStorm3D_Model *md=*im;
-		Storm3D_Model *md = static_cast<Storm3D_Model *> (*im);
+		Storm3D_Terrain &terrain = static_cast<Storm3D_Terrain &> (**it);
+		Storm3D_TerrainModels &models = terrain.getModels();
 
-		// Raytrace
-		md->RayTrace(position,direction_normalized,ray_length,rti,accurate);
+		if(models.hasTree())
+		{
+			models.RayTraceBundle(position, directions_normalized, ray_lengths, ray_amount, rtis, accurate);
+			return;
+		}
 	}
 
-	// TODO: Add terrain stuff
+	modelBvh->RayTraceBundle(position, directions_normalized, ray_lengths, ray_amount, rtis, accurate);
 }
 
 
@@ -1269,15 +1357,8 @@ void Storm3D_Scene::SphereCollision(const VC3 &position,float radius,Storm3D_Col
 		}
 	}
 
-	// Spherecollide to each model
-	for(std::set<IStorm3D_Model*>::iterator im=models.begin();im!=models.end();im++)
-	{
-		// Typecast (to simplify code)
-		IStorm3D_Model *md=*im;
-
-		// Spherecollide
-		md->SphereCollision(position,radius,cinf, accurate);
-	}
+	// Spherecollide models through the scene's own tree
+	modelBvh->SphereCollision(position, radius, cinf, accurate);
 
 	// TODO: Add terrain stuff
 }
@@ -101,6 +101,11 @@ void Storm3D_Terrain::forcemapHeight(const VC2 &position, float radius, bool abo
 	data->heightMap.forcemapHeight(position, radius, above, below);
 }
 
+void Storm3D_Terrain::updateCollisionMap(const VC2I &start, const VC2I &end)
+{
+	data->heightMap.updateCollisionMap(start, end);
+}
+
 int Storm3D_Terrain::addTerrainTexture(IStorm3D_Texture &texture)
 {
 	return data->heightMap.addTerrainTexture(static_cast<Storm3D_Texture &> (texture));
@@ -6,7 +6,8 @@ renderer_d3d:=storm3dv2
 
 
 FILES:=Clipper.cpp IStorm3D.cpp RenderWindow.cpp Storm3D_Adapter.cpp \
-       Storm3D_Bone.cpp Storm3D_Camera.cpp Storm3D.cpp Storm3D_Face.cpp \
+       Storm3D_Bone.cpp Storm3D_Camera.cpp Storm3D_CompressedAnimation.cpp \
+	   Storm3D.cpp Storm3D_CollisionBvh.cpp Storm3D_Face.cpp \
 	   storm3d_fakespotlight.cpp Storm3D_Font.cpp \
 	   Storm3D_Helper_AInterface.cpp Storm3D_Helper_Animation.cpp \
 	   Storm3D_Helpers.cpp Storm3D_KeyFrames.cpp \
@@ -14,7 +15,7 @@ FILES:=Clipper.cpp IStorm3D.cpp RenderWindow.cpp Storm3D_Adapter.cpp \
 	   Storm3D_Light_Animation.cpp Storm3D_Line.cpp Storm3D_Material.cpp \
 	   Storm3D_Material_TextureLayer.cpp \
 	   Storm3D_Mesh_Animation.cpp Storm3D_Mesh_CollisionTable.cpp \
-	   Storm3D_Mesh.cpp Storm3D_Model.cpp Storm3D_Model_Object_Animation.cpp \
+	   Storm3D_Mesh.cpp Storm3D_Model.cpp Storm3D_ModelBvh.cpp Storm3D_Model_Object_Animation.cpp \
 	   Storm3D_Model_Object.cpp Storm3D_ParticleSystem.cpp \
 	   Storm3D_ParticleSystem_PMH.cpp Storm3D_PicList.cpp \
 	   Storm3D_ProceduralManager.cpp storm3d_resourcemanager.cpp \
@@ -25,6 +26,7 @@ FILES:=Clipper.cpp IStorm3D.cpp RenderWindow.cpp Storm3D_Adapter.cpp \
 	   Storm3D_SurfaceInfo.cpp \
 	   Storm3D_Terrain.cpp storm3d_terrain_decalsystem.cpp \
 	   storm3d_terrain_groups.cpp storm3d_terrain_heightmap.cpp \
+	   storm3d_terrain_heightpyramid.cpp \
 	   storm3d_terrain_lightmanager.cpp storm3d_terrain_lod.cpp \
 	   storm3d_terrain_models.cpp storm3d_terrain_renderer.cpp \
 	   storm3d_terrain_utils.cpp Storm3d_Texture.cpp \
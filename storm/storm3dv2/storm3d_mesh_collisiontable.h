@@ -11,8 +11,12 @@
 
 // Common datatype includes
 #include "DatatypeDef.h"
-//#include "c2_qtree.h"
-#include "c2_qtree_static.h"
+#include "c2_sphere.h"
+#include "c2_ray.h"
+#include "c2_aabb.h"
+#include "c2_frustum.h"
+#include "c2_collision.h"
+#include "Storm3D_CollisionBvh.h"
 
 //------------------------------------------------------------------
 // CollisionFace
@@ -32,8 +36,7 @@ class Storm3D_Mesh_CollisionTable
 	int face_amount;
 	
 	//Storm3D_Face *tfaces;
-	//Quadtree<CollisionFace> *tree;
-	StaticQuadtree<CollisionFace> *tree;
+	Storm3D_CollisionBvh bvh;
 public:
 
 	// Rebuild table (fill with mesh's faces)
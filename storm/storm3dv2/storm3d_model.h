@@ -155,8 +155,12 @@ class Storm3D_Model : public IStorm3D_Model
 	// Client data
 	IStorm3D_Model_Data *custom_data;
 	IModelObserver *observer;
+	// Collision trees of the scenes this model is in (one per scene)
+	std::vector<IModelObserver *> scene_observers;
 
 	void InformChangeToChilds();	// Called when model changes
+	void InformObserversPosition(const VC3 &position);
+	void InformObserversRadius(float radius);
 
 	// Creation/delete (only Storm3D uses these)
 	Storm3D_Model(Storm3D *Storm3D2);
@@ -205,6 +209,32 @@ class Storm3D_Model : public IStorm3D_Model
 
 	bool skyModel;
 
+	// Render pass modifiers from model filename (foobar.s3d@DA, ...)
+	struct ObjectLoadFlags
+	{
+		bool reflectionMask;
+		bool delayedAlpha;
+		bool earlyAlpha;
+		bool alphaTestPass;
+		bool conditionalAlphaTestPass;
+		int alphaTestValue;
+
+		ObjectLoadFlags()
+		:	reflectionMask(false),
+			delayedAlpha(false),
+			earlyAlpha(false),
+			alphaTestPass(false),
+			conditionalAlphaTestPass(false),
+			alphaTestValue(0x70)
+		{
+		}
+	};
+
+	void applyObjectLoadFlags(Storm3D_Model_Object *object, const ObjectLoadFlags &flags);
+	void updateLightObjects();
+	// Preprocessed .s3b version of a model (see S3D_BakedModelFile.h)
+	bool LoadBakedS3D(const char *bakedFilename, const char *path, const ObjectLoadFlags &flags);
+
 public:
 
 	void updateEffectTexture();
@@ -8,6 +8,8 @@
 //------------------------------------------------------------------
 // CHANGED: was empty
 #include <list>
+#include <map>
+#include <memory>
 #include "storm3d_common_imp.h"
 #include "IStorm3D_Scene.h"
 #include "storm3d_camera.h"
@@ -15,6 +17,8 @@
 #include "storm3d_terrain_utils.h"
 
 class Storm3D_Line;
+class Storm3D_ModelBvh;
+struct Storm3D_SceneModelObserver;
 
 //------------------------------------------------------------------
 // Storm3D_Scene
@@ -30,6 +34,13 @@ class Storm3D_Scene : public IStorm3D_Scene
 	// "Terrains in scene" - set
 	std::set<IStorm3D_Terrain*> terrains;
 
+	// Collision tree for all models, used when no terrain has a model tree.
+	// Kept up to date by observers in each model's scene observers.
+	Storm3D_ModelBvh *modelBvh;
+	std::map<IStorm3D_Model *, std::shared_ptr<Storm3D_SceneModelObserver> > modelObservers;
+
+	void detachModelObserver(IStorm3D_Model *mod);
+
 	// "Pictures to render" - set
 	// CHANGED: was set
 	std::list<Storm3D_Scene_PicList*> piclist;
@@ -159,6 +170,7 @@ public:
 
 	// Test collision (to each model in scene)
 	void RayTrace(const VC3 &position,const VC3 &direction_normalized,float ray_length,Storm3D_CollisionInfo &rti, bool accurate);
+	void RayTraceBundle(const VC3 &position,const VC3 *directions_normalized,const float *ray_lengths,int ray_amount,Storm3D_CollisionInfo *rtis, bool accurate);
 	void SphereCollision(const VC3 &position,float radius,Storm3D_CollisionInfo &cinf, bool accurate);
 	void GetEyeVectors(const VC2I &screen_position, Vector &position, Vector &direction);
 
@@ -29,6 +29,7 @@ public:
 	void setObstacleHeightmap(const unsigned short *obstacleHeightmap, const util::AreaMap *areaMap);
 	void recreateCollisionMap();
 	void forcemapHeight(const VC2 &position, float radius, bool above = true, bool below = false);
+	void updateCollisionMap(const VC2I &start, const VC2I &end);
 
 	unsigned short *getCollisionHeightmap();
 
@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "storm3d_terrain_heightmap.h"
+#include "storm3d_terrain_heightpyramid.h"
 #include "storm3d_terrain_lod.h"
 #include "storm3d_terrain_utils.h"
 #include "Storm3D_ShaderManager.h"
@@ -238,6 +239,7 @@ struct Storm3D_TerrainHeightmapData
 
 	std::unique_ptr<unsigned short[]> heightMap;
 	std::unique_ptr<unsigned short[]> collisionHeightMap;
+	Storm3D_TerrainHeightPyramid heightPyramid;
 	VC2I resolution;
 	VC3 size;
 	VC2I collResolution;
@@ -885,6 +887,14 @@ void Storm3D_TerrainHeightmap::setHeightMap(const unsigned short *buffer, const
 	data->collisionHeightMap.swap(tempBuffer2);
 */
 
+	{
+		int obstacleMinusHeightmapShift = data->obstaclemapShiftMult - data->heightmapShiftMult;
+		VC2I obstacleResolution(data->collResolution.x << obstacleMinusHeightmapShift, data->collResolution.y << obstacleMinusHeightmapShift);
+
+		data->heightPyramid.create(obstacleResolution, obstacleMinusHeightmapShift);
+		data->heightPyramid.updateAll(data->collisionHeightMap.get(), data->obstacleHeightmap);
+	}
+
 	data->resolution = resolution + VC2I(1, 1);
 	data->size = size;
 	data->heightMap.swap(tempBuffer);
@@ -917,6 +927,7 @@ void Storm3D_TerrainHeightmap::updateHeightMap(const unsigned short *buffer, con
 	}
 
 	// ToDo: update collision map too!
+	// (height pyramid follows the collision map, so it needs no update here either)
 
 	data->updateHeightBuffers(start, end);
 }
@@ -925,10 +936,18 @@ void Storm3D_TerrainHeightmap::setObstacleHeightmap(const unsigned short *obstac
 {
 	data->obstacleHeightmap = obstacleHeightmap;
 	data->areaMap = areaMap;
+
+	data->heightPyramid.invalidateAll();
 }
 
 void Storm3D_TerrainHeightmap::recreateCollisionMap()
 {
+	data->heightPyramid.invalidateAll();
+}
+
+void Storm3D_TerrainHeightmap::updateCollisionMap(const VC2I &start, const VC2I &end)
+{
+	data->heightPyramid.invalidate(start, end);
 }
 
 unsigned short *Storm3D_TerrainHeightmap::getCollisionHeightmap()
@@ -1018,6 +1037,11 @@ void Storm3D_TerrainHeightmap::forcemapHeight(const VC2 &position, float radius,
 			}
 		}
 	}
+
+	int obstacleMinusHeightmapShift = data->obstaclemapShiftMult - data->heightmapShiftMult;
+	VC2I obstacleStart(xmin << obstacleMinusHeightmapShift, ymin << obstacleMinusHeightmapShift);
+	VC2I obstacleEnd((xmax + 1) << obstacleMinusHeightmapShift, (ymax + 1) << obstacleMinusHeightmapShift);
+	data->heightPyramid.invalidate(obstacleStart, obstacleEnd);
 }
 
 void Storm3D_TerrainHeightmap::calculateVisibility(Storm3D_Scene &scene)
@@ -1689,6 +1713,9 @@ void Storm3D_TerrainHeightmap::rayTrace(const VC3 &position, const VC3 &directio
     int maxx_minus_one = maxx - (1<<obstacle_map_mult_shift);
     int maxy_minus_one = maxy - (1<<obstacle_map_mult_shift);
 
+		// apply collision/obstacle changes made since the last raytrace
+		data->heightPyramid.flush(data->collisionHeightMap.get(), data->obstacleHeightmap);
+
     e = 2 * dy - dx;
     for (i = 0; i < dx; i++) 
     {
@@ -1722,6 +1749,56 @@ void Storm3D_TerrainHeightmap::rayTrace(const VC3 &position, const VC3 &directio
 				}
 			}
 
+			// jump over blocks the ray passes above
+			if (!data->heightPyramid.isEmpty())
+			{
+				Storm3D_TerrainRayWalk walk;
+				walk.x = x;
+				walk.y = y;
+				walk.e = e;
+				walk.dx = dx;
+				walk.dy = dy;
+				walk.sx = sx;
+				walk.sy = sy;
+				walk.steep = (steep != 0);
+				walk.hs = hs;
+				walk.hdiff = hdiff;
+				walk.interiorMin = VC2I(2, 2);
+				walk.interiorMax = VC2I(maxx_minus_one - 1, maxy_minus_one - 1);
+				walk.obstacles = (data->obstacleHeightmap != NULL && data->areaMap != NULL);
+				walk.lineOfSight = lineOfSight;
+
+				int skip = data->heightPyramid.findSkip(walk, i);
+				if (skip > 0)
+				{
+					// keep obstacle hit normal logic intact, it looks at the last tested cell
+					if (walk.obstacles)
+					{
+						int lastX = 0;
+						int lastY = 0;
+						walk.getPosition(lineOfSight ? skip - 2 : skip - 1, lastX, lastY);
+
+						int lastBlockIndex = ((lastY>>obstacle_minus_heightmap_shift)<<hmapsh) + (lastX>>obstacle_minus_heightmap_shift);
+						int lastObstacleBlockIndex = (lastY<<obstacleShift) + lastX;
+						if (steep)
+						{
+							lastBlockIndex = ((lastX>>obstacle_minus_heightmap_shift)<<hmapsh) + (lastY>>obstacle_minus_heightmap_shift);
+							lastObstacleBlockIndex = (lastX<<obstacleShift) + lastY;
+						}
+
+						prevObstacleHeight = (int)data->collisionHeightMap[lastBlockIndex] * 3
+							+ 3 * ((int)(data->obstacleHeightmap[lastObstacleBlockIndex] & OBSTACLE_MAP_MASK_HEIGHT));
+					}
+
+					walk.advance(skip);
+					x = walk.x;
+					y = walk.y;
+					e = walk.e;
+					i += skip - 1;
+					continue;
+				}
+			}
+
       int blockIndex;
       int obstacleBlockIndex;
 
@@ -0,0 +1,329 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#endif
+
+//------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------
+#include "storm3d_terrain_heightpyramid.h"
+#include <Storm3D_ObstacleMapDefs.h>
+#include <algorithm>
+#include <cassert>
+
+#include "../../util/Debug_MemoryManager.h"
+
+namespace {
+
+	// level 0 blocks are 8x8 obstacle map cells
+	const int BASE_BLOCK_SHIFT = 3;
+	const int MANY_STEPS = 1 << 30;
+
+	// Minor axis steps taken during given amount of raytrace steps
+	inline int getMinorSteps(int e, int dx, int dy, int steps)
+	{
+		if(steps <= 0)
+			return 0;
+
+		int raw = e + 2 * dy * (steps - 1);
+		if(raw < 0)
+			return 0;
+
+		return raw / (2 * dx) + 1;
+	}
+
+	// Amount of positions (current included) visited before minor axis
+	// has moved more than minorLimit cells
+	inline int getStepsWithinMinor(int e, int dx, int dy, int minorLimit)
+	{
+		int bound = 2 * dx * minorLimit - e;
+		if(bound <= 0)
+			return 1;
+		if(dy == 0)
+			return MANY_STEPS;
+
+		return (bound - 1) / (2 * dy) + 2;
+	}
+
+	inline int getRayHeight(const Storm3D_TerrainRayWalk &walk, int step)
+	{
+		return 3 * walk.hs + (3 * walk.hdiff * step) / walk.dx;
+	}
+
+} // unnamed
+
+//------------------------------------------------------------------
+// Storm3D_TerrainRayWalk
+//------------------------------------------------------------------
+void Storm3D_TerrainRayWalk::getPosition(int steps, int &resultX, int &resultY) const
+{
+	resultX = x + steps * sx;
+	resultY = y + getMinorSteps(e, dx, dy, steps) * sy;
+}
+
+void Storm3D_TerrainRayWalk::advance(int steps)
+{
+	int minorSteps = getMinorSteps(e, dx, dy, steps);
+
+	x += steps * sx;
+	y += minorSteps * sy;
+	e += 2 * dy * steps - 2 * dx * minorSteps;
+}
+
+//------------------------------------------------------------------
+// Storm3D_TerrainHeightPyramid
+//------------------------------------------------------------------
+Storm3D_TerrainHeightPyramid::Storm3D_TerrainHeightPyramid()
+:	obstacleMinusHeightmapShift(0),
+	dirtyAll(false)
+{
+}
+
+void Storm3D_TerrainHeightPyramid::create(const VC2I &obstacleResolution_, int obstacleMinusHeightmapShift_)
+{
+	clear();
+
+	obstacleResolution = obstacleResolution_;
+	obstacleMinusHeightmapShift = obstacleMinusHeightmapShift_;
+
+	if(obstacleResolution.x <= 0 || obstacleResolution.y <= 0)
+		return;
+
+	int shift = BASE_BLOCK_SHIFT;
+	VC2I size((obstacleResolution.x + (1 << shift) - 1) >> shift, (obstacleResolution.y + (1 << shift) - 1) >> shift);
+
+	for(;;)
+	{
+		levels.push_back(Level());
+		Level &level = levels.back();
+
+		level.size = size;
+		level.shift = shift;
+		level.terrain.resize(size.x * size.y);
+		level.obstacles.resize(size.x * size.y);
+
+		if(size.x == 1 && size.y == 1)
+			break;
+
+		size.x = (size.x + 1) / 2;
+		size.y = (size.y + 1) / 2;
+		++shift;
+	}
+
+	dirtyBlocks.assign(levels[0].terrain.size(), 0);
+}
+
+void Storm3D_TerrainHeightPyramid::clear()
+{
+	levels.clear();
+	obstacleResolution = VC2I(0, 0);
+
+	dirtyBlocks.clear();
+	dirtyList.clear();
+	dirtyAll = false;
+}
+
+bool Storm3D_TerrainHeightPyramid::isEmpty() const
+{
+	return levels.empty();
+}
+
+void Storm3D_TerrainHeightPyramid::updateBase(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap, const VC2I &blockStart, const VC2I &blockEnd)
+{
+	Level &level = levels[0];
+	int blockSize = 1 << level.shift;
+	int heightmapPitch = obstacleResolution.x >> obstacleMinusHeightmapShift;
+
+	for(int by = blockStart.y; by < blockEnd.y; ++by)
+	for(int bx = blockStart.x; bx < blockEnd.x; ++bx)
+	{
+		int x0 = bx * blockSize;
+		int y0 = by * blockSize;
+		int x1 = std::min(x0 + blockSize, obstacleResolution.x);
+		int y1 = std::min(y0 + blockSize, obstacleResolution.y);
+
+		int terrainMax = 0;
+		for(int hy = y0 >> obstacleMinusHeightmapShift; hy <= (y1 - 1) >> obstacleMinusHeightmapShift; ++hy)
+		for(int hx = x0 >> obstacleMinusHeightmapShift; hx <= (x1 - 1) >> obstacleMinusHeightmapShift; ++hx)
+			terrainMax = std::max(terrainMax, int(collisionHeightMap[hy * heightmapPitch + hx]));
+
+		int obstacleMax = 0;
+		if(obstacleHeightmap)
+		{
+			for(int y = y0; y < y1; ++y)
+			for(int x = x0; x < x1; ++x)
+				obstacleMax = std::max(obstacleMax, int(obstacleHeightmap[y * obstacleResolution.x + x] & OBSTACLE_MAP_MASK_HEIGHT));
+		}
+
+		int index = by * level.size.x + bx;
+		level.terrain[index] = (unsigned short) terrainMax;
+		level.obstacles[index] = (unsigned short) obstacleMax;
+	}
+}
+
+void Storm3D_TerrainHeightPyramid::update(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap, const VC2I &start, const VC2I &end)
+{
+	if(levels.empty() || !collisionHeightMap)
+		return;
+
+	VC2I areaStart(std::max(start.x, 0), std::max(start.y, 0));
+	VC2I areaEnd(std::min(end.x, obstacleResolution.x), std::min(end.y, obstacleResolution.y));
+	if(areaStart.x >= areaEnd.x || areaStart.y >= areaEnd.y)
+		return;
+
+	VC2I blockStart(areaStart.x >> BASE_BLOCK_SHIFT, areaStart.y >> BASE_BLOCK_SHIFT);
+	VC2I blockEnd(((areaEnd.x - 1) >> BASE_BLOCK_SHIFT) + 1, ((areaEnd.y - 1) >> BASE_BLOCK_SHIFT) + 1);
+	updateBase(collisionHeightMap, obstacleHeightmap, blockStart, blockEnd);
+
+	for(unsigned int i = 1; i < levels.size(); ++i)
+	{
+		const Level &child = levels[i - 1];
+		Level &level = levels[i];
+
+		blockStart.x >>= 1;
+		blockStart.y >>= 1;
+		blockEnd.x = ((blockEnd.x - 1) >> 1) + 1;
+		blockEnd.y = ((blockEnd.y - 1) >> 1) + 1;
+
+		for(int by = blockStart.y; by < blockEnd.y; ++by)
+		for(int bx = blockStart.x; bx < blockEnd.x; ++bx)
+		{
+			unsigned short terrainMax = 0;
+			unsigned short obstacleMax = 0;
+
+			for(int cy = by * 2; cy < std::min(by * 2 + 2, child.size.y); ++cy)
+			for(int cx = bx * 2; cx < std::min(bx * 2 + 2, child.size.x); ++cx)
+			{
+				int childIndex = cy * child.size.x + cx;
+				terrainMax = std::max(terrainMax, child.terrain[childIndex]);
+				obstacleMax = std::max(obstacleMax, child.obstacles[childIndex]);
+			}
+
+			int index = by * level.size.x + bx;
+			level.terrain[index] = terrainMax;
+			level.obstacles[index] = obstacleMax;
+		}
+	}
+}
+
+void Storm3D_TerrainHeightPyramid::updateAll(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap)
+{
+	update(collisionHeightMap, obstacleHeightmap, VC2I(0, 0), obstacleResolution);
+}
+
+void Storm3D_TerrainHeightPyramid::invalidate(const VC2I &start, const VC2I &end)
+{
+	if(levels.empty() || dirtyAll)
+		return;
+
+	VC2I areaStart(std::max(start.x, 0), std::max(start.y, 0));
+	VC2I areaEnd(std::min(end.x, obstacleResolution.x), std::min(end.y, obstacleResolution.y));
+	if(areaStart.x >= areaEnd.x || areaStart.y >= areaEnd.y)
+		return;
+
+	const Level &level = levels[0];
+	for(int by = areaStart.y >> BASE_BLOCK_SHIFT; by <= (areaEnd.y - 1) >> BASE_BLOCK_SHIFT; ++by)
+	for(int bx = areaStart.x >> BASE_BLOCK_SHIFT; bx <= (areaEnd.x - 1) >> BASE_BLOCK_SHIFT; ++bx)
+	{
+		int index = by * level.size.x + bx;
+		if(!dirtyBlocks[index])
+		{
+			dirtyBlocks[index] = 1;
+			dirtyList.push_back(index);
+		}
+	}
+}
+
+void Storm3D_TerrainHeightPyramid::invalidateAll()
+{
+	if(!levels.empty())
+		dirtyAll = true;
+}
+
+void Storm3D_TerrainHeightPyramid::flush(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap)
+{
+	if(!dirtyAll && dirtyList.empty())
+		return;
+
+	if(dirtyAll)
+	{
+		updateAll(collisionHeightMap, obstacleHeightmap);
+	}
+	else
+	{
+		int blockSize = 1 << BASE_BLOCK_SHIFT;
+		int blocksX = levels.empty() ? 0 : levels[0].size.x;
+		for(unsigned int i = 0; i < dirtyList.size(); ++i)
+		{
+			VC2I start((dirtyList[i] % blocksX) * blockSize, (dirtyList[i] / blocksX) * blockSize);
+			update(collisionHeightMap, obstacleHeightmap, start, start + VC2I(blockSize, blockSize));
+		}
+	}
+
+	for(unsigned int i = 0; i < dirtyList.size(); ++i)
+		dirtyBlocks[dirtyList[i]] = 0;
+	dirtyList.clear();
+	dirtyAll = false;
+}
+
+int Storm3D_TerrainHeightPyramid::findSkip(const Storm3D_TerrainRayWalk &walk, int step) const
+{
+	int obstacleX = walk.steep ? walk.y : walk.x;
+	int obstacleY = walk.steep ? walk.x : walk.y;
+	if(obstacleX < 0 || obstacleY < 0 || obstacleX >= obstacleResolution.x || obstacleY >= obstacleResolution.y)
+		return 0;
+
+	int rayHeight = getRayHeight(walk, step);
+	int skip = 0;
+
+	// Climb as long as the ray passes over the whole block
+	for(unsigned int i = 0; i < levels.size(); ++i)
+	{
+		const Level &level = levels[i];
+
+		int blockX = obstacleX >> level.shift;
+		int blockY = obstacleY >> level.shift;
+		int index = blockY * level.size.x + blockX;
+
+		int top = level.terrain[index];
+		if(walk.obstacles)
+			top += level.obstacles[index];
+		if(3 * top > rayHeight)
+			break;
+
+		int blockMajor = (walk.steep ? blockY : blockX) << level.shift;
+		int blockMinor = (walk.steep ? blockX : blockY) << level.shift;
+		int blockSize = 1 << level.shift;
+
+		int majorSteps = (walk.sx > 0) ? blockMajor + blockSize - walk.x : walk.x - blockMajor + 1;
+		int minorLimit = (walk.sy > 0) ? blockMinor + blockSize - 1 - walk.y : walk.y - blockMinor;
+
+		int steps = std::min(majorSteps, getStepsWithinMinor(walk.e, walk.dx, walk.dy, minorLimit));
+		steps = std::min(steps, walk.dx - step);
+		if(walk.lineOfSight)
+			steps &= ~1;
+
+		if(steps <= skip)
+			break;
+
+		// Must not jump over the map edge check
+		int lastX = 0;
+		int lastY = 0;
+		walk.getPosition(steps - 1, lastX, lastY);
+		int lastObstacleX = walk.steep ? lastY : lastX;
+		int lastObstacleY = walk.steep ? lastX : lastY;
+		if(lastObstacleX < walk.interiorMin.x || lastObstacleX > walk.interiorMax.x
+			|| lastObstacleY < walk.interiorMin.y || lastObstacleY > walk.interiorMax.y)
+			break;
+
+		// Ray height is monotonic, lowest point is at either end
+		int lowest = std::min(rayHeight, getRayHeight(walk, step + steps - 1));
+		if(3 * top > lowest)
+			break;
+
+		skip = steps;
+	}
+
+	return skip;
+}
@@ -0,0 +1,99 @@
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+#ifndef INCLUDED_STORM3D_TERRAIN_HEIGHTPYRAMID_H
+#define INCLUDED_STORM3D_TERRAIN_HEIGHTPYRAMID_H
+
+#include <vector>
+#include "DatatypeDef.h"
+
+/*
+Max height pyramid for the accurate terrain raytrace
+----------------------------------------------------
+Level 0 keeps the highest collision heightmap value and the highest
+obstacle height for each 8x8 block of obstacle map cells, every level
+above halves the resolution. A ray which stays above a block's
+maximum over the steps it spends inside the block cannot hit anything
+there, so the raytrace can jump over it.
+
+Values only have to be upper bounds: stale high values just mean less
+skipping. Anything writing to the collision or obstacle maps must
+call invalidate() for the changed area, changed blocks are recomputed
+by flush() which the raytrace calls before walking.
+*/
+
+// Raytrace loop state, in the loop's own (possibly x/y swapped) coordinates
+struct Storm3D_TerrainRayWalk
+{
+	int x;
+	int y;
+	int e;
+
+	int dx;
+	int dy;
+	int sx;
+	int sy;
+	bool steep;
+
+	// ray height at step i is 3 * hs + (3 * hdiff * i) / dx
+	int hs;
+	int hdiff;
+
+	// cells steps can land on (obstacle map coordinates, inclusive)
+	VC2I interiorMin;
+	VC2I interiorMax;
+
+	// obstacle heights are tested too
+	bool obstacles;
+	// only every second step is tested
+	bool lineOfSight;
+
+	// Position after given amount of steps
+	void getPosition(int steps, int &resultX, int &resultY) const;
+	void advance(int steps);
+};
+
+class Storm3D_TerrainHeightPyramid
+{
+	struct Level
+	{
+		VC2I size;
+		// obstacle map cells per block side (log2)
+		int shift;
+
+		std::vector<unsigned short> terrain;
+		std::vector<unsigned short> obstacles;
+	};
+
+	std::vector<Level> levels;
+	VC2I obstacleResolution;
+	int obstacleMinusHeightmapShift;
+
+	// level 0 blocks waiting for flush()
+	std::vector<unsigned char> dirtyBlocks;
+	std::vector<int> dirtyList;
+	bool dirtyAll;
+
+	void updateBase(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap, const VC2I &blockStart, const VC2I &blockEnd);
+
+public:
+	Storm3D_TerrainHeightPyramid();
+
+	// Heightmap cell is (1 << obstacleMinusHeightmapShift) obstacle cells wide
+	void create(const VC2I &obstacleResolution, int obstacleMinusHeightmapShift);
+	void clear();
+	bool isEmpty() const;
+
+	// Area in obstacle map coordinates, end exclusive (obstacle map may be null)
+	void update(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap, const VC2I &start, const VC2I &end);
+	void updateAll(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap);
+
+	// Like update(), but only marks the area. Recomputed on next flush()
+	void invalidate(const VC2I &start, const VC2I &end);
+	void invalidateAll();
+	void flush(const unsigned short *collisionHeightMap, const unsigned short *obstacleHeightmap);
+
+	// Amount of steps (starting at step) known to hit nothing, 0 if none
+	int findSkip(const Storm3D_TerrainRayWalk &walk, int step) const;
+};
+
+#endif
@@ -11,6 +11,7 @@
 #include <c2_oobb.h>
 
 #include "storm3d_terrain_models.h"
+#include "Storm3D_ModelBvh.h"
 #include "storm3d_terrain_utils.h"
 #include "storm3d_spotlight.h"
 #include "storm3d_fakespotlight.h"
@@ -55,12 +56,16 @@ int active_visibility = 0;
 	{
 		Quadtree<Storm3D_Model> *tree;
 		Quadtree<Storm3D_Model>::Entity *entity;
+		Storm3D_ModelBvh *bvh;
+		int bvhHandle;
 		std::vector<Storm3D_Model *> *visibleModels[MAX_VISIBILITY_STRUCTURES];
 		DataBase *data;
 
-		ModelObserver(Quadtree<Storm3D_Model> *tree_, Quadtree<Storm3D_Model>::Entity *entity_, std::vector<Storm3D_Model *> *visibleModels_, DataBase *data_)
+		ModelObserver(Quadtree<Storm3D_Model> *tree_, Quadtree<Storm3D_Model>::Entity *entity_, Storm3D_ModelBvh *bvh_, int bvhHandle_, std::vector<Storm3D_Model *> *visibleModels_, DataBase *data_)
 		:	tree(tree_),
 			entity(entity_),
+			bvh(bvh_),
+			bvhHandle(bvhHandle_),
 			//visibleModels(visibleModels_),
 			data(data_)
 		{
@@ -76,11 +81,13 @@ int active_visibility = 0;
 		void updatePosition(const VC3 &position)
 		{
 			entity->setPosition(position);
+			bvh->setPosition(bvhHandle, position);
 		}
 
 		void updateRadius(float radius)
 		{
 			entity->setRadius(radius);
+			bvh->setRadius(bvhHandle, radius);
 		}
 
 		void updateVisibility(Storm3D_Model_Object *object)
@@ -111,6 +118,7 @@ int active_visibility = 0;
 		void destroy(Storm3D_Model *model)
 		{
 			tree->erase(entity);
+			bvh->erase(bvhHandle);
 		}
 	};
 
@@ -234,7 +242,9 @@ struct Storm3D_TerrainModelsData : public DataBase
 	Storm3D &storm;
 	std::set<Storm3D_Model *> models;
 
+	// quadtree for visibility, bvh for collision queries
 	std::unique_ptr<Quadtree<Storm3D_Model> > tree;
+	std::unique_ptr<Storm3D_ModelBvh> bvh;
 	std::map<Storm3D_Model *, std::shared_ptr<IModelObserver> > observers;
 
 	std::vector<Light> lights;
@@ -347,7 +357,8 @@ struct Storm3D_TerrainModelsData : public DataBase
 
 		//std::vector<Storm3D_Model *> *visibleModels_ = &visibleModels[0];
 		Quadtree<Storm3D_Model>::Entity *entity = tree->insert(model, model->GetPosition(), model->bounding_radius);
-		std::shared_ptr<ModelObserver> observer(new ModelObserver(tree.get(), entity, &visibleModels[0], this));
+		int bvhHandle = bvh->insert(model, model->GetPosition(), model->bounding_radius);
+		std::shared_ptr<ModelObserver> observer(new ModelObserver(tree.get(), entity, bvh.get(), bvhHandle, &visibleModels[0], this));
 		observers[model] = observer;
 
 		model->observer = observer.get();
@@ -553,6 +564,7 @@ struct Storm3D_TerrainModelsData : public DataBase
 
 		std::unique_ptr<Quadtree<Storm3D_Model> > newTree(new Quadtree<Storm3D_Model> (mmin, mmax));
 		tree.swap(newTree);
+		bvh.reset(new Storm3D_ModelBvh());
 
 		std::set<Storm3D_Model *>::iterator it = models.begin();
 		for(; it != models.end(); ++it)
@@ -1968,18 +1980,20 @@ bool Storm3D_TerrainModels::hasTree() const
 
 void Storm3D_TerrainModels::RayTrace(const VC3 &position, const VC3 &direction, float rayLength, Storm3D_CollisionInfo &info, bool accurate) const
 {
-	assert(data->tree);
+	assert(data->bvh);
+	data->bvh->RayTrace(position, direction, rayLength, info, accurate);
+}
 
-	Ray ray(position, direction, rayLength);
-	data->tree->RayTrace(ray, info, accurate);
+void Storm3D_TerrainModels::RayTraceBundle(const VC3 &position, const VC3 *directions, const float *rayLengths, int rayAmount, Storm3D_CollisionInfo *infos, bool accurate) const
+{
+	assert(data->bvh);
+	data->bvh->RayTraceBundle(position, directions, rayLengths, rayAmount, infos, accurate);
 }
 
 void Storm3D_TerrainModels::SphereCollision(const VC3 &position, float radius, Storm3D_CollisionInfo &info, bool accurate) const
 {
-	assert(data->tree);
-
-	Sphere sphere(position, radius);
-	data->tree->SphereCollision(sphere, info, accurate);
+	assert(data->bvh);
+	data->bvh->SphereCollision(position, radius, info, accurate);
 }
 
 void Storm3D_TerrainModels::calculateVisibility(Storm3D_Scene &scene, int timeDelta)
@@ -44,6 +44,7 @@ public:
 	void buildTree(const VC3 &size);
 	bool hasTree() const;
 	void RayTrace(const VC3 &position, const VC3 &direction, float rayLength, Storm3D_CollisionInfo &info, bool accurate) const;
+	void RayTraceBundle(const VC3 &position, const VC3 *directions, const float *rayLengths, int rayAmount, Storm3D_CollisionInfo *infos, bool accurate) const;
 	void SphereCollision(const VC3 &position, float radius, Storm3D_CollisionInfo &info, bool accurate) const;
 
 	enum MaterialType
@@ -0,0 +1,265 @@
+
+#include "precompiled.h"
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#pragma warning(disable:4786)
+#endif
+
+#include "LoadTrace.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include "Logger.h"
+
+#include "../util/Debug_MemoryManager.h"
+
+namespace {
+
+	typedef std::chrono::steady_clock TraceClock;
+
+	// keeps a forgotten trace from eating all memory
+	const int MAX_TRACE_EVENTS = 1000000;
+
+	struct TraceEvent
+	{
+		char phase;
+		const char *category;
+		std::string name;
+		int thread;
+		long long time;		// usec from start
+	};
+
+	struct TraceState
+	{
+		std::atomic<bool> enabled;
+		std::mutex mutex;
+
+		std::string filename;
+		TraceClock::time_point startTime;
+		std::vector<TraceEvent> events;
+		std::map<std::thread::id, int> threads;
+		bool overflow;
+
+		TraceState()
+		:	enabled(false),
+			overflow(false)
+		{
+		}
+	};
+
+	TraceState traceState;
+
+	// mutex must be locked
+	void addEvent(char phase, const char *category, const char *name)
+	{
+		if ((int)traceState.events.size() >= MAX_TRACE_EVENTS)
+		{
+			traceState.overflow = true;
+			return;
+		}
+
+		std::thread::id id = std::this_thread::get_id();
+		std::map<std::thread::id, int>::iterator it = traceState.threads.find(id);
+		int thread = 0;
+		if (it == traceState.threads.end())
+		{
+			thread = (int)traceState.threads.size() + 1;
+			traceState.threads[id] = thread;
+		}
+		else
+			thread = it->second;
+
+		TraceEvent e;
+		e.phase = phase;
+		e.category = category;
+		if (name != NULL)
+			e.name = name;
+		e.thread = thread;
+		e.time = std::chrono::duration_cast<std::chrono::microseconds>(TraceClock::now() - traceState.startTime).count();
+		traceState.events.push_back(e);
+	}
+
+	// length of a valid utf-8 sequence starting at c, 0 if not valid
+	int getUtf8Length(const unsigned char *c)
+	{
+		int length = 0;
+		if (c[0] >= 0xC2 && c[0] <= 0xDF)
+			length = 2;
+		else if (c[0] >= 0xE0 && c[0] <= 0xEF)
+			length = 3;
+		else if (c[0] >= 0xF0 && c[0] <= 0xF4)
+			length = 4;
+		else
+			return 0;
+
+		for (int i = 1; i < length; i++)
+		{
+			if ((c[i] & 0xC0) != 0x80)
+				return 0;
+		}
+
+		// overlong forms, surrogates and past U+10FFFF
+		if ((c[0] == 0xE0 && c[1] < 0xA0) || (c[0] == 0xED && c[1] >= 0xA0)
+			|| (c[0] == 0xF0 && c[1] < 0x90) || (c[0] == 0xF4 && c[1] >= 0x90))
+			return 0;
+
+		return length;
+	}
+
+	// utf-8 is written as is, other bytes (such as ansi code page
+	// file names) as latin-1 escapes so that the json stays valid
+	void writeString(FILE *f, const char *string)
+	{
+		fputc('"', f);
+		const unsigned char *c = (const unsigned char *)string;
+		while (*c != '\0')
+		{
+			if (*c == '"' || *c == '\\')
+				fprintf(f, "\\%c", *c);
+			else if (*c < 0x20)
+				fprintf(f, "\\u%04x", *c);
+			else if (*c >= 0x80)
+			{
+				int length = getUtf8Length(c);
+				if (length > 0)
+				{
+					fwrite(c, 1, length, f);
+					c += length;
+					continue;
+				}
+				fprintf(f, "\\u%04x", *c);
+			}
+			else
+				fputc(*c, f);
+
+			++c;
+		}
+		fputc('"', f);
+	}
+
+} // unnamed
+
+
+bool LoadTrace::start(const char *filename)
+{
+	if (filename == NULL || filename[0] == '\0')
+		return false;
+
+	std::lock_guard<std::mutex> lock(traceState.mutex);
+
+	// make sure we can write it before collecting anything
+	FILE *f = fopen(filename, "wb");
+	if (f == NULL)
+		return false;
+	fclose(f);
+
+	traceState.filename = filename;
+	traceState.startTime = TraceClock::now();
+	traceState.events.clear();
+	traceState.threads.clear();
+	traceState.overflow = false;
+	traceState.enabled = true;
+
+	// main thread gets the first id
+	addEvent('i', "engine", "trace start");
+	return true;
+}
+
+void LoadTrace::stop()
+{
+	std::lock_guard<std::mutex> lock(traceState.mutex);
+	if (!traceState.enabled)
+		return;
+
+	traceState.enabled = false;
+
+	FILE *f = fopen(traceState.filename.c_str(), "wb");
+	if (f == NULL)
+	{
+		Logger::getInstance()->error("LoadTrace::stop - Could not write trace file.");
+		Logger::getInstance()->debug(traceState.filename.c_str());
+		return;
+	}
+
+	fprintf(f, "{\"traceEvents\":[\n");
+
+	std::map<std::thread::id, int>::iterator it = traceState.threads.begin();
+	for (; it != traceState.threads.end(); ++it)
+	{
+		if (it->second == 1)
+			fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}},\n");
+		else
+			fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}},\n", it->second, it->second - 1);
+	}
+
+	for (int i = 0; i < (int)traceState.events.size(); i++)
+	{
+		const TraceEvent &e = traceState.events[i];
+
+		fprintf(f, "{\"ph\":\"%c\",\"cat\":", e.phase);
+		writeString(f, e.category);
+		if (e.phase != 'E')
+		{
+			fprintf(f, ",\"name\":");
+			writeString(f, e.name.c_str());
+		}
+		if (e.phase == 'i')
+			fprintf(f, ",\"s\":\"g\"");
+		fprintf(f, ",\"pid\":1,\"tid\":%d,\"ts\":%lld}", e.thread, e.time);
+		if (i + 1 < (int)traceState.events.size())
+			fputc(',', f);
+		fputc('\n', f);
+	}
+
+	fprintf(f, "],\n\"displayTimeUnit\":\"ms\"}\n");
+	fclose(f);
+
+	if (traceState.overflow)
+		Logger::getInstance()->warning("LoadTrace::stop - Too many events, trace was cut short.");
+
+	traceState.events.clear();
+	traceState.threads.clear();
+}
+
+bool LoadTrace::isEnabled()
+{
+	return traceState.enabled;
+}
+
+void LoadTrace::begin(const char *category, const char *name)
+{
+	if (!traceState.enabled)
+		return;
+
+	std::lock_guard<std::mutex> lock(traceState.mutex);
+	if (traceState.enabled)
+		addEvent('B', category, name);
+}
+
+void LoadTrace::end(const char *category)
+{
+	if (!traceState.enabled)
+		return;
+
+	std::lock_guard<std::mutex> lock(traceState.mutex);
+	if (traceState.enabled)
+		addEvent('E', category, NULL);
+}
+
+void LoadTrace::instant(const char *category, const char *name)
+{
+	if (!traceState.enabled)
+		return;
+
+	std::lock_guard<std::mutex> lock(traceState.mutex);
+	if (traceState.enabled)
+		addEvent('i', category, name);
+}
+
@@ -0,0 +1,62 @@
+
+#ifndef LOADTRACE_H
+#define LOADTRACE_H
+
+/**
+ * Startup and loading trace (-loadtrace=<file>).
+ *
+ * Collects begin/end markers with thread and category, and writes them
+ * as Chrome trace event JSON on stop (open in chrome://tracing or
+ * Perfetto). While tracing is off a marker costs one flag check.
+ *
+ * Categories in use: engine, filesystem, script, terrain, model,
+ * texture, sound, physics, load.
+ *
+ * @author Frozenbyte
+ */
+class LoadTrace
+{
+public:
+	static bool start(const char *filename);
+
+	// writes the file, does nothing if not started
+	static void stop();
+
+	static bool isEnabled();
+
+	// name is copied, end closes latest begin of the calling thread
+	static void begin(const char *category, const char *name);
+	static void end(const char *category);
+
+	// single point in time (such as first interactive frame)
+	static void instant(const char *category, const char *name);
+};
+
+/**
+ * Begin/end marker pair for a scope.
+ */
+class LoadTraceScope
+{
+public:
+	LoadTraceScope(const char *category, const char *name)
+		: category(category)
+	{
+		if (LoadTrace::isEnabled())
+			LoadTrace::begin(category, name);
+	}
+
+	~LoadTraceScope()
+	{
+		if (LoadTrace::isEnabled())
+			LoadTrace::end(category);
+	}
+
+private:
+	const char *category;
+
+	LoadTraceScope(const LoadTraceScope &);
+	LoadTraceScope &operator = (const LoadTraceScope &);
+};
+
+#endif
+
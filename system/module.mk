@@ -10,7 +10,7 @@ include $(TOPDIR)/$(dir)/module.mk
 
 
 FILES:=FileTimestampChecker.cpp Logger.cpp SystemRandom.cpp SystemTime.cpp \
-       Timer.cpp Miscellaneous.cpp \
+       Timer.cpp Miscellaneous.cpp LoadTrace.cpp \
 	   $(SRC_system/$(SYS))
 
 
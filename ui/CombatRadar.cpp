@@ -10,6 +10,7 @@
 #include "../game/Unit.h"
 #include "../game/UnitType.h"
 #include "../game/UnitList.h"
+#include "../container/SlotMap.h"
 #include "../ui/MapWindow.h"
 #include "../convert/str2int.h"
 #include "../game/SimpleOptions.h"
@@ -187,20 +188,20 @@ namespace ui
     int oldAmount = radarUnitsAmount;
     radarUnitsAmount = 0;
 
-		LinkedList *ulist;
+		const SlotMap<Unit> *uslots;
 
 		if (SimpleOptions::getBool(DH_OPT_B_GUI_RADAR_SHOW_ALL))
 		{
-			ulist = game->units->getAllUnits();
+			uslots = game->units->getAllUnitSlots();
 		} else {
-			ulist = game->units->getOwnedUnits(1);
+			uslots = game->units->getOwnedUnitSlots(1);
 		}
 
-    LinkedListIterator iter = LinkedListIterator(ulist);
+    SlotMap<Unit>::Iterator iter(uslots);
 
     while (iter.iterateAvailable())
     {
-      Unit *u = (Unit *)iter.iterateNext();
+      Unit *u = iter.iterateNext();
       if (u->isActive() && !u->isDestroyed()
         && u->visibility.isInRadarByPlayer(player)
 //        && u->visibility.isSeenByPlayer(player)
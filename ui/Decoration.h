@@ -4,6 +4,8 @@
 
 #include <DatatypeDef.h>
 
+#include "../container/SlotMap.h"
+
 #define DECORATION_MAX_EFFECTS 19
 
 namespace ui
@@ -109,6 +111,9 @@ namespace ui
 
 	  float animationSpeed;
 
+      // handle in DecorationManager
+      SlotMapHandle listHandle;
+
       friend class DecorationManager;
   };
 }
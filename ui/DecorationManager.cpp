@@ -10,7 +10,7 @@
 
 #include "Decoration.h"
 #include "VisualObject.h"
-#include "../container/LinkedList.h"
+#include "../container/SlotMap.h"
 #include "../util/ColorMap.h"
 #include "../system/Logger.h"
 
@@ -20,17 +20,17 @@ namespace ui
   
 	DecorationManager::DecorationManager()
   {
-    decorList = new LinkedList();
+    decorList = new SlotMap<Decoration>();
   }
 
 
   DecorationManager::~DecorationManager()
   {
-		while (!decorList->isEmpty())
+		for (int i = decorList->getDenseAmount() - 1; i >= 0; i--)
 		{
-			Decoration *d = (Decoration *)decorList->popLast();
-			delete d;
+			delete decorList->getDenseItem(i);
 		}
+		decorList->clear();
 		delete decorList;
   }
 
@@ -38,24 +38,24 @@ namespace ui
   Decoration *DecorationManager::createDecoration()
   {
 		Decoration *decor = new Decoration();
-		decorList->append(decor);
+		decor->listHandle = decorList->insert(decor);
 		return decor;
   }
 
 
   void DecorationManager::deleteDecoration(Decoration *decoration)
   {
-		decorList->remove(decoration);
+		decorList->erase(decoration->listHandle);
 		delete decoration;
 	}
 
 
   Decoration *DecorationManager::getDecorationByName(const char *name) const
   {
-		LinkedListIterator iter = LinkedListIterator(decorList);
+		SlotMap<Decoration>::Iterator iter(decorList);
 		while (iter.iterateAvailable())
 		{
-			Decoration *decor = (Decoration *)iter.iterateNext();
+			Decoration *decor = iter.iterateNext();
 			if (decor->name != NULL && strcmp(decor->name, name) == 0)
 			{
 				return decor;
@@ -67,10 +67,10 @@ namespace ui
 
   void DecorationManager::run()
   {
-		LinkedListIterator iter = LinkedListIterator(decorList);
+		SlotMap<Decoration>::Iterator iter(decorList);
 		while (iter.iterateAvailable())
 		{
-			Decoration *decor = (Decoration *)iter.iterateNext();
+			Decoration *decor = iter.iterateNext();
 			decor->run();
 		}
   }
@@ -78,10 +78,10 @@ namespace ui
 
   void DecorationManager::synchronizeAllDecorations() const
   {
-		LinkedListIterator iter = LinkedListIterator(decorList);
+		SlotMap<Decoration>::Iterator iter(decorList);
 		while (iter.iterateAvailable())
 		{
-			Decoration *decor = (Decoration *)iter.iterateNext();
+			Decoration *decor = iter.iterateNext();
 			for (int i = 0; i < DECORATION_MAX_EFFECTS; i++)
 				decor->effectValue[i] = 0;
 		}		
@@ -89,10 +89,10 @@ namespace ui
 
 	void DecorationManager::updateDecorationIllumination(util::ColorMap *colorMap)
 	{
-		LinkedListIterator iter = LinkedListIterator(decorList);
+		SlotMap<Decoration>::Iterator iter(decorList);
 		while (iter.iterateAvailable())
 		{
-			Decoration *decor = (Decoration *)iter.iterateNext();
+			Decoration *decor = iter.iterateNext();
 			if (decor->getVisualObject() != NULL)
 			{
 				VC3 pos = decor->getPosition();
@@ -109,10 +109,10 @@ namespace ui
 
 		int i = DECORID_LOWEST_POSSIBLE_VALUE;
 
-		LinkedListIterator iter(decorList);
+		SlotMap<Decoration>::Iterator iter(decorList);
 		while (iter.iterateAvailable())
 		{
-			Decoration *d = (Decoration *)iter.iterateNext();
+			Decoration *d = iter.iterateNext();
 			if (decor == d) return i;
 			i++;
 		}
@@ -125,10 +125,10 @@ namespace ui
 	{
 		int i = DECORID_LOWEST_POSSIBLE_VALUE;
 
-		LinkedListIterator iter(decorList);
+		SlotMap<Decoration>::Iterator iter(decorList);
 		while (iter.iterateAvailable())
 		{
-			Decoration *d = (Decoration *)iter.iterateNext();
+			Decoration *d = iter.iterateNext();
 			if (i == id) return d;
 			i++;
 		}
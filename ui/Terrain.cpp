@@ -23,6 +23,7 @@
 #include "../game/gamedefs.h"
 #include "../game/GameMap.h"
 #include "../system/Logger.h"
+#include "../system/LoadTrace.h"
 #include "../filesystem/input_stream_wrapper.h"
 #include "../filesystem/file_package_manager.h"
 #include "../filesystem/input_file_stream.h"
@@ -209,7 +210,7 @@ static void uninit_terrain_object_variables()
 
 	static filesystem::InputStream &operator >> (filesystem::InputStream &stream, VC3 &vector)
 	{
-		return stream >> vector.x >> vector.y >> vector.z;
+		return stream.readFloatArray(&vector, 1);
 	}
 
 	static filesystem::InputStream &operator >> (filesystem::InputStream &stream, TColor<unsigned char> &color)
@@ -1764,8 +1765,8 @@ static util::ObjectDurabilityParser durp;
 					stream >> data.physicsType;
 					stream >> data.physicsMass;
 					stream >> data.physicsSoundMaterial;
-					stream >> data.physicsData1.x >> data.physicsData1.y >> data.physicsData1.z;
-					stream >> data.physicsData2.x >> data.physicsData2.y >> data.physicsData2.z;
+					stream >> data.physicsData1;
+					stream >> data.physicsData2;
 					if(version >= 19)
 					{
 						stream >> data.durabilityType;
@@ -2869,6 +2870,7 @@ static util::ObjectDurabilityParser durp;
 
 Terrain::Terrain(IStorm3D *storm, IStorm3D_Scene *scene, const char *dirName, const char *forceMapName, const util::AreaMap *areaMap, game::GameMap *gameMap, ui::LightManager *lightManager, ui::AmbientSoundManager *ambientSoundManager)
 {
+	LoadTraceScope trace("terrain", dirName);
 	init_terrain_object_variables();
 
 	data = new TerrainData();
@@ -2938,6 +2940,7 @@ void Terrain::setAmbientSoundManager(ui::AmbientSoundManager *ambientSoundManage
 void Terrain::loadPhysicsCache(game::GamePhysics *gamePhysics, char *mapFilename)
 {
 	assert(mapFilename != NULL);
+	LoadTraceScope trace("physics", "physics cache");
 
 	std::string filenamestr = std::string(mapFilename) + std::string("/pcache.bin");
 	filesystem::FB_FILE *f = filesystem::fb_fopen(filenamestr.c_str(), "rb");
@@ -1019,6 +1019,12 @@ void PathFind::setBlockingCount(int xPosition, int yPosition, int amount)
 	obstacleMap[xPosition][yPosition] = amount;
 }
 
+signed char *PathFind::getBlockingColumn(int xPosition)
+{
+	assert(xPosition >= 0 && xPosition < xSize);
+	return &obstacleMap[xPosition][0];
+}
+
 
 // Returns model (from pathblocks) at given point. 0 if not found
 IStorm3D_Model *PathFind::getModelAt(int xPosition, int yPosition, const VC3 &worldCoords) const
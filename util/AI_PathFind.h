@@ -221,6 +221,9 @@ public:
 	// NOTE: for loading of the pathfind map...
 	void setBlockingCount(int xPosition, int yPosition, int amount);
 
+	// Blocking counts of one x column (ySize values), also for map loading
+	signed char *getBlockingColumn(int xPosition);
+
 	// Returns model (from pathblocks) at given point. 0 if not found
 	IStorm3D_Model *getModelAt(int xPosition, int yPosition, const VC3 &worldCoords) const;
 
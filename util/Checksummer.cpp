@@ -2,10 +2,12 @@
 #include "precompiled.h"
 
 #include "Checksummer.h"
-#include "../filesystem/input_stream_wrapper.h"
+#include "../filesystem/file_package_manager.h"
+#include "../filesystem/crc32.h"
 
 #include <assert.h>
 #include <stdio.h>
+#include <vector>
 
 using namespace frozenbyte;
 
@@ -47,46 +49,35 @@ namespace util
 	{
 		assert(filename != NULL);
 
-		filesystem::FB_FILE *f = filesystem::fb_fopen(filename, "rb");
-		if (f == NULL)
+		filesystem::FilePackageManager &manager = filesystem::FilePackageManager::getInstance();
+
+		// Opening a stream is cheap, data is only read on demand
+		filesystem::InputStream stream = manager.getFile(filename);
+		if (stream.isEof())
 		{
 			return false;
 		}
 
-		//fseek(f, 0, SEEK_END);
-		//int size = ftell(f);
-		//fseek(f, 0, SEEK_SET);
-		int size = filesystem::fb_fsize(f);
-
-		char *buf = new char[size];
-
-		bool success = true;
-		int got = filesystem::fb_fread(buf, size, 1, f);
-		if (got != 1)
+		*filesize = stream.getSize();
+		if (*filesize <= 0)
 		{
-			success = false;
-		} else {
-			success = true;
-			*filesize = size;
-			unsigned int hashCode = 1327341033;
-			int hashmult = 0;
-			for (int i = 0; i < size; i++)
-			{
-				if ((i % 73) == 0)
-					hashCode += (buf[i] << hashmult);
-				else
-					hashCode ^= (buf[i] << hashmult);
-				hashmult+=4;
-				if (hashmult > 23) hashmult -= 23;
-			}
-			*checksum = hashCode;
+			// (nothing to read, crc of empty data)
+			*filesize = 0;
+			*checksum = filesystem::calculateCrc32(NULL, 0);
+			return true;
 		}
-		
-		delete [] buf;
 
-		filesystem::fb_fclose(f);
+		unsigned int crc = manager.getCrc(filename);
+		if (crc == 0)
+		{
+			// Package cannot tell, count it from the data
+			std::vector<unsigned char> buf(*filesize);
+			stream.read(&buf[0], *filesize);
+			crc = filesystem::calculateCrc32(&buf[0], *filesize);
+		}
 
-		return success;
+		*checksum = crc;
+		return true;
 	}	
 
 }
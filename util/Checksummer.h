@@ -1,4 +1,3 @@
-
 #ifndef CHECKSUMMER_H
 #define CHECKSUMMER_H
 
@@ -7,6 +6,8 @@ namespace util
   class Checksummer
 	{
 		public:
+			// Checksum is the crc32 of the file. Packages provide it from their
+			// directory (or cache it), so the file is not reread.
 			static unsigned int countChecksumForFile(const char *filename);
 
 			static bool doesChecksumAndSizeMatchFile(unsigned int checksum, int filesize, const char *filename);
@@ -20,3 +21,4 @@ namespace util
 
 #endif
 
+
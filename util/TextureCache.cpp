@@ -7,17 +7,20 @@
 #endif
 
 #include "TextureCache.h"
+#include "TextureReader.h"
 #include "../system/Logger.h"
 #include <IStorm3D.h>
-#include "../filesystem/input_stream_wrapper.h"
 
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
+#include <string.h>
 
 namespace frozenbyte {
 
 	static const int TEMPORARY_TIME = 20 * 1000;
+	static const int DEFAULT_UPLOAD_FILE_BYTES = 4 * 1024 * 1024;
 
 	struct TextureDeleter
 	{
@@ -99,9 +102,18 @@ struct TextureCache::Data
 
 	int loadflags;
 
+	// requested but not yet created textures (name -> temporaryCache)
+	std::map<std::string, bool> requestedTextures;
+	// reads requested by loadTextureData
+	std::map<std::string, bool> requestedDatas;
+	TextureReader reader;
+	// texture file bytes (not decoded/video memory) created per update
+	int uploadFileBytes;
+
 	Data(IStorm3D &storm_)
 	:	storm(storm_),
-		loadflags(0)
+		loadflags(0),
+		uploadFileBytes(DEFAULT_UPLOAD_FILE_BYTES)
 	{
 	}
 
@@ -117,20 +129,121 @@ struct TextureCache::Data
 		Logger::getInstance()->debug(("TextureCache preloaded a total of " + std::to_string(total) + " bytes").c_str());
 	}
 
-	void loadTexture(std::string fileName, bool temporaryCache)
+	// Takes a finished read into use. Returns bytes used for texture creation.
+	size_t finishRead(const std::string &fileName, std::vector<char> &fileData)
 	{
-		makeLower(fileName);
+		if(requestedDatas.erase(fileName) && !fileData.empty() && textureDatas.find(fileName) == textureDatas.end())
+		{
+			TextureData td;
+			td.data_size = fileData.size();
+			td.data = new char[td.data_size];
+			memcpy(td.data, &fileData[0], td.data_size);
+			textureDatas[fileName] = td;
+		}
+
+		std::map<std::string, bool>::iterator it = requestedTextures.find(fileName);
+		if(it == requestedTextures.end())
+			return 0;
+
+		bool temporaryCache = it->second;
+		requestedTextures.erase(it);
 
-		// try to find texture data from CPU side memory
 		const void *data = NULL;
 		size_t data_size = 0;
-		std::map<std::string, TextureData >::iterator it = textureDatas.find(fileName.c_str());
+		getTextureData(fileName, fileData, data, data_size);
+		createTexture(fileName, temporaryCache, data, data_size);
+
+		return data_size;
+	}
+
+	// Completes pending read of this file, if any
+	void finishRead(const std::string &fileName)
+	{
+		std::vector<char> fileData;
+		if(reader.take(fileName, fileData))
+			finishRead(fileName, fileData);
+
+		requestedTextures.erase(fileName);
+		requestedDatas.erase(fileName);
+	}
+
+	void uploadFinished(bool all)
+	{
+		size_t uploaded = 0;
+		std::string fileName;
+		std::vector<char> fileData;
+
+		while(all || uploaded < size_t(uploadFileBytes))
+		{
+			if(!reader.takeFinished(fileName, fileData))
+				break;
+
+			uploaded += finishRead(fileName, fileData);
+		}
+	}
+
+	void finishAll()
+	{
+		uploadFinished(true);
+
+		while(!requestedTextures.empty())
+			finishRead(std::string(requestedTextures.begin()->first));
+		while(!requestedDatas.empty())
+			finishRead(std::string(requestedDatas.begin()->first));
+	}
+
+	void requestTexture(std::string fileName, bool temporaryCache)
+	{
+		makeLower(fileName);
+
+		if(getTexture(fileName) || requestedTextures.find(fileName) != requestedTextures.end())
+			return;
+
+		requestedTextures[fileName] = temporaryCache;
+
+		// data already in memory, only creation left
+		if(textureDatas.find(fileName) != textureDatas.end())
+			reader.addFinished(fileName);
+		else
+			reader.request(fileName);
+	}
+
+	// Preloaded data is preferred over just read file
+	void getTextureData(const std::string &fileName, const std::vector<char> &fileData, const void *&data, size_t &data_size)
+	{
+		std::map<std::string, TextureData >::iterator it = textureDatas.find(fileName);
 		if(it != textureDatas.end())
 		{
 			data = it->second.data;
 			data_size = it->second.data_size;
 		}
+		else if(!fileData.empty())
+		{
+			data = &fileData[0];
+			data_size = fileData.size();
+		}
+	}
+
+	void loadTexture(std::string fileName, bool temporaryCache)
+	{
+		makeLower(fileName);
+
+		// requested texture is created here instead, waiting for the read if needed
+		requestedTextures.erase(fileName);
+		std::vector<char> fileData;
+		if(reader.take(fileName, fileData))
+			finishRead(fileName, fileData);
+
+		// try to find texture data from CPU side memory
+		const void *data = NULL;
+		size_t data_size = 0;
+		getTextureData(fileName, fileData, data, data_size);
+
+		createTexture(fileName, temporaryCache, data, data_size);
+	}
 
+	void createTexture(const std::string &fileName, bool temporaryCache, const void *data, size_t data_size)
+	{
 		IStorm3D_Texture *t = storm.CreateNewTexture(fileName.c_str(), loadflags, 0, data, data_size);
 		if(!t)
 		{
@@ -179,27 +292,8 @@ struct TextureCache::Data
 		// already loaded
 		if(textureDatas.find(fileName) != textureDatas.end()) return;
 
-		filesystem::FB_FILE *file = filesystem::fb_fopen(fileName.c_str(), "rb");
-		if(file)
-		{
-			TextureData td;
-			td.data_size = filesystem::fb_fsize(file);
-
-			if(td.data_size > 0)
-			{
-				td.data = new char[td.data_size];
-				if(filesystem::fb_fread(td.data, 1, td.data_size, file) == td.data_size)
-				{
-					textureDatas[fileName] = td;
-				}
-				else
-				{
-					delete[] td.data;
-				}
-			}
-
-			filesystem::fb_fclose(file);
-		}
+		requestedDatas[fileName] = true;
+		reader.request(fileName);
 	}
 };
 
@@ -225,8 +319,30 @@ void TextureCache::clearTemporary()
 	data->timedTemporaries.clear();
 }
 
+void TextureCache::requestTexture(const char *fileName, bool temporaryCache)
+{
+	data->requestTexture(fileName, temporaryCache);
+}
+
+void TextureCache::finishRequests()
+{
+	data->finishAll();
+}
+
+int TextureCache::getRequestAmount() const
+{
+	return int(data->requestedTextures.size() + data->requestedDatas.size());
+}
+
+void TextureCache::setUploadFileBytes(int fileBytesPerUpdate)
+{
+	data->uploadFileBytes = fileBytesPerUpdate;
+}
+
 void TextureCache::update(int ms)
 {
+	data->uploadFinished(false);
+
 	TimedTemporaryList::iterator it = data->timedTemporaries.begin();
 	for(; it != data->timedTemporaries.end(); )
 	{
@@ -249,6 +365,7 @@ IStorm3D_Texture *TextureCache::getTexture(const char *fileName, bool temporaryC
 
 	if(!result)
 	{
+		// requested but not yet created, loadTexture waits for the read
 		loadTexture(fileName, temporaryCache);
 		result = data->getTexture(fileName);
 	}
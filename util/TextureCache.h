@@ -15,13 +15,26 @@ public:
 	TextureCache(IStorm3D &storm);
 	~TextureCache();
 
-	// loads texture data to cpu side memory
+	// loads texture data to cpu side memory (read on worker thread)
 	void loadTextureDataToMemory(const char *fileName);
 
 	void loadTexture(const char *fileName, bool temporaryCache);
 	void clearTemporary();
+
+	// creates read textures within the upload budget
 	void update(int ms);
 
+	// file is read on a worker thread, texture is created by update()
+	// (or right away if getTexture asks for it before that)
+	void requestTexture(const char *fileName, bool temporaryCache);
+	// creates all requested textures now, waiting for reads if needed
+	void finishRequests();
+	int getRequestAmount() const;
+
+	// limits texture creation per update by texture file size (as read, so
+	// not the decoded or video memory size). at least one is always created
+	void setUploadFileBytes(int fileBytesPerUpdate);
+
 	void setLoadFlags(int flags);
 	int getLoadFlags();
 
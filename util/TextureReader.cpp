@@ -0,0 +1,164 @@
+
+#include "precompiled.h"
+
+#ifdef _MSC_VER
+#pragma warning(disable:4103)
+#pragma warning(disable:4786)
+#endif
+
+#include "TextureReader.h"
+#include "../filesystem/input_stream_wrapper.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace frozenbyte {
+
+	static const int READ_THREAD_AMOUNT = 2;
+
+	static bool readFile(const std::string &fileName, std::vector<char> &result)
+	{
+		result.clear();
+
+		filesystem::FB_FILE *file = filesystem::fb_fopen(fileName.c_str(), "rb");
+		if(!file)
+			return false;
+
+		bool ok = false;
+		size_t size = filesystem::fb_fsize(file);
+		if(size > 0)
+		{
+			result.resize(size);
+			ok = filesystem::fb_fread(&result[0], 1, size, file) == size;
+			if(!ok)
+				result.clear();
+		}
+
+		filesystem::fb_fclose(file);
+		return ok;
+	}
+
+TextureReader::TextureReader()
+:	quit(false)
+{
+}
+
+TextureReader::~TextureReader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		condition.notify_all();
+	}
+
+	for(unsigned int i = 0; i < threads.size(); ++i)
+		threads[i].join();
+}
+
+void TextureReader::run()
+{
+	while(true)
+	{
+		std::string fileName;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while(queue.empty() && !quit)
+				condition.wait(lock);
+
+			if(quit)
+				return;
+
+			fileName = queue.front();
+			queue.pop_front();
+		}
+
+		std::vector<char> data;
+		readFile(fileName, data);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		Read &read = reads[fileName];
+		read.data.swap(data);
+		read.done = true;
+		finished.push_back(fileName);
+		condition.notify_all();
+	}
+}
+
+// mutex must be locked
+void TextureReader::removeFinished(const std::string &fileName)
+{
+	std::deque<std::string>::iterator it = std::find(finished.begin(), finished.end(), fileName);
+	if(it != finished.end())
+		finished.erase(it);
+}
+
+void TextureReader::request(const std::string &fileName)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(reads.find(fileName) != reads.end())
+		return;
+
+	reads[fileName] = Read();
+	queue.push_back(fileName);
+	condition.notify_one();
+
+	if(threads.empty())
+	{
+		for(int i = 0; i < READ_THREAD_AMOUNT; ++i)
+			threads.push_back(std::thread(&TextureReader::run, this));
+	}
+}
+
+void TextureReader::addFinished(const std::string &fileName)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(reads.find(fileName) != reads.end())
+		return;
+
+	reads[fileName].done = true;
+	finished.push_back(fileName);
+}
+
+bool TextureReader::take(const std::string &fileName, std::vector<char> &result)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	std::map<std::string, Read>::iterator it = reads.find(fileName);
+	if(it == reads.end())
+		return false;
+
+	while(!it->second.done)
+		condition.wait(lock);
+
+	// a later request of the same file must not be taken as finished
+	// by this (already taken) read
+	removeFinished(fileName);
+
+	result.swap(it->second.data);
+	reads.erase(it);
+	return true;
+}
+
+bool TextureReader::takeFinished(std::string &fileName, std::vector<char> &result)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(finished.empty())
+		return false;
+
+	fileName = finished.front();
+	finished.pop_front();
+
+	std::map<std::string, Read>::iterator it = reads.find(fileName);
+	assert(it != reads.end() && it->second.done);
+
+	result.swap(it->second.data);
+	reads.erase(it);
+	return true;
+}
+
+int TextureReader::getRequestAmount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return int(reads.size());
+}
+
+} // frozenbyte
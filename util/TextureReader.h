@@ -0,0 +1,63 @@
+#ifndef INCLUDED_TEXTUREREADER_H
+#define INCLUDED_TEXTUREREADER_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace frozenbyte {
+
+// Reads (and unpacks) texture files on worker threads for TextureCache.
+// Threads are started with the first request.
+class TextureReader
+{
+	struct Read
+	{
+		bool done;
+		std::vector<char> data;
+
+		Read()
+		:	done(false)
+		{
+		}
+	};
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::string> queue;
+	// done reads in completion order, each name is in here at most once
+	std::deque<std::string> finished;
+	std::map<std::string, Read> reads;
+	std::vector<std::thread> threads;
+	bool quit;
+
+	void run();
+	void removeFinished(const std::string &fileName);
+
+public:
+	TextureReader();
+	~TextureReader();
+
+	void request(const std::string &fileName);
+
+	// Finished read without data (caller has it already)
+	void addFinished(const std::string &fileName);
+
+	// Waits for the read if it is still queued or in progress.
+	// Returns false if file was not requested.
+	bool take(const std::string &fileName, std::vector<char> &result);
+
+	// Oldest finished read, does not wait
+	bool takeFinished(std::string &fileName, std::vector<char> &result);
+
+	// Requested reads not yet taken (finished or not)
+	int getRequestAmount();
+};
+
+} // frozenbyte
+
+#endif
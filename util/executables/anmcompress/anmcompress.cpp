@@ -0,0 +1,274 @@
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+// Compresses .anm bone animations into .anc files (see
+// storm3dv2/Storm3D_CompressedAnimation.h). The loader uses the .anc when
+// one exists next to the .anm and is not older than it, otherwise it loads
+// the .anm with all of its keys.
+//
+// Usage: anmcompress [-rotation <radians>] [-position <units>] <anim.anm | dir> [...]
+// Tolerances are the largest error allowed for a dropped key.
+//
+// Build together with storm/storm3dv2/Storm3D_CompressedAnimation.cpp.
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "../../../filesystem/file_package_manager.h"
+#include "../../../filesystem/standard_package.h"
+#include "../../../filesystem/ifile_list.h"
+#include "../../../storm/storm3dv2/Storm3D_CompressedAnimation.h"
+
+using namespace std;
+using namespace frozenbyte;
+
+namespace {
+
+	// In memory size of the old key arrays (std::pair<int, Rotation> + std::pair<int, Vector>)
+	const int SOURCE_ROTATION_KEY_SIZE = sizeof(int) + 4 * sizeof(float);
+	const int SOURCE_POSITION_KEY_SIZE = sizeof(int) + 3 * sizeof(float);
+
+	struct Stats
+	{
+		unsigned int sourceKeys;
+		unsigned int compressedKeys;
+		unsigned int sourceBytes;
+		unsigned int compressedBytes;
+
+		Stats()
+		:	sourceKeys(0),
+			compressedKeys(0),
+			sourceBytes(0),
+			compressedBytes(0)
+		{
+		}
+	};
+
+	bool readFile(const string &fileName, vector<unsigned char> &result)
+	{
+		FILE *fp = fopen(fileName.c_str(), "rb");
+		if(!fp)
+			return false;
+
+		fseek(fp, 0, SEEK_END);
+		long size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+
+		if(size > 0)
+		{
+			result.resize(size);
+			if(fread(&result[0], 1, size, fp) != size_t(size))
+				result.clear();
+		}
+
+		fclose(fp);
+		return !result.empty();
+	}
+
+	// Same parsing as Storm3D_BoneAnimation::LoadSource
+	bool readSource(const vector<unsigned char> &data, int &boneId, int &loopTime, vector<Storm3D_CompressedAnimation::SourceTrack> &tracks, string &error)
+	{
+		unsigned int position = 0;
+		bool failed = false;
+
+		struct Reader
+		{
+			const vector<unsigned char> &data;
+			unsigned int &position;
+			bool &failed;
+
+			void read(void *buffer, unsigned int bytes)
+			{
+				if(failed || bytes > data.size() - position)
+				{
+					failed = true;
+					memset(buffer, 0, bytes);
+					return;
+				}
+
+				memcpy(buffer, &data[position], bytes);
+				position += bytes;
+			}
+
+			int readInt()
+			{
+				int value = 0;
+				read(&value, sizeof(int));
+				return value;
+			}
+		} reader = { data, position, failed };
+
+		char header[5] = { 0 };
+		reader.read(header, 5);
+		if(memcmp(header, "ANM11", 5) != 0)
+		{
+			error = "not an ANM11 file";
+			return false;
+		}
+
+		boneId = reader.readInt();
+		loopTime = reader.readInt();
+		int boneCount = reader.readInt();
+		if(boneCount < 0 || unsigned(boneCount) > data.size() || loopTime <= 0)
+		{
+			error = "invalid header";
+			return false;
+		}
+
+		tracks.resize(boneCount);
+		for(int i = 0; i < boneCount && !failed; ++i)
+		{
+			int keyCount = reader.readInt();
+			int positionKeyCount = reader.readInt();
+			if(keyCount < 0 || unsigned(keyCount) > data.size())
+				failed = true;
+
+			for(int j = 0; j < keyCount && !failed; ++j)
+			{
+				int time = reader.readInt();
+				QUAT rotation;
+				reader.read(&rotation, sizeof(float) * 4);
+				tracks[i].rotation_times.push_back(time);
+				tracks[i].rotations.push_back(rotation);
+
+				if(positionKeyCount > 0)
+				{
+					VC3 position;
+					reader.read(&position, sizeof(float) * 3);
+					tracks[i].position_times.push_back(time);
+					tracks[i].positions.push_back(position);
+				}
+			}
+		}
+
+		if(failed)
+		{
+			error = "truncated file";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool compressAnimation(const string &fileName, const Storm3D_CompressedAnimation::Tolerance &tolerance, Stats &stats, string &error)
+	{
+		vector<unsigned char> data;
+		if(!readFile(fileName, data))
+		{
+			error = "cannot open";
+			return false;
+		}
+
+		int boneId = 0;
+		int loopTime = 0;
+		vector<Storm3D_CompressedAnimation::SourceTrack> tracks;
+		if(!readSource(data, boneId, loopTime, tracks, error))
+			return false;
+
+		Storm3D_CompressedAnimation animation;
+		animation.compress(boneId, loopTime, tracks, tolerance);
+
+		vector<unsigned char> result;
+		animation.write(result);
+
+		string outputName = fileName.substr(0, fileName.size() - 1) + "c";
+		FILE *fp = fopen(outputName.c_str(), "wb");
+		if(!fp)
+		{
+			error = "cannot write " + outputName;
+			return false;
+		}
+
+		bool written = fwrite(&result[0], 1, result.size(), fp) == result.size();
+		fclose(fp);
+		if(!written)
+		{
+			error = "cannot write " + outputName;
+			return false;
+		}
+
+		for(unsigned int i = 0; i < tracks.size(); ++i)
+		{
+			stats.sourceKeys += tracks[i].rotations.size() + tracks[i].positions.size();
+			stats.sourceBytes += tracks[i].rotations.size() * SOURCE_ROTATION_KEY_SIZE + tracks[i].positions.size() * SOURCE_POSITION_KEY_SIZE;
+		}
+
+		stats.compressedKeys += animation.getRotationKeyAmount() + animation.getPositionKeyAmount();
+		stats.compressedBytes += animation.getMemoryUsage();
+		return true;
+	}
+
+	bool isAnimation(const string &fileName)
+	{
+		if(fileName.size() < 4)
+			return false;
+
+		string extension = fileName.substr(fileName.size() - 4);
+		for(unsigned int i = 0; i < extension.size(); ++i)
+			extension[i] = tolower(extension[i]);
+
+		return extension == ".anm";
+	}
+
+} // unnamed
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		printf("Usage: anmcompress [-rotation <radians>] [-position <units>] <anim.anm | dir> [...]\n");
+		return 1;
+	}
+
+	filesystem::FilePackageManager &manager = filesystem::FilePackageManager::getInstance();
+	std::shared_ptr<filesystem::IFilePackage> standardPackage(new filesystem::StandardPackage());
+	manager.addPackage(standardPackage, 999);
+
+	Storm3D_CompressedAnimation::Tolerance tolerance;
+	vector<string> files;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-rotation") == 0 && i + 1 < argc)
+		{
+			tolerance.rotation = float(atof(argv[++i]));
+			continue;
+		}
+		if(strcmp(argv[i], "-position") == 0 && i + 1 < argc)
+		{
+			tolerance.position = float(atof(argv[++i]));
+			continue;
+		}
+
+		if(isAnimation(argv[i]))
+		{
+			files.push_back(argv[i]);
+			continue;
+		}
+
+		std::shared_ptr<filesystem::IFileList> fileList = manager.findFiles(argv[i], "*.anm");
+		filesystem::getAllFiles(*fileList, argv[i], files, true);
+	}
+
+	Stats stats;
+	int compressed = 0;
+	int failed = 0;
+	for(unsigned int i = 0; i < files.size(); ++i)
+	{
+		string error;
+		if(compressAnimation(files[i], tolerance, stats, error))
+			++compressed;
+		else
+		{
+			printf("Skipped %s (%s)\n", files[i].c_str(), error.c_str());
+			++failed;
+		}
+	}
+
+	printf("%d animations compressed, %d skipped\n", compressed, failed);
+	printf("Keys %u -> %u, key memory %u -> %u bytes\n", stats.sourceKeys, stats.compressedKeys, stats.sourceBytes, stats.compressedBytes);
+	return 0;
+}
@@ -0,0 +1,23 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone tool, links with filesystem and system sources
+FILES_anmcompress:=anmcompress.cpp
+
+SRC_anmcompress:=$(addprefix $(d)/,$(FILES_anmcompress)) \
+                 storm/storm3dv2/Storm3D_CompressedAnimation.cpp
+DEPSRC_anmcompress=$(SRC_filesystem) $(SRC_system)
+
+TOOLS+=$(d)/anmcompress
+
+$(d)/anmcompress: $(SRC_anmcompress:.cpp=.o) $$(patsubst %.cpp,%.o,$$(DEPSRC_anmcompress))
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+CLEANDIRS+=$(d)
+
+-include $(foreach FILE,$(FILES_anmcompress),$(d)/$(FILE:.cpp=.d))
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
@@ -0,0 +1,167 @@
+
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+// Builds fast decompressing packages (LzPackage) out of data directories.
+//
+// Usage: lzpacker [-order <trace>] <package.fbl> <dir> [dir ...]
+// Run from the game root so that stored names match what the game asks for (data/...).
+//
+// With -order (may be given several times) files are laid out in the order
+// they were first opened in the file access traces (-filetrace), so that
+// loading reads the package front to back. Files not in traces go last.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdio.h>
+#include <ctype.h>
+
+#include "../../../filesystem/file_package_manager.h"
+#include "../../../filesystem/standard_package.h"
+#include "../../../filesystem/ifile_list.h"
+#include "../../../filesystem/lz_package_writer.h"
+#include "../../../filesystem/file_access_trace.h"
+
+using namespace std;
+using namespace frozenbyte;
+
+namespace {
+
+	typedef map<string, unsigned int> AccessOrder;
+
+	string getOrderKey(string file)
+	{
+		for(unsigned int i = 0; i < file.size(); ++i)
+		{
+			if(file[i] == '\\')
+				file[i] = '/';
+			else
+				file[i] = tolower(file[i]);
+		}
+
+		while(file.compare(0, 2, "./") == 0)
+			file.erase(0, 2);
+
+		return file;
+	}
+
+	bool readTrace(const string &traceFile, AccessOrder &order)
+	{
+		vector<filesystem::FileAccessRecord> records;
+		if(!filesystem::readFileAccessTrace(traceFile, records))
+			return false;
+
+		for(unsigned int i = 0; i < records.size(); ++i)
+		{
+			if(records[i].size == filesystem::FileAccessRecord::NOT_FOUND)
+				continue;
+
+			// First access wins, later traces append
+			unsigned int index = order.size();
+			order.insert(AccessOrder::value_type(getOrderKey(records[i].path), index));
+		}
+
+		return true;
+	}
+
+	struct OrderSorter
+	{
+		const AccessOrder &order;
+
+		OrderSorter(const AccessOrder &order_)
+		:	order(order_)
+		{
+		}
+
+		unsigned int getIndex(const string &file) const
+		{
+			AccessOrder::const_iterator it = order.find(getOrderKey(file));
+			if(it == order.end())
+				return 0xFFFFFFFF;
+
+			return it->second;
+		}
+
+		bool operator () (const string &a, const string &b) const
+		{
+			return getIndex(a) < getIndex(b);
+		}
+	};
+
+} // unnamed
+
+int main(int argc, char *argv[])
+{
+	AccessOrder order;
+
+	int firstArg = 1;
+	while(firstArg + 1 < argc && string(argv[firstArg]) == "-order")
+	{
+		if(!readTrace(argv[firstArg + 1], order))
+		{
+			printf("Error, could not read trace %s\n", argv[firstArg + 1]);
+			return 1;
+		}
+
+		firstArg += 2;
+	}
+
+	if(argc - firstArg < 2)
+	{
+		printf("Usage: lzpacker [-order <trace>] <package.fbl> <dir> [dir ...]\n");
+		return 1;
+	}
+
+	const char *packageName = argv[firstArg];
+
+	filesystem::FilePackageManager &manager = filesystem::FilePackageManager::getInstance();
+	std::shared_ptr<filesystem::IFilePackage> standardPackage(new filesystem::StandardPackage());
+	manager.addPackage(standardPackage, 999);
+
+	vector<string> files;
+	for(int i = firstArg + 1; i < argc; ++i)
+	{
+		std::shared_ptr<filesystem::IFileList> fileList = manager.findFiles(argv[i], "*", true);
+		filesystem::getAllFiles(*fileList, argv[i], files, true, true);
+	}
+
+	int orderedFiles = 0;
+	if(!order.empty())
+	{
+		OrderSorter sorter(order);
+		stable_sort(files.begin(), files.end(), sorter);
+
+		for(unsigned int i = 0; i < files.size(); ++i)
+		{
+			if(sorter.getIndex(files[i]) != 0xFFFFFFFF)
+				++orderedFiles;
+		}
+	}
+
+	filesystem::LzPackageWriter writer;
+	if(!writer.open(packageName))
+	{
+		printf("Error, could not create %s\n", packageName);
+		return 1;
+	}
+
+	for(unsigned int i = 0; i < files.size(); ++i)
+	{
+		if(!writer.addFile(files[i], files[i]))
+			printf("Skipped %s (empty or unreadable)\n", files[i].c_str());
+	}
+
+	if(!writer.finish())
+	{
+		printf("Error, could not write %s\n", packageName);
+		return 1;
+	}
+
+	printf("%s: %d files, %u -> %u bytes\n", packageName, writer.getFileAmount(), writer.getUnpackedSize(), writer.getPackedSize());
+	if(!order.empty())
+		printf("%d files in trace order\n", orderedFiles);
+	return 0;
+}
@@ -0,0 +1,22 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone tool, links with filesystem and system sources
+FILES_lzpacker:=lzpacker.cpp
+
+SRC_lzpacker:=$(addprefix $(d)/,$(FILES_lzpacker))
+DEPSRC_lzpacker=$(SRC_filesystem) $(SRC_system)
+
+TOOLS+=$(d)/lzpacker
+
+$(d)/lzpacker: $(SRC_lzpacker:.cpp=.o) $$(patsubst %.cpp,%.o,$$(DEPSRC_lzpacker))
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+CLEANDIRS+=$(d)
+
+-include $(foreach FILE,$(FILES_lzpacker),$(d)/$(FILE:.cpp=.d))
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
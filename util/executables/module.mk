@@ -0,0 +1,33 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Data preparation tools (lzpacker, s3dbaker, anmcompress), each one is
+# built as its own program out of SRC_<tool> and DEPSRC_<tool>
+# ("make tools" builds them)
+
+# (keeps the default goal of the including makefile)
+tools_default_goal:=$(.DEFAULT_GOAL)
+# (simple variable, the programs are added with their own $(d))
+TOOLS:=$(TOOLS)
+
+# DEPSRC_<tool> refers to modules that may be included after this one
+.SECONDEXPANSION:
+
+dir:=$(d)/lzpacker
+include $(TOPDIR)/$(dir)/module.mk
+dir:=$(d)/s3dbaker
+include $(TOPDIR)/$(dir)/module.mk
+dir:=$(d)/anmcompress
+include $(TOPDIR)/$(dir)/module.mk
+
+
+.PHONY: tools
+tools: $(TOOLS)
+
+.DEFAULT_GOAL:=$(tools_default_goal)
+
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
@@ -0,0 +1,22 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone tool, links with filesystem and system sources
+FILES_s3dbaker:=s3dbaker.cpp
+
+SRC_s3dbaker:=$(addprefix $(d)/,$(FILES_s3dbaker))
+DEPSRC_s3dbaker=$(SRC_filesystem) $(SRC_system)
+
+TOOLS+=$(d)/s3dbaker
+
+$(d)/s3dbaker: $(SRC_s3dbaker:.cpp=.o) $$(patsubst %.cpp,%.o,$$(DEPSRC_s3dbaker))
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+CLEANDIRS+=$(d)
+
+-include $(foreach FILE,$(FILES_s3dbaker),$(d)/$(FILE:.cpp=.d))
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
@@ -0,0 +1,12 @@
+#ifndef PRECOMPILED_H
+#define PRECOMPILED_H
+
+// (no precompiled headers support for s3dbaker.)
+
+#include <assert.h>
+#include <string.h>
+#include <memory>
+
+#include "../../../system/Logger.h"
+
+#endif
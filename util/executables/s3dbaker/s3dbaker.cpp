@@ -0,0 +1,581 @@
+#include "precompiled.h"
+
+// Copyright 2002-2004 Frozenbyte Ltd.
+
+// Bakes .s3d models into .s3b files (see storm3dv2/S3D_BakedModelFile.h)
+// which the model loader reads with one read instead of parsing field by field.
+//
+// Usage: s3dbaker <model.s3d | dir> [...]
+// Each model is written next to the original with .s3b extension. Models
+// loaded with geometry modifiers (foobar.s3d@MX etc.) still use the .s3d.
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <ctype.h>
+
+#include "../../../filesystem/file_package_manager.h"
+#include "../../../filesystem/standard_package.h"
+#include "../../../filesystem/ifile_list.h"
+#include "../../../filesystem/crc32.h"
+#include "../../../storm/storm3dv2/S3D_BakedModelFile.h"
+
+using namespace std;
+using namespace frozenbyte;
+
+namespace {
+
+	// IStorm3D_Helper::HTYPE
+	enum { HelperPoint = 0, HelperCamera = 3 };
+
+	// Little endian .s3d reader, stops at end of data
+	class Reader
+	{
+		const vector<unsigned char> &data;
+		unsigned int position;
+		bool failed;
+
+	public:
+		Reader(const vector<unsigned char> &data_)
+		:	data(data_),
+			position(0),
+			failed(false)
+		{
+		}
+
+		void read(void *buffer, unsigned int bytes)
+		{
+			if(failed || bytes > data.size() - position)
+			{
+				failed = true;
+				memset(buffer, 0, bytes);
+				return;
+			}
+
+			memcpy(buffer, &data[position], bytes);
+			position += bytes;
+		}
+
+		template<class T>
+		T get()
+		{
+			T value = T();
+			read(&value, sizeof(T));
+			return value;
+		}
+
+		void getFloats(float *buffer, int amount)
+		{
+			read(buffer, amount * sizeof(float));
+		}
+
+		string getString()
+		{
+			string result;
+			for(;;)
+			{
+				char c = get<char> ();
+				if(c == '\0' || failed)
+					break;
+
+				result += c;
+			}
+
+			return result;
+		}
+
+		void skip(unsigned int bytes)
+		{
+			if(failed || bytes > data.size() - position)
+				failed = true;
+			else
+				position += bytes;
+		}
+
+		bool hasFailed() const
+		{
+			return failed;
+		}
+	};
+
+	class BakedWriter
+	{
+		S3DB_HEADER header;
+		vector<S3DB_TEXTURE> textures;
+		vector<S3DB_MATERIAL> materials;
+		vector<S3DB_OBJECT> objects;
+		vector<S3DB_HELPER> helpers;
+		vector<char> strings;
+
+		// Offsets relative to data section, fixed when writing
+		vector<unsigned char> data;
+
+		template<class T>
+		static void append(vector<unsigned char> &buffer, const T *values, unsigned int amount)
+		{
+			const unsigned char *bytes = reinterpret_cast<const unsigned char *> (values);
+			buffer.insert(buffer.end(), bytes, bytes + amount * sizeof(T));
+		}
+
+		static void align(vector<unsigned char> &buffer)
+		{
+			while(buffer.size() % S3DB_ALIGNMENT)
+				buffer.push_back(0);
+		}
+
+	public:
+		BakedWriter()
+		{
+			memset(&header, 0, sizeof(header));
+			memcpy(header.id, S3DB_ID, 4);
+			header.version = S3DB_VERSION;
+
+			// Empty string at offset 0
+			strings.push_back('\0');
+		}
+
+		S3DB_HEADER &getHeader()
+		{
+			return header;
+		}
+
+		uint32_t addString(const string &string)
+		{
+			if(string.empty())
+				return 0;
+
+			uint32_t offset = strings.size();
+			strings.insert(strings.end(), string.begin(), string.end());
+			strings.push_back('\0');
+			return offset;
+		}
+
+		template<class T>
+		uint32_t addData(const vector<T> &values)
+		{
+			align(data);
+			uint32_t offset = data.size();
+			if(!values.empty())
+				append(data, &values[0], values.size());
+
+			return offset;
+		}
+
+		void addTexture(const S3DB_TEXTURE &texture) { textures.push_back(texture); }
+		void addMaterial(const S3DB_MATERIAL &material) { materials.push_back(material); }
+		void addObject(const S3DB_OBJECT &object) { objects.push_back(object); }
+		void addHelper(const S3DB_HELPER &helper) { helpers.push_back(helper); }
+
+		bool write(const string &fileName)
+		{
+			vector<unsigned char> result;
+			result.resize(sizeof(S3DB_HEADER));
+			align(result);
+
+			header.texture_amount = textures.size();
+			header.texture_offset = result.size();
+			if(!textures.empty())
+				append(result, &textures[0], textures.size());
+			align(result);
+
+			header.material_amount = materials.size();
+			header.material_offset = result.size();
+			if(!materials.empty())
+				append(result, &materials[0], materials.size());
+			align(result);
+
+			header.object_amount = objects.size();
+			header.object_offset = result.size();
+			unsigned int objectStart = result.size();
+			if(!objects.empty())
+				append(result, &objects[0], objects.size());
+			align(result);
+
+			header.helper_amount = helpers.size();
+			header.helper_offset = result.size();
+			unsigned int helperStart = result.size();
+			if(!helpers.empty())
+				append(result, &helpers[0], helpers.size());
+			align(result);
+
+			header.string_offset = result.size();
+			header.string_size = strings.size();
+			append(result, &strings[0], strings.size());
+			align(result);
+
+			// Relocate data references
+			uint32_t base = result.size();
+			header.data_offset = base;
+			for(unsigned int i = 0; i < objects.size(); ++i)
+			{
+				S3DB_OBJECT &object = *reinterpret_cast<S3DB_OBJECT *> (&result[objectStart + i * sizeof(S3DB_OBJECT)]);
+				object.vertex_offset += base;
+				object.weight_offset += base;
+				for(int j = 0; j < S3DB_LOD_AMOUNT; ++j)
+					object.face_offset[j] += base;
+			}
+			for(unsigned int i = 0; i < helpers.size(); ++i)
+			{
+				S3DB_HELPER &helper = *reinterpret_cast<S3DB_HELPER *> (&result[helperStart + i * sizeof(S3DB_HELPER)]);
+				helper.key_offset += base;
+			}
+
+			result.insert(result.end(), data.begin(), data.end());
+			header.file_size = result.size();
+			memcpy(&result[0], &header, sizeof(header));
+
+			FILE *fp = fopen(fileName.c_str(), "wb");
+			if(!fp)
+				return false;
+
+			bool ok = fwrite(&result[0], 1, result.size(), fp) == result.size();
+			if(fclose(fp) != 0)
+				ok = false;
+
+			return ok;
+		}
+	};
+
+	// Same rules as Storm3D_Model::LoadS3D, which only accepts versions 9+
+	bool bakeModel(const string &fileName, string &error)
+	{
+		vector<unsigned char> fileData;
+		{
+			FILE *fp = fopen(fileName.c_str(), "rb");
+			if(!fp)
+			{
+				error = "cannot open";
+				return false;
+			}
+
+			fseek(fp, 0, SEEK_END);
+			long size = ftell(fp);
+			fseek(fp, 0, SEEK_SET);
+
+			if(size > 0)
+			{
+				fileData.resize(size);
+				if(fread(&fileData[0], 1, size, fp) != size_t(size))
+					fileData.clear();
+			}
+
+			fclose(fp);
+		}
+
+		Reader reader(fileData);
+		BakedWriter writer;
+
+		char id[4] = { 0 };
+		reader.read(id, 4);
+		if(memcmp(id, "S3D", 3) != 0)
+		{
+			error = "not an s3d file";
+			return false;
+		}
+
+		int version = id[3] - '0';
+		if(version == 0)
+			version = reader.get<int> ();
+		if(version < 9)
+		{
+			error = "version too old";
+			return false;
+		}
+
+		int textureAmount = reader.get<uint16_t> ();
+		int materialAmount = reader.get<uint16_t> ();
+		int objectAmount = reader.get<uint16_t> ();
+		int lightAmount = reader.get<uint16_t> ();
+		int helperAmount = reader.get<uint16_t> ();
+
+		S3DB_HEADER &header = writer.getHeader();
+		header.source_version = version;
+		header.source_size = fileData.size();
+		header.source_crc = filesystem::calculateCrc32(&fileData[0], fileData.size());
+		header.bone_id = reader.get<int32_t> ();
+
+		for(int i = 0; i < textureAmount; ++i)
+		{
+			S3DB_TEXTURE texture;
+			texture.filename = writer.addString(reader.getString());
+			texture.identification = reader.get<uint32_t> ();
+			reader.skip(2 + 2 + 1); // start frame, frame change time, dynamic
+
+			writer.addTexture(texture);
+		}
+
+		for(int i = 0; i < materialAmount; ++i)
+		{
+			S3DB_MATERIAL material;
+			memset(&material, 0, sizeof(material));
+
+			material.name = writer.addString(reader.getString());
+			material.texture_base = reader.get<int16_t> ();
+			material.texture_base2 = reader.get<int16_t> ();
+			material.texture_bump = reader.get<int16_t> ();
+			material.texture_reflection = reader.get<int16_t> ();
+			material.texture_distortion = -1;
+			if(version >= 14)
+				material.texture_distortion = reader.get<int16_t> ();
+
+			reader.getFloats(material.color, 3);
+			reader.getFloats(material.self_illum, 3);
+			reader.getFloats(material.specular, 3);
+			material.specular_sharpness = reader.get<float> ();
+			material.doublesided = reader.get<uint8_t> ();
+			material.wireframe = reader.get<uint8_t> ();
+			material.reflection_texgen = reader.get<int32_t> ();
+			material.alphablend_type = reader.get<int32_t> ();
+			material.transparency = reader.get<float> ();
+
+			if(version >= 12)
+				material.glow = reader.get<float> ();
+			if(version >= 13)
+			{
+				reader.getFloats(material.scroll_speed, 2);
+				material.scroll_autostart = reader.get<char> () ? 1 : 0;
+			}
+
+			if(material.texture_base2 >= 0)
+			{
+				material.base2_blend_op = reader.get<int32_t> ();
+				material.base2_blend_factor = reader.get<float> ();
+			}
+			if(material.texture_reflection >= 0)
+			{
+				material.reflection_blend_op = reader.get<int32_t> ();
+				material.reflection_blend_factor = reader.get<float> ();
+			}
+
+			const int16_t textureIndices[] = { material.texture_base, material.texture_base2, material.texture_bump, material.texture_reflection, material.texture_distortion };
+			for(int j = 0; j < 5; ++j)
+			{
+				if(textureIndices[j] >= textureAmount)
+				{
+					error = "invalid texture index";
+					return false;
+				}
+			}
+
+			writer.addMaterial(material);
+		}
+
+		for(int i = 0; i < objectAmount; ++i)
+		{
+			S3DB_OBJECT object;
+			memset(&object, 0, sizeof(object));
+
+			object.name = writer.addString(reader.getString());
+			object.parent = writer.addString(reader.getString());
+			object.material_index = reader.get<int16_t> ();
+			reader.getFloats(object.position, 3);
+			reader.getFloats(object.rotation, 4);
+			reader.getFloats(object.scale, 3);
+
+			object.no_collision = reader.get<char> () == 1 ? 1 : 0;
+			object.no_render = reader.get<char> () == 1 ? 1 : 0;
+			if(version >= 11)
+				object.light_object = reader.get<char> () == 1 ? 1 : 0;
+
+			int vertexAmount = reader.get<uint16_t> ();
+			int faceAmount = reader.get<uint16_t> ();
+			if(version >= 10)
+				object.has_lods = reader.get<char> () != 0 ? 1 : 0;
+			object.has_weights = reader.get<char> () == 1 ? 1 : 0;
+
+			if(object.material_index >= materialAmount)
+			{
+				error = "invalid material index";
+				return false;
+			}
+
+			vector<S3DB_VERTEX> vertices(vertexAmount);
+			for(int j = 0; j < vertexAmount; ++j)
+				reader.getFloats(&vertices[j].position[0], 10);
+
+			vector<S3DB_FACE> faces(faceAmount);
+			for(int j = 0; j < faceAmount; ++j)
+			{
+				for(int k = 0; k < 3; ++k)
+				{
+					faces[j].vertex[k] = reader.get<uint16_t> ();
+					if(faces[j].vertex[k] >= uint32_t(vertexAmount))
+					{
+						error = "invalid face";
+						return false;
+					}
+				}
+			}
+
+			object.vertex_amount = vertexAmount;
+			object.vertex_offset = writer.addData(vertices);
+			object.face_amount[0] = faceAmount;
+			object.face_offset[0] = writer.addData(faces);
+
+			if(object.has_lods)
+			{
+				for(int lod = 1; lod < S3DB_LOD_AMOUNT; ++lod)
+				{
+					vector<S3DB_FACE> lodFaces(reader.get<uint16_t> ());
+					for(unsigned int j = 0; j < lodFaces.size(); ++j)
+					{
+						for(int k = 0; k < 3; ++k)
+						{
+							lodFaces[j].vertex[k] = reader.get<uint16_t> ();
+							if(lodFaces[j].vertex[k] >= uint32_t(vertexAmount))
+							{
+								error = "invalid lod face";
+								return false;
+							}
+						}
+					}
+
+					object.face_amount[lod] = lodFaces.size();
+					object.face_offset[lod] = writer.addData(lodFaces);
+				}
+			}
+
+			if(object.has_weights)
+			{
+				vector<S3DB_WEIGHT> weights(vertexAmount);
+				for(int j = 0; j < vertexAmount; ++j)
+				{
+					memset(&weights[j], 0, sizeof(S3DB_WEIGHT));
+					weights[j].index1 = reader.get<int32_t> ();
+					weights[j].index2 = reader.get<int32_t> ();
+					weights[j].weight1 = reader.get<uint8_t> ();
+					weights[j].weight2 = reader.get<uint8_t> ();
+				}
+
+				object.weight_offset = writer.addData(weights);
+			}
+
+			writer.addObject(object);
+		}
+
+		// Lights are not used by the loader, their keys are not stored either
+		for(int i = 0; i < lightAmount; ++i)
+		{
+			reader.getString();
+			reader.getString();
+			reader.skip(4 + 4 + 3 * 4 * 3 + 4 * 4 + 4 + 2 * 4);
+		}
+
+		for(int i = 0; i < helperAmount; ++i)
+		{
+			S3DB_HELPER helper;
+			memset(&helper, 0, sizeof(helper));
+
+			helper.name = writer.addString(reader.getString());
+			helper.parent = writer.addString(reader.getString());
+			helper.helper_type = reader.get<int32_t> ();
+			reader.getFloats(helper.position, 3);
+			reader.getFloats(helper.other, 3);
+			reader.getFloats(helper.other2, 3);
+			helper.keyframe_endtime = reader.get<int32_t> ();
+
+			int positionKeys = reader.get<uint16_t> ();
+			int other1Keys = reader.get<uint16_t> ();
+			int other2Keys = reader.get<uint16_t> ();
+
+			if(helper.helper_type < HelperPoint || helper.helper_type > 4)
+			{
+				error = "invalid helper type";
+				return false;
+			}
+
+			// Same keys the loader reads
+			if(helper.helper_type == HelperPoint)
+				other1Keys = 0;
+			if(helper.helper_type != HelperCamera)
+				other2Keys = 0;
+
+			vector<S3DB_KEY> keys(positionKeys + other1Keys + other2Keys);
+			for(unsigned int j = 0; j < keys.size(); ++j)
+			{
+				keys[j].keytime = reader.get<int32_t> ();
+				reader.getFloats(keys[j].value, 3);
+			}
+
+			helper.poskey_amount = positionKeys;
+			helper.o1key_amount = other1Keys;
+			helper.o2key_amount = other2Keys;
+			helper.key_offset = writer.addData(keys);
+
+			writer.addHelper(helper);
+		}
+
+		if(reader.hasFailed())
+		{
+			error = "unexpected end of file";
+			return false;
+		}
+
+		string bakedName = fileName;
+		bakedName[bakedName.size() - 1] = 'b';
+		if(!writer.write(bakedName))
+		{
+			error = "cannot write " + bakedName;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool isModel(const string &fileName)
+	{
+		if(fileName.size() < 4)
+			return false;
+
+		string extension = fileName.substr(fileName.size() - 4);
+		for(unsigned int i = 0; i < extension.size(); ++i)
+			extension[i] = tolower(extension[i]);
+
+		return extension == ".s3d";
+	}
+
+} // unnamed
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		printf("Usage: s3dbaker <model.s3d | dir> [...]\n");
+		return 1;
+	}
+
+	filesystem::FilePackageManager &manager = filesystem::FilePackageManager::getInstance();
+	std::shared_ptr<filesystem::IFilePackage> standardPackage(new filesystem::StandardPackage());
+	manager.addPackage(standardPackage, 999);
+
+	vector<string> files;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(isModel(argv[i]))
+		{
+			files.push_back(argv[i]);
+			continue;
+		}
+
+		std::shared_ptr<filesystem::IFileList> fileList = manager.findFiles(argv[i], "*.s3d");
+		filesystem::getAllFiles(*fileList, argv[i], files, true);
+	}
+
+	int baked = 0;
+	int failed = 0;
+	for(unsigned int i = 0; i < files.size(); ++i)
+	{
+		string error;
+		if(bakeModel(files[i], error))
+			++baked;
+		else
+		{
+			// Old versions are simply left to the .s3d loader
+			printf("Skipped %s (%s)\n", files[i].c_str(), error.c_str());
+			++failed;
+		}
+	}
+
+	printf("%d models baked, %d skipped\n", baked, failed);
+	return 0;
+}
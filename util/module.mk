@@ -3,6 +3,12 @@ dirstack_$(sp) := $(d)
 d              := $(dir)
 
 
+dir:=$(d)/tests
+include $(TOPDIR)/$(dir)/module.mk
+dir:=$(d)/executables
+include $(TOPDIR)/$(dir)/module.mk
+
+
 FILES:=AI_PathFind.cpp AreaMap.cpp assert.cpp BuildingHandler.cpp \
        BuildingMap.cpp CircleAreaTracker.cpp ClippedCircle.cpp ColorMap.cpp \
 	   CursorRayTracer.cpp Dampers.cpp DecalManager.cpp DecalSpawner.cpp \
@@ -18,7 +24,7 @@ FILES:=AI_PathFind.cpp AreaMap.cpp assert.cpp BuildingHandler.cpp \
 	   ScriptManager.cpp ScriptProcess.cpp SelfIlluminationChanger.cpp \
 	   SimpleParser.cpp SoundMaterialParser.cpp SpotLightCalculator.cpp \
 	   StringUtil.cpp TextFileModifier.cpp TextFinder.cpp TextureCache.cpp \
-	   TextureSwitcher.cpp UberCrypt.cpp UnicodeConverter.cpp \
+	   TextureReader.cpp TextureSwitcher.cpp UberCrypt.cpp UnicodeConverter.cpp \
 	   Debug_MemoryManager.cpp CheckedIntValue.cpp jpak.cpp
 
 
@@ -0,0 +1,206 @@
+
+// Checks Storm3D_CollisionBvh against brute force and times both.
+//
+// Usage: collisionbvhtest [triangles] [rays]
+// Returns 0 if all ray and sphere queries match.
+
+#include "../../../storm/storm3dv2/Storm3D_CollisionBvh.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+	typedef std::chrono::steady_clock TestClock;
+
+	float randomFloat()
+	{
+		return rand() / float(RAND_MAX);
+	}
+
+	VC3 randomOffset()
+	{
+		return VC3(randomFloat() - 0.5f, randomFloat() - 0.5f, randomFloat() - 0.5f);
+	}
+
+	double getMilliseconds(const TestClock::time_point &start, const TestClock::time_point &end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	// Reference per-triangle test (one sided, 0 < range < max)
+	int bruteRayTrace(const std::vector<Storm3D_CollisionBvh::Triangle> &triangles, const VC3 &position, const VC3 &direction, float maxRange, float &range)
+	{
+		int result = -1;
+		for(unsigned int i = 0; i < triangles.size(); ++i)
+		{
+			const Storm3D_CollisionBvh::Triangle &t = triangles[i];
+			VC3 edge1 = t.vertex1 - t.vertex0;
+			VC3 edge2 = t.vertex2 - t.vertex0;
+
+			VC3 p = direction.GetCrossWith(edge2);
+			float det = edge1.GetDotWith(p);
+			if(det < 0.0001f)
+				continue;
+
+			VC3 s = position - t.vertex0;
+			float u = s.GetDotWith(p);
+			if(u < 0 || u > det)
+				continue;
+
+			VC3 q = s.GetCrossWith(edge1);
+			float v = direction.GetDotWith(q);
+			if(v < 0 || u + v > det)
+				continue;
+
+			float hitRange = edge2.GetDotWith(q) / det;
+			if(hitRange > 0 && hitRange < maxRange && hitRange < range)
+			{
+				range = hitRange;
+				result = t.id;
+			}
+		}
+
+		return result;
+	}
+
+	bool boxTouchesSphere(const Storm3D_CollisionBvh::Triangle &t, const VC3 &position, float radius)
+	{
+		VC3 minimum(std::min(t.vertex0.x, std::min(t.vertex1.x, t.vertex2.x)), std::min(t.vertex0.y, std::min(t.vertex1.y, t.vertex2.y)), std::min(t.vertex0.z, std::min(t.vertex1.z, t.vertex2.z)));
+		VC3 maximum(std::max(t.vertex0.x, std::max(t.vertex1.x, t.vertex2.x)), std::max(t.vertex0.y, std::max(t.vertex1.y, t.vertex2.y)), std::max(t.vertex0.z, std::max(t.vertex1.z, t.vertex2.z)));
+
+		VC3 closest(std::max(minimum.x, std::min(position.x, maximum.x)), std::max(minimum.y, std::min(position.y, maximum.y)), std::max(minimum.z, std::min(position.z, maximum.z)));
+		// small margin, boxes on the sphere surface may go either way
+		return (position - closest).GetSquareLength() < radius * radius * 0.999f;
+	}
+
+	class CollectVisitor: public Storm3D_CollisionBvh::SphereVisitor
+	{
+	public:
+		std::vector<int> ids;
+
+		float visit(int id, float radius)
+		{
+			ids.push_back(id);
+			return radius;
+		}
+	};
+
+} // unnamed
+
+int main(int argc, char **argv)
+{
+	int triangleAmount = (argc > 1) ? atoi(argv[1]) : 20000;
+	int rayAmount = (argc > 2) ? atoi(argv[2]) : 3000;
+	srand(1);
+
+	// Mostly flat ground-like layer with some taller clutter
+	std::vector<Storm3D_CollisionBvh::Triangle> triangles;
+	for(int i = 0; i < triangleAmount; ++i)
+	{
+		VC3 center(randomFloat() * 40, randomFloat() * ((i % 3) ? 2 : 30), randomFloat() * 40);
+
+		Storm3D_CollisionBvh::Triangle t;
+		t.vertex0 = center;
+		t.vertex1 = center + randomOffset();
+		t.vertex2 = center + randomOffset();
+		t.id = i;
+		triangles.push_back(t);
+	}
+
+	Storm3D_CollisionBvh bvh;
+	bvh.build(triangles);
+	printf("%d triangles, bvh memory %u bytes\n", triangleAmount, bvh.getMemoryUsage());
+
+	int rayErrors = 0;
+	int hits = 0;
+	double bruteTime = 0;
+	double bvhTime = 0;
+	for(int i = 0; i < rayAmount; ++i)
+	{
+		VC3 position(randomFloat() * 40, randomFloat() * 30, randomFloat() * 40);
+		VC3 direction = randomOffset();
+		// axis aligned rays hit the zero direction component paths
+		if(i % 10 == 0)
+			direction = VC3(1, 0, 0);
+		direction.Normalize();
+		float maxRange = randomFloat() * 60;
+
+		TestClock::time_point start = TestClock::now();
+		float bruteRange = 1e30f;
+		int bruteId = bruteRayTrace(triangles, position, direction, maxRange, bruteRange);
+		TestClock::time_point middle = TestClock::now();
+		float bvhRange = 0;
+		int bvhId = bvh.rayTrace(position, direction, maxRange, bvhRange);
+		TestClock::time_point end = TestClock::now();
+
+		bruteTime += getMilliseconds(start, middle);
+		bvhTime += getMilliseconds(middle, end);
+
+		if(bruteId >= 0)
+			++hits;
+
+		// equal range on different triangle is a tie, either is fine
+		bool same = (bruteId == bvhId) || (bruteId >= 0 && bvhId >= 0 && fabsf(bruteRange - bvhRange) < 1e-5f);
+		if(!same)
+		{
+			if(rayErrors < 5)
+				printf("ray %d: brute force %d (%f), bvh %d (%f)\n", i, bruteId, bruteRange, bvhId, bvhRange);
+			++rayErrors;
+		}
+	}
+
+	printf("%d rays, %d hits, %d mismatches\n", rayAmount, hits, rayErrors);
+	printf("brute force %.3f ms, bvh %.3f ms\n", bruteTime, bvhTime);
+
+	// Every triangle whose bounds touch the sphere must be visited
+	int sphereErrors = 0;
+	for(int i = 0; i < 200; ++i)
+	{
+		VC3 position(randomFloat() * 40, randomFloat() * 30, randomFloat() * 40);
+		float radius = randomFloat() * 2;
+
+		CollectVisitor visitor;
+		bvh.sphereQuery(position, radius, visitor);
+
+		std::vector<char> visited(triangles.size());
+		for(unsigned int j = 0; j < visitor.ids.size(); ++j)
+			visited[visitor.ids[j]] = 1;
+
+		for(unsigned int j = 0; j < triangles.size(); ++j)
+		{
+			if(!visited[j] && boxTouchesSphere(triangles[j], position, radius))
+				++sphereErrors;
+		}
+	}
+
+	printf("200 spheres, %d missed triangles\n", sphereErrors);
+
+	// Tree smaller than one packet
+	std::vector<Storm3D_CollisionBvh::Triangle> small(triangles.begin(), triangles.begin() + 3);
+	Storm3D_CollisionBvh smallBvh;
+	smallBvh.build(small);
+
+	float smallRange = 0;
+	int smallId = smallBvh.rayTrace(small[0].vertex0 + VC3(0, 5, 0), VC3(0, -1, 0), 100, smallRange);
+	float bruteSmallRange = 1e30f;
+	int bruteSmallId = bruteRayTrace(small, small[0].vertex0 + VC3(0, 5, 0), VC3(0, -1, 0), 100, bruteSmallRange);
+	if(smallId != bruteSmallId)
+	{
+		printf("small tree: brute force %d, bvh %d\n", bruteSmallId, smallId);
+		++rayErrors;
+	}
+
+	if(rayErrors > 0 || sphereErrors > 0)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,22 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone test, checks Storm3D_CollisionBvh against brute force
+FILES_collisionbvhtest:=collisionbvhtest.cpp
+
+SRC_collisionbvhtest:=$(addprefix $(d)/,$(FILES_collisionbvhtest)) \
+                      storm/storm3dv2/Storm3D_CollisionBvh.cpp
+
+TESTS+=$(d)/collisionbvhtest
+
+$(d)/collisionbvhtest: $(SRC_collisionbvhtest:.cpp=.o)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+CLEANDIRS+=$(d)
+
+-include $(foreach FILE,$(FILES_collisionbvhtest),$(d)/$(FILE:.cpp=.d))
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
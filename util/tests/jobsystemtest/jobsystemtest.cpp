@@ -0,0 +1,204 @@
+// Checks JobSystem results with different worker amounts and times
+// parallelFor against a serial loop.
+//
+// Usage: jobsystemtest [max workers]
+// Returns 0 if every check passed.
+
+#include "../../../game/JobSystem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace game;
+
+namespace {
+
+	typedef std::chrono::steady_clock TestClock;
+
+	double getMilliseconds(const TestClock::time_point &start, const TestClock::time_point &end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	double work(int i)
+	{
+		double x = i;
+		for (int k = 0; k < 200; k++)
+			x = x * 1.0000001 + 0.5;
+		return x;
+	}
+
+	int failures = 0;
+
+	void check(bool ok, int workers, const char *what)
+	{
+		if (!ok)
+		{
+			printf("FAILED (%d workers): %s\n", workers, what);
+			failures++;
+		}
+	}
+
+	void testParallelFor(JobSystem &jobs, int workers)
+	{
+		const int amount = 100000;
+		const int rounds = 20;
+
+		// same chunk function for both, so only the job overhead and
+		// the parallelism differ
+		std::vector<double> reference(amount);
+		std::vector<double> result(amount);
+		int round = 0;
+		JobSystem::ParallelForFunction serialFunction = [&reference, &round](int start, int end, int)
+		{
+			for (int i = start; i < end; i++)
+				reference[i] = work(i + round);
+		};
+		JobSystem::ParallelForFunction parallelFunction = [&result, &round](int start, int end, int)
+		{
+			for (int i = start; i < end; i++)
+				result[i] = work(i + round);
+		};
+
+		TestClock::time_point serialStart = TestClock::now();
+		for (round = 0; round < rounds; round++)
+			serialFunction(0, amount, 0);
+		TestClock::time_point serialEnd = TestClock::now();
+
+		TestClock::time_point parallelStart = TestClock::now();
+		for (round = 0; round < rounds; round++)
+			jobs.parallelFor(0, amount, 256, parallelFunction);
+		TestClock::time_point parallelEnd = TestClock::now();
+
+		check(result == reference, workers, "parallelFor results differ from serial loop");
+
+		printf("%d workers: serial %.1f ms, parallelFor %.1f ms\n", workers,
+			getMilliseconds(serialStart, serialEnd), getMilliseconds(parallelStart, parallelEnd));
+	}
+
+	void testChunks(JobSystem &jobs, int workers)
+	{
+		const int amount = 100000;
+		int chunkAmount = JobSystem::getChunkAmount(0, amount, 1000);
+		check(chunkAmount == 100, workers, "chunk amount");
+		check(JobSystem::getChunkAmount(0, 1001, 1000) == 2, workers, "partial chunk amount");
+		check(JobSystem::getChunkAmount(5, 5, 10) == 0, workers, "empty range chunk amount");
+
+		// per chunk results, merged in chunk order
+		std::vector<long long> sums(chunkAmount, -1);
+		jobs.parallelFor(0, amount, 1000, [&sums](int start, int end, int chunk)
+		{
+			long long sum = 0;
+			for (int i = start; i < end; i++)
+				sum += i;
+			sums[chunk] = sum;
+		});
+
+		bool chunksOk = true;
+		long long total = 0;
+		for (int i = 0; i < chunkAmount; i++)
+		{
+			long long first = i * 1000LL;
+			if (sums[i] != first * 1000 + 999 * 1000 / 2)
+				chunksOk = false;
+			total += sums[i];
+		}
+		check(chunksOk, workers, "chunk boundaries");
+		check(total == (long long)amount * (amount - 1) / 2, workers, "chunk sum");
+	}
+
+	void testDependencies(JobSystem &jobs, int workers)
+	{
+		std::atomic<int> stage(0);
+		std::atomic<int> wrongOrder(0);
+
+		for (int r = 0; r < 2000; r++)
+		{
+			JobCounter first;
+			JobCounter second;
+			JobCounter third;
+			stage = 0;
+
+			for (int k = 0; k < 8; k++)
+				jobs.addJob([&]() { if (stage.load() != 0) wrongOrder++; }, &first);
+			jobs.addJob([&]() { stage = 1; }, &second, &first);
+			for (int k = 0; k < 4; k++)
+				jobs.addJob([&]() { if (stage.load() != 1) wrongOrder++; }, &third, &second);
+
+			jobs.wait(&third);
+			jobs.wait(&first);
+			jobs.wait(&second);
+		}
+
+		check(wrongOrder.load() == 0, workers, "dependent jobs started early");
+	}
+
+	void testNested(JobSystem &jobs, int workers)
+	{
+		std::atomic<long long> sum(0);
+		jobs.parallelFor(0, 16, 1, [&](int, int, int)
+		{
+			jobs.parallelFor(0, 1000, 100, [&sum](int start, int end, int)
+			{
+				for (int i = start; i < end; i++)
+					sum += i;
+			});
+		});
+
+		check(sum.load() == 16LL * 999 * 1000 / 2, workers, "nested parallelFor");
+	}
+
+	// waiting for a slow job must sleep, not spin
+	void testWaitSleeps(JobSystem &jobs, int workers)
+	{
+		if (workers == 0)
+			return;
+
+		JobCounter counter;
+		clock_t cpuStart = clock();
+		TestClock::time_point start = TestClock::now();
+
+		jobs.addJob([]() { std::this_thread::sleep_for(std::chrono::milliseconds(200)); }, &counter);
+		// (let a worker take it, so that wait has nothing to run)
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		jobs.wait(&counter);
+
+		double cpu = double(clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+		double wall = getMilliseconds(start, TestClock::now());
+		printf("%d workers: waited %.1f ms for a sleeping job, %.1f ms cpu\n", workers, wall, cpu);
+	}
+
+} // unnamed
+
+int main(int argc, char **argv)
+{
+	int maxWorkers = (argc > 1) ? atoi(argv[1]) : 7;
+
+	for (int workers = 0; workers <= maxWorkers; workers = (workers == 0) ? 1 : workers * 2 + 1)
+	{
+		JobSystem jobs(workers);
+		check(jobs.getWorkerAmount() == workers, workers, "worker amount");
+
+		testParallelFor(jobs, workers);
+		testChunks(jobs, workers);
+		testDependencies(jobs, workers);
+		testNested(jobs, workers);
+		testWaitSleeps(jobs, workers);
+
+		printf("%d workers: %d jobs, %d steals\n", workers, jobs.getJobAmount(), jobs.getStealAmount());
+	}
+
+	if (failures > 0)
+	{
+		printf("FAILED: %d checks\n", failures);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
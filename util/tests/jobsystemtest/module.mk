@@ -0,0 +1,22 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone test, checks JobSystem results and times parallelFor
+FILES_jobsystemtest:=jobsystemtest.cpp
+
+SRC_jobsystemtest:=$(addprefix $(d)/,$(FILES_jobsystemtest)) \
+                   game/JobSystem.cpp
+
+TESTS+=$(d)/jobsystemtest
+
+$(d)/jobsystemtest: $(SRC_jobsystemtest:.cpp=.o)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS) -pthread
+
+CLEANDIRS+=$(d)
+
+-include $(foreach FILE,$(FILES_jobsystemtest),$(d)/$(FILE:.cpp=.d))
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
@@ -0,0 +1,9 @@
+#ifndef PRECOMPILED_H
+#define PRECOMPILED_H
+
+// (no precompiled headers support for jobsystemtest.)
+
+#include <assert.h>
+#include <string.h>
+
+#endif
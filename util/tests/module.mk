@@ -0,0 +1,37 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone test programs, each one is built out of SRC_<test>
+# ("make tests" builds them, "make check" also runs them)
+
+# (keeps the default goal of the including makefile)
+tests_default_goal:=$(.DEFAULT_GOAL)
+# (simple variable, the programs are added with their own $(d))
+TESTS:=$(TESTS)
+
+dir:=$(d)/collisionbvhtest
+include $(TOPDIR)/$(dir)/module.mk
+
+dir:=$(d)/unitlistgridtest
+include $(TOPDIR)/$(dir)/module.mk
+
+dir:=$(d)/jobsystemtest
+include $(TOPDIR)/$(dir)/module.mk
+
+dir:=$(d)/texturereadertest
+include $(TOPDIR)/$(dir)/module.mk
+
+
+.PHONY: tests check
+tests: $(TESTS)
+
+check: tests
+	@for test in $(TESTS); do echo "$$test"; ./$$test || exit 1; done
+
+.DEFAULT_GOAL:=$(tests_default_goal)
+
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
@@ -0,0 +1,23 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone test, checks TextureReader request/take bookkeeping
+FILES_texturereadertest:=texturereadertest.cpp
+
+SRC_texturereadertest:=$(addprefix $(d)/,$(FILES_texturereadertest)) \
+                       util/TextureReader.cpp
+DEPSRC_texturereadertest=$(SRC_filesystem) $(SRC_system)
+
+TESTS+=$(d)/texturereadertest
+
+$(d)/texturereadertest: $(SRC_texturereadertest:.cpp=.o) $$(patsubst %.cpp,%.o,$$(DEPSRC_texturereadertest))
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS) -pthread
+
+CLEANDIRS+=$(d)
+
+-include $(foreach FILE,$(FILES_texturereadertest),$(d)/$(FILE:.cpp=.d))
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
@@ -0,0 +1,191 @@
+// Checks TextureReader request/take bookkeeping, mainly that a file taken
+// with take() and then requested again comes out of takeFinished() only
+// once its new read is done (and with the file data).
+//
+// Usage: texturereadertest [rounds]
+// Writes its test files to the current directory and removes them.
+// Returns 0 if every check passed.
+
+#include "../../TextureReader.h"
+#include "../../../filesystem/file_package_manager.h"
+#include "../../../filesystem/standard_package.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+using namespace frozenbyte;
+
+namespace {
+
+	const int FILE_AMOUNT = 4;
+	// large enough for a read to be still in progress when checked
+	const int FILE_SIZE = 4 * 1024 * 1024;
+
+	int failures = 0;
+
+	void check(bool ok, const char *what)
+	{
+		if (!ok)
+		{
+			printf("FAILED: %s\n", what);
+			failures++;
+		}
+	}
+
+	std::string getFileName(int i)
+	{
+		char buf[64];
+		sprintf(buf, "texturereadertest_%d.tmp", i);
+		return buf;
+	}
+
+	bool writeFile(const std::string &fileName, char fill)
+	{
+		FILE *f = fopen(fileName.c_str(), "wb");
+		if (!f)
+			return false;
+
+		std::vector<char> data(FILE_SIZE, fill);
+		bool ok = fwrite(&data[0], 1, data.size(), f) == data.size();
+		fclose(f);
+		return ok;
+	}
+
+	bool hasContent(const std::vector<char> &data, char fill)
+	{
+		if (data.size() != FILE_SIZE)
+			return false;
+		return data.front() == fill && data.back() == fill;
+	}
+
+	// Takes finished reads until the given one shows up, fails on any other
+	bool waitFinished(TextureReader &reader, const std::string &fileName, std::vector<char> &result)
+	{
+		std::string finishedName;
+		while (true)
+		{
+			if (reader.takeFinished(finishedName, result))
+				return finishedName == fileName;
+			if (reader.getRequestAmount() == 0)
+				return false;
+		}
+	}
+
+	void testRequestAll(TextureReader &reader)
+	{
+		for (int i = 0; i < FILE_AMOUNT; i++)
+			reader.request(getFileName(i));
+		// duplicate request is ignored
+		reader.request(getFileName(0));
+
+		std::vector<bool> seen(FILE_AMOUNT, false);
+		std::string fileName;
+		std::vector<char> data;
+		int taken = 0;
+		while (reader.getRequestAmount() > 0)
+		{
+			if (!reader.takeFinished(fileName, data))
+				continue;
+
+			for (int i = 0; i < FILE_AMOUNT; i++)
+			{
+				if (fileName != getFileName(i))
+					continue;
+
+				check(!seen[i], "file finished twice");
+				check(hasContent(data, char('a' + i)), "finished read has file data");
+				seen[i] = true;
+			}
+			taken++;
+		}
+
+		check(taken == FILE_AMOUNT, "every requested file finished once");
+		check(!reader.takeFinished(fileName, data), "nothing finished after all taken");
+	}
+
+	void testTakeThenRequestAgain(TextureReader &reader)
+	{
+		std::string fileName = getFileName(1);
+		std::vector<char> data;
+
+		reader.request(fileName);
+		check(reader.take(fileName, data), "take finds the request");
+		check(hasContent(data, 'b'), "take has file data");
+
+		// new read of the same file, the one taken above must not
+		// be handed out for it
+		reader.request(fileName);
+		check(waitFinished(reader, fileName, data), "re-requested file finishes");
+		check(hasContent(data, 'b'), "re-requested read has file data");
+
+		std::string finishedName;
+		check(!reader.takeFinished(finishedName, data), "re-requested file finishes only once");
+		check(reader.getRequestAmount() == 0, "no reads left");
+	}
+
+	void testAddFinished(TextureReader &reader)
+	{
+		std::string fileName = getFileName(2);
+		std::vector<char> data;
+
+		// caller has the data already, only the name comes back
+		reader.addFinished(fileName);
+		check(reader.take(fileName, data), "take finds added file");
+		check(data.empty(), "added file has no data");
+
+		reader.request(fileName);
+		check(waitFinished(reader, fileName, data), "added, taken and re-requested file finishes");
+		check(hasContent(data, 'c'), "added, taken and re-requested read has file data");
+		check(reader.getRequestAmount() == 0, "no reads left after added file");
+	}
+
+}
+
+int main(int argc, char *argv[])
+{
+	int rounds = 20;
+	if (argc > 1)
+		rounds = atoi(argv[1]);
+
+	filesystem::FilePackageManager &manager = filesystem::FilePackageManager::getInstance();
+	std::shared_ptr<filesystem::IFilePackage> standardPackage(new filesystem::StandardPackage());
+	manager.addPackage(standardPackage, 999);
+
+	for (int i = 0; i < FILE_AMOUNT; i++)
+	{
+		if (!writeFile(getFileName(i), char('a' + i)))
+		{
+			printf("Could not write test file %s\n", getFileName(i).c_str());
+			return 1;
+		}
+	}
+
+	{
+		TextureReader reader;
+		check(reader.getRequestAmount() == 0, "new reader has no requests");
+
+		std::vector<char> data;
+		check(!reader.take(getFileName(0), data), "take of unrequested file fails");
+
+		for (int i = 0; i < rounds; i++)
+		{
+			testRequestAll(reader);
+			testTakeThenRequestAgain(reader);
+			testAddFinished(reader);
+		}
+	}
+
+	for (int i = 0; i < FILE_AMOUNT; i++)
+		remove(getFileName(i).c_str());
+
+	if (failures > 0)
+	{
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	printf("All checks passed (%d rounds)\n", rounds);
+	return 0;
+}
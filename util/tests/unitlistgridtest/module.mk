@@ -0,0 +1,22 @@
+sp             := $(sp).x
+dirstack_$(sp) := $(d)
+d              := $(dir)
+
+
+# Standalone test, checks UnitListGrid against brute force and the quadtree
+FILES_unitlistgridtest:=unitlistgridtest.cpp
+
+SRC_unitlistgridtest:=$(addprefix $(d)/,$(FILES_unitlistgridtest)) \
+                      game/UnitListGrid.cpp
+
+TESTS+=$(d)/unitlistgridtest
+
+$(d)/unitlistgridtest: $(SRC_unitlistgridtest:.cpp=.o)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+CLEANDIRS+=$(d)
+
+-include $(foreach FILE,$(FILES_unitlistgridtest),$(d)/$(FILE:.cpp=.d))
+
+d  := $(dirstack_$(sp))
+sp := $(basename $(sp))
@@ -0,0 +1,239 @@
+// Checks UnitListGrid queries against brute force and times the grid
+// against the unit quadtree.
+//
+// Usage: unitlistgridtest [units] [ticks]
+// Returns 0 if the grid gave every unit a brute force test found.
+
+#include <DatatypeDef.h>
+#include <Storm3D_Datatypes.h>
+#include <c2_aabb.h>
+#include <c2_collisioninfo.h>
+#include <c2_qtree.h>
+
+#include "../../../game/UnitListGrid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+// same as UnitList
+#define UNIT_GRID_MOVE_SLACK 0.5f
+#define UNIT_QTREE_UPDATE_TRESHOLD 0.5f
+
+namespace game {
+
+	// Just what the grid and the quadtree need, same collision rule
+	// as the real Unit
+	class Unit
+	{
+	public:
+		VC3 position;
+		VC3 velocity;
+		float unitListRadius;
+
+		void SphereCollision(const VC3 &position, float radius, Storm3D_CollisionInfo &info, bool) const
+		{
+			VC3 diff = this->position - position;
+			float maxRadius = unitListRadius + radius;
+			info.hit = (diff.GetSquareLength() <= maxRadius);
+		}
+
+		void RayTrace(const VC3 &, const VC3 &, float, Storm3D_CollisionInfo &, bool) const
+		{
+		}
+
+		bool fits(const AABB &) const
+		{
+			return false;
+		}
+	};
+
+} // game
+
+using namespace game;
+
+namespace {
+
+	typedef std::chrono::steady_clock TestClock;
+
+	float randomFloat(float min, float max)
+	{
+		return min + (max - min) * (rand() / float(RAND_MAX));
+	}
+
+	double getMilliseconds(const TestClock::time_point &start, const TestClock::time_point &end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	bool hits(const Unit *unit, const VC3 &position, float radius)
+	{
+		Storm3D_CollisionInfo info;
+		unit->SphereCollision(position, radius, info, true);
+		return info.hit;
+	}
+
+	struct Collector
+	{
+		std::vector<Unit *> &result;
+		const VC3 &position;
+		float radius;
+		bool testSphere;
+
+		Collector(std::vector<Unit *> &result_, const VC3 &position_, float radius_, bool testSphere_)
+		:	result(result_),
+			position(position_),
+			radius(radius_),
+			testSphere(testSphere_)
+		{
+		}
+
+		void operator() (Unit *unit)
+		{
+			if (!testSphere || hits(unit, position, radius))
+				result.push_back(unit);
+		}
+	};
+
+} // unnamed
+
+int main(int argc, char **argv)
+{
+	int unitAmount = (argc > 1) ? atoi(argv[1]) : 600;
+	int ticks = (argc > 2) ? atoi(argv[2]) : 500;
+	if (unitAmount < 1 || ticks < 1)
+	{
+		printf("usage: unitlistgridtest [units] [ticks]\n");
+		return 1;
+	}
+
+	const float area = 256.0f;
+	const float queryRadii[3] = { 35.0f, 30.0f, 10.0f };
+
+	srand(1);
+	std::vector<Unit> units(unitAmount);
+	for (int i = 0; i < unitAmount; i++)
+	{
+		units[i].position = VC3(randomFloat(-area / 2, area / 2), 0, randomFloat(-area / 2, area / 2));
+		units[i].velocity = VC3(randomFloat(-0.3f, 0.3f), 0, randomFloat(-0.3f, 0.3f));
+		// a few big ones, these widen every grid query
+		units[i].unitListRadius = (i % 50 == 0) ? 8.0f : 2.0f;
+	}
+
+	Quadtree<Unit> tree(VC2(-area, -area), VC2(area, area));
+	std::vector<Quadtree<Unit>::Entity *> treeEntities(unitAmount);
+	std::vector<VC3> treePositions(unitAmount);
+
+	UnitListGrid grid(VC2(-area, -area), VC2(area, area), 8.0f);
+	std::vector<int> gridHandles(unitAmount);
+	std::vector<VC3> gridPositions(unitAmount);
+
+	for (int i = 0; i < unitAmount; i++)
+	{
+		treeEntities[i] = tree.insert(&units[i], units[i].position, units[i].unitListRadius);
+		treePositions[i] = units[i].position;
+		gridHandles[i] = grid.insert(&units[i], units[i].position, units[i].unitListRadius);
+		gridPositions[i] = units[i].position;
+	}
+
+	double treeUpdateTime = 0;
+	double treeQueryTime = 0;
+	double gridUpdateTime = 0;
+	double gridQueryTime = 0;
+	int missing = 0;
+	int extra = 0;
+	long found = 0;
+
+	std::vector<Unit *> treeResult;
+	std::vector<Unit *> gridResult;
+	std::vector<Unit *> bruteResult;
+
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		// lists are updated at the start of the tick (like UnitList::updateLists),
+		// units then move before the queries, at most the slack
+		TestClock::time_point start = TestClock::now();
+		for (int i = 0; i < unitAmount; i++)
+		{
+			VC3 diff = units[i].position - treePositions[i];
+			if (fabsf(diff.x) > UNIT_QTREE_UPDATE_TRESHOLD || fabsf(diff.z) > UNIT_QTREE_UPDATE_TRESHOLD)
+			{
+				treeEntities[i]->setPosition(units[i].position);
+				treePositions[i] = units[i].position;
+			}
+		}
+		TestClock::time_point treeDone = TestClock::now();
+		for (int i = 0; i < unitAmount; i++)
+		{
+			gridPositions[i] = units[i].position;
+			grid.setPosition(gridHandles[i], gridPositions[i]);
+		}
+		TestClock::time_point gridDone = TestClock::now();
+
+		treeUpdateTime += getMilliseconds(start, treeDone);
+		gridUpdateTime += getMilliseconds(treeDone, gridDone);
+
+		for (int i = 0; i < unitAmount; i++)
+		{
+			units[i].position += units[i].velocity;
+			if (fabsf(units[i].position.x) > area / 2)
+				units[i].velocity.x = -units[i].velocity.x;
+			if (fabsf(units[i].position.z) > area / 2)
+				units[i].velocity.z = -units[i].velocity.z;
+		}
+
+		// about two queries per unit (actors and projectiles)
+		for (int q = 0; q < unitAmount * 2; q++)
+		{
+			VC3 position = units[q % unitAmount].position + VC3(randomFloat(-3, 3), 0, randomFloat(-3, 3));
+			float radius = queryRadii[q % 3];
+
+			treeResult.clear();
+			gridResult.clear();
+			bruteResult.clear();
+
+			TestClock::time_point queryStart = TestClock::now();
+			Collector treeCollector(treeResult, position, radius, false);
+			tree.visitSphere(treeCollector, position, radius);
+			TestClock::time_point queryTree = TestClock::now();
+			Collector gridCollector(gridResult, position, radius, true);
+			grid.visitCandidates(gridCollector, position, radius, UNIT_GRID_MOVE_SLACK);
+			TestClock::time_point queryGrid = TestClock::now();
+
+			treeQueryTime += getMilliseconds(queryStart, queryTree);
+			gridQueryTime += getMilliseconds(queryTree, queryGrid);
+
+			for (int i = 0; i < unitAmount; i++)
+			{
+				if (hits(&units[i], position, radius))
+					bruteResult.push_back(&units[i]);
+			}
+
+			std::sort(gridResult.begin(), gridResult.end());
+			std::sort(bruteResult.begin(), bruteResult.end());
+			for (int i = 0; i < (int)bruteResult.size(); i++)
+			{
+				if (!std::binary_search(gridResult.begin(), gridResult.end(), bruteResult[i]))
+					missing++;
+			}
+			extra += (int)gridResult.size() + missing - (int)bruteResult.size();
+			found += (long)bruteResult.size();
+		}
+	}
+
+	printf("%d units, %d ticks, %.2f units per query\n", unitAmount, ticks, found / double(ticks * unitAmount * 2));
+	printf("quadtree: update %.1f ms, query %.1f ms\n", treeUpdateTime, treeQueryTime);
+	printf("grid:     update %.1f ms, query %.1f ms\n", gridUpdateTime, gridQueryTime);
+
+	if (missing > 0 || extra != 0)
+	{
+		printf("FAILED: grid missed %d units, gave %d extra\n", missing, extra);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}